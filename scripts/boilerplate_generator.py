@@ -143,7 +143,7 @@ def get_arg_names(args):
 
     return [starred_name.strip("* ") for starred_name in starred_names]
 
-def get_func_boilerplate(fn_info):
+def get_func_boilerplate(fn_info, mod_name):
     call_args_str = ", ".join(get_arg_names(fn_info.args))
 
     if "int" in fn_info.rtype:
@@ -172,10 +172,36 @@ def get_func_boilerplate(fn_info):
     ret += "static {0.rtype} (*_{0.name}) ({0.args}) = {0.name}_stub;\n\n".format(fn_info)
 
     # then add a documented function calling the dynamically loaded one via the
-    # reference
-    ret += ("{0.doc}{0.rtype} {0.name} ({0.args}) {{\n" +
-            "    return _{0.name} ({1});\n" +
-            "}}\n\n\n").format(fn_info, call_args_str)
+    # reference (loading the plugin first if lazy loading is enabled) with
+    # entry/exit tracepoints around the call (no-ops unless the library is
+    # configured with --with-sdt) and the call recorded in the metrics;
+    # note that return values are passed through as they are -- ownership of
+    # the structs allocated by the plugin transfers straight to the caller,
+    # the API boundary never copies them
+    if fn_info.rtype.strip() == "void":
+        ret += ("{0.doc}{0.rtype} {0.name} ({0.args}) {{\n" +
+                "    gint64 duration = 0;\n" +
+                "    bd_ensure_plugin_loaded (BD_PLUGIN_{2});\n" +
+                "    BD_TRACE (api_entry, \"{3}\", \"{0.name}\");\n" +
+                "    duration = g_get_monotonic_time ();\n" +
+                "    _{0.name} ({1});\n" +
+                "    duration = g_get_monotonic_time () - duration;\n" +
+                "    BD_TRACE (api_exit, \"{3}\", \"{0.name}\", duration);\n" +
+                "    bd_utils_metrics_record_call (\"{3}\", \"{0.name}\", duration);\n" +
+                "}}\n\n\n").format(fn_info, call_args_str, mod_name.upper(), mod_name)
+    else:
+        ret += ("{0.doc}{0.rtype} {0.name} ({0.args}) {{\n" +
+                "    gint64 duration = 0;\n" +
+                "    {0.rtype} probe_ret;\n" +
+                "    bd_ensure_plugin_loaded (BD_PLUGIN_{2});\n" +
+                "    BD_TRACE (api_entry, \"{3}\", \"{0.name}\");\n" +
+                "    duration = g_get_monotonic_time ();\n" +
+                "    probe_ret = _{0.name} ({1});\n" +
+                "    duration = g_get_monotonic_time () - duration;\n" +
+                "    BD_TRACE (api_exit, \"{3}\", \"{0.name}\", duration);\n" +
+                "    bd_utils_metrics_record_call (\"{3}\", \"{0.name}\", duration);\n" +
+                "    return probe_ret;\n" +
+                "}}\n\n\n").format(fn_info, call_args_str, mod_name.upper(), mod_name)
 
     return ret
 
@@ -296,7 +322,7 @@ def generate_source_header(api_file, out_dir, skip_patterns=None):
         for info in nonapi_fn_infos:
             src_f.write(get_fn_code(info))
         for info in api_fn_infos:
-            src_f.write(get_func_boilerplate(info))
+            src_f.write(get_func_boilerplate(info, mod_name))
         src_f.write(get_loading_func(api_fn_infos, mod_name))
         src_f.write(get_unloading_func(api_fn_infos, mod_name))
 
@@ -18,6 +18,7 @@ typedef enum {
 } BDInitError;
 
 gboolean bd_init (BDPluginSpec **require_plugins, BDUtilsLogFunc log_func, GError **error);
+gboolean bd_init_lazy (BDPluginSpec **require_plugins, BDUtilsLogFunc log_func, GError **error);
 gboolean bd_ensure_init (BDPluginSpec **require_plugins, BDUtilsLogFunc log_func, GError **error);
 gboolean bd_reinit (BDPluginSpec **require_plugins, gboolean reload, BDUtilsLogFunc log_func, GError **error);
 gboolean bd_try_init(BDPluginSpec **request_plugins, BDUtilsLogFunc log_func,
@@ -18,8 +18,14 @@
  */
 
 #include <glib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/btrfs.h>
+#include <linux/btrfs_tree.h>
 #include <blockdev/utils.h>
 #include <bs_size.h>
 
@@ -252,23 +258,6 @@ static BDBtrfsDeviceInfo* get_device_info_from_match (GMatchInfo *match_info) {
     return ret;
 }
 
-static BDBtrfsSubvolumeInfo* get_subvolume_info_from_match (GMatchInfo *match_info) {
-    BDBtrfsSubvolumeInfo *ret = g_new(BDBtrfsSubvolumeInfo, 1);
-    gchar *item = NULL;
-
-    item = g_match_info_fetch_named (match_info, "id");
-    ret->id = g_ascii_strtoull (item, NULL, 0);
-    g_free (item);
-
-    item = g_match_info_fetch_named (match_info, "parent_id");
-    ret->parent_id = g_ascii_strtoull (item, NULL, 0);
-    g_free (item);
-
-    ret->path = g_match_info_fetch_named (match_info, "path");
-
-    return ret;
-}
-
 static BDBtrfsFilesystemInfo* get_filesystem_info_from_match (GMatchInfo *match_info) {
     BDBtrfsFilesystemInfo *ret = g_new(BDBtrfsFilesystemInfo, 1);
     gchar *item = NULL;
@@ -506,7 +495,7 @@ guint64 bd_btrfs_get_default_subvolume_id (const gchar *mountpoint, GError **err
         !check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
-    regex = g_regex_new ("ID (\\d+) .*", 0, 0, error);
+    regex = bd_utils_get_regex ("ID (\\d+) .*", error);
     if (!regex) {
         bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create new GRegex");
         /* error is already populated */
@@ -514,15 +503,12 @@ guint64 bd_btrfs_get_default_subvolume_id (const gchar *mountpoint, GError **err
     }
 
     success = bd_utils_exec_and_capture_output (argv, NULL, &output, error);
-    if (!success) {
-        g_regex_unref (regex);
+    if (!success)
         return 0;
-    }
 
     success = g_regex_match (regex, output, 0, &match_info);
     if (!success) {
         g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_PARSE, "Failed to parse subvolume's ID");
-        g_regex_unref (regex);
         g_match_info_free (match_info);
         g_free (output);
         return 0;
@@ -533,7 +519,6 @@ guint64 bd_btrfs_get_default_subvolume_id (const gchar *mountpoint, GError **err
 
     g_free (match);
     g_match_info_free (match_info);
-    g_regex_unref (regex);
     g_free (output);
 
     return ret;
@@ -599,6 +584,199 @@ gboolean bd_btrfs_create_snapshot (const gchar *source, const gchar *dest, gbool
     return bd_utils_exec_and_report_error (argv, extra, error);
 }
 
+/**
+ * open_btrfs_volume: (skip)
+ *
+ * Finds the mountpoint of the mounted btrfs volume @device belongs to (by
+ * matching @device against the member devices reported by the
+ * BTRFS_IOC_FS_INFO/BTRFS_IOC_DEV_INFO ioctls of every mounted btrfs volume)
+ * and opens it.
+ *
+ * Returns: an O_RDONLY fd of the volume's mountpoint or -1 if the volume is
+ *          not mounted (or cannot be queried via the ioctls); no error is
+ *          reported, the callers are expected to fall back to the 'btrfs'
+ *          utility
+ */
+static gint open_btrfs_volume (const gchar *device) {
+    struct btrfs_ioctl_fs_info_args fa;
+    struct btrfs_ioctl_dev_info_args da;
+    gchar *mountinfo = NULL;
+    gchar **lines = NULL;
+    gchar **line_p = NULL;
+    gchar **fields = NULL;
+    gchar *mountpoint = NULL;
+    gchar *resolved = NULL;
+    gchar *dev_resolved = NULL;
+    guint64 devid = 0;
+    guint64 found = 0;
+    gboolean match = FALSE;
+    gint fd = -1;
+
+    resolved = bd_utils_resolve_device (device, NULL);
+    if (!resolved)
+        resolved = g_strdup (device);
+
+    if (!g_file_get_contents ("/proc/self/mountinfo", &mountinfo, NULL, NULL)) {
+        g_free (resolved);
+        return -1;
+    }
+
+    lines = g_strsplit (mountinfo, "\n", 0);
+    g_free (mountinfo);
+    for (line_p = lines; *line_p && fd < 0; line_p++) {
+        /* fields: ID parent major:minor root mountpoint options... - fstype source... */
+        fields = g_strsplit (*line_p, " ", 0);
+        if (g_strv_length (fields) < 7 || g_strcmp0 (fields[g_strv_length (fields) - 3], "btrfs") != 0) {
+            g_strfreev (fields);
+            continue;
+        }
+        /* octal-escaped (e.g. "\040" for a space) */
+        mountpoint = g_strcompress (fields[4]);
+        g_strfreev (fields);
+
+        fd = open (mountpoint, O_RDONLY | O_CLOEXEC);
+        g_free (mountpoint);
+        if (fd < 0)
+            continue;
+
+        memset (&fa, 0, sizeof (fa));
+        if (ioctl (fd, BTRFS_IOC_FS_INFO, &fa) < 0) {
+            close (fd);
+            fd = -1;
+            continue;
+        }
+
+        match = FALSE;
+        for (devid = 0, found = 0; devid <= fa.max_id && found < fa.num_devices && !match; devid++) {
+            memset (&da, 0, sizeof (da));
+            da.devid = devid;
+            if (ioctl (fd, BTRFS_IOC_DEV_INFO, &da) < 0)
+                /* no device with this ID (or a seed/missing device) */
+                continue;
+            found++;
+            dev_resolved = bd_utils_resolve_device ((gchar *) da.path, NULL);
+            match = g_strcmp0 (dev_resolved ? dev_resolved : (gchar *) da.path, resolved) == 0;
+            g_free (dev_resolved);
+        }
+
+        if (!match) {
+            close (fd);
+            fd = -1;
+        }
+    }
+
+    g_strfreev (lines);
+    g_free (resolved);
+
+    return fd;
+}
+
+/**
+ * list_devices_from_ioctls: (skip)
+ *
+ * Member devices of the mounted btrfs volume open as @fd straight from the
+ * BTRFS_IOC_FS_INFO/BTRFS_IOC_DEV_INFO ioctls, without spawning anything.
+ *
+ * Returns: the member devices or %NULL if the ioctls are not usable
+ */
+static BDBtrfsDeviceInfo** list_devices_from_ioctls (gint fd) {
+    struct btrfs_ioctl_fs_info_args fa;
+    struct btrfs_ioctl_dev_info_args da;
+    GPtrArray *dev_infos = NULL;
+    BDBtrfsDeviceInfo *info = NULL;
+    guint64 devid = 0;
+    guint64 found = 0;
+    guint i = 0;
+
+    memset (&fa, 0, sizeof (fa));
+    if (ioctl (fd, BTRFS_IOC_FS_INFO, &fa) < 0)
+        return NULL;
+
+    dev_infos = g_ptr_array_new ();
+    for (devid = 0, found = 0; devid <= fa.max_id && found < fa.num_devices; devid++) {
+        memset (&da, 0, sizeof (da));
+        da.devid = devid;
+        if (ioctl (fd, BTRFS_IOC_DEV_INFO, &da) < 0)
+            continue;
+        found++;
+        info = g_new0 (BDBtrfsDeviceInfo, 1);
+        info->id = da.devid;
+        info->path = g_strdup ((gchar *) da.path);
+        info->size = da.total_bytes;
+        info->used = da.bytes_used;
+        g_ptr_array_add (dev_infos, info);
+    }
+
+    if (dev_infos->len == 0) {
+        g_ptr_array_free (dev_infos, TRUE);
+        return NULL;
+    }
+
+    if (found < fa.num_devices) {
+        /* some devices are missing, the picture would be incomplete -- let
+           the callers fall back to the 'btrfs' utility */
+        for (i = 0; i < dev_infos->len; i++)
+            bd_btrfs_device_info_free (g_ptr_array_index (dev_infos, i));
+        g_ptr_array_free (dev_infos, TRUE);
+        return NULL;
+    }
+
+    g_ptr_array_add (dev_infos, NULL);
+    return (BDBtrfsDeviceInfo **) g_ptr_array_free (dev_infos, FALSE);
+}
+
+/**
+ * filesystem_info_from_ioctls: (skip)
+ *
+ * Information about the mounted btrfs volume open as @fd straight from the
+ * BTRFS_IOC_FS_INFO/BTRFS_IOC_GET_FSLABEL/BTRFS_IOC_SPACE_INFO ioctls,
+ * without spawning anything.
+ *
+ * Returns: the volume's filesystem info or %NULL if the ioctls are not usable
+ */
+static BDBtrfsFilesystemInfo* filesystem_info_from_ioctls (gint fd) {
+    struct btrfs_ioctl_fs_info_args fa;
+    struct btrfs_ioctl_space_args sa;
+    struct btrfs_ioctl_space_args *spaces = NULL;
+    gchar label[BTRFS_LABEL_SIZE] = { 0 };
+    BDBtrfsFilesystemInfo *info = NULL;
+    guint64 used = 0;
+    guint64 i = 0;
+
+    memset (&fa, 0, sizeof (fa));
+    if (ioctl (fd, BTRFS_IOC_FS_INFO, &fa) < 0)
+        return NULL;
+
+    if (ioctl (fd, BTRFS_IOC_GET_FSLABEL, label) < 0)
+        return NULL;
+
+    /* first call just gets the number of space infos, the second fetches them */
+    memset (&sa, 0, sizeof (sa));
+    if (ioctl (fd, BTRFS_IOC_SPACE_INFO, &sa) < 0)
+        return NULL;
+    spaces = g_malloc0 (sizeof (sa) + sa.total_spaces * sizeof (struct btrfs_ioctl_space_info));
+    spaces->space_slots = sa.total_spaces;
+    if (ioctl (fd, BTRFS_IOC_SPACE_INFO, spaces) < 0) {
+        g_free (spaces);
+        return NULL;
+    }
+    for (i = 0; i < spaces->total_spaces; i++)
+        used += spaces->spaces[i].used_bytes;
+    g_free (spaces);
+
+    info = g_new0 (BDBtrfsFilesystemInfo, 1);
+    info->label = g_strdup (label);
+    info->uuid = g_strdup_printf ("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                                  fa.fsid[0], fa.fsid[1], fa.fsid[2], fa.fsid[3],
+                                  fa.fsid[4], fa.fsid[5], fa.fsid[6], fa.fsid[7],
+                                  fa.fsid[8], fa.fsid[9], fa.fsid[10], fa.fsid[11],
+                                  fa.fsid[12], fa.fsid[13], fa.fsid[14], fa.fsid[15]);
+    info->num_devices = fa.num_devices;
+    info->used = used;
+
+    return info;
+}
+
 /**
  * bd_btrfs_list_devices:
  * @device: a device that is part of the queried btrfs volume
@@ -622,11 +800,23 @@ BDBtrfsDeviceInfo** bd_btrfs_list_devices (const gchar *device, GError **error)
     GRegex *regex = NULL;
     GMatchInfo *match_info = NULL;
     GPtrArray *dev_infos;
+    BDBtrfsDeviceInfo **ret = NULL;
+    gint fd = -1;
 
     if (!check_deps (&avail_deps, DEPS_BTRFS_MASK, deps, DEPS_LAST, &deps_check_lock, error) ||
         !check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
+    /* if the volume is mounted, the ioctls give us everything without
+       spawning the 'btrfs' utility */
+    fd = open_btrfs_volume (device);
+    if (fd >= 0) {
+        ret = list_devices_from_ioctls (fd);
+        close (fd);
+        if (ret)
+            return ret;
+    }
+
     regex = g_regex_new (pattern, G_REGEX_EXTENDED, 0, error);
     if (!regex) {
         bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create new GRegex");
@@ -669,133 +859,334 @@ BDBtrfsDeviceInfo** bd_btrfs_list_devices (const gchar *device, GError **error)
     return (BDBtrfsDeviceInfo **) g_ptr_array_free (dev_infos, FALSE);
 }
 
+/* metadata of one subvolume gathered from the root tree */
+typedef struct SubvolRef {
+    guint64 id;
+    guint64 parent_id;
+    guint64 dirid;          /* directory (in the parent subvolume) containing the subvolume */
+    gchar *name;
+    gchar *path;            /* computed lazily from the parent chain */
+    gboolean snapshot;
+    gboolean ordered;       /* already emitted during the topological walk */
+} SubvolRef;
+
+static void subvol_ref_free (gpointer data) {
+    SubvolRef *ref = data;
+
+    g_free (ref->name);
+    g_free (ref->path);
+    g_free (ref);
+}
+
 /**
- * bd_btrfs_list_subvolumes:
- * @mountpoint: a mountpoint of the queried btrfs volume
- * @snapshots_only: whether to list only snapshot subvolumes or not
- * @error: (out): place to store error (if any)
+ * gather_subvol_refs: (skip)
  *
- * Returns: (array zero-terminated=1): information about the subvolumes that are part of the btrfs volume
- * mounted at @mountpoint or %NULL in case of error
+ * Walks the root tree of the (mounted) volume open as @fd with the
+ * BTRFS_IOC_TREE_SEARCH ioctl using incremental batched reads -- one fixed
+ * page-sized buffer is reused for all the batches, so the memory usage is
+ * bounded no matter how many subvolumes there are.
  *
- * The subvolumes are sorted in a way that no child subvolume appears in the
- * list before its parent (sub)volume.
+ * Returns: subvolume ID -> SubvolRef mapping or %NULL in case of error
+ */
+static GHashTable* gather_subvol_refs (gint fd, const gchar *mountpoint, GError **error) {
+    GHashTable *refs = NULL;
+    struct btrfs_ioctl_search_args args;
+    struct btrfs_ioctl_search_header sh;
+    struct btrfs_root_ref rr;
+    SubvolRef *ref = NULL;
+    guint64 *key = NULL;
+    guint64 id = 0;
+    gsize off = 0;
+    guint i = 0;
+
+    refs = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, subvol_ref_free);
+
+    memset (&args, 0, sizeof (args));
+    args.key.tree_id = BTRFS_ROOT_TREE_OBJECTID;
+    args.key.min_objectid = BTRFS_FIRST_FREE_OBJECTID;
+    args.key.max_objectid = BTRFS_LAST_FREE_OBJECTID;
+    args.key.min_type = BTRFS_ROOT_ITEM_KEY;
+    args.key.max_type = BTRFS_ROOT_BACKREF_KEY;
+    args.key.max_offset = G_MAXUINT64;
+    args.key.max_transid = G_MAXUINT64;
+
+    while (TRUE) {
+        args.key.nr_items = G_MAXUINT32;
+        if (ioctl (fd, BTRFS_IOC_TREE_SEARCH, &args) < 0) {
+            g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_DEVICE,
+                         "Failed to search the root tree on '%s': %m", mountpoint);
+            g_hash_table_destroy (refs);
+            return NULL;
+        }
+        if (args.key.nr_items == 0)
+            break;
+
+        off = 0;
+        for (i = 0; i < args.key.nr_items; i++) {
+            /* the buffer is just a byte stream, the headers/items may be unaligned */
+            memcpy (&sh, args.buf + off, sizeof (sh));
+            off += sizeof (sh);
+
+            if (sh.type == BTRFS_ROOT_BACKREF_KEY) {
+                /* (subvolume, BTRFS_ROOT_BACKREF_KEY, parent subvolume) */
+                memcpy (&rr, args.buf + off, sizeof (rr));
+                id = sh.objectid;
+                ref = g_hash_table_lookup (refs, &id);
+                if (!ref) {
+                    ref = g_new0 (SubvolRef, 1);
+                    ref->id = id;
+                    key = g_new (guint64, 1);
+                    *key = id;
+                    g_hash_table_insert (refs, key, ref);
+                }
+                ref->parent_id = sh.offset;
+                ref->dirid = GUINT64_FROM_LE (rr.dirid);
+                g_free (ref->name);
+                ref->name = g_strndup ((gchar *) args.buf + off + sizeof (rr),
+                                       GUINT16_FROM_LE (rr.name_len));
+            } else if (sh.type == BTRFS_ROOT_ITEM_KEY &&
+                       sh.len >= offsetof (struct btrfs_root_item, parent_uuid) + BTRFS_UUID_SIZE) {
+                /* a subvolume with a parent UUID set is a snapshot (old
+                   filesystems may have short root items without the field) */
+                const guint8 *parent_uuid = (guint8 *) args.buf + off +
+                                            offsetof (struct btrfs_root_item, parent_uuid);
+                gboolean is_snapshot = FALSE;
+                gsize j = 0;
+
+                for (j = 0; j < BTRFS_UUID_SIZE && !is_snapshot; j++)
+                    is_snapshot = parent_uuid[j] != 0;
+                if (is_snapshot) {
+                    id = sh.objectid;
+                    ref = g_hash_table_lookup (refs, &id);
+                    if (!ref) {
+                        ref = g_new0 (SubvolRef, 1);
+                        ref->id = id;
+                        key = g_new (guint64, 1);
+                        *key = id;
+                        g_hash_table_insert (refs, key, ref);
+                    }
+                    ref->snapshot = TRUE;
+                }
+            }
+            off += sh.len;
+        }
+
+        /* continue the next batch right after the last returned key */
+        args.key.min_objectid = sh.objectid;
+        args.key.min_type = sh.type;
+        if (sh.offset < G_MAXUINT64)
+            args.key.min_offset = sh.offset + 1;
+        else if (sh.type < args.key.max_type) {
+            args.key.min_offset = 0;
+            args.key.min_type = sh.type + 1;
+        } else {
+            args.key.min_offset = 0;
+            args.key.min_type = BTRFS_ROOT_ITEM_KEY;
+            args.key.min_objectid = sh.objectid + 1;
+        }
+    }
+
+    return refs;
+}
+
+/**
+ * subvol_ref_path: (skip)
  *
- * Tech category: %BD_BTRFS_TECH_SUBVOL-%BD_BTRFS_TECH_MODE_QUERY
+ * Resolves (and caches) the path of @ref relative to the top-level volume by
+ * following the parent chain and resolving the containing directories with
+ * the BTRFS_IOC_INO_LOOKUP ioctl.
+ *
+ * Returns: the path of @ref (owned by @ref) or %NULL in case of error
  */
-BDBtrfsSubvolumeInfo** bd_btrfs_list_subvolumes (const gchar *mountpoint, gboolean snapshots_only, GError **error) {
-    const gchar *argv[7] = {"btrfs", "subvol", "list", "-p", NULL, NULL, NULL};
-    gchar *output = NULL;
-    gboolean success = FALSE;
-    gchar **lines = NULL;
-    gchar **line_p = NULL;
-    gchar const * const pattern = "ID\\s+(?P<id>\\d+)\\s+gen\\s+\\d+\\s+(cgen\\s+\\d+\\s+)?" \
-                                  "parent\\s+(?P<parent_id>\\d+)\\s+top\\s+level\\s+\\d+\\s+" \
-                                  "(otime\\s+\\d{4}-\\d{2}-\\d{2}\\s+\\d\\d:\\d\\d:\\d\\d\\s+)?"\
-                                  "path\\s+(?P<path>\\S+)";
-    GRegex *regex = NULL;
-    GMatchInfo *match_info = NULL;
-    guint64 i = 0;
-    guint64 y = 0;
-    guint64 next_sorted_idx = 0;
-    GPtrArray *subvol_infos;
-    BDBtrfsSubvolumeInfo* item = NULL;
-    BDBtrfsSubvolumeInfo* swap_item = NULL;
-    BDBtrfsSubvolumeInfo** ret = NULL;
+static const gchar* subvol_ref_path (gint fd, GHashTable *refs, SubvolRef *ref, GError **error) {
+    struct btrfs_ioctl_ino_lookup_args la;
+    SubvolRef *parent = NULL;
+    const gchar *parent_path = NULL;
 
-    if (!check_deps (&avail_deps, DEPS_BTRFS_MASK, deps, DEPS_LAST, &deps_check_lock, error) ||
-        !check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
-        return FALSE;
+    if (ref->path)
+        return ref->path;
 
-    if (snapshots_only) {
-        argv[4] = "-s";
-        argv[5] = mountpoint;
-    } else
-        argv[4] = mountpoint;
+    if (!ref->name) {
+        g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_PARSE,
+                     "Found no reference for the subvolume %"G_GUINT64_FORMAT, ref->id);
+        return NULL;
+    }
 
-    regex = g_regex_new (pattern, G_REGEX_EXTENDED, 0, error);
-    if (!regex) {
-        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create new GRegex");
-        /* error is already populated */
+    /* path of the directory containing the subvolume inside its parent
+       subvolume ("" or with a trailing slash) */
+    memset (&la, 0, sizeof (la));
+    la.treeid = ref->parent_id;
+    la.objectid = ref->dirid;
+    if (ioctl (fd, BTRFS_IOC_INO_LOOKUP, &la) < 0) {
+        g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_DEVICE,
+                     "Failed to resolve the path of the subvolume %"G_GUINT64_FORMAT": %m", ref->id);
         return NULL;
     }
 
-    success = bd_utils_exec_and_capture_output (argv, NULL, &output, error);
-    if (!success) {
-        g_regex_unref (regex);
-        if (g_error_matches (*error,  BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
-            /* no output -> no subvolumes */
-            g_clear_error (error);
-            return g_new0 (BDBtrfsSubvolumeInfo*, 1);
-        } else {
-            /* error is already populated from the call above or simply no output*/
+    if (ref->parent_id == BTRFS_FS_TREE_OBJECTID)
+        ref->path = g_strdup_printf ("%s%s", la.name, ref->name);
+    else {
+        parent = g_hash_table_lookup (refs, &ref->parent_id);
+        if (!parent) {
+            g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_PARSE,
+                         "Unknown parent subvolume %"G_GUINT64_FORMAT" of the subvolume %"G_GUINT64_FORMAT,
+                         ref->parent_id, ref->id);
             return NULL;
         }
+        parent_path = subvol_ref_path (fd, refs, parent, error);
+        if (!parent_path)
+            return NULL;
+        ref->path = g_strdup_printf ("%s/%s%s", parent_path, la.name, ref->name);
     }
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
+    return ref->path;
+}
 
-    subvol_infos = g_ptr_array_new ();
-    for (line_p = lines; *line_p; line_p++) {
-        success = g_regex_match (regex, *line_p, 0, &match_info);
-        if (!success) {
-            g_match_info_free (match_info);
-            continue;
-        }
+/**
+ * enumerate_subvolumes: (skip)
+ *
+ * The common core of bd_btrfs_list_subvolumes() and
+ * bd_btrfs_foreach_subvolume(): a bounded-memory kernel walk of the root
+ * tree with no child process. The subvolumes are passed to @func in an order
+ * in which no child subvolume comes before its parent (sub)volume.
+ */
+static gboolean enumerate_subvolumes (const gchar *mountpoint, gboolean snapshots_only, BDBtrfsSubvolumeFunc func, gpointer user_data, GError **error) {
+    gint fd = -1;
+    GHashTable *refs = NULL;
+    GHashTableIter iter;
+    GPtrArray *remaining = NULL;
+    SubvolRef *ref = NULL;
+    SubvolRef *parent = NULL;
+    BDBtrfsSubvolumeInfo info = { 0, 0, NULL };
+    gboolean progressed = FALSE;
+    gboolean go_on = TRUE;
+    gboolean ret = FALSE;
+    gpointer value = NULL;
+    guint i = 0;
 
-        g_ptr_array_add (subvol_infos, get_subvolume_info_from_match (match_info));
-        g_match_info_free (match_info);
+    fd = open (mountpoint, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_DEVICE,
+                     "Failed to open the mountpoint '%s': %m", mountpoint);
+        return FALSE;
     }
 
-    g_strfreev (lines);
-    g_regex_unref (regex);
-
-    if (subvol_infos->len == 0) {
-        g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_PARSE, "Failed to parse information about subvolumes");
-        g_ptr_array_free (subvol_infos, TRUE);
-        return NULL;
+    refs = gather_subvol_refs (fd, mountpoint, error);
+    if (!refs) {
+        close (fd);
+        return FALSE;
     }
 
-    /* now we know how much space to allocate for the result (subvols + NULL) */
-    ret = g_new0 (BDBtrfsSubvolumeInfo*, subvol_infos->len + 1);
-
-    /* we need to sort the subvolumes in a way that no child subvolume appears
-       in the list before its parent (sub)volume */
-
-    /* let's start by moving all top-level (sub)volumes to the beginning */
-    for (i=0; i < subvol_infos->len; i++) {
-        item = (BDBtrfsSubvolumeInfo*) g_ptr_array_index (subvol_infos, i);
-        if (item->parent_id == BD_BTRFS_MAIN_VOLUME_ID)
-            /* top-level (sub)volume */
-            ret[next_sorted_idx++] = item;
-    }
-    /* top-level (sub)volumes are now processed */
-    for (i=0; i < next_sorted_idx; i++)
-        g_ptr_array_remove_fast (subvol_infos, ret[i]);
-
-    /* now sort the rest in a way that we search for an already sorted parent or sibling */
-    for (i=0; i < subvol_infos->len; i++) {
-        item = (BDBtrfsSubvolumeInfo*) g_ptr_array_index (subvol_infos, i);
-        ret[next_sorted_idx] = item;
-        /* move the item towards beginning of the array checking if some parent
-           or sibling has been already processed/sorted before or we reached the
-           top-level (sub)volumes */
-        for (y=next_sorted_idx; (y > 0 && (ret[y-1]->id != item->parent_id) && (ret[y-1]->parent_id != item->parent_id) && (ret[y-1]->parent_id != BD_BTRFS_MAIN_VOLUME_ID)); y--) {
-            swap_item = ret[y-1];
-            ret[y-1] = ret[y];
-            ret[y] = swap_item;
+    remaining = g_ptr_array_new ();
+    g_hash_table_iter_init (&iter, refs);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+        g_ptr_array_add (remaining, value);
+
+    /* emit the subvolumes so that no child comes before its parent; every
+       pass emits at least the subvolumes whose parents were emitted in the
+       previous one */
+    while (go_on && remaining->len > 0) {
+        progressed = FALSE;
+        i = 0;
+        while (go_on && i < remaining->len) {
+            ref = g_ptr_array_index (remaining, i);
+            parent = g_hash_table_lookup (refs, &ref->parent_id);
+            if (ref->parent_id == BTRFS_FS_TREE_OBJECTID || !parent || parent->ordered) {
+                ref->ordered = TRUE;
+                progressed = TRUE;
+                g_ptr_array_remove_index_fast (remaining, i);
+                if (!snapshots_only || ref->snapshot) {
+                    info.id = ref->id;
+                    info.parent_id = ref->parent_id;
+                    info.path = (gchar *) subvol_ref_path (fd, refs, ref, error);
+                    if (!info.path)
+                        goto out;
+                    go_on = func (&info, user_data);
+                }
+            } else
+                i++;
+        }
+        if (go_on && !progressed) {
+            /* can only happen on a corrupted parent chain */
+            g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_PARSE,
+                         "Failed to order the subvolumes by their parent chain");
+            goto out;
         }
-        next_sorted_idx++;
     }
-    ret[next_sorted_idx] = NULL;
 
-    /* now just free the pointer array */
-    g_ptr_array_free (subvol_infos, TRUE);
+    ret = TRUE;
 
+out:
+    g_ptr_array_free (remaining, TRUE);
+    g_hash_table_destroy (refs);
+    close (fd);
     return ret;
 }
 
+/**
+ * bd_btrfs_foreach_subvolume:
+ * @mountpoint: a mountpoint of the queried btrfs volume
+ * @snapshots_only: whether to report only snapshot subvolumes or not
+ * @func: (scope call): function to call for every subvolume
+ * @user_data: (allow-none): data to pass to @func
+ * @error: (out): place to store error (if any)
+ *
+ * Calls @func for every subvolume of the btrfs volume mounted at @mountpoint,
+ * in an order in which no child subvolume comes before its parent
+ * (sub)volume. Unlike bd_btrfs_list_subvolumes() the subvolumes are streamed
+ * one by one with bounded memory usage, which makes this the preferred
+ * variant for volumes with very many (tens of thousands of) subvolumes.
+ *
+ * Returns: whether the enumeration succeeded or not (a %FALSE return from
+ *          @func only stops the enumeration early and is not an error)
+ *
+ * Tech category: %BD_BTRFS_TECH_SUBVOL-%BD_BTRFS_TECH_MODE_QUERY
+ */
+gboolean bd_btrfs_foreach_subvolume (const gchar *mountpoint, gboolean snapshots_only, BDBtrfsSubvolumeFunc func, gpointer user_data, GError **error) {
+    if (!check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    return enumerate_subvolumes (mountpoint, snapshots_only, func, user_data, error);
+}
+
+static gboolean collect_subvol_info (BDBtrfsSubvolumeInfo *info, gpointer user_data) {
+    g_ptr_array_add ((GPtrArray *) user_data, bd_btrfs_subvolume_info_copy (info));
+    return TRUE;
+}
+
+/**
+ * bd_btrfs_list_subvolumes:
+ * @mountpoint: a mountpoint of the queried btrfs volume
+ * @snapshots_only: whether to list only snapshot subvolumes or not
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (array zero-terminated=1): information about the subvolumes that are part of the btrfs volume
+ * mounted at @mountpoint or %NULL in case of error
+ *
+ * The subvolumes are sorted in a way that no child subvolume appears in the
+ * list before its parent (sub)volume.
+ *
+ * Tech category: %BD_BTRFS_TECH_SUBVOL-%BD_BTRFS_TECH_MODE_QUERY
+ */
+BDBtrfsSubvolumeInfo** bd_btrfs_list_subvolumes (const gchar *mountpoint, gboolean snapshots_only, GError **error) {
+    GPtrArray *subvol_infos = NULL;
+    guint i = 0;
+
+    if (!check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    subvol_infos = g_ptr_array_new ();
+    if (!enumerate_subvolumes (mountpoint, snapshots_only, collect_subvol_info, subvol_infos, error)) {
+        for (i = 0; i < subvol_infos->len; i++)
+            bd_btrfs_subvolume_info_free (g_ptr_array_index (subvol_infos, i));
+        g_ptr_array_free (subvol_infos, TRUE);
+        return NULL;
+    }
+
+    g_ptr_array_add (subvol_infos, NULL);
+    return (BDBtrfsSubvolumeInfo **) g_ptr_array_free (subvol_infos, FALSE);
+}
+
 /**
  * bd_btrfs_filesystem_info:
  * @device: a device that is part of the queried btrfs volume
@@ -816,11 +1207,22 @@ BDBtrfsFilesystemInfo* bd_btrfs_filesystem_info (const gchar *device, GError **e
     GRegex *regex = NULL;
     GMatchInfo *match_info = NULL;
     BDBtrfsFilesystemInfo *ret = NULL;
+    gint fd = -1;
 
     if (!check_deps (&avail_deps, DEPS_BTRFS_MASK, deps, DEPS_LAST, &deps_check_lock, error) ||
         !check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
+    /* if the volume is mounted, the ioctls give us everything without
+       spawning the 'btrfs' utility */
+    fd = open_btrfs_volume (device);
+    if (fd >= 0) {
+        ret = filesystem_info_from_ioctls (fd);
+        close (fd);
+        if (ret)
+            return ret;
+    }
+
     regex = g_regex_new (pattern, G_REGEX_EXTENDED, 0, error);
     if (!regex) {
         bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create new GRegex");
@@ -26,12 +26,28 @@
 #define DBUS_PROPS_IFACE "org.freedesktop.DBus.Properties"
 
 
+typedef struct UtilDepCheckTask {
+    const UtilDep *dep;
+    volatile guint *avail_deps;
+    guint idx;
+    GError *error;
+} UtilDepCheckTask;
+
+static void check_dep_worker (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    UtilDepCheckTask *task = (UtilDepCheckTask *) data;
+
+    if (bd_utils_check_util_version (task->dep->name, task->dep->version,
+                                     task->dep->ver_arg, task->dep->ver_regexp, &(task->error)))
+        g_atomic_int_or (task->avail_deps, 1 << task->idx);
+}
+
 gboolean __attribute__ ((visibility ("hidden")))
 check_deps (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_specs, guint l_deps, GMutex *deps_check_lock, GError **error) {
     guint i = 0;
-    gboolean ret = FALSE;
-    GError *l_error = NULL;
     guint val = 0;
+    UtilDepCheckTask *tasks = NULL;
+    guint n_tasks = 0;
+    GThreadPool *pool = NULL;
 
     val = (guint) g_atomic_int_get (avail_deps);
     if ((val & req_deps) == req_deps)
@@ -49,28 +65,87 @@ check_deps (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_spec
         return TRUE;
     }
 
+    tasks = g_new0 (UtilDepCheckTask, l_deps);
     for (i=0; i < l_deps; i++) {
         if (((1 << i) & req_deps) && !((1 << i) & val)) {
-            ret = bd_utils_check_util_version (deps_specs[i].name, deps_specs[i].version,
-                                               deps_specs[i].ver_arg, deps_specs[i].ver_regexp, &l_error);
-            /* if not ret and l_error -> set/prepend error */
-            if (!ret) {
-                if (*error)
-                    g_prefix_error (error, "%s\n", l_error->message);
-                else
-                    g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR,
-                                 "%s", l_error->message);
-                g_clear_error (&l_error);
-            } else
-                g_atomic_int_or (avail_deps, 1 << i);
+            tasks[n_tasks].dep = deps_specs + i;
+            tasks[n_tasks].avail_deps = avail_deps;
+            tasks[n_tasks].idx = i;
+            n_tasks++;
+        }
+    }
+
+    /* each probe spawns the utility to ask for its version, run all of them in
+       flight at once instead of one by one */
+    if (n_tasks > 1)
+        pool = g_thread_pool_new (check_dep_worker, NULL, (gint) n_tasks, FALSE, NULL);
+    if (pool) {
+        for (i=0; i < n_tasks; i++)
+            g_thread_pool_push (pool, tasks + i, NULL);
+        /* wait for all the probes to finish */
+        g_thread_pool_free (pool, FALSE, TRUE);
+    } else
+        for (i=0; i < n_tasks; i++)
+            check_dep_worker (tasks + i, NULL);
+
+    for (i=0; i < n_tasks; i++) {
+        if (tasks[i].error) {
+            if (*error)
+                g_prefix_error (error, "%s\n", tasks[i].error->message);
+            else
+                g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR,
+                             "%s", tasks[i].error->message);
+            g_clear_error (&(tasks[i].error));
         }
     }
+    g_free (tasks);
 
     g_mutex_unlock (deps_check_lock);
     val = (guint) g_atomic_int_get (avail_deps);
     return (val & req_deps) == req_deps;
 }
 
+typedef struct DepsCheckData {
+    volatile guint *avail_deps;
+    guint req_deps;
+    const UtilDep *deps_specs;
+    guint l_deps;
+    GMutex *deps_check_lock;
+} DepsCheckData;
+
+static gpointer check_deps_thread (gpointer data) {
+    DepsCheckData *task = (DepsCheckData *) data;
+    GError *error = NULL;
+
+    if (!check_deps (task->avail_deps, task->req_deps, task->deps_specs, task->l_deps,
+                     task->deps_check_lock, &error))
+        /* just warming up the cache, failures are properly reported by the
+           first real call */
+        g_clear_error (&error);
+    g_free (task);
+    return NULL;
+}
+
+void __attribute__ ((visibility ("hidden")))
+check_deps_async (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_specs, guint l_deps, GMutex *deps_check_lock) {
+    DepsCheckData *data = g_new0 (DepsCheckData, 1);
+    GThread *thread = NULL;
+
+    data->avail_deps = avail_deps;
+    data->req_deps = req_deps;
+    data->deps_specs = deps_specs;
+    data->l_deps = l_deps;
+    data->deps_check_lock = deps_check_lock;
+
+    thread = g_thread_try_new ("deps-check", check_deps_thread, data, NULL);
+    if (thread)
+        g_thread_unref (thread);
+    else
+        /* couldn't start the thread, nothing to do, the probes will simply run
+           on the first call */
+        g_free (data);
+}
+
 gboolean __attribute__ ((visibility ("hidden")))
 check_module_deps (volatile guint *avail_deps, guint req_deps, const gchar *const*modules, guint l_modules, GMutex *deps_check_lock, GError **error) {
     guint i = 0;
@@ -133,7 +208,7 @@ static gboolean _check_dbus_api_version (GBusType bus_type, const gchar *version
     const gchar *bus_version = NULL;
     int cmp = 0;
 
-    bus = g_bus_get_sync (bus_type, NULL, error);
+    bus = bd_utils_dbus_get_connection (bus_type, error);
     if (!bus)
         return FALSE;
 
@@ -143,6 +218,7 @@ static gboolean _check_dbus_api_version (GBusType bus_type, const gchar *version
     ret = g_dbus_connection_call_sync (bus, version_bus, version_path, DBUS_PROPS_IFACE,
                                        "Get", args, NULL, G_DBUS_CALL_FLAGS_NONE,
                                        -1, NULL, error);
+    g_object_unref (bus);
     if (!ret) {
         g_prefix_error (error, "Failed to get %s property of the %s object: ", version_prop, version_path);
         return FALSE;
@@ -267,7 +343,7 @@ static gboolean _check_util_feature (const gchar *util, const gchar *feature, co
     }
 
     if (feature_regexp) {
-        regex = g_regex_new (feature_regexp, 0, 0, error);
+        regex = bd_utils_get_regex (feature_regexp, error);
         if (!regex) {
             g_free (output);
             /* error is already populated */
@@ -279,11 +355,9 @@ static gboolean _check_util_feature (const gchar *util, const gchar *feature, co
             g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_FEATURE_CHECK_ERROR,
                          "Failed to determine %s's features from: %s", util, output);
             g_free (output);
-            g_regex_unref (regex);
             g_match_info_free (match_info);
             return FALSE;
         }
-        g_regex_unref (regex);
 
         features_str = g_match_info_fetch (match_info, 1);
         g_match_info_free (match_info);
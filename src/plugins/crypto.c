@@ -226,9 +226,85 @@ BDCryptoLUKSTokenInfo* bd_crypto_luks_token_info_copy (BDCryptoLUKSTokenInfo *in
     return new_info;
 }
 
+BDCryptoDevice* bd_crypto_device_copy (BDCryptoDevice *device) {
+    if (device == NULL)
+        return NULL;
+
+    g_atomic_int_inc (&device->ref_count);
+    return device;
+}
+
+void bd_crypto_device_free (BDCryptoDevice *device) {
+    if (device == NULL)
+        return;
+
+    if (!g_atomic_int_dec_and_test (&device->ref_count))
+        return;
+
+    crypt_free ((struct crypt_device *) device->cd);
+    g_free (device->spec);
+    g_free (device);
+}
+
 /* "C" locale to get the locale-agnostic error messages */
 static locale_t c_locale = (locale_t) 0;
 
+#ifdef LIBCRYPTSETUP_2
+/* cache of PBKDF costs measured per (type, hash, time_ms) so repeated LUKS2
+   formats don't re-run the deliberately expensive benchmark for every volume */
+static GMutex pbkdf_bench_lock;
+static GHashTable *pbkdf_bench_cache = NULL;
+
+typedef struct PBKDFBenchResult {
+    guint32 iterations;
+    guint32 max_memory_kb;
+    guint32 parallel_threads;
+} PBKDFBenchResult;
+
+static gchar* pbkdf_bench_key (const gchar *type, const gchar *hash, guint32 time_ms) {
+    return g_strdup_printf ("%s:%s:%u", type ? type : "", hash ? hash : "", time_ms);
+}
+
+/* callers must hold pbkdf_bench_lock */
+static PBKDFBenchResult* pbkdf_bench_lookup (const gchar *type, const gchar *hash, guint32 time_ms) {
+    PBKDFBenchResult *result = NULL;
+    gchar *key = NULL;
+
+    if (!pbkdf_bench_cache)
+        return NULL;
+
+    key = pbkdf_bench_key (type, hash, time_ms);
+    result = g_hash_table_lookup (pbkdf_bench_cache, key);
+    g_free (key);
+    return result;
+}
+
+static void pbkdf_bench_store (const gchar *type, const gchar *hash, guint32 time_ms, guint32 iterations, guint32 max_memory_kb, guint32 parallel_threads) {
+    PBKDFBenchResult *result = NULL;
+
+    g_mutex_lock (&pbkdf_bench_lock);
+    if (!pbkdf_bench_cache)
+        pbkdf_bench_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    result = g_new0 (PBKDFBenchResult, 1);
+    result->iterations = iterations;
+    result->max_memory_kb = max_memory_kb;
+    result->parallel_threads = parallel_threads;
+    g_hash_table_replace (pbkdf_bench_cache, pbkdf_bench_key (type, hash, time_ms), result);
+    g_mutex_unlock (&pbkdf_bench_lock);
+}
+
+static void pbkdf_bench_cleanup (void) {
+    g_mutex_lock (&pbkdf_bench_lock);
+    if (pbkdf_bench_cache) {
+        g_hash_table_destroy (pbkdf_bench_cache);
+        pbkdf_bench_cache = NULL;
+    }
+    g_mutex_unlock (&pbkdf_bench_lock);
+}
+
+#endif
+
 /**
  * bd_crypto_check_deps:
  *
@@ -295,6 +371,9 @@ void bd_crypto_close (void) {
     c_locale = (locale_t) 0;
     crypt_set_log_callback (NULL, NULL, NULL);
     crypt_set_debug_level (CRYPT_DEBUG_NONE);
+#ifdef LIBCRYPTSETUP_2
+    pbkdf_bench_cleanup ();
+#endif
 }
 
 /**
@@ -324,13 +403,21 @@ gboolean bd_crypto_is_tech_avail (BDCryptoTech tech, guint64 mode, GError **erro
             g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
                          "LUKS 2 technology requires libcryptsetup >= 2.0");
             return FALSE;
+#endif
+#ifndef LIBCRYPTSETUP_REENCRYPT
+            if (mode & BD_CRYPTO_TECH_MODE_REENCRYPT) {
+                g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
+                             "LUKS 2 reencryption requires libcryptsetup >= 2.4");
+                return FALSE;
+            }
 #endif
             ret = mode & (BD_CRYPTO_TECH_MODE_CREATE|BD_CRYPTO_TECH_MODE_OPEN_CLOSE|BD_CRYPTO_TECH_MODE_QUERY|
                           BD_CRYPTO_TECH_MODE_ADD_KEY|BD_CRYPTO_TECH_MODE_REMOVE_KEY|BD_CRYPTO_TECH_MODE_RESIZE|
-                          BD_CRYPTO_TECH_MODE_SUSPEND_RESUME|BD_CRYPTO_TECH_MODE_BACKUP_RESTORE);
+                          BD_CRYPTO_TECH_MODE_SUSPEND_RESUME|BD_CRYPTO_TECH_MODE_BACKUP_RESTORE|
+                          BD_CRYPTO_TECH_MODE_REENCRYPT);
             if (ret != mode) {
                 g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
-                             "Only 'create', 'open', 'query', 'add-key', 'remove-key', 'resize', 'suspend-resume', 'backup-restore' supported for LUKS 2");
+                             "Only 'create', 'open', 'query', 'add-key', 'remove-key', 'resize', 'suspend-resume', 'backup-restore', 'reencrypt' supported for LUKS 2");
                 return FALSE;
             } else
                 return TRUE;
@@ -451,7 +538,19 @@ gboolean bd_crypto_device_is_luks (const gchar *device, GError **error) {
     gint fd = 0;
     gint status = 0;
     const gchar *value = NULL;
+    gchar *usage = NULL;
+    gchar *type = NULL;
     guint n_try = 0;
+    guint64 devno = 0;
+    guint64 cache_gen = 0;
+    gboolean ret = FALSE;
+
+    if (bd_utils_probe_cache_lookup (device, &usage, &type, &devno, &cache_gen)) {
+        ret = (g_strcmp0 (usage, "crypto") == 0) && (g_strcmp0 (type, "crypto_LUKS") == 0);
+        g_free (usage);
+        g_free (type);
+        return ret;
+    }
 
     probe = blkid_new_probe ();
     if (!probe) {
@@ -507,6 +606,7 @@ gboolean bd_crypto_device_is_luks (const gchar *device, GError **error) {
         /* 1 = nothing detected */
         blkid_free_probe (probe);
         close (fd);
+        bd_utils_probe_cache_insert (devno, cache_gen, NULL, NULL);
         return FALSE;
     }
 
@@ -518,32 +618,26 @@ gboolean bd_crypto_device_is_luks (const gchar *device, GError **error) {
         close (fd);
         return FALSE;
     }
-
-    if (g_strcmp0 (value, "crypto") != 0) {
-        blkid_free_probe (probe);
-        close (fd);
-        return FALSE;
-    }
+    usage = g_strdup (value);
 
     status = blkid_probe_lookup_value (probe, "TYPE", &value, NULL);
     if (status != 0) {
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
                      "Failed to get filesystem type for the device '%s'", device);
+        g_free (usage);
         blkid_free_probe (probe);
         close (fd);
         return FALSE;
     }
 
-    if (g_strcmp0 (value, "crypto_LUKS") != 0) {
-        blkid_free_probe (probe);
-        close (fd);
-        return FALSE;
-    }
+    ret = (g_strcmp0 (usage, "crypto") == 0) && (g_strcmp0 (value, "crypto_LUKS") == 0);
 
+    bd_utils_probe_cache_insert (devno, cache_gen, usage, value);
+    g_free (usage);
     blkid_free_probe (probe);
     close (fd);
 
-    return TRUE;
+    return ret;
 }
 
 /**
@@ -737,6 +831,24 @@ static struct crypt_pbkdf_type *get_pbkdf_params (BDCryptoLUKSPBKDF *user_pbkdf,
             new_pbkdf->parallel_threads = default_pbkdf->parallel_threads;
     }
 
+    /* no explicit iteration count -> a benchmark would run, use previously
+       measured costs for the same (type, hash, time_ms) if we have them */
+    if (!(new_pbkdf->flags & CRYPT_PBKDF_NO_BENCHMARK)) {
+        PBKDFBenchResult *result = NULL;
+
+        g_mutex_lock (&pbkdf_bench_lock);
+        result = pbkdf_bench_lookup (new_pbkdf->type, new_pbkdf->hash, new_pbkdf->time_ms);
+        if (result) {
+            new_pbkdf->iterations = result->iterations;
+            if (g_strcmp0 (new_pbkdf->type, CRYPT_KDF_PBKDF2) != 0) {
+                new_pbkdf->max_memory_kb = result->max_memory_kb;
+                new_pbkdf->parallel_threads = result->parallel_threads;
+            }
+            new_pbkdf->flags |= CRYPT_PBKDF_NO_BENCHMARK;
+        }
+        g_mutex_unlock (&pbkdf_bench_lock);
+    }
+
     return new_pbkdf;
 }
 #endif
@@ -888,6 +1000,20 @@ static gboolean luks_format (const gchar *device, const gchar *cipher, guint64 k
         return FALSE;
     }
 
+#ifdef LIBCRYPTSETUP_2
+    /* remember the costs the format ended up with so the next format with the
+       same PBKDF spec can skip the benchmark -- but only when the benchmark
+       actually ran; caching caller-specified (possibly deliberately weak)
+       iterations would poison later default formats with them */
+    if (luks_version == BD_CRYPTO_LUKS_VERSION_LUKS2) {
+        const struct crypt_pbkdf_type *used_pbkdf = crypt_get_pbkdf_type (cd);
+        if (used_pbkdf && used_pbkdf->iterations && !(used_pbkdf->flags & CRYPT_PBKDF_NO_BENCHMARK))
+            pbkdf_bench_store (used_pbkdf->type, used_pbkdf->hash, used_pbkdf->time_ms,
+                               used_pbkdf->iterations, used_pbkdf->max_memory_kb,
+                               used_pbkdf->parallel_threads);
+    }
+#endif
+
     bd_utils_report_progress (progress_id, ((data_size != 0) && key_file) ? 40 : 50, "Format created");
     if (data_size != 0) {
         ret = crypt_keyslot_add_by_volume_key (cd, CRYPT_ANY_SLOT, NULL, 0,
@@ -1038,6 +1164,214 @@ gboolean bd_crypto_luks_format_luks2_blob (const gchar *device, const gchar *cip
     return luks_format (device, cipher, key_size, pass_data, data_len, NULL, min_entropy, luks_version, extra, error);
 }
 
+/**
+ * bd_crypto_pbkdf_benchmark:
+ * @pbkdf: (allow-none): PBKDF specification (type, hash and time cost) to
+ *                       benchmark or %NULL for the LUKS2 defaults
+ * @error: (out): place to store error (if any)
+ *
+ * Measures the PBKDF cost parameters (iterations and, for argon2, memory and
+ * parallel costs) matching the requested time cost and caches the result so
+ * subsequent LUKS2 formats with the same PBKDF specification reuse it instead
+ * of running the benchmark (roughly the time cost of CPU burn) again. The
+ * cache is also populated by every successful LUKS2 format, this function just
+ * allows paying the price once explicitly up front (e.g. before provisioning
+ * many volumes).
+ *
+ * Returns: (transfer full): fully specified PBKDF parameters with the measured
+ *                           costs filled in or %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS2-%BD_CRYPTO_TECH_MODE_CREATE
+ */
+#ifndef LIBCRYPTSETUP_2
+BDCryptoLUKSPBKDF* bd_crypto_pbkdf_benchmark (BDCryptoLUKSPBKDF *pbkdf __attribute__((unused)), GError **error) {
+    g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
+                 "PBKDF benchmarking requires LUKS2 support (libcryptsetup >= 2.0)");
+    return NULL;
+}
+#else
+BDCryptoLUKSPBKDF* bd_crypto_pbkdf_benchmark (BDCryptoLUKSPBKDF *pbkdf, GError **error) {
+    /* fixed sample inputs, the measured costs only depend on the PBKDF spec */
+    static const gchar bench_pass[] = "0123456789abcdef";
+    static const gchar bench_salt[] = "0123456789abcdef";
+    struct crypt_pbkdf_type bench = ZERO_INIT;
+    const struct crypt_pbkdf_type *default_pbkdf = NULL;
+    PBKDFBenchResult *result = NULL;
+    gint ret = 0;
+
+    default_pbkdf = crypt_get_pbkdf_default (CRYPT_LUKS2);
+    if (!default_pbkdf) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_FORMAT_FAILED,
+                     "Failed to get default values for pbkdf.");
+        return NULL;
+    }
+
+    bench.type = (pbkdf && pbkdf->type) ? pbkdf->type : default_pbkdf->type;
+    bench.hash = (pbkdf && pbkdf->hash) ? pbkdf->hash : default_pbkdf->hash;
+    bench.time_ms = (pbkdf && pbkdf->time_ms) ? pbkdf->time_ms : default_pbkdf->time_ms;
+    if (g_strcmp0 (bench.type, CRYPT_KDF_PBKDF2) != 0) {
+        bench.max_memory_kb = (pbkdf && pbkdf->max_memory_kb) ? pbkdf->max_memory_kb : default_pbkdf->max_memory_kb;
+        bench.parallel_threads = (pbkdf && pbkdf->parallel_threads) ? pbkdf->parallel_threads : default_pbkdf->parallel_threads;
+    }
+
+    g_mutex_lock (&pbkdf_bench_lock);
+    result = pbkdf_bench_lookup (bench.type, bench.hash, bench.time_ms);
+    if (result) {
+        BDCryptoLUKSPBKDF *cached = bd_crypto_luks_pbkdf_new (bench.type, bench.hash, result->max_memory_kb,
+                                                              result->iterations, bench.time_ms, result->parallel_threads);
+        g_mutex_unlock (&pbkdf_bench_lock);
+        return cached;
+    }
+    g_mutex_unlock (&pbkdf_bench_lock);
+
+    ret = crypt_benchmark_pbkdf (NULL, &bench, bench_pass, sizeof (bench_pass) - 1,
+                                 bench_salt, sizeof (bench_salt) - 1,
+                                 DEFAULT_LUKS_KEYSIZE_BITS * 2 / 8, NULL, NULL);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_FORMAT_FAILED,
+                     "Failed to benchmark PBKDF: %s", strerror_l (-ret, c_locale));
+        return NULL;
+    }
+
+    pbkdf_bench_store (bench.type, bench.hash, bench.time_ms,
+                       bench.iterations, bench.max_memory_kb, bench.parallel_threads);
+
+    return bd_crypto_luks_pbkdf_new (bench.type, bench.hash, bench.max_memory_kb,
+                                     bench.iterations, bench.time_ms, bench.parallel_threads);
+}
+#endif
+
+typedef struct CryptoFormatAsyncData {
+    gchar *device;
+    gchar *cipher;
+    guint64 key_size;
+    gchar *passphrase;
+    gchar *key_file;
+    guint64 min_entropy;
+    BDCryptoLUKSVersion luks_version;
+    BDCryptoLUKSExtra *extra;
+} CryptoFormatAsyncData;
+
+static void crypto_format_async_data_free (CryptoFormatAsyncData *data) {
+    g_free (data->device);
+    g_free (data->cipher);
+    g_free (data->passphrase);
+    g_free (data->key_file);
+    bd_crypto_luks_extra_free (data->extra);
+    g_free (data);
+}
+
+static void crypto_format_async_thread (GTask *task, gpointer source_object __attribute__((unused)), gpointer task_data, GCancellable *cancellable __attribute__((unused))) {
+    CryptoFormatAsyncData *data = (CryptoFormatAsyncData *) task_data;
+    GError *l_error = NULL;
+
+    if (g_task_return_error_if_cancelled (task))
+        return;
+
+    if (!bd_crypto_luks_format_luks2 (data->device, data->cipher, data->key_size, data->passphrase,
+                                      data->key_file, data->min_entropy, data->luks_version,
+                                      data->extra, &l_error))
+        g_task_return_error (task, l_error);
+    else
+        g_task_return_boolean (task, TRUE);
+}
+
+static void crypto_format_async_start (const gchar *device, const gchar *cipher, guint64 key_size, const gchar *passphrase, const gchar *key_file, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data) {
+    GTask *task = NULL;
+    CryptoFormatAsyncData *data = NULL;
+
+    data = g_new0 (CryptoFormatAsyncData, 1);
+    data->device = g_strdup (device);
+    data->cipher = g_strdup (cipher);
+    data->key_size = key_size;
+    data->passphrase = g_strdup (passphrase);
+    data->key_file = g_strdup (key_file);
+    data->min_entropy = min_entropy;
+    data->luks_version = luks_version;
+    data->extra = bd_crypto_luks_extra_copy (extra);
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, crypto_format_async_start);
+    g_task_set_task_data (task, data, (GDestroyNotify) crypto_format_async_data_free);
+    g_task_run_in_thread (task, crypto_format_async_thread);
+    g_object_unref (task);
+}
+
+/**
+ * bd_crypto_luks_format_async:
+ * @device: a device to format as LUKS
+ * @cipher: (allow-none): cipher specification (type-mode, e.g. "aes-xts-plain64") or %NULL to use the default
+ * @key_size: size of the volume key in bits or 0 to use the default
+ * @passphrase: (allow-none): a passphrase for the new LUKS device or %NULL if not requested
+ * @key_file: (allow-none): a key file for the new LUKS device or %NULL if not requested
+ * @min_entropy: minimum random data entropy (in bits) required to format @device as LUKS
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): function to call when the format is done
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Asynchronous variant of bd_crypto_luks_format(). The format (including the
+ * PBKDF benchmark and keyslot derivation which block for seconds) runs in a
+ * worker thread with progress reported through the standard progress reporting
+ * machinery so any number of formats can be in flight at once without
+ * dedicating a caller thread to each. Call bd_crypto_luks_format_finish() from
+ * @callback to get the result.
+ *
+ * Returns: whether the format was successfully started or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_CREATE
+ */
+gboolean bd_crypto_luks_format_async (const gchar *device, const gchar *cipher, guint64 key_size, const gchar *passphrase, const gchar *key_file, guint64 min_entropy, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error UNUSED) {
+    crypto_format_async_start (device, cipher, key_size, passphrase, key_file, min_entropy,
+                               BD_CRYPTO_LUKS_VERSION_LUKS1, NULL, cancellable, callback, user_data);
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_format_luks2_async:
+ * @device: a device to format as LUKS
+ * @cipher: (allow-none): cipher specification (type-mode, e.g. "aes-xts-plain64") or %NULL to use the default
+ * @key_size: size of the volume key in bits or 0 to use the default
+ * @passphrase: (allow-none): a passphrase for the new LUKS device or %NULL if not requested
+ * @key_file: (allow-none): a key file for the new LUKS device or %NULL if not requested
+ * @min_entropy: minimum random data entropy (in bits) required to format @device as LUKS
+ * @luks_version: whether to use LUKS v1 or LUKS v2
+ * @extra: (allow-none): extra arguments for LUKS format creation
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): function to call when the format is done
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Asynchronous variant of bd_crypto_luks_format_luks2(). See
+ * bd_crypto_luks_format_async() for details; call
+ * bd_crypto_luks_format_finish() from @callback to get the result.
+ *
+ * Returns: whether the format was successfully started or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS2-%BD_CRYPTO_TECH_MODE_CREATE
+ */
+gboolean bd_crypto_luks_format_luks2_async (const gchar *device, const gchar *cipher, guint64 key_size, const gchar *passphrase, const gchar *key_file, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error UNUSED) {
+    crypto_format_async_start (device, cipher, key_size, passphrase, key_file, min_entropy,
+                               luks_version, extra, cancellable, callback, user_data);
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_format_finish:
+ * @result: a #GAsyncResult obtained from the #GAsyncReadyCallback passed to
+ *          bd_crypto_luks_format_async() or bd_crypto_luks_format_luks2_async()
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: whether the device was successfully formatted as LUKS or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_CREATE
+ */
+gboolean bd_crypto_luks_format_finish (GAsyncResult *result, GError **error) {
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 static gboolean luks_open (const gchar *device, const gchar *name, const guint8 *pass_data, gsize data_len, const gchar *key_file, gboolean read_only, GError **error) {
     struct crypt_device *cd = NULL;
     gboolean success = FALSE;
@@ -1144,6 +1478,95 @@ gboolean bd_crypto_luks_open_blob (const gchar *device, const gchar *name, const
     return luks_open (device, name, (const guint8*) pass_data, data_len, NULL, read_only, error);
 }
 
+typedef struct CryptoOpenAsyncData {
+    gchar *device;
+    gchar *name;
+    gchar *passphrase;
+    gchar *key_file;
+    gboolean read_only;
+} CryptoOpenAsyncData;
+
+static void crypto_open_async_data_free (CryptoOpenAsyncData *data) {
+    g_free (data->device);
+    g_free (data->name);
+    g_free (data->passphrase);
+    g_free (data->key_file);
+    g_free (data);
+}
+
+static void crypto_open_async_thread (GTask *task, gpointer source_object __attribute__((unused)), gpointer task_data, GCancellable *cancellable __attribute__((unused))) {
+    CryptoOpenAsyncData *data = (CryptoOpenAsyncData *) task_data;
+    GError *l_error = NULL;
+
+    if (g_task_return_error_if_cancelled (task))
+        return;
+
+    if (!bd_crypto_luks_open (data->device, data->name, data->passphrase, data->key_file,
+                              data->read_only, &l_error))
+        g_task_return_error (task, l_error);
+    else
+        g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * bd_crypto_luks_open_async:
+ * @device: the device to open
+ * @name: name for the LUKS device
+ * @passphrase: (allow-none): passphrase to open the @device or %NULL
+ * @key_file: (allow-none): key file path to use for opening the @device or %NULL
+ * @read_only: whether to open as read-only or not (meaning read-write)
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): function to call when the open is done
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Asynchronous variant of bd_crypto_luks_open(). The open (which pays a full
+ * key derivation, for argon2 deliberately taking the PBKDF time cost) runs in
+ * a worker thread so the caller is not blocked for its duration. Call
+ * bd_crypto_luks_open_finish() from @callback to get the result.
+ *
+ * One of @passphrase, @key_file has to be != %NULL.
+ *
+ * Returns: whether the open was successfully started or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ */
+gboolean bd_crypto_luks_open_async (const gchar *device, const gchar *name, const gchar *passphrase, const gchar *key_file, gboolean read_only, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error UNUSED) {
+    GTask *task = NULL;
+    CryptoOpenAsyncData *data = NULL;
+
+    data = g_new0 (CryptoOpenAsyncData, 1);
+    data->device = g_strdup (device);
+    data->name = g_strdup (name);
+    data->passphrase = g_strdup (passphrase);
+    data->key_file = g_strdup (key_file);
+    data->read_only = read_only;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, bd_crypto_luks_open_async);
+    g_task_set_task_data (task, data, (GDestroyNotify) crypto_open_async_data_free);
+    g_task_run_in_thread (task, crypto_open_async_thread);
+    g_object_unref (task);
+
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_open_finish:
+ * @result: a #GAsyncResult obtained from the #GAsyncReadyCallback passed to
+ *          bd_crypto_luks_open_async()
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: whether the device was successfully opened or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ */
+gboolean bd_crypto_luks_open_finish (GAsyncResult *result, GError **error) {
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * bd_crypto_luks_open_keyring:
  * @device: the device to open
@@ -1252,6 +1675,81 @@ gboolean bd_crypto_luks_close (const gchar *luks_device, GError **error) {
     return _crypto_close (luks_device, "LUKS", error);
 }
 
+/**
+ * bd_crypto_device_open:
+ * @device: the device to open
+ * @error: (out): place to store error (if any)
+ *
+ * Opens the given LUKS @device and keeps its metadata loaded in memory so a
+ * series of keyslot/info operations on the same device (see the
+ * bd_crypto_luks_device_* functions) doesn't re-read and re-parse the header
+ * for every single call. The handle holds the device open, close it with
+ * bd_crypto_device_close() (or bd_crypto_device_free()) as soon as it is no
+ * longer needed. The handle is not thread-safe, calls using the same handle
+ * have to be serialized by the caller.
+ *
+ * Returns: (transfer full): a handle for @device or %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+BDCryptoDevice* bd_crypto_device_open (const gchar *device, GError **error) {
+    struct crypt_device *cd = NULL;
+    BDCryptoDevice *handle = NULL;
+    gint ret = 0;
+
+    ret = crypt_init (&cd, device);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        return NULL;
+    }
+
+    ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        return NULL;
+    }
+
+    handle = g_new0 (BDCryptoDevice, 1);
+    handle->cd = cd;
+    handle->spec = g_strdup (device);
+    handle->ref_count = 1;
+
+    return handle;
+}
+
+/**
+ * bd_crypto_device_close:
+ * @device: the handle to close
+ * @error: (out): place to store error (if any)
+ *
+ * Releases one reference to @device, closing the underlying device when the
+ * last reference (see bd_crypto_device_copy()) is gone.
+ *
+ * Returns: whether the handle was successfully closed or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+gboolean bd_crypto_device_close (BDCryptoDevice *device, GError **error UNUSED) {
+    bd_crypto_device_free (device);
+    return TRUE;
+}
+
+static gboolean _luks_add_key (struct crypt_device *cd, const guint8 *pass_data, gsize data_len, const guint8 *npass_data, gsize ndata_len, GError **error) {
+    gint ret = 0;
+
+    ret = crypt_keyslot_add_by_passphrase (cd, CRYPT_ANY_SLOT, (char*) pass_data, data_len, (char*) npass_data, ndata_len);
+    if (ret < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_ADD_KEY,
+                     "Failed to add key: %s", strerror_l(-ret, c_locale));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /**
  * bd_crypto_luks_add_key_blob:
  * @device: device to add new key to
@@ -1270,6 +1768,7 @@ gboolean bd_crypto_luks_add_key_blob (const gchar *device, const guint8 *pass_da
     gint ret = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
+    gboolean success = FALSE;
 
     msg = g_strdup_printf ("Started adding key to the LUKS device '%s'", device);
     progress_id = bd_utils_report_started (msg);
@@ -1292,19 +1791,10 @@ gboolean bd_crypto_luks_add_key_blob (const gchar *device, const guint8 *pass_da
         return FALSE;
     }
 
-    ret = crypt_keyslot_add_by_passphrase (cd, CRYPT_ANY_SLOT, (char*) pass_data, data_len, (char*) npass_data, ndata_len);
-
-    if (ret < 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_ADD_KEY,
-                     "Failed to add key: %s", strerror_l(-ret, c_locale));
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, (*error)->message);
-        return FALSE;
-    }
-
+    success = _luks_add_key (cd, pass_data, data_len, npass_data, ndata_len, error);
     crypt_free (cd);
-    bd_utils_report_finished (progress_id, "Completed");
-    return TRUE;
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
 }
 
 /**
@@ -1373,9 +1863,59 @@ gboolean bd_crypto_luks_add_key (const gchar *device, const gchar *pass, const g
 }
 
 /**
- * bd_crypto_luks_remove_key_blob:
- * @device: device to add new key to
- * @pass_data: (array length=data_len): a passphrase for the new LUKS device (may contain arbitrary binary data) to remove
+ * bd_crypto_luks_device_add_key:
+ * @device: an opened device handle (see bd_crypto_device_open())
+ * @pass_data: (array length=data_len): an existing passphrase for the device (may contain arbitrary binary data)
+ * @data_len: length of the @pass_data buffer
+ * @npass_data: (array length=ndata_len): a new passphrase to add (may contain arbitrary binary data)
+ * @ndata_len: length of the @npass_data buffer
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_crypto_luks_add_key_blob() working on an opened device handle
+ * so the device's metadata is loaded only once for any number of operations.
+ *
+ * Returns: whether the @npass_data was successfully added to @device or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_ADD_KEY
+ */
+gboolean bd_crypto_luks_device_add_key (BDCryptoDevice *device, const guint8 *pass_data, gsize data_len, const guint8 *npass_data, gsize ndata_len, GError **error) {
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    gboolean success = FALSE;
+
+    msg = g_strdup_printf ("Started adding key to the LUKS device '%s'", device->spec);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    success = _luks_add_key ((struct crypt_device *) device->cd, pass_data, data_len, npass_data, ndata_len, error);
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
+}
+
+static gboolean _luks_remove_key (struct crypt_device *cd, const guint8 *pass_data, gsize data_len, GError **error) {
+    gint ret = 0;
+
+    ret = crypt_activate_by_passphrase (cd, NULL, CRYPT_ANY_SLOT, (char*) pass_data, data_len, 0);
+    if (ret < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEY_SLOT,
+                     "Failed to determine key slot: %s", strerror_l(-ret, c_locale));
+        return FALSE;
+    }
+
+    ret = crypt_keyslot_destroy (cd, ret);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_REMOVE_KEY,
+                     "Failed to remove key: %s", strerror_l(-ret, c_locale));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_remove_key_blob:
+ * @device: device to add new key to
+ * @pass_data: (array length=data_len): a passphrase for the new LUKS device (may contain arbitrary binary data) to remove
  * @data_len: length of the @pass_data buffer
  * @error: (out): place to store error (if any)
  *
@@ -1390,6 +1930,7 @@ gboolean bd_crypto_luks_remove_key_blob (const gchar *device, const guint8 *pass
     gint ret = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
+    gboolean success = FALSE;
 
     msg = g_strdup_printf ("Started removing key from the LUKS device '%s'", device);
     progress_id = bd_utils_report_started (msg);
@@ -1412,27 +1953,10 @@ gboolean bd_crypto_luks_remove_key_blob (const gchar *device, const guint8 *pass
         return FALSE;
     }
 
-    ret = crypt_activate_by_passphrase (cd, NULL, CRYPT_ANY_SLOT, (char*) pass_data, data_len, 0);
-    if (ret < 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEY_SLOT,
-                     "Failed to determine key slot: %s", strerror_l(-ret, c_locale));
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, (*error)->message);
-        return FALSE;
-    }
-
-    ret = crypt_keyslot_destroy (cd, ret);
-    if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_REMOVE_KEY,
-                     "Failed to remove key: %s", strerror_l(-ret, c_locale));
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, (*error)->message);
-        return FALSE;
-    }
-
+    success = _luks_remove_key (cd, pass_data, data_len, error);
     crypt_free (cd);
-    bd_utils_report_finished (progress_id, "Completed");
-    return TRUE;
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
 }
 
 /**
@@ -1474,6 +1998,54 @@ gboolean bd_crypto_luks_remove_key (const gchar *device, const gchar *pass, cons
     return success;
 }
 
+/**
+ * bd_crypto_luks_device_remove_key:
+ * @device: an opened device handle (see bd_crypto_device_open())
+ * @pass_data: (array length=data_len): a passphrase of the keyslot to remove (may contain arbitrary binary data)
+ * @data_len: length of the @pass_data buffer
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_crypto_luks_remove_key_blob() working on an opened device
+ * handle so the device's metadata is loaded only once for any number of
+ * operations.
+ *
+ * Returns: whether the key was successfully removed or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_REMOVE_KEY
+ */
+gboolean bd_crypto_luks_device_remove_key (BDCryptoDevice *device, const guint8 *pass_data, gsize data_len, GError **error) {
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    gboolean success = FALSE;
+
+    msg = g_strdup_printf ("Started removing key from the LUKS device '%s'", device->spec);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    success = _luks_remove_key ((struct crypt_device *) device->cd, pass_data, data_len, error);
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
+}
+
+static gboolean _luks_change_key (struct crypt_device *cd, const guint8 *pass_data, gsize data_len, const guint8 *npass_data, gsize ndata_len, GError **error) {
+    gint ret = 0;
+
+    ret = crypt_keyslot_change_by_passphrase (cd, CRYPT_ANY_SLOT, CRYPT_ANY_SLOT,
+                                              (char*) pass_data, data_len,
+                                              (char*) npass_data, ndata_len);
+    if (ret < 0) {
+        if (ret == -EPERM)
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to change the passphrase: No keyslot with given passphrase found.");
+        else
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_ADD_KEY,
+                         "Failed to change the passphrase: %s", strerror_l (-ret, c_locale));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /**
  * bd_crypto_luks_change_key_blob:
  * @device: device to change key of
@@ -1492,6 +2064,7 @@ gboolean bd_crypto_luks_change_key_blob (const gchar *device, const guint8 *pass
     gint ret = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
+    gboolean success = FALSE;
 
     msg = g_strdup_printf ("Started changing key on the LUKS device '%s'", device);
     progress_id = bd_utils_report_started (msg);
@@ -1514,24 +2087,10 @@ gboolean bd_crypto_luks_change_key_blob (const gchar *device, const guint8 *pass
         return FALSE;
     }
 
-    ret = crypt_keyslot_change_by_passphrase (cd, CRYPT_ANY_SLOT, CRYPT_ANY_SLOT,
-                                              (char*) pass_data, data_len,
-                                              (char*) npass_data, ndata_len);
-    if (ret < 0) {
-        if (ret == -EPERM)
-            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                         "Failed to change the passphrase: No keyslot with given passphrase found.");
-        else
-            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_ADD_KEY,
-                         "Failed to change the passphrase: %s", strerror_l (-ret, c_locale));
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, (*error)->message);
-        return FALSE;
-    }
-
+    success = _luks_change_key (cd, pass_data, data_len, npass_data, ndata_len, error);
     crypt_free (cd);
-    bd_utils_report_finished (progress_id, "Completed");
-    return TRUE;
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
 }
 
 /**
@@ -1551,6 +2110,37 @@ gboolean bd_crypto_luks_change_key (const gchar *device, const gchar *pass, cons
     return bd_crypto_luks_change_key_blob (device, (guint8*) pass, strlen (pass), (guint8*) npass, strlen (npass), error);
 }
 
+/**
+ * bd_crypto_luks_device_change_key:
+ * @device: an opened device handle (see bd_crypto_device_open())
+ * @pass_data: (array length=data_len): an existing passphrase to change (may contain arbitrary binary data)
+ * @data_len: length of the @pass_data buffer
+ * @npass_data: (array length=ndata_len): a new passphrase to change it to (may contain arbitrary binary data)
+ * @ndata_len: length of the @npass_data buffer
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_crypto_luks_change_key_blob() working on an opened device
+ * handle so the device's metadata is loaded only once for any number of
+ * operations.
+ *
+ * Returns: whether the key was successfully changed or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_ADD_KEY&%BD_CRYPTO_TECH_MODE_REMOVE_KEY
+ */
+gboolean bd_crypto_luks_device_change_key (BDCryptoDevice *device, const guint8 *pass_data, gsize data_len, const guint8 *npass_data, gsize ndata_len, GError **error) {
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    gboolean success = FALSE;
+
+    msg = g_strdup_printf ("Started changing key on the LUKS device '%s'", device->spec);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    success = _luks_change_key ((struct crypt_device *) device->cd, pass_data, data_len, npass_data, ndata_len, error);
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
+}
+
 static gboolean luks_resize (const gchar *luks_device, guint64 size, const guint8 *pass_data, gsize data_len, const gchar *key_file, GError **error) {
     struct crypt_device *cd = NULL;
     struct crypt_active_device cad;
@@ -1846,6 +2436,19 @@ gboolean bd_crypto_luks_resume (const gchar *luks_device, const gchar *passphras
     return luks_resume (luks_device, (guint8*) passphrase, passphrase ? strlen (passphrase) : 0, key_file, error);
 }
 
+static gboolean _luks_kill_slot (struct crypt_device *cd, gint slot, GError **error) {
+    gint ret = 0;
+
+    ret = crypt_keyslot_destroy (cd, slot);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to destroy keyslot: %s", strerror_l (-ret, c_locale));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /**
  * bd_crypto_luks_kill_slot:
  * @device: device to kill slot on
@@ -1864,6 +2467,7 @@ gboolean bd_crypto_luks_kill_slot (const gchar *device, gint slot, GError **erro
     gint ret = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
+    gboolean success = FALSE;
 
     msg = g_strdup_printf ("Started killing slot %d on LUKS device '%s'", slot, device);
     progress_id = bd_utils_report_started (msg);
@@ -1886,18 +2490,40 @@ gboolean bd_crypto_luks_kill_slot (const gchar *device, gint slot, GError **erro
         return FALSE;
     }
 
-    ret = crypt_keyslot_destroy (cd, slot);
-    if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to destroy keyslot: %s", strerror_l (-ret, c_locale));
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, (*error)->message);
-        return FALSE;
-    }
-
+    success = _luks_kill_slot (cd, slot, error);
     crypt_free (cd);
-    bd_utils_report_finished (progress_id, "Completed");
-    return TRUE;
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
+}
+
+/**
+ * bd_crypto_luks_device_kill_slot:
+ * @device: an opened device handle (see bd_crypto_device_open())
+ * @slot: keyslot to destroy
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_crypto_luks_kill_slot() working on an opened device handle so
+ * the device's metadata is loaded only once for any number of operations.
+ *
+ * Note: This can destroy last remaining keyslot without confirmation making
+ *       the LUKS device permanently inaccessible.
+ *
+ * Returns: whether the given @slot was successfully destroyed or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_REMOVE_KEY
+ */
+gboolean bd_crypto_luks_device_kill_slot (BDCryptoDevice *device, gint slot, GError **error) {
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    gboolean success = FALSE;
+
+    msg = g_strdup_printf ("Started killing slot %d on LUKS device '%s'", slot, device->spec);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    success = _luks_kill_slot ((struct crypt_device *) device->cd, slot, error);
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
 }
 
 /**
@@ -1997,40 +2623,144 @@ gboolean bd_crypto_luks_header_restore (const gchar *device, const gchar *backup
 }
 
 /**
- * bd_crypto_luks_info:
- * @device: a device to get information about
+ * bd_crypto_luks_reencrypt:
+ * @device: device to reencrypt (the underlying block device with the LUKS 2 header)
+ * @name: (allow-none): name of the active (mapped) device for online reencryption
+ *                      or %NULL if @device is not active
+ * @pass_data: (array length=data_len): a passphrase for @device (may contain arbitrary binary data)
+ * @data_len: length of the @pass_data buffer
+ * @max_write_speed: maximum reencryption write speed in MiB/s or 0 for no throttling
  * @error: (out): place to store error (if any)
  *
- * Returns: information about the @device or %NULL in case of error
+ * Reencrypts the data on @device in place with a new volume key (keeping the
+ * cipher), making volume key rotation a background operation instead of an
+ * outage. The reencryption state lives in the LUKS 2 metadata ("checksum"
+ * resilience), so an interrupted or crashed run is resumed from its last
+ * checkpoint by simply calling this function again. Progress is reported
+ * through the standard progress reporting machinery.
  *
- * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_QUERY
+ * Tech category: %BD_CRYPTO_TECH_LUKS2-%BD_CRYPTO_TECH_MODE_REENCRYPT
+ *
+ * Returns: whether the @device was successfully reencrypted or not
  */
-BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error) {
+#ifndef LIBCRYPTSETUP_REENCRYPT
+gboolean bd_crypto_luks_reencrypt (const gchar *device __attribute__((unused)), const gchar *name __attribute__((unused)), const guint8 *pass_data __attribute__((unused)), gsize data_len __attribute__((unused)), guint32 max_write_speed __attribute__((unused)), GError **error) {
+    g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
+                 "LUKS 2 reencryption requires libcryptsetup >= 2.4");
+    return FALSE;
+}
+#else
+typedef struct CryptoReencryptProgress {
+    guint64 progress_id;
+    guint32 max_write_speed;    /* MiB/s, 0 = unlimited */
+    gint64 start_time;          /* monotonic, microseconds */
+    guint64 start_offset;
+    gboolean started;
+} CryptoReencryptProgress;
+
+static int reencrypt_progress (uint64_t size, uint64_t offset, void *usrptr) {
+    CryptoReencryptProgress *prog = (CryptoReencryptProgress *) usrptr;
+
+    if (!prog->started) {
+        /* on resume @offset starts at the checkpoint, not at 0 */
+        prog->start_offset = offset;
+        prog->start_time = g_get_monotonic_time ();
+        prog->started = TRUE;
+    }
+
+    bd_utils_report_progress (prog->progress_id, size ? (guint8) (offset * 100 / size) : 0, "Reencrypting");
+
+    if (prog->max_write_speed != 0) {
+        guint64 done = offset - prog->start_offset;
+        gint64 min_elapsed = (gint64) (done / (prog->max_write_speed * 1048576.0) * G_USEC_PER_SEC);
+        gint64 elapsed = g_get_monotonic_time () - prog->start_time;
+
+        if (elapsed < min_elapsed)
+            g_usleep (min_elapsed - elapsed);
+    }
+
+    return 0;
+}
+
+gboolean bd_crypto_luks_reencrypt (const gchar *device, const gchar *name, const guint8 *pass_data, gsize data_len, guint32 max_write_speed, GError **error) {
     struct crypt_device *cd = NULL;
-    BDCryptoLUKSInfo *info = NULL;
-    const gchar *version = NULL;
-    gint ret;
+    struct crypt_params_reencrypt params = ZERO_INIT;
+    struct crypt_params_luks2 luks2_params = ZERO_INIT;
+    CryptoReencryptProgress prog = ZERO_INIT;
+    crypt_reencrypt_info reenc_info;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    gint ret = 0;
+
+    msg = g_strdup_printf ("Started reencryption of LUKS device '%s'", device);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
 
     ret = crypt_init (&cd, device);
     if (ret != 0) {
-        /* not a block device, try init_by_name */
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    ret = crypt_load (cd, CRYPT_LUKS2, NULL);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device's parameters (LUKS 2 is required for reencryption): %s",
+                     strerror_l (-ret, c_locale));
         crypt_free (cd);
-        ret = crypt_init_by_name (&cd, device);
-    } else {
-        ret = crypt_load (cd, CRYPT_LUKS, NULL);
-        if (ret != 0) {
-            /* not a LUKS device, try init_by_name */
-            crypt_free (cd);
-            ret = crypt_init_by_name (&cd, device);
-        }
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    params.mode = CRYPT_REENCRYPT_REENCRYPT;
+    params.direction = CRYPT_REENCRYPT_FORWARD;
+    params.resilience = "checksum";
+    params.hash = "sha256";
+    luks2_params.sector_size = crypt_get_sector_size (cd);
+    params.luks2 = &luks2_params;
+
+    /* a previous (interrupted) reencryption is recorded in the metadata,
+       just pick it up at its last checkpoint */
+    reenc_info = crypt_reencrypt_status (cd, NULL);
+    if (reenc_info == CRYPT_REENCRYPT_CLEAN || reenc_info == CRYPT_REENCRYPT_CRASH)
+        params.flags |= CRYPT_REENCRYPT_RESUME_ONLY;
+
+    ret = crypt_reencrypt_init_by_passphrase (cd, name, (const char *) pass_data, data_len,
+                                              CRYPT_ANY_SLOT, CRYPT_ANY_SLOT,
+                                              crypt_get_cipher (cd), crypt_get_cipher_mode (cd),
+                                              &params);
+    if (ret < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize reencryption: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
     }
 
+    prog.progress_id = progress_id;
+    prog.max_write_speed = max_write_speed;
+
+    ret = crypt_reencrypt_run (cd, reencrypt_progress, &prog);
     if (ret != 0) {
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
-        return NULL;
+                     "Failed to reencrypt device: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
     }
 
+    crypt_free (cd);
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
+#endif
+
+static BDCryptoLUKSInfo* _luks_info (struct crypt_device *cd, GError **error) {
+    BDCryptoLUKSInfo *info = NULL;
+    const gchar *version = NULL;
+
     info = g_new0 (BDCryptoLUKSInfo, 1);
 
     version = crypt_get_type (cd);
@@ -2058,10 +2788,64 @@ BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error) {
     info->sector_size = 0;
 #endif
 
+    return info;
+}
+
+/**
+ * bd_crypto_luks_info:
+ * @device: a device to get information about
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: information about the @device or %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error) {
+    struct crypt_device *cd = NULL;
+    BDCryptoLUKSInfo *info = NULL;
+    gint ret;
+
+    ret = crypt_init (&cd, device);
+    if (ret != 0) {
+        /* not a block device, try init_by_name */
+        crypt_free (cd);
+        ret = crypt_init_by_name (&cd, device);
+    } else {
+        ret = crypt_load (cd, CRYPT_LUKS, NULL);
+        if (ret != 0) {
+            /* not a LUKS device, try init_by_name */
+            crypt_free (cd);
+            ret = crypt_init_by_name (&cd, device);
+        }
+    }
+
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        return NULL;
+    }
+
+    info = _luks_info (cd, error);
     crypt_free (cd);
     return info;
 }
 
+/**
+ * bd_crypto_luks_device_info:
+ * @device: an opened device handle (see bd_crypto_device_open())
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_crypto_luks_info() working on an opened device handle so the
+ * device's metadata is loaded only once for any number of operations.
+ *
+ * Returns: information about the @device or %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+BDCryptoLUKSInfo* bd_crypto_luks_device_info (BDCryptoDevice *device, GError **error) {
+    return _luks_info ((struct crypt_device *) device->cd, error);
+}
+
 /**
  * bd_crypto_integrity_info:
  * @device: a device to get information about
@@ -2152,9 +2936,24 @@ static int crypt_token_max (const char *type __attribute__((unused))) {
 BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device __attribute__((unused)), GError **error) {
     return NULL;
 }
+
+/**
+ * bd_crypto_luks_device_token_info:
+ * @device: an opened device handle (see bd_crypto_device_open())
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_crypto_luks_token_info() working on an opened device handle so
+ * the device's metadata is loaded only once for any number of operations.
+ *
+ * Returns: (array zero-terminated=1): information about tokens on @device
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+BDCryptoLUKSTokenInfo** bd_crypto_luks_device_token_info (BDCryptoDevice *device __attribute__((unused)), GError **error) {
+    return NULL;
+}
 #else
-BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError **error) {
-    struct crypt_device *cd = NULL;
+static BDCryptoLUKSTokenInfo** _luks_token_info (struct crypt_device *cd) {
     GPtrArray *tokens = NULL;
     BDCryptoLUKSTokenInfo *info = NULL;
     crypt_token_info token_info;
@@ -2162,30 +2961,8 @@ BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError *
     gint ret;
     gint token_it, keyslot_it;
 
-    ret = crypt_init (&cd, device);
-    if (ret != 0) {
-        /* not a block device, try init_by_name */
-        crypt_free (cd);
-        ret = crypt_init_by_name (&cd, device);
-    } else {
-        ret = crypt_load (cd, CRYPT_LUKS, NULL);
-        if (ret != 0) {
-            /* not a LUKS device, try init_by_name */
-            crypt_free (cd);
-            ret = crypt_init_by_name (&cd, device);
-        }
-    }
-
-    if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+    if (g_strcmp0 (crypt_get_type (cd), CRYPT_LUKS2) != 0)
         return NULL;
-    }
-
-    if (g_strcmp0 (crypt_get_type (cd), CRYPT_LUKS2) != 0) {
-        crypt_free (cd);
-        return NULL;
-    }
 
     tokens = g_ptr_array_new ();
 
@@ -2210,12 +2987,44 @@ BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError *
         g_ptr_array_add (tokens, info);
     }
 
-    crypt_free (cd);
-
     /* returning NULL-terminated array of BDCryptoLUKSTokenInfo */
     g_ptr_array_add (tokens, NULL);
     return (BDCryptoLUKSTokenInfo **) g_ptr_array_free (tokens, FALSE);
 }
+
+BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError **error) {
+    struct crypt_device *cd = NULL;
+    BDCryptoLUKSTokenInfo **info = NULL;
+    gint ret;
+
+    ret = crypt_init (&cd, device);
+    if (ret != 0) {
+        /* not a block device, try init_by_name */
+        crypt_free (cd);
+        ret = crypt_init_by_name (&cd, device);
+    } else {
+        ret = crypt_load (cd, CRYPT_LUKS, NULL);
+        if (ret != 0) {
+            /* not a LUKS device, try init_by_name */
+            crypt_free (cd);
+            ret = crypt_init_by_name (&cd, device);
+        }
+    }
+
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        return NULL;
+    }
+
+    info = _luks_token_info (cd);
+    crypt_free (cd);
+    return info;
+}
+
+BDCryptoLUKSTokenInfo** bd_crypto_luks_device_token_info (BDCryptoDevice *device, GError **error __attribute__((unused))) {
+    return _luks_token_info ((struct crypt_device *) device->cd);
+}
 #endif
 
 /**
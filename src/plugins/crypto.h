@@ -56,6 +56,7 @@ typedef enum {
     BD_CRYPTO_TECH_MODE_RESIZE         = 1 << 5,
     BD_CRYPTO_TECH_MODE_SUSPEND_RESUME = 1 << 6,
     BD_CRYPTO_TECH_MODE_BACKUP_RESTORE = 1 << 7,
+    BD_CRYPTO_TECH_MODE_REENCRYPT      = 1 << 8,
 } BDCryptoTechMode;
 
 typedef enum {
@@ -176,6 +177,24 @@ typedef struct BDCryptoLUKSTokenInfo {
 void bd_crypto_luks_token_info_free (BDCryptoLUKSTokenInfo *info);
 BDCryptoLUKSTokenInfo* bd_crypto_luks_token_info_copy (BDCryptoLUKSTokenInfo *info);
 
+/**
+ * BDCryptoDevice:
+ *
+ * An opened crypto device handle keeping the device's (LUKS) metadata loaded
+ * in memory so a series of operations on the same device doesn't re-read and
+ * re-parse the header for every single call. The members are private, use the
+ * bd_crypto_device_* and bd_crypto_luks_device_* functions to work with the
+ * handle.
+ */
+typedef struct BDCryptoDevice {
+    gpointer cd;
+    gchar *spec;
+    gint ref_count;
+} BDCryptoDevice;
+
+void bd_crypto_device_free (BDCryptoDevice *device);
+BDCryptoDevice* bd_crypto_device_copy (BDCryptoDevice *device);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -200,10 +219,24 @@ gboolean bd_crypto_luks_format (const gchar *device, const gchar *cipher, guint6
 gboolean bd_crypto_luks_format_blob (const gchar *device, const gchar *cipher, guint64 key_size, const guint8 *pass_data, gsize data_len, guint64 min_entropy, GError **error);
 gboolean bd_crypto_luks_format_luks2 (const gchar *device, const gchar *cipher, guint64 key_size, const gchar *passphrase, const gchar *key_file, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra,GError **error);
 gboolean bd_crypto_luks_format_luks2_blob (const gchar *device, const gchar *cipher, guint64 key_size, const guint8 *pass_data, gsize data_len, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra, GError **error);
+BDCryptoLUKSPBKDF* bd_crypto_pbkdf_benchmark (BDCryptoLUKSPBKDF *pbkdf, GError **error);
+gboolean bd_crypto_luks_format_async (const gchar *device, const gchar *cipher, guint64 key_size, const gchar *passphrase, const gchar *key_file, guint64 min_entropy, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error);
+gboolean bd_crypto_luks_format_luks2_async (const gchar *device, const gchar *cipher, guint64 key_size, const gchar *passphrase, const gchar *key_file, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error);
+gboolean bd_crypto_luks_format_finish (GAsyncResult *result, GError **error);
 gboolean bd_crypto_luks_open (const gchar *device, const gchar *name, const gchar *passphrase, const gchar *key_file, gboolean read_only, GError **error);
 gboolean bd_crypto_luks_open_blob (const gchar *device, const gchar *name, const guint8* pass_data, gsize data_len, gboolean read_only, GError **error);
+gboolean bd_crypto_luks_open_async (const gchar *device, const gchar *name, const gchar *passphrase, const gchar *key_file, gboolean read_only, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error);
+gboolean bd_crypto_luks_open_finish (GAsyncResult *result, GError **error);
 gboolean bd_crypto_luks_open_keyring (const gchar *device, const gchar *name, const gchar *key_desc, gboolean read_only, GError **error);
 gboolean bd_crypto_luks_close (const gchar *luks_device, GError **error);
+BDCryptoDevice* bd_crypto_device_open (const gchar *device, GError **error);
+gboolean bd_crypto_device_close (BDCryptoDevice *device, GError **error);
+gboolean bd_crypto_luks_device_add_key (BDCryptoDevice *device, const guint8 *pass_data, gsize data_len, const guint8 *npass_data, gsize ndata_len, GError **error);
+gboolean bd_crypto_luks_device_remove_key (BDCryptoDevice *device, const guint8 *pass_data, gsize data_len, GError **error);
+gboolean bd_crypto_luks_device_change_key (BDCryptoDevice *device, const guint8 *pass_data, gsize data_len, const guint8 *npass_data, gsize ndata_len, GError **error);
+gboolean bd_crypto_luks_device_kill_slot (BDCryptoDevice *device, gint slot, GError **error);
+BDCryptoLUKSInfo* bd_crypto_luks_device_info (BDCryptoDevice *device, GError **error);
+BDCryptoLUKSTokenInfo** bd_crypto_luks_device_token_info (BDCryptoDevice *device, GError **error);
 gboolean bd_crypto_luks_add_key (const gchar *device, const gchar *pass, const gchar *key_file, const gchar *npass, const gchar *nkey_file, GError **error);
 gboolean bd_crypto_luks_add_key_blob (const gchar *device, const guint8 *pass_data, gsize data_len, const guint8 *npass_data, gsize ndata_len, GError **error);
 gboolean bd_crypto_luks_remove_key (const gchar *device, const gchar *pass, const gchar *key_file, GError **error);
@@ -219,6 +252,7 @@ gboolean bd_crypto_luks_resume (const gchar *luks_device, const gchar *passphras
 gboolean bd_crypto_luks_kill_slot (const gchar *device, gint slot, GError **error);
 gboolean bd_crypto_luks_header_backup (const gchar *device, const gchar *backup_file, GError **error);
 gboolean bd_crypto_luks_header_restore (const gchar *device, const gchar *backup_file, GError **error);
+gboolean bd_crypto_luks_reencrypt (const gchar *device, const gchar *name, const guint8 *pass_data, gsize data_len, guint32 max_write_speed, GError **error);
 
 BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error);
 BDCryptoIntegrityInfo* bd_crypto_integrity_info (const gchar *device, GError **error);
@@ -19,6 +19,8 @@
 
 #include <glib.h>
 #include <unistd.h>
+/* provides major and minor macros */
+#include <sys/sysmacros.h>
 #include <blockdev/utils.h>
 #include <libdevmapper.h>
 #include <stdarg.h>
@@ -59,6 +61,43 @@ GQuark bd_dm_error_quark (void)
     return g_quark_from_static_string ("g-bd-dm-error-quark");
 }
 
+/**
+ * bd_dm_map_info_copy: (skip)
+ *
+ * Creates a new copy of @data.
+ */
+BDDMMapInfo* bd_dm_map_info_copy (BDDMMapInfo *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDDMMapInfo *new = g_new0 (BDDMMapInfo, 1);
+    new->name = g_strdup (data->name);
+    new->uuid = g_strdup (data->uuid);
+    new->major = data->major;
+    new->minor = data->minor;
+    new->live_table = data->live_table;
+    new->suspended = data->suspended;
+    new->read_only = data->read_only;
+    new->target_type = g_strdup (data->target_type);
+
+    return new;
+}
+
+/**
+ * bd_dm_map_info_free: (skip)
+ *
+ * Frees @data.
+ */
+void bd_dm_map_info_free (BDDMMapInfo *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->name);
+    g_free (data->uuid);
+    g_free (data->target_type);
+    g_free (data);
+}
+
 typedef struct raid_set* (*RSEvalFunc) (struct raid_set *rs, gpointer data);
 
 
@@ -398,6 +437,102 @@ gboolean bd_dm_map_exists (const gchar *map_name, gboolean live_only, gboolean a
     return ret;
 }
 
+/**
+ * bd_dm_get_all_maps:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): information about all
+ * the existing DM maps or %NULL in case of error
+ *
+ * Enumerates the maps and queries their status in a single sweep -- one
+ * DM_DEVICE_LIST followed by one status task per map -- so that callers
+ * interested in the whole topology don't have to issue a separate ioctl
+ * sequence for every map. Maps that disappear during the sweep are skipped.
+ *
+ * Tech category: %BD_DM_TECH_MAP-%BD_DM_TECH_MODE_QUERY
+ */
+BDDMMapInfo** bd_dm_get_all_maps (GError **error) {
+    struct dm_task *task_list = NULL;
+    struct dm_task *task_status = NULL;
+    struct dm_names *names = NULL;
+    struct dm_info info;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *target_type = NULL;
+    gchar *params = NULL;
+    const gchar *uuid = NULL;
+    guint64 next = 0;
+    GPtrArray *maps = NULL;
+    BDDMMapInfo *map = NULL;
+
+    if (geteuid () != 0) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_NOT_ROOT,
+                     "Not running as root, cannot query DM maps");
+        return NULL;
+    }
+
+    task_list = dm_task_create(DM_DEVICE_LIST);
+    if (!task_list) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
+                     "Failed to create DM task");
+        return NULL;
+    }
+
+    dm_task_run(task_list);
+    names = dm_task_get_names(task_list);
+
+    maps = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_dm_map_info_free);
+
+    if (names && names->dev) {
+        do {
+            names = (void *)names + next;
+            next = names->next;
+
+            /* a single status task gives us the info, the UUID and the
+               target type of the map */
+            task_status = dm_task_create(DM_DEVICE_STATUS);
+            if (!task_status) {
+                g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
+                             "Failed to create DM task");
+                g_ptr_array_free (maps, TRUE);
+                dm_task_destroy (task_list);
+                return NULL;
+            }
+
+            /* something failed or the map disappeared in the meantime, try
+               the next one */
+            if ((dm_task_set_name (task_status, names->name) == 0) ||
+                (dm_task_run (task_status) == 0) ||
+                (dm_task_get_info (task_status, &info) == 0) ||
+                !info.exists) {
+                dm_task_destroy (task_status);
+                continue;
+            }
+
+            map = g_new0 (BDDMMapInfo, 1);
+            map->name = g_strdup (names->name);
+            uuid = dm_task_get_uuid (task_status);
+            map->uuid = (uuid && (*uuid != '\0')) ? g_strdup (uuid) : NULL;
+            map->major = (guint64) major (names->dev);
+            map->minor = (guint64) minor (names->dev);
+            map->live_table = info.live_table;
+            map->suspended = info.suspended;
+            map->read_only = info.read_only;
+            dm_get_next_target (task_status, NULL, &start, &length, &target_type, &params);
+            map->target_type = g_strdup (target_type);
+            g_ptr_array_add (maps, map);
+
+            dm_task_destroy (task_status);
+        } while (next);
+    }
+
+    dm_task_destroy (task_list);
+
+    /* add the terminating NULL and extract the NULL-terminated array */
+    g_ptr_array_add (maps, NULL);
+    return (BDDMMapInfo**) g_ptr_array_free (maps, FALSE);
+}
+
 #ifdef WITH_BD_DMRAID
 /**
  * init_dmraid_stack: (skip)
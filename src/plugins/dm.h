@@ -26,6 +26,22 @@ typedef enum {
     BD_DM_TECH_MODE_QUERY             = 1 << 2,
 } BDDMTechMode;
 
+/* 'target_type' is the type of the map's (first) target, e.g. "linear" or
+   "multipath"; 'uuid' may be NULL if the map has no UUID set */
+typedef struct BDDMMapInfo {
+    gchar *name;
+    gchar *uuid;
+    guint64 major;
+    guint64 minor;
+    gboolean live_table;
+    gboolean suspended;
+    gboolean read_only;
+    gchar *target_type;
+} BDDMMapInfo;
+
+BDDMMapInfo* bd_dm_map_info_copy (BDDMMapInfo *data);
+void bd_dm_map_info_free (BDDMMapInfo *data);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -44,6 +60,7 @@ gboolean bd_dm_is_tech_avail (BDDMTech tech, guint64 mode, GError **error);
 gboolean bd_dm_create_linear (const gchar *map_name, const gchar *device, guint64 length, const gchar *uuid, GError **error);
 gboolean bd_dm_remove (const gchar *map_name, GError **error);
 gboolean bd_dm_map_exists (const gchar *map_name, gboolean live_only, gboolean active_only, GError **error);
+BDDMMapInfo** bd_dm_get_all_maps (GError **error);
 gchar* bd_dm_name_from_node (const gchar *dm_node, GError **error);
 gchar* bd_dm_node_from_name (const gchar *map_name, GError **error);
 gchar* bd_dm_get_subsystem_from_name (const gchar *device_name, GError **error);
@@ -186,7 +186,14 @@ gboolean bd_fs_init (void) {
  *
  */
 void bd_fs_close (void) {
-    /* nothing to do here */
+    /* stop the probe cache and its udev watch thread (if running) */
+    bd_fs_set_probe_cache (FALSE, NULL);
+
+    /* drop the cached mountinfo table */
+    fs_mount_table_cleanup ();
+
+    /* drop the cached capability matrix */
+    fs_capabilities_cleanup ();
 }
 
 /**
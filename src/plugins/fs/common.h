@@ -4,6 +4,31 @@
 #ifndef BD_FS_COMMON
 #define BD_FS_COMMON
 
+/* machinery shared by the *_many functions for running an operation on many
+   devices in parallel (implemented in generic.c) */
+typedef struct FsBatchTask {
+    const gchar *device;
+    gpointer op_data;
+    GError *error;
+    gboolean success;
+    struct FsBatchState *state;
+} FsBatchTask;
+
+typedef gboolean (*FsBatchOp) (FsBatchTask *task);
+
+/* state shared by all devices of a batched fs operation */
+typedef struct FsBatchState {
+    GMutex lock;
+    GCond cond;
+    guint remaining;
+    guint done;
+    guint total;
+    guint64 progress_id;
+    FsBatchOp op;
+} FsBatchState;
+
+gboolean run_fs_batch (FsBatchTask *tasks, guint count, guint max_parallel, FsBatchOp op, const gchar *verb_ing, const gchar *verb, GError **item_errors, GError **error) __attribute__ ((visibility ("hidden")));
+
 gint synced_close (gint fd);
 gboolean has_fs (blkid_probe probe, const gchar *device, const gchar *fs_type, GError **error);
 gboolean wipe_fs (const gchar *device, const gchar *fs_type, gboolean wipe_all, GError **error);
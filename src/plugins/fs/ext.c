@@ -17,6 +17,8 @@
  * Author: Vratislav Podzimek <vpodzime@redhat.com>
  */
 
+#include <ext2fs/ext2fs.h>
+
 #include <blockdev/utils.h>
 #include <check_deps.h>
 
@@ -815,6 +817,62 @@ static BDFSExtInfo* get_ext_info_from_table (GHashTable *table, gboolean free_ta
     return ret;
 }
 
+/**
+ * ext_get_info_ext2fs:
+ * @device: the device to get the info for
+ *
+ * Reads the superblock fields needed for the info directly using libext2fs
+ * instead of spawning dumpe2fs and parsing its full output (which also walks
+ * all the group descriptors).
+ *
+ * Returns: (transfer full): information about the file system on @device or
+ *                           %NULL if the superblock cannot be read (the
+ *                           dumpe2fs-based path is used as a fallback then)
+ */
+static BDFSExtInfo* ext_get_info_ext2fs (const gchar *device) {
+    ext2_filsys fs = NULL;
+    struct ext2_super_block *sb = NULL;
+    BDFSExtInfo *ret = NULL;
+    GString *state = NULL;
+    gboolean zero_uuid = TRUE;
+    guint i = 0;
+    errcode_t status = 0;
+
+    status = ext2fs_open (device, EXT2_FLAG_64BITS | EXT2_FLAG_SUPER_ONLY, 0, 0, unix_io_manager, &fs);
+    if (status != 0)
+        return NULL;
+
+    sb = fs->super;
+    ret = g_new0 (BDFSExtInfo, 1);
+
+    ret->label = g_strndup (sb->s_volume_name, sizeof (sb->s_volume_name));
+
+    for (i = 0; zero_uuid && i < sizeof (sb->s_uuid); i++)
+        zero_uuid = sb->s_uuid[i] == 0;
+    if (zero_uuid)
+        ret->uuid = g_strdup ("");
+    else
+        ret->uuid = g_strdup_printf ("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                                     sb->s_uuid[0], sb->s_uuid[1], sb->s_uuid[2], sb->s_uuid[3],
+                                     sb->s_uuid[4], sb->s_uuid[5], sb->s_uuid[6], sb->s_uuid[7],
+                                     sb->s_uuid[8], sb->s_uuid[9], sb->s_uuid[10], sb->s_uuid[11],
+                                     sb->s_uuid[12], sb->s_uuid[13], sb->s_uuid[14], sb->s_uuid[15]);
+
+    /* same strings dumpe2fs uses for the state */
+    state = g_string_new ((sb->s_state & EXT2_VALID_FS) ? "clean" : "not clean");
+    if (sb->s_state & EXT2_ERROR_FS)
+        g_string_append (state, " with errors");
+    ret->state = g_string_free (state, FALSE);
+
+    ret->block_size = fs->blocksize;
+    ret->block_count = ext2fs_blocks_count (sb);
+    ret->free_blocks = ext2fs_free_blocks_count (sb);
+
+    ext2fs_close (fs);
+
+    return ret;
+}
+
 static BDFSExtInfo* ext_get_info (const gchar *device, GError **error) {
     const gchar *args[4] = {"dumpe2fs", "-h", device, NULL};
     gboolean success = FALSE;
@@ -823,6 +881,10 @@ static BDFSExtInfo* ext_get_info (const gchar *device, GError **error) {
     guint num_items = 0;
     BDFSExtInfo *ret = NULL;
 
+    ret = ext_get_info_ext2fs (device);
+    if (ret)
+        return ret;
+
     if (!check_deps (&avail_deps, DEPS_DUMPE2FS_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return NULL;
 
@@ -893,19 +955,38 @@ BDFSExt4Info* bd_fs_ext4_get_info (const gchar *device, GError **error) {
     return (BDFSExt4Info*) ext_get_info (device, error);
 }
 
+static gboolean extract_resize2fs_progress (const gchar *line, guint8 *completion) {
+    /* with -p resize2fs announces its passes like "Begin pass 3 (max = 1234)";
+       it runs up to 5 passes so use the pass boundaries as coarse progress
+       steps (the in-pass progress bar is redrawn in place and cannot be
+       parsed line by line) */
+    guint64 pass = 0;
+
+    if (!g_str_has_prefix (line, "Begin pass "))
+        return FALSE;
+
+    pass = g_ascii_strtoull (line + 11, NULL, 10);
+    if (pass < 1 || pass > 5)
+        return FALSE;
+
+    *completion = (guint8) ((pass - 1) * 100 / 5);
+    return TRUE;
+}
+
 static gboolean ext_resize (const gchar *device, guint64 new_size, const BDExtraArg **extra, GError **error) {
-    const gchar *args[4] = {"resize2fs", device, NULL, NULL};
+    const gchar *args[5] = {"resize2fs", "-p", device, NULL, NULL};
     gboolean ret = FALSE;
+    gint status = 0;
 
     if (!check_deps (&avail_deps, DEPS_RESIZE2FS_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
     if (new_size != 0)
         /* resize2fs doesn't understand bytes, just 512B sectors */
-        args[2] = g_strdup_printf ("%"G_GUINT64_FORMAT"s", new_size / 512);
-    ret = bd_utils_exec_and_report_error (args, extra, error);
+        args[3] = g_strdup_printf ("%"G_GUINT64_FORMAT"s", new_size / 512);
+    ret = bd_utils_exec_and_report_progress (args, extra, extract_resize2fs_progress, &status, error);
 
-    g_free ((gchar *) args[2]);
+    g_free ((gchar *) args[3]);
     return ret;
 }
 
@@ -17,6 +17,8 @@
  * Author: Vratislav Podzimek <vpodzime@redhat.com>
  */
 
+#define _GNU_SOURCE
+
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <blkid.h>
@@ -26,6 +28,22 @@
 #include <sys/ioctl.h>
 #include <linux/fs.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <linux/falloc.h>
+#include <sys/sysmacros.h>
+
+/* fallbacks for old kernel headers */
+#ifndef BLKDISCARD
+#define BLKDISCARD _IO(0x12,119)
+#endif
+#ifndef BLKZEROOUT
+#define BLKZEROOUT _IO(0x12,127)
+#endif
+
+/* size of one BLKZEROOUT request; smaller requests mean finer-grained
+   progress reporting, bigger ones less ioctl overhead */
+#define ZERO_CHUNK_SIZE (1 * 1024 * 1024 * 1024ULL)
 
 #include <blockdev/utils.h>
 
@@ -104,6 +122,30 @@ get_fs_info (const gchar *type)
     return NULL;
 }
 
+
+/**
+ * bd_fs_set_probe_cache:
+ * @enabled: whether to serve repeated signature probes from an in-memory cache
+ *           or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables the library-level cache for the libblkid probe results
+ * used by bd_fs_get_fstype(). The cache is shared with the other plugins that
+ * probe device signatures (see bd_utils_set_probe_cache()): with the cache
+ * enabled repeated probes of the same device are answered from memory; cached
+ * entries are invalidated by the write operations going through the library
+ * (like bd_fs_wipe() or bd_fs_mkfs()) and by udev events on block devices so
+ * out-of-band changes are picked up on the next probe. The cache is disabled
+ * by default.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+gboolean bd_fs_set_probe_cache (gboolean enabled, GError **error) {
+    return bd_utils_set_probe_cache (enabled, error);
+}
+
 /**
  * bd_fs_wipe:
  * @device: the device to wipe signatures from
@@ -126,6 +168,9 @@ gboolean bd_fs_wipe (const gchar *device, gboolean all, GError **error) {
     progress_id = bd_utils_report_started (msg);
     g_free (msg);
 
+    /* probes running concurrently with the wipe must not cache their results */
+    bd_utils_probe_cache_invalidate (device);
+
     probe = blkid_new_probe ();
     if (!probe) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
@@ -218,6 +263,8 @@ gboolean bd_fs_wipe (const gchar *device, gboolean all, GError **error) {
     blkid_free_probe (probe);
     synced_close (fd);
 
+    bd_utils_probe_cache_invalidate (device);
+
     bd_utils_report_finished (progress_id, "Completed");
 
     return TRUE;
@@ -255,6 +302,140 @@ gboolean bd_fs_clean (const gchar *device, GError **error) {
       return TRUE;
 }
 
+/**
+ * discard_zeroes_data:
+ * @st_rdev: device number of the block device
+ *
+ * Returns: whether a discarded region of the device is guaranteed to read
+ *          back as zeroes (%FALSE whenever the sysfs attribute cannot be
+ *          read, e.g. for partitions)
+ */
+static gboolean discard_zeroes_data (dev_t st_rdev) {
+    gchar *path = NULL;
+    gchar *contents = NULL;
+    gboolean ret = FALSE;
+
+    path = g_strdup_printf ("/sys/dev/block/%u:%u/queue/discard_zeroes_data",
+                            major (st_rdev), minor (st_rdev));
+    if (g_file_get_contents (path, &contents, NULL, NULL)) {
+        ret = g_ascii_strtoull (contents, NULL, 0) == 1;
+        g_free (contents);
+    }
+    g_free (path);
+
+    return ret;
+}
+
+/**
+ * bd_fs_zero_device:
+ * @device: the device (or regular file) to zero out
+ * @error: (out): place to store error (if any)
+ *
+ * Zeroes out the whole @device using the kernel offloads instead of writing
+ * the zeroes from user space: BLKDISCARD when a discarded region is
+ * guaranteed to read back as zeroes, BLKZEROOUT (which uses the write-zeroes
+ * command of the controller when supported and an in-kernel write loop
+ * otherwise) for the other block devices and hole punching for regular
+ * files. The device is opened exclusively so a mounted or otherwise used
+ * device is refused. Progress is reported per zeroed chunk through the
+ * standard progress reporting machinery.
+ *
+ * Returns: whether @device was successfully zeroed out or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_WIPE
+ */
+gboolean bd_fs_zero_device (const gchar *device, GError **error) {
+    gint fd = -1;
+    struct stat st;
+    guint64 size = 0;
+    guint64 done = 0;
+    guint64 range[2] = {0, 0};
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+
+    msg = g_strdup_printf ("Started zeroing the device '%s'", device);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    fd = open (device, O_WRONLY|O_EXCL|O_CLOEXEC);
+    if (fd == -1) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to open the device '%s' exclusively: %m", device);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    if (fstat (fd, &st) != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to stat the device '%s': %m", device);
+        close (fd);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    if (S_ISREG (st.st_mode)) {
+        /* regular file: just punch a hole over the whole length */
+        if (fallocate (fd, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE, 0, st.st_size) != 0) {
+            g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                         "Failed to punch a hole over the file '%s': %m", device);
+            close (fd);
+            bd_utils_report_finished (progress_id, (*error)->message);
+            return FALSE;
+        }
+
+        synced_close (fd);
+        bd_utils_report_finished (progress_id, "Completed");
+        return TRUE;
+    }
+
+    if (!S_ISBLK (st.st_mode)) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "'%s' is neither a block device nor a regular file", device);
+        close (fd);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    if (ioctl (fd, BLKGETSIZE64, &size) != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to get the size of the device '%s': %m", device);
+        close (fd);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    /* a single whole-device discard when it's guaranteed to zero the data */
+    if (discard_zeroes_data (st.st_rdev)) {
+        range[0] = 0;
+        range[1] = size;
+        if (ioctl (fd, BLKDISCARD, range) == 0) {
+            synced_close (fd);
+            bd_utils_report_finished (progress_id, "Completed");
+            return TRUE;
+        }
+        /* fall through to BLKZEROOUT */
+    }
+
+    while (done < size) {
+        range[0] = done;
+        range[1] = MIN (size - done, ZERO_CHUNK_SIZE);
+        if (ioctl (fd, BLKZEROOUT, range) != 0) {
+            g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                         "Failed to zero out the device '%s': %m", device);
+            close (fd);
+            bd_utils_report_finished (progress_id, (*error)->message);
+            return FALSE;
+        }
+        done += range[1];
+        bd_utils_report_progress (progress_id, (done * 100) / size, NULL);
+    }
+
+    synced_close (fd);
+    bd_utils_report_finished (progress_id, "Completed");
+
+    return TRUE;
+}
+
 /**
  * bd_fs_get_fstype:
  * @device: the device to probe
@@ -273,9 +454,24 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
     gint fd = 0;
     gint status = 0;
     const gchar *value = NULL;
+    gchar *usage = NULL;
     gchar *fstype = NULL;
     size_t len = 0;
     guint n_try = 0;
+    guint64 devno = 0;
+    guint64 cache_gen = 0;
+
+    if (bd_utils_probe_cache_lookup (device, &usage, &fstype, &devno, &cache_gen)) {
+        if (usage && strncmp (usage, "filesystem", 10) != 0) {
+            g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                         "The signature on the device '%s' is of type '%s', not 'filesystem'", device, usage);
+            g_free (usage);
+            g_free (fstype);
+            return NULL;
+        }
+        g_free (usage);
+        return fstype;
+    }
 
     probe = blkid_new_probe ();
     if (!probe) {
@@ -331,6 +527,7 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
         /* 1 = nothing detected */
         blkid_free_probe (probe);
         synced_close (fd);
+        bd_utils_probe_cache_insert (devno, cache_gen, NULL, NULL);
         return NULL;
     }
 
@@ -342,10 +539,15 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
         synced_close (fd);
         return NULL;
     }
+    usage = g_strdup (value);
 
-    if (strncmp (value, "filesystem", 10) != 0) {
+    if (strncmp (usage, "filesystem", 10) != 0) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
-                     "The signature on the device '%s' is of type '%s', not 'filesystem'", device, value);
+                     "The signature on the device '%s' is of type '%s', not 'filesystem'", device, usage);
+        /* still a valid probe result usable by the other plugins */
+        if (blkid_probe_lookup_value (probe, "TYPE", &value, &len) == 0)
+            bd_utils_probe_cache_insert (devno, cache_gen, usage, value);
+        g_free (usage);
         blkid_free_probe (probe);
         synced_close (fd);
         return NULL;
@@ -355,6 +557,7 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
     if (status != 0) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Failed to get filesystem type for the device '%s'", device);
+        g_free (usage);
         blkid_free_probe (probe);
         synced_close (fd);
         return NULL;
@@ -364,6 +567,9 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
     blkid_free_probe (probe);
     synced_close (fd);
 
+    bd_utils_probe_cache_insert (devno, cache_gen, usage, fstype);
+    g_free (usage);
+
     return fstype;
 }
 
@@ -419,15 +625,13 @@ static gchar* fs_mount (const gchar *device, gchar *fstype, gboolean *unmount, G
  * @device: the device the file system of which to resize
  * @new_size: new requested size for the file system *in bytes*
  *            (if 0, the file system is adapted to the underlying block device)
- * @extra: (allow-none) (array zero-terminated=1): extra options for the resize (right now
- *                                                 passed to the 'xfs_growfs' utility)
  * @error: (out): place to store error (if any)
  *
  * This is just a helper function for bd_fs_resize.
  *
  * Returns: whether the file system on @device was successfully resized or not
  */
-static gboolean xfs_resize_device (const gchar *device, guint64 new_size, const BDExtraArg **extra, GError **error) {
+static gboolean xfs_resize_device (const gchar *device, guint64 new_size, GError **error) {
     g_autofree gchar* mountpoint = NULL;
     gboolean ret = FALSE;
     gboolean success = FALSE;
@@ -447,7 +651,7 @@ static gboolean xfs_resize_device (const gchar *device, guint64 new_size, const
     new_size = (new_size + xfs_info->block_size - 1) / xfs_info->block_size;
     bd_fs_xfs_info_free (xfs_info);
 
-    success = bd_fs_xfs_resize (mountpoint, new_size, extra, error);
+    success = bd_fs_xfs_resize (mountpoint, new_size, NULL, error);
 
     if (unmount) {
         ret = bd_fs_unmount (mountpoint, FALSE, FALSE, NULL, &local_error);
@@ -627,9 +831,325 @@ static gboolean btrfs_set_label (const gchar *device, const gchar *label, GError
     return success;
 }
 
+static BDFSXfsInfo* xfs_get_info (const gchar *device, GError **error);
+
+extern BDExtraArg** bd_fs_exfat_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_ext2_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_ext3_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_ext4_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_f2fs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_nilfs2_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_ntfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_reiserfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_vfat_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_xfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_btrfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
+
+/* thin adapters giving the per-filesystem functions the uniform signatures
+   required by the fs_ops dispatch table below; the ext* ones serve ext2, ext3
+   and ext4 alike (the underlying utilities are the same) */
+
+static gboolean ext_resize_device (const gchar *device, guint64 new_size, GError **error) {
+    return bd_fs_ext4_resize (device, new_size, NULL, error);
+}
+
+static gboolean ext_repair_device (const gchar *device, GError **error) {
+    return bd_fs_ext4_repair (device, TRUE, NULL, error);
+}
+
+static gboolean ext_check_device (const gchar *device, GError **error) {
+    return bd_fs_ext4_check (device, NULL, error);
+}
+
+static gboolean xfs_repair_device (const gchar *device, GError **error) {
+    return bd_fs_xfs_repair (device, NULL, error);
+}
+
+static gboolean vfat_repair_device (const gchar *device, GError **error) {
+    return bd_fs_vfat_repair (device, NULL, error);
+}
+
+static gboolean vfat_check_device (const gchar *device, GError **error) {
+    return bd_fs_vfat_check (device, NULL, error);
+}
+
+static gboolean f2fs_repair_device (const gchar *device, GError **error) {
+    return bd_fs_f2fs_repair (device, NULL, error);
+}
+
+static gboolean f2fs_check_device (const gchar *device, GError **error) {
+    return bd_fs_f2fs_check (device, NULL, error);
+}
+
+static gboolean reiserfs_repair_device (const gchar *device, GError **error) {
+    return bd_fs_reiserfs_repair (device, NULL, error);
+}
+
+static gboolean reiserfs_check_device (const gchar *device, GError **error) {
+    return bd_fs_reiserfs_check (device, NULL, error);
+}
+
+static gboolean exfat_repair_device (const gchar *device, GError **error) {
+    return bd_fs_exfat_repair (device, NULL, error);
+}
+
+static gboolean exfat_check_device (const gchar *device, GError **error) {
+    return bd_fs_exfat_check (device, NULL, error);
+}
+
+static gboolean btrfs_repair_device (const gchar *device, GError **error) {
+    return bd_fs_btrfs_repair (device, NULL, error);
+}
+
+static gboolean btrfs_check_device (const gchar *device, GError **error) {
+    return bd_fs_btrfs_check (device, NULL, error);
+}
+
+static gboolean udf_mkfs (const gchar *device, const BDExtraArg **extra, GError **error) {
+    return bd_fs_udf_mkfs (device, NULL, NULL, 0, extra, error);
+}
+
+static guint64 ext_get_size (const gchar *device, GError **error) {
+    BDFSExt4Info *info = bd_fs_ext4_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->block_size * info->block_count;
+        bd_fs_ext4_info_free (info);
+    }
+    return size;
+}
+
+static guint64 ext_get_free_space (const gchar *device, GError **error) {
+    BDFSExt4Info *info = bd_fs_ext4_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->block_size * info->free_blocks;
+        bd_fs_ext4_info_free (info);
+    }
+    return size;
+}
+
+static guint64 xfs_get_size (const gchar *device, GError **error) {
+    BDFSXfsInfo *info = xfs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->block_size * info->block_count;
+        bd_fs_xfs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 vfat_get_size (const gchar *device, GError **error) {
+    BDFSVfatInfo *info = bd_fs_vfat_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->cluster_size * info->cluster_count;
+        bd_fs_vfat_info_free (info);
+    }
+    return size;
+}
+
+static guint64 vfat_get_free_space (const gchar *device, GError **error) {
+    BDFSVfatInfo *info = bd_fs_vfat_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->cluster_size * info->free_cluster_count;
+        bd_fs_vfat_info_free (info);
+    }
+    return size;
+}
+
+static guint64 ntfs_get_size (const gchar *device, GError **error) {
+    BDFSNtfsInfo *info = bd_fs_ntfs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->size;
+        bd_fs_ntfs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 ntfs_get_free_space (const gchar *device, GError **error) {
+    BDFSNtfsInfo *info = bd_fs_ntfs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->free_space;
+        bd_fs_ntfs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 f2fs_get_size (const gchar *device, GError **error) {
+    BDFSF2FSInfo *info = bd_fs_f2fs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->sector_size * info->sector_count;
+        bd_fs_f2fs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 reiserfs_get_size (const gchar *device, GError **error) {
+    BDFSReiserFSInfo *info = bd_fs_reiserfs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->block_size * info->block_count;
+        bd_fs_reiserfs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 reiserfs_get_free_space (const gchar *device, GError **error) {
+    BDFSReiserFSInfo *info = bd_fs_reiserfs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->block_size * info->free_blocks;
+        bd_fs_reiserfs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 nilfs2_get_size (const gchar *device, GError **error) {
+    BDFSNILFS2Info *info = bd_fs_nilfs2_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->size;
+        bd_fs_nilfs2_info_free (info);
+    }
+    return size;
+}
+
+static guint64 nilfs2_get_free_space (const gchar *device, GError **error) {
+    BDFSNILFS2Info *info = bd_fs_nilfs2_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->block_size * info->free_blocks;
+        bd_fs_nilfs2_info_free (info);
+    }
+    return size;
+}
+
+static guint64 exfat_get_size (const gchar *device, GError **error) {
+    BDFSExfatInfo *info = bd_fs_exfat_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->sector_size * info->sector_count;
+        bd_fs_exfat_info_free (info);
+    }
+    return size;
+}
+
+static guint64 btrfs_get_size (const gchar *device, GError **error) {
+    BDFSBtrfsInfo *info = btrfs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->size;
+        bd_fs_btrfs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 btrfs_get_free_space (const gchar *device, GError **error) {
+    BDFSBtrfsInfo *info = btrfs_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->free_space;
+        bd_fs_btrfs_info_free (info);
+    }
+    return size;
+}
+
+static guint64 udf_get_size (const gchar *device, GError **error) {
+    BDFSUdfInfo *info = bd_fs_udf_get_info (device, error);
+    guint64 size = 0;
+
+    if (info) {
+        size = info->block_size * info->block_count;
+        bd_fs_udf_info_free (info);
+    }
+    return size;
+}
+
+/**
+ * BDFSOps:
+ * @type: filesystem identifier, must be present
+ * @mkfs_options: translation of %BDFSMkfsOptions to the mkfs extra arguments, must be present
+ * @mkfs: filesystem creation, must be present
+ * @resize: filesystem resize, %NULL for no support
+ * @repair: filesystem repair, %NULL for no support
+ * @check: filesystem consistency check, %NULL for no support
+ * @set_label: setting the filesystem label, %NULL for no support
+ * @set_uuid: setting the filesystem UUID, %NULL for no support
+ * @get_size: getting the filesystem size, %NULL for no support
+ * @get_free_space: getting the filesystem free space, %NULL for no support
+ *
+ * One row of the dispatch table the generic fs functions route through. Every
+ * operation of every filesystem is registered here (and only here), the
+ * generic functions just look the row up once and call through the pointers
+ * instead of walking per-operation string-comparison cascades.
+ */
+typedef struct BDFSOps {
+    const gchar *type;
+    BDExtraArg** (*mkfs_options) (BDFSMkfsOptions *options, const BDExtraArg **extra);
+    gboolean (*mkfs) (const gchar *device, const BDExtraArg **extra, GError **error);
+    gboolean (*resize) (const gchar *device, guint64 new_size, GError **error);
+    gboolean (*repair) (const gchar *device, GError **error);
+    gboolean (*check) (const gchar *device, GError **error);
+    gboolean (*set_label) (const gchar *device, const gchar *label, GError **error);
+    gboolean (*set_uuid) (const gchar *device, const gchar *uuid, GError **error);
+    guint64 (*get_size) (const gchar *device, GError **error);
+    guint64 (*get_free_space) (const gchar *device, GError **error);
+} BDFSOps;
+
+static const BDFSOps fs_ops[] = {
+    {"ext4", bd_fs_ext4_mkfs_options, bd_fs_ext4_mkfs, ext_resize_device, ext_repair_device, ext_check_device, bd_fs_ext4_set_label, bd_fs_ext4_set_uuid, ext_get_size, ext_get_free_space},
+    {"ext3", bd_fs_ext3_mkfs_options, bd_fs_ext3_mkfs, ext_resize_device, ext_repair_device, ext_check_device, bd_fs_ext4_set_label, bd_fs_ext4_set_uuid, ext_get_size, ext_get_free_space},
+    {"ext2", bd_fs_ext2_mkfs_options, bd_fs_ext2_mkfs, ext_resize_device, ext_repair_device, ext_check_device, bd_fs_ext4_set_label, bd_fs_ext4_set_uuid, ext_get_size, ext_get_free_space},
+    {"xfs", bd_fs_xfs_mkfs_options, bd_fs_xfs_mkfs, xfs_resize_device, xfs_repair_device, bd_fs_xfs_check, bd_fs_xfs_set_label, bd_fs_xfs_set_uuid, xfs_get_size, NULL},
+    {"vfat", bd_fs_vfat_mkfs_options, bd_fs_vfat_mkfs, bd_fs_vfat_resize, vfat_repair_device, vfat_check_device, bd_fs_vfat_set_label, NULL, vfat_get_size, vfat_get_free_space},
+    {"ntfs", bd_fs_ntfs_mkfs_options, bd_fs_ntfs_mkfs, bd_fs_ntfs_resize, bd_fs_ntfs_repair, bd_fs_ntfs_check, bd_fs_ntfs_set_label, bd_fs_ntfs_set_uuid, ntfs_get_size, ntfs_get_free_space},
+    {"f2fs", bd_fs_f2fs_mkfs_options, bd_fs_f2fs_mkfs, f2fs_resize_device, f2fs_repair_device, f2fs_check_device, NULL, NULL, f2fs_get_size, NULL},
+    {"reiserfs", bd_fs_reiserfs_mkfs_options, bd_fs_reiserfs_mkfs, bd_fs_reiserfs_resize, reiserfs_repair_device, reiserfs_check_device, bd_fs_reiserfs_set_label, bd_fs_reiserfs_set_uuid, reiserfs_get_size, reiserfs_get_free_space},
+    {"nilfs2", bd_fs_nilfs2_mkfs_options, bd_fs_nilfs2_mkfs, nilfs2_resize_device, NULL, NULL, bd_fs_nilfs2_set_label, bd_fs_nilfs2_set_uuid, nilfs2_get_size, nilfs2_get_free_space},
+    {"exfat", bd_fs_exfat_mkfs_options, bd_fs_exfat_mkfs, NULL, exfat_repair_device, exfat_check_device, bd_fs_exfat_set_label, NULL, exfat_get_size, NULL},
+    {"btrfs", bd_fs_btrfs_mkfs_options, bd_fs_btrfs_mkfs, btrfs_resize_device, btrfs_repair_device, btrfs_check_device, btrfs_set_label, bd_fs_btrfs_set_uuid, btrfs_get_size, btrfs_get_free_space},
+    {"udf", bd_fs_udf_mkfs_options, udf_mkfs, NULL, NULL, NULL, bd_fs_udf_set_label, bd_fs_udf_set_uuid, udf_get_size, NULL},
+    {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL}
+};
+
+static const BDFSOps *
+get_fs_ops (const gchar *type)
+{
+    g_return_val_if_fail (type != NULL, NULL);
+
+    for (guint n = 0; fs_ops[n].type != NULL; n++) {
+        if (strcmp (fs_ops[n].type, type) == 0)
+            return &fs_ops[n];
+    }
+
+    return NULL;
+}
+
 static gboolean device_operation (const gchar *device, BDFsOpType op, guint64 new_size, const gchar *label, const gchar *uuid, GError **error) {
     const gchar* op_name = NULL;
     g_autofree gchar* fstype = NULL;
+    const BDFSOps *ops = NULL;
 
     /* MKFS is covered as a special case, it's a bug to use this function for this case */
     g_assert_true (op != BD_FS_MKFS);
@@ -649,157 +1169,32 @@ static gboolean device_operation (const gchar *device, BDFsOpType op, guint64 ne
         }
     }
 
-    if (g_strcmp0 (fstype, "ext2") == 0 || g_strcmp0 (fstype, "ext3") == 0
-                                        || g_strcmp0 (fstype, "ext4") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                return bd_fs_ext4_resize (device, new_size, NULL, error);
-            case BD_FS_REPAIR:
-                return bd_fs_ext4_repair (device, TRUE, NULL, error);
-            case BD_FS_CHECK:
-                return bd_fs_ext4_check (device, NULL, error);
-            case BD_FS_LABEL:
-                return bd_fs_ext4_set_label (device, label, error);
-            case BD_FS_UUID:
-                return bd_fs_ext4_set_uuid (device, uuid, error);
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "xfs") == 0) {
+    ops = get_fs_ops (fstype);
+    if (ops) {
         switch (op) {
             case BD_FS_RESIZE:
-                return xfs_resize_device (device, new_size, NULL, error);
-            case BD_FS_REPAIR:
-                return bd_fs_xfs_repair (device, NULL, error);
-            case BD_FS_CHECK:
-                return bd_fs_xfs_check (device, error);
-            case BD_FS_LABEL:
-                return bd_fs_xfs_set_label (device, label, error);
-            case BD_FS_UUID:
-                return bd_fs_xfs_set_uuid (device, uuid, error);
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "vfat") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                return bd_fs_vfat_resize (device, new_size, error);
+                if (ops->resize)
+                    return ops->resize (device, new_size, error);
+                break;
             case BD_FS_REPAIR:
-                return bd_fs_vfat_repair (device, NULL, error);
+                if (ops->repair)
+                    return ops->repair (device, error);
+                break;
             case BD_FS_CHECK:
-                return bd_fs_vfat_check (device, NULL, error);
+                if (ops->check)
+                    return ops->check (device, error);
+                break;
             case BD_FS_LABEL:
-                return bd_fs_vfat_set_label (device, label, error);
+                if (ops->set_label)
+                    return ops->set_label (device, label, error);
+                break;
             case BD_FS_UUID:
+                if (ops->set_uuid)
+                    return ops->set_uuid (device, uuid, error);
                 break;
             default:
                 g_assert_not_reached ();
         }
-    } else if (g_strcmp0 (fstype, "ntfs") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                return bd_fs_ntfs_resize (device, new_size, error);
-            case BD_FS_REPAIR:
-                return bd_fs_ntfs_repair (device, error);
-            case BD_FS_CHECK:
-                return bd_fs_ntfs_check (device, error);
-            case BD_FS_LABEL:
-                return bd_fs_ntfs_set_label (device, label, error);
-            case BD_FS_UUID:
-                return bd_fs_ntfs_set_uuid (device, uuid, error);
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "f2fs") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                return f2fs_resize_device (device, new_size, error);
-            case BD_FS_REPAIR:
-                return bd_fs_f2fs_repair (device, NULL, error);
-            case BD_FS_CHECK:
-                return bd_fs_f2fs_check (device, NULL, error);
-            case BD_FS_LABEL:
-                break;
-            case BD_FS_UUID:
-                break;
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "reiserfs") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                return bd_fs_reiserfs_resize (device, new_size, error);
-            case BD_FS_REPAIR:
-                return bd_fs_reiserfs_repair (device, NULL, error);
-            case BD_FS_CHECK:
-                return bd_fs_reiserfs_check (device, NULL, error);
-            case BD_FS_LABEL:
-                return bd_fs_reiserfs_set_label (device, label, error);
-            case BD_FS_UUID:
-                return bd_fs_reiserfs_set_uuid (device, uuid, error);
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "nilfs2") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                return nilfs2_resize_device (device, new_size, error);
-            case BD_FS_REPAIR:
-                break;
-            case BD_FS_CHECK:
-                break;
-            case BD_FS_LABEL:
-                return bd_fs_nilfs2_set_label (device, label, error);
-            case BD_FS_UUID:
-                return bd_fs_nilfs2_set_uuid (device, uuid, error);
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "exfat") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                break;
-            case BD_FS_REPAIR:
-                return bd_fs_exfat_repair (device, NULL, error);
-            case BD_FS_CHECK:
-                return bd_fs_exfat_check (device, NULL, error);
-            case BD_FS_LABEL:
-                return bd_fs_exfat_set_label (device, label, error);
-            case BD_FS_UUID:
-                break;
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "btrfs") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                return btrfs_resize_device (device, new_size, error);
-            case BD_FS_REPAIR:
-                return bd_fs_btrfs_repair (device, NULL, error);
-            case BD_FS_CHECK:
-                return bd_fs_btrfs_check (device, NULL, error);
-            case BD_FS_LABEL:
-                return btrfs_set_label (device, label, error);
-            case BD_FS_UUID:
-                return bd_fs_btrfs_set_uuid (device, uuid, error);
-            default:
-                g_assert_not_reached ();
-        }
-    } else if (g_strcmp0 (fstype, "udf") == 0) {
-        switch (op) {
-            case BD_FS_RESIZE:
-                break;
-            case BD_FS_REPAIR:
-                break;
-            case BD_FS_CHECK:
-                break;
-            case BD_FS_LABEL:
-                return bd_fs_udf_set_label (device, label, error);
-            case BD_FS_UUID:
-                return bd_fs_udf_set_uuid (device, uuid, error);
-            default:
-                g_assert_not_reached ();
-        }
     }
     switch (op) {
         case BD_FS_RESIZE:
@@ -844,6 +1239,81 @@ gboolean bd_fs_resize (const gchar *device, guint64 new_size, GError **error) {
     return device_operation (device, BD_FS_RESIZE, new_size, NULL, NULL, error);
 }
 
+typedef struct FsResizeAsyncData {
+    gchar *device;
+    guint64 new_size;
+} FsResizeAsyncData;
+
+static void fs_resize_async_data_free (FsResizeAsyncData *data) {
+    g_free (data->device);
+    g_free (data);
+}
+
+static void fs_resize_async_thread (GTask *task, gpointer source_object __attribute__((unused)), gpointer task_data, GCancellable *cancellable __attribute__((unused))) {
+    FsResizeAsyncData *data = (FsResizeAsyncData *) task_data;
+    GError *l_error = NULL;
+
+    if (g_task_return_error_if_cancelled (task))
+        return;
+
+    if (!bd_fs_resize (data->device, data->new_size, &l_error))
+        g_task_return_error (task, l_error);
+    else
+        g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * bd_fs_resize_async:
+ * @device: the device the file system of which to resize
+ * @new_size: new requested size for the file system (if 0, the file system is
+ *            adapted to the underlying block device)
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): function to call when the resize is done
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Asynchronous variant of bd_fs_resize(). The resize runs in a worker thread
+ * with progress reported through the standard progress reporting machinery so
+ * the caller is not blocked for the duration of the resize. Call
+ * bd_fs_resize_finish() from @callback to get the result.
+ *
+ * Returns: whether the resize was successfully started or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_RESIZE
+ */
+gboolean bd_fs_resize_async (const gchar *device, guint64 new_size, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error __attribute__((unused))) {
+    GTask *task = NULL;
+    FsResizeAsyncData *data = NULL;
+
+    data = g_new0 (FsResizeAsyncData, 1);
+    data->device = g_strdup (device);
+    data->new_size = new_size;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, bd_fs_resize_async);
+    g_task_set_task_data (task, data, (GDestroyNotify) fs_resize_async_data_free);
+    g_task_run_in_thread (task, fs_resize_async_thread);
+    g_object_unref (task);
+
+    return TRUE;
+}
+
+/**
+ * bd_fs_resize_finish:
+ * @result: a #GAsyncResult obtained from the #GAsyncReadyCallback passed to
+ *          bd_fs_resize_async()
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: whether the file system was successfully resized or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_RESIZE
+ */
+gboolean bd_fs_resize_finish (GAsyncResult *result, GError **error) {
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * bd_fs_repair:
  * @device: the device the file system of which to repair
@@ -914,6 +1384,214 @@ gboolean bd_fs_set_uuid (const gchar *device, const gchar *uuid, GError **error)
     return device_operation (device, BD_FS_UUID, 0, NULL, uuid, error);
 }
 
+/* fast in-process superblock readers -- pread the few fields needed by
+   bd_fs_get_size and bd_fs_get_free_space directly instead of spawning the
+   filesystem utilities; the utility-based path stays as a fallback for the
+   other filesystems and for any read or validation failure */
+
+static gboolean read_sb_bytes (gint fd, guint64 offset, guint8 *buf, size_t len) {
+    ssize_t n_read = 0;
+
+    while (len > 0) {
+        n_read = pread (fd, buf, len, (off_t) offset);
+        if (n_read == -1 && errno == EINTR)
+            continue;
+        if (n_read <= 0)
+            return FALSE;
+        buf += n_read;
+        offset += (guint64) n_read;
+        len -= (size_t) n_read;
+    }
+
+    return TRUE;
+}
+
+static guint16 sb_le16 (const guint8 *buf, guint64 offset) {
+    guint16 val = 0;
+
+    memcpy (&val, buf + offset, sizeof (val));
+    return GUINT16_FROM_LE (val);
+}
+
+static guint32 sb_le32 (const guint8 *buf, guint64 offset) {
+    guint32 val = 0;
+
+    memcpy (&val, buf + offset, sizeof (val));
+    return GUINT32_FROM_LE (val);
+}
+
+static guint64 sb_le64 (const guint8 *buf, guint64 offset) {
+    guint64 val = 0;
+
+    memcpy (&val, buf + offset, sizeof (val));
+    return GUINT64_FROM_LE (val);
+}
+
+static guint32 sb_be32 (const guint8 *buf, guint64 offset) {
+    guint32 val = 0;
+
+    memcpy (&val, buf + offset, sizeof (val));
+    return GUINT32_FROM_BE (val);
+}
+
+static guint64 sb_be64 (const guint8 *buf, guint64 offset) {
+    guint64 val = 0;
+
+    memcpy (&val, buf + offset, sizeof (val));
+    return GUINT64_FROM_BE (val);
+}
+
+static gboolean ext_sb_get_size (gint fd, gboolean free_space, guint64 *size) {
+    guint8 sb[1024];
+    guint64 count = 0;
+
+    /* the primary superblock lives at a fixed 1 KiB offset */
+    if (!read_sb_bytes (fd, 1024, sb, sizeof (sb)))
+        return FALSE;
+
+    if (sb_le16 (sb, 56) != 0xEF53)                          /* s_magic */
+        return FALSE;
+
+    if (free_space)
+        count = sb_le32 (sb, 12);                            /* s_free_blocks_count_lo */
+    else
+        count = sb_le32 (sb, 4);                             /* s_blocks_count_lo */
+
+    if (sb_le32 (sb, 96) & 0x80) {                           /* s_feature_incompat & INCOMPAT_64BIT */
+        if (free_space)
+            count |= ((guint64) sb_le32 (sb, 344)) << 32;    /* s_free_blocks_count_hi */
+        else
+            count |= ((guint64) sb_le32 (sb, 336)) << 32;    /* s_blocks_count_hi */
+    }
+
+    *size = count * (G_GUINT64_CONSTANT (1024) << sb_le32 (sb, 24));   /* s_log_block_size */
+    return TRUE;
+}
+
+static gboolean xfs_sb_get_size (gint fd, gboolean free_space, guint64 *size) {
+    guint8 sb[160];
+    guint64 blocks = 0;
+
+    if (!read_sb_bytes (fd, 0, sb, sizeof (sb)))
+        return FALSE;
+
+    if (memcmp (sb, "XFSB", 4) != 0)                         /* sb_magicnum */
+        return FALSE;
+
+    if (free_space)
+        blocks = sb_be64 (sb, 144);                          /* sb_fdblocks */
+    else
+        blocks = sb_be64 (sb, 8);                            /* sb_dblocks */
+
+    *size = blocks * sb_be32 (sb, 4);                        /* sb_blocksize */
+    return TRUE;
+}
+
+static gboolean vfat_sb_get_size (gint fd, gboolean free_space, guint64 *size) {
+    guint8 bs[512];
+    guint8 fsinfo[512];
+    guint32 bps = 0;
+    guint32 spc = 0;
+    guint32 reserved = 0;
+    guint32 n_fats = 0;
+    guint32 root_entries = 0;
+    guint32 fat_sectors = 0;
+    guint32 total_sectors = 0;
+    guint32 root_dir_sectors = 0;
+    guint32 meta_sectors = 0;
+    guint32 clusters = 0;
+    guint32 free_clusters = 0;
+    gboolean fat32 = FALSE;
+
+    if (!read_sb_bytes (fd, 0, bs, sizeof (bs)))
+        return FALSE;
+
+    if (bs[510] != 0x55 || bs[511] != 0xAA)                  /* boot sector signature */
+        return FALSE;
+
+    bps = sb_le16 (bs, 11);                                  /* bytes per sector */
+    spc = bs[13];                                            /* sectors per cluster */
+    reserved = sb_le16 (bs, 14);
+    n_fats = bs[16];
+    root_entries = sb_le16 (bs, 17);
+    total_sectors = sb_le16 (bs, 19);
+    if (total_sectors == 0)
+        total_sectors = sb_le32 (bs, 32);
+    fat_sectors = sb_le16 (bs, 22);
+    if (fat_sectors == 0) {
+        fat_sectors = sb_le32 (bs, 36);                      /* FAT32 */
+        fat32 = TRUE;
+    }
+
+    if (bps == 0 || spc == 0 || fat_sectors == 0 || total_sectors == 0)
+        return FALSE;
+
+    root_dir_sectors = (root_entries * 32 + bps - 1) / bps;
+    meta_sectors = reserved + n_fats * fat_sectors + root_dir_sectors;
+    if (meta_sectors >= total_sectors)
+        return FALSE;
+    clusters = (total_sectors - meta_sectors) / spc;
+
+    if (free_space) {
+        /* the free cluster count is only tracked in the FAT32 FS information
+           sector, counting it on FAT12/16 would mean scanning the whole FAT */
+        if (!fat32)
+            return FALSE;
+        if (!read_sb_bytes (fd, (guint64) sb_le16 (bs, 48) * bps, fsinfo, sizeof (fsinfo)))
+            return FALSE;
+        if (sb_le32 (fsinfo, 0) != 0x41615252 || sb_le32 (fsinfo, 484) != 0x61417272)
+            return FALSE;
+        free_clusters = sb_le32 (fsinfo, 488);
+        if (free_clusters == 0xFFFFFFFF || free_clusters > clusters)
+            return FALSE;
+        *size = (guint64) free_clusters * spc * bps;
+    } else
+        *size = (guint64) clusters * spc * bps;
+
+    return TRUE;
+}
+
+static gboolean btrfs_sb_get_size (gint fd, gboolean free_space, guint64 *size) {
+    guint8 sb[144];
+
+    /* getting the free space needs the space info trees, the superblock is
+       not enough */
+    if (free_space)
+        return FALSE;
+
+    /* the primary superblock lives at a fixed 64 KiB offset */
+    if (!read_sb_bytes (fd, 0x10000, sb, sizeof (sb)))
+        return FALSE;
+
+    if (memcmp (sb + 0x40, "_BHRfS_M", 8) != 0)              /* magic */
+        return FALSE;
+
+    *size = sb_le64 (sb, 0x70);                              /* total_bytes */
+    return TRUE;
+}
+
+static gboolean fs_get_size_direct (const gchar *device, const gchar *fstype, gboolean free_space, guint64 *size) {
+    gint fd = -1;
+    gboolean ret = FALSE;
+
+    fd = open (device, O_RDONLY|O_CLOEXEC);
+    if (fd == -1)
+        return FALSE;
+
+    if (g_strcmp0 (fstype, "ext2") == 0 || g_strcmp0 (fstype, "ext3") == 0
+                                        || g_strcmp0 (fstype, "ext4") == 0)
+        ret = ext_sb_get_size (fd, free_space, size);
+    else if (g_strcmp0 (fstype, "xfs") == 0)
+        ret = xfs_sb_get_size (fd, free_space, size);
+    else if (g_strcmp0 (fstype, "vfat") == 0)
+        ret = vfat_sb_get_size (fd, free_space, size);
+    else if (g_strcmp0 (fstype, "btrfs") == 0)
+        ret = btrfs_sb_get_size (fd, free_space, size);
+
+    close (fd);
+    return ret;
+}
+
 static BDFSXfsInfo* xfs_get_info (const gchar *device, GError **error) {
     g_autofree gchar* mountpoint = NULL;
     gboolean unmount = FALSE;
@@ -944,9 +1622,12 @@ static BDFSXfsInfo* xfs_get_info (const gchar *device, GError **error) {
  * @device: the device with file system to get size for
  * @error: (out): place to store error (if any)
  *
- * Get size for filesystem on @device. This calls other fs info functions from this
- * plugin based on detected filesystem (e.g. bd_fs_xfs_get_info for XFS). This
- * function will return an error for unknown/unsupported filesystems.
+ * Get size for filesystem on @device. For the common filesystems (ext2/3/4,
+ * XFS, FAT and Btrfs) the value is read directly from the superblock without
+ * running any filesystem utility. For the other filesystems this calls other
+ * fs info functions from this plugin based on detected filesystem
+ * (e.g. bd_fs_xfs_get_info for XFS). This function will return an error for
+ * unknown/unsupported filesystems.
  *
  * Returns: size of filesystem on @device, 0 in case of error.
  *
@@ -954,6 +1635,7 @@ static BDFSXfsInfo* xfs_get_info (const gchar *device, GError **error) {
  */
 guint64 bd_fs_get_size (const gchar *device, GError **error) {
     g_autofree gchar* fstype = NULL;
+    const BDFSOps *ops = NULL;
     guint64 size = 0;
 
     fstype = bd_fs_get_fstype (device, error);
@@ -968,83 +1650,19 @@ guint64 bd_fs_get_size (const gchar *device, GError **error) {
         }
     }
 
-    if (g_strcmp0 (fstype, "ext2") == 0 || g_strcmp0 (fstype, "ext3") == 0
-                                        || g_strcmp0 (fstype, "ext4") == 0) {
-        BDFSExt4Info* info = bd_fs_ext4_get_info (device, error);
-        if (info) {
-            size = info->block_size * info->block_count;
-            bd_fs_ext4_info_free (info);
-        }
+    /* fast path: read the value directly from the superblock without spawning
+       the filesystem utilities */
+    if (fs_get_size_direct (device, fstype, FALSE, &size))
         return size;
 
-    } else if (g_strcmp0 (fstype, "xfs") == 0) {
-        BDFSXfsInfo *info = xfs_get_info (device, error);
-        if (info) {
-            size = info->block_size * info->block_count;
-            bd_fs_xfs_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "vfat") == 0) {
-        BDFSVfatInfo *info = bd_fs_vfat_get_info (device, error);
-        if (info) {
-            size = info->cluster_size * info->cluster_count;
-            bd_fs_vfat_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "ntfs") == 0) {
-        BDFSNtfsInfo *info = bd_fs_ntfs_get_info (device, error);
-        if (info) {
-            size = info->size;
-            bd_fs_ntfs_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "f2fs") == 0) {
-        BDFSF2FSInfo *info = bd_fs_f2fs_get_info (device, error);
-        if (info) {
-            size = info->sector_size * info->sector_count;
-            bd_fs_f2fs_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "reiserfs") == 0) {
-        BDFSReiserFSInfo *info = bd_fs_reiserfs_get_info (device, error);
-        if (info) {
-            size = info->block_size * info->block_count;
-            bd_fs_reiserfs_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "nilfs2") == 0) {
-        BDFSNILFS2Info *info = bd_fs_nilfs2_get_info (device, error);
-        if (info) {
-            size = info->size;
-            bd_fs_nilfs2_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "exfat") == 0) {
-        BDFSExfatInfo *info = bd_fs_exfat_get_info (device, error);
-        if (info) {
-            size = info->sector_size * info->sector_count;
-            bd_fs_exfat_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "btrfs") == 0) {
-        BDFSBtrfsInfo *info = btrfs_get_info (device, error);
-        if (info) {
-            size = info->size;
-            bd_fs_btrfs_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "udf") == 0) {
-        BDFSUdfInfo *info = bd_fs_udf_get_info (device, error);
-        if (info) {
-            size = info->block_size * info->block_count;
-            bd_fs_udf_info_free (info);
-        }
-        return size;
-    } else {
+    ops = get_fs_ops (fstype);
+    if (!ops || !ops->get_size) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
                     "Getting size of filesystem '%s' is not supported.", fstype);
         return 0;
     }
+
+    return ops->get_size (device, error);
 }
 
 /**
@@ -1052,9 +1670,12 @@ guint64 bd_fs_get_size (const gchar *device, GError **error) {
  * @device: the device with file system to get free space for
  * @error: (out): place to store error (if any)
  *
- * Get free space for filesystem on @device. This calls other fs info functions from this
- * plugin based on detected filesystem (e.g. bd_fs_ext4_get_info for ext4). This
- * function will return an error for unknown/unsupported filesystems.
+ * Get free space for filesystem on @device. For the common filesystems
+ * (ext2/3/4, XFS and FAT32) the value is read directly from the superblock
+ * without running any filesystem utility. For the other filesystems this
+ * calls other fs info functions from this plugin based on detected filesystem
+ * (e.g. bd_fs_ext4_get_info for ext4). This function will return an error for
+ * unknown/unsupported filesystems.
  *
  * Returns: free space of filesystem on @device, 0 in case of error.
  *
@@ -1062,6 +1683,7 @@ guint64 bd_fs_get_size (const gchar *device, GError **error) {
  */
 guint64 bd_fs_get_free_space (const gchar *device, GError **error) {
     g_autofree gchar* fstype = NULL;
+    const BDFSOps *ops = NULL;
     guint64 size = 0;
 
     fstype = bd_fs_get_fstype (device, error);
@@ -1076,55 +1698,142 @@ guint64 bd_fs_get_free_space (const gchar *device, GError **error) {
         }
     }
 
-    if (g_strcmp0 (fstype, "ext2") == 0 || g_strcmp0 (fstype, "ext3") == 0
-                                        || g_strcmp0 (fstype, "ext4") == 0) {
-        BDFSExt4Info* info = bd_fs_ext4_get_info (device, error);
-        if (info) {
-            size = info->block_size * info->free_blocks;
-            bd_fs_ext4_info_free (info);
-        }
+    /* fast path: read the value directly from the superblock without spawning
+       the filesystem utilities */
+    if (fs_get_size_direct (device, fstype, TRUE, &size))
         return size;
 
-    } else if (g_strcmp0 (fstype, "vfat") == 0) {
-        BDFSVfatInfo *info = bd_fs_vfat_get_info (device, error);
-        if (info) {
-            size = info->cluster_size * info->free_cluster_count;
-            bd_fs_vfat_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "ntfs") == 0) {
-        BDFSNtfsInfo *info = bd_fs_ntfs_get_info (device, error);
-        if (info) {
-            size = info->free_space;
-            bd_fs_ntfs_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "reiserfs") == 0) {
-        BDFSReiserFSInfo *info = bd_fs_reiserfs_get_info (device, error);
-        if (info) {
-            size = info->block_size * info->free_blocks;
-            bd_fs_reiserfs_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "nilfs2") == 0) {
-        BDFSNILFS2Info *info = bd_fs_nilfs2_get_info (device, error);
-        if (info) {
-            size = info->block_size * info->free_blocks;
-            bd_fs_nilfs2_info_free (info);
-        }
-        return size;
-    } else if (g_strcmp0 (fstype, "btrfs") == 0) {
-        BDFSBtrfsInfo *info = btrfs_get_info (device, error);
-        if (info) {
-            size = info->free_space;
-            bd_fs_btrfs_info_free (info);
-        }
-        return size;
-    } else {
+    ops = get_fs_ops (fstype);
+    if (!ops || !ops->get_free_space) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
                     "Getting free space on filesystem '%s' is not supported.", fstype);
         return 0;
     }
+
+    return ops->get_free_space (device, error);
+}
+
+/* capability matrix computed from the utility probes, built lazily once and
+   then served as-is */
+static GMutex fs_caps_lock;
+static BDFSCapabilities **fs_caps = NULL;
+
+/**
+ * bd_fs_capabilities_copy: (skip)
+ *
+ * Creates a new copy of @data.
+ */
+BDFSCapabilities* bd_fs_capabilities_copy (BDFSCapabilities *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSCapabilities *ret = g_new0 (BDFSCapabilities, 1);
+
+    ret->fstype = g_strdup (data->fstype);
+    ret->mkfs = data->mkfs;
+    ret->mkfs_options = data->mkfs_options;
+    ret->resize = data->resize;
+    ret->resize_mode = data->resize_mode;
+    ret->check = data->check;
+    ret->repair = data->repair;
+    ret->set_label = data->set_label;
+    ret->set_uuid = data->set_uuid;
+    ret->query = data->query;
+
+    return ret;
+}
+
+/**
+ * bd_fs_capabilities_free: (skip)
+ *
+ * Frees @data.
+ */
+void bd_fs_capabilities_free (BDFSCapabilities *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->fstype);
+    g_free (data);
+}
+
+static gboolean caps_util_available (const gchar *util) {
+    if (util == NULL)
+        return FALSE;
+    if (util[0] == '\0')
+        /* empty string if no util needed */
+        return TRUE;
+    return bd_utils_check_util_version (util, NULL, "", NULL, NULL);
+}
+
+/**
+ * bd_fs_get_capabilities:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns the capability matrix of all the supported filesystems. The
+ * availability of every operation's utility is probed only when the matrix is
+ * built for the first time, repeated calls return the same table, so querying
+ * the capabilities for many filesystems (e.g. when rendering a dialog) costs
+ * no process spawns and no locking beyond one pointer check. Utilities
+ * installed or removed while the process is running are not reflected in the
+ * table; use the bd_fs_can_* functions for a live check of a single
+ * operation.
+ *
+ * Returns: (transfer none) (array zero-terminated=1): capabilities of all the
+ *          supported filesystems (owned by the plugin, do not free)
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+BDFSCapabilities** bd_fs_get_capabilities (GError **error __attribute__((unused))) {
+    BDFSCapabilities **caps = NULL;
+    guint n = 0;
+    guint i = 0;
+
+    g_mutex_lock (&fs_caps_lock);
+    if (fs_caps) {
+        caps = fs_caps;
+        g_mutex_unlock (&fs_caps_lock);
+        return caps;
+    }
+
+    for (n = 0; fs_info[n].type != NULL; n++);
+
+    caps = g_new0 (BDFSCapabilities *, n + 1);
+    for (i = 0; i < n; i++) {
+        caps[i] = g_new0 (BDFSCapabilities, 1);
+        caps[i]->fstype = g_strdup (fs_info[i].type);
+        caps[i]->mkfs = caps_util_available (fs_info[i].mkfs_util);
+        caps[i]->mkfs_options = fs_info[i].mkfs_options;
+        caps[i]->resize = caps_util_available (fs_info[i].resize_util);
+        caps[i]->resize_mode = fs_info[i].resize_mode;
+        caps[i]->check = caps_util_available (fs_info[i].check_util);
+        caps[i]->repair = caps_util_available (fs_info[i].repair_util);
+        caps[i]->set_label = caps_util_available (fs_info[i].label_util);
+        caps[i]->set_uuid = caps_util_available (fs_info[i].uuid_util);
+        caps[i]->query = caps_util_available (fs_info[i].info_util);
+    }
+
+    fs_caps = caps;
+    g_mutex_unlock (&fs_caps_lock);
+
+    return caps;
+}
+
+/**
+ * fs_capabilities_cleanup:
+ *
+ * Drops the cached capability matrix (if any).
+ */
+void fs_capabilities_cleanup (void) {
+    BDFSCapabilities **caps_p = NULL;
+
+    g_mutex_lock (&fs_caps_lock);
+    if (fs_caps) {
+        for (caps_p = fs_caps; *caps_p; caps_p++)
+            bd_fs_capabilities_free (*caps_p);
+        g_free (fs_caps);
+        fs_caps = NULL;
+    }
+    g_mutex_unlock (&fs_caps_lock);
 }
 
 static gboolean query_fs_operation (const gchar *fs_type, BDFsOpType op, gchar **required_utility, BDFsResizeFlags *mode, BDFSMkfsOptionsFlags *options, GError **error) {
@@ -1430,19 +2139,6 @@ gboolean bd_fs_unfreeze (const gchar *mountpoint, GError **error) {
     return fs_freeze (mountpoint, FALSE, error);
 }
 
-extern BDExtraArg** bd_fs_exfat_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_ext2_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_ext3_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_ext4_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_f2fs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_nilfs2_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_ntfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_reiserfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_vfat_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_xfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_btrfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
-
 /**
  * bd_fs_mkfs:
  * @device: the device to create the new filesystem on
@@ -1470,53 +2166,278 @@ extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDEx
  */
 gboolean bd_fs_mkfs (const gchar *device, const gchar *fstype, BDFSMkfsOptions *options, const BDExtraArg **extra, GError **error) {
     BDExtraArg **extra_args = NULL;
+    const BDFSOps *ops = NULL;
     gboolean ret = FALSE;
 
-    if (g_strcmp0 (fstype, "exfat") == 0) {
-        extra_args = bd_fs_exfat_mkfs_options (options, extra);
-        ret = bd_fs_exfat_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "ext2") == 0) {
-        extra_args = bd_fs_ext2_mkfs_options (options, extra);
-        ret = bd_fs_ext2_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "ext3") == 0) {
-        extra_args = bd_fs_ext3_mkfs_options (options, extra);
-        ret = bd_fs_ext3_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "ext4") == 0) {
-        extra_args = bd_fs_ext4_mkfs_options (options, extra);
-        ret = bd_fs_ext4_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "f2fs") == 0) {
-        extra_args = bd_fs_f2fs_mkfs_options (options, extra);
-        ret = bd_fs_f2fs_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "nilfs2") == 0) {
-        extra_args = bd_fs_nilfs2_mkfs_options (options, extra);
-        ret = bd_fs_nilfs2_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "ntfs") == 0) {
-        extra_args = bd_fs_ntfs_mkfs_options (options, extra);
-        ret = bd_fs_ntfs_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "reiserfs") == 0) {
-        extra_args = bd_fs_reiserfs_mkfs_options (options, extra);
-        ret = bd_fs_reiserfs_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "vfat") == 0) {
-        extra_args = bd_fs_vfat_mkfs_options (options, extra);
-        ret = bd_fs_vfat_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "xfs") == 0) {
-        extra_args = bd_fs_xfs_mkfs_options (options, extra);
-        ret = bd_fs_xfs_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "btrfs") == 0) {
-        extra_args = bd_fs_btrfs_mkfs_options (options, extra);
-        ret = bd_fs_btrfs_mkfs (device, (const BDExtraArg **) extra_args, error);
-    } else if (g_strcmp0 (fstype, "udf") == 0) {
-        extra_args = bd_fs_udf_mkfs_options (options, extra);
-        ret = bd_fs_udf_mkfs (device, NULL, NULL, 0, (const BDExtraArg **) extra_args, error);
-    } else {
+    ops = get_fs_ops (fstype);
+    if (!ops) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
                      "Filesystem '%s' is not supported.", fstype);
         return FALSE;
     }
 
+    extra_args = ops->mkfs_options (options, extra);
+    ret = ops->mkfs (device, (const BDExtraArg **) extra_args, error);
+
     for (BDExtraArg **arg_p = extra_args; *arg_p; arg_p++)
         bd_extra_arg_free (*arg_p);
     g_free (extra_args);
 
+    /* the mkfs utility may have written to the device even when it failed */
+    bd_utils_probe_cache_invalidate (device);
+
+    return ret;
+}
+
+/* one device of a batched fs operation */
+static void fs_batch_worker (gpointer data, gpointer pool_data __attribute__((unused))) {
+    FsBatchTask *task = (FsBatchTask *) data;
+    FsBatchState *state = task->state;
+
+    /* progress of the individual operations is muted, only the combined
+       progress of the whole batch is reported */
+    bd_utils_mute_prog_reporting_thread (NULL);
+
+    task->success = state->op (task);
+
+    /* unmute before reporting the combined progress and so that the mute does
+       not leak into unrelated work later scheduled on this (shared) pool
+       thread */
+    bd_utils_unmute_prog_reporting_thread (NULL);
+
+    g_mutex_lock (&state->lock);
+    state->done++;
+    state->remaining--;
+    bd_utils_report_progress (state->progress_id, (state->done * 100) / state->total, NULL);
+    g_cond_signal (&state->cond);
+    g_mutex_unlock (&state->lock);
+}
+
+/**
+ * run_fs_batch:
+ * @tasks: array of @count tasks with the device and operation data filled in
+ * @count: number of the tasks
+ * @max_parallel: maximum number of operations running at the same time (0 for
+ *                the number of online CPUs)
+ * @op: the operation to run for every task
+ * @verb_ing: description of the operation for the progress messages
+ *            (e.g. "formatting")
+ * @verb: description of the operation for the error message (e.g. "format")
+ * @item_errors: (allow-none): array of @count elements to store the per-device
+ *               errors in or %NULL
+ * @error: (out): place to store error (if any)
+ *
+ * Runs @op for all the @tasks on a thread pool with at most @max_parallel of
+ * them in flight at any time, reporting the combined progress of the batch.
+ *
+ * Returns: whether all the operations succeeded or not
+ */
+gboolean run_fs_batch (FsBatchTask *tasks, guint count, guint max_parallel, FsBatchOp op, const gchar *verb_ing, const gchar *verb, GError **item_errors, GError **error) {
+    GThreadPool *pool = NULL;
+    FsBatchState state;
+    guint i = 0;
+    guint n_failed = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    if (count == 0)
+        return TRUE;
+    if (max_parallel == 0)
+        max_parallel = g_get_num_processors ();
+
+    g_mutex_init (&state.lock);
+    g_cond_init (&state.cond);
+    state.remaining = count;
+    state.done = 0;
+    state.total = count;
+    state.op = op;
+
+    msg = g_strdup_printf ("Started %s batch of %u devices", verb_ing, count);
+    state.progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    pool = g_thread_pool_new (fs_batch_worker, NULL, (gint) max_parallel, FALSE, &l_error);
+    if (!pool) {
+        bd_utils_report_finished (state.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        g_mutex_clear (&state.lock);
+        g_cond_clear (&state.cond);
+        return FALSE;
+    }
+
+    for (i = 0; i < count; i++) {
+        tasks[i].state = &state;
+        g_thread_pool_push (pool, &tasks[i], NULL);
+    }
+
+    g_mutex_lock (&state.lock);
+    while (state.remaining > 0)
+        g_cond_wait (&state.cond, &state.lock);
+    g_mutex_unlock (&state.lock);
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i = 0; i < count; i++) {
+        if (!tasks[i].success)
+            n_failed++;
+        if (item_errors)
+            item_errors[i] = tasks[i].error;
+        else
+            g_clear_error (&tasks[i].error);
+    }
+
+    if (n_failed > 0) {
+        g_set_error (&l_error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to %s %u of the %u filesystems", verb, n_failed, count);
+        bd_utils_report_finished (state.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+    } else
+        bd_utils_report_finished (state.progress_id, "Completed");
+
+    g_mutex_clear (&state.lock);
+    g_cond_clear (&state.cond);
+
+    return n_failed == 0;
+}
+
+static gboolean fs_batch_mkfs_op (FsBatchTask *task) {
+    BDFSMkfsItem *item = (BDFSMkfsItem *) task->op_data;
+
+    return bd_fs_mkfs (item->device, item->fstype, item->options, NULL, &task->error);
+}
+
+static gboolean fs_batch_check_op (FsBatchTask *task) {
+    return bd_fs_check (task->device, &task->error);
+}
+
+static gboolean fs_batch_repair_op (FsBatchTask *task) {
+    return bd_fs_repair (task->device, &task->error);
+}
+
+/**
+ * bd_fs_mkfs_many:
+ * @items: (array length=count): specifications of the filesystems to create
+ * @count: number of the specifications in @items
+ * @max_parallel: maximum number of mkfs utilities running at the same time
+ *                (0 for the number of online CPUs)
+ * @item_errors: (out caller-allocates) (allow-none) (array length=count): place
+ *               to store the per-device errors (%NULL for devices that were
+ *               successfully formatted) or %NULL
+ * @error: (out): place to store error (if any)
+ *
+ * Creates the given filesystems on the given devices concurrently with at most
+ * @max_parallel mkfs utilities running at any time. Every item is processed
+ * the same way %bd_fs_mkfs would process it, an error on one device doesn't
+ * stop the formatting of the remaining devices. Combined progress of the
+ * whole batch is reported through the standard progress reporting machinery
+ * (one step per formatted device, scaled to 100); progress of the individual
+ * mkfs runs is muted.
+ *
+ * Returns: whether all the filesystems were successfully created or not (see
+ *          @item_errors for the per-device errors)
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_CREATE
+ *
+ */
+gboolean bd_fs_mkfs_many (BDFSMkfsItem **items, guint count, guint max_parallel, GError **item_errors, GError **error) {
+    FsBatchTask *tasks = NULL;
+    gboolean ret = FALSE;
+    guint i = 0;
+
+    if (count == 0)
+        return TRUE;
+
+    tasks = g_new0 (FsBatchTask, count);
+    for (i = 0; i < count; i++) {
+        tasks[i].device = items[i]->device;
+        tasks[i].op_data = items[i];
+    }
+
+    ret = run_fs_batch (tasks, count, max_parallel, fs_batch_mkfs_op, "formatting", "create", item_errors, error);
+    g_free (tasks);
+
+    return ret;
+}
+
+/**
+ * bd_fs_check_many:
+ * @devices: (array length=count): devices the file systems of which to check
+ * @count: number of the devices in @devices
+ * @max_parallel: maximum number of check utilities running at the same time
+ *                (0 for the number of online CPUs)
+ * @item_errors: (out caller-allocates) (allow-none) (array length=count): place
+ *               to store the per-device errors (%NULL for devices that passed
+ *               the check) or %NULL
+ * @error: (out): place to store error (if any)
+ *
+ * Checks the file systems on the given devices concurrently with at most
+ * @max_parallel check utilities running at any time. Every device is processed
+ * the same way %bd_fs_check would process it, a failed check on one device
+ * doesn't stop the checks of the remaining devices. Combined progress of the
+ * whole batch is reported through the standard progress reporting machinery;
+ * progress of the individual checks is muted.
+ *
+ * Returns: whether all the file systems passed the consistency check or not
+ *          (see @item_errors for the per-device errors)
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_CHECK
+ *
+ */
+gboolean bd_fs_check_many (const gchar **devices, guint count, guint max_parallel, GError **item_errors, GError **error) {
+    FsBatchTask *tasks = NULL;
+    gboolean ret = FALSE;
+    guint i = 0;
+
+    if (count == 0)
+        return TRUE;
+
+    tasks = g_new0 (FsBatchTask, count);
+    for (i = 0; i < count; i++)
+        tasks[i].device = devices[i];
+
+    ret = run_fs_batch (tasks, count, max_parallel, fs_batch_check_op, "checking", "check", item_errors, error);
+    g_free (tasks);
+
+    return ret;
+}
+
+/**
+ * bd_fs_repair_many:
+ * @devices: (array length=count): devices the file systems of which to repair
+ * @count: number of the devices in @devices
+ * @max_parallel: maximum number of repair utilities running at the same time
+ *                (0 for the number of online CPUs)
+ * @item_errors: (out caller-allocates) (allow-none) (array length=count): place
+ *               to store the per-device errors (%NULL for devices that were
+ *               successfully repaired) or %NULL
+ * @error: (out): place to store error (if any)
+ *
+ * Repairs the file systems on the given devices concurrently with at most
+ * @max_parallel repair utilities running at any time. Every device is
+ * processed the same way %bd_fs_repair would process it, a failed repair on
+ * one device doesn't stop the repairs of the remaining devices. Combined
+ * progress of the whole batch is reported through the standard progress
+ * reporting machinery; progress of the individual repairs is muted.
+ *
+ * Returns: whether all the file systems were successfully repaired or not
+ *          (see @item_errors for the per-device errors)
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_REPAIR
+ *
+ */
+gboolean bd_fs_repair_many (const gchar **devices, guint count, guint max_parallel, GError **item_errors, GError **error) {
+    FsBatchTask *tasks = NULL;
+    gboolean ret = FALSE;
+    guint i = 0;
+
+    if (count == 0)
+        return TRUE;
+
+    tasks = g_new0 (FsBatchTask, count);
+    for (i = 0; i < count; i++)
+        tasks[i].device = devices[i];
+
+    ret = run_fs_batch (tasks, count, max_parallel, fs_batch_repair_op, "repairing", "repair", item_errors, error);
+    g_free (tasks);
+
     return ret;
 }
@@ -5,7 +5,9 @@
 
 gboolean bd_fs_wipe (const gchar *device, gboolean all, GError **error);
 gboolean bd_fs_clean (const gchar *device, GError **error);
+gboolean bd_fs_zero_device (const gchar *device, GError **error);
 gchar* bd_fs_get_fstype (const gchar *device,  GError **error);
+gboolean bd_fs_set_probe_cache (gboolean enabled, GError **error);
 
 gboolean bd_fs_freeze (const gchar *mountpoint, GError **error);
 gboolean bd_fs_unfreeze (const gchar *mountpoint, GError **error);
@@ -27,9 +29,21 @@ typedef struct BDFSMkfsOptions {
 
 gboolean bd_fs_mkfs (const gchar *device, const gchar *fstype, BDFSMkfsOptions *options, const BDExtraArg **extra, GError **error);
 
+typedef struct BDFSMkfsItem {
+    const gchar *device;
+    const gchar *fstype;
+    BDFSMkfsOptions *options;
+} BDFSMkfsItem;
+
+gboolean bd_fs_mkfs_many (BDFSMkfsItem **items, guint count, guint max_parallel, GError **item_errors, GError **error);
+
 gboolean bd_fs_resize (const gchar *device, guint64 new_size, GError **error);
+gboolean bd_fs_resize_async (const gchar *device, guint64 new_size, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error);
+gboolean bd_fs_resize_finish (GAsyncResult *result, GError **error);
 gboolean bd_fs_repair (const gchar *device, GError **error);
 gboolean bd_fs_check (const gchar *device, GError **error);
+gboolean bd_fs_check_many (const gchar **devices, guint count, guint max_parallel, GError **item_errors, GError **error);
+gboolean bd_fs_repair_many (const gchar **devices, guint count, guint max_parallel, GError **item_errors, GError **error);
 gboolean bd_fs_set_label (const gchar *device, const gchar *label, GError **error);
 gboolean bd_fs_set_uuid (const gchar *device, const gchar *uuid, GError **error);
 guint64 bd_fs_get_size (const gchar *device, GError **error);
@@ -42,6 +56,24 @@ typedef enum {
     BD_FS_ONLINE_GROW = 1 << 4
 } BDFsResizeFlags;
 
+typedef struct BDFSCapabilities {
+    gchar *fstype;
+    gboolean mkfs;
+    BDFSMkfsOptionsFlags mkfs_options;
+    gboolean resize;
+    BDFsResizeFlags resize_mode;
+    gboolean check;
+    gboolean repair;
+    gboolean set_label;
+    gboolean set_uuid;
+    gboolean query;
+} BDFSCapabilities;
+
+BDFSCapabilities* bd_fs_capabilities_copy (BDFSCapabilities *data);
+void bd_fs_capabilities_free (BDFSCapabilities *data);
+
+BDFSCapabilities** bd_fs_get_capabilities (GError **error);
+
 gboolean bd_fs_can_mkfs (const gchar *type, BDFSMkfsOptionsFlags *options, gchar **required_utility, GError **error);
 gboolean bd_fs_can_resize (const gchar *type, BDFsResizeFlags *mode, gchar **required_utility, GError **error);
 gboolean bd_fs_can_check (const gchar *type, gchar **required_utility, GError **error);
@@ -51,4 +83,6 @@ gboolean bd_fs_can_set_uuid (const gchar *type, gchar **required_utility, GError
 gboolean bd_fs_can_get_size (const gchar *type, gchar **required_utility, GError **error);
 gboolean bd_fs_can_get_free_space (const gchar *type, gchar **required_utility, GError **error);
 
+void fs_capabilities_cleanup (void) __attribute__ ((visibility ("hidden")));
+
 #endif  /* BD_FS_GENERIC */
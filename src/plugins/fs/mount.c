@@ -28,9 +28,12 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
+#include <poll.h>
 
 #include "fs.h"
 #include "mount.h"
+#include "common.h"
 
 #define MOUNT_ERR_BUF_SIZE 1024
 
@@ -42,6 +45,9 @@ typedef struct MountArgs {
     const gchar *spec;
     gboolean lazy;
     gboolean force;
+    /* (allow-none) preparsed fstab to use instead of parsing it in the
+       libmount context (shared by the batched mounts) */
+    struct libmnt_table *fstab;
 } MountArgs;
 
 typedef gboolean (*MountFunc) (MountArgs *args, GError **error);
@@ -253,6 +259,7 @@ static gboolean get_mount_error_old (struct libmnt_context *cxt, int rc, MountAr
                       ro_args.device = args->device;
                       ro_args.mountpoint = args->mountpoint;
                       ro_args.fstype = args->fstype;
+                      ro_args.fstab = args->fstab;
                       if (!args->options)
                           ro_args.options = g_strdup ("ro");
                       else
@@ -409,6 +416,15 @@ static gboolean do_mount (MountArgs *args, GError **error) {
         }
     }
 
+    if (args->fstab) {
+        if (mnt_context_set_fstab (cxt, args->fstab) != 0) {
+            g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                         "Failed to set the preparsed fstab for mount");
+            mnt_free_context(cxt);
+            return FALSE;
+        }
+    }
+
 #ifdef LIBMOUNT_NEW_ERR_API
     /* we don't want libmount to try RDONLY mounts if we were explicitly given the "rw" option */
     if (args->options && (mnt_optstr_get_option (args->options, "rw", NULL, NULL) == 0))
@@ -688,6 +704,7 @@ gboolean bd_fs_mount (const gchar *device, const gchar *mountpoint, const gchar
     args.mountpoint = mountpoint;
     args.fstype = fstype;
     args.options = options;
+    args.fstab = NULL;
 
     current_uid = getuid ();
     run_as_uid = current_uid;
@@ -731,27 +748,193 @@ gboolean bd_fs_mount (const gchar *device, const gchar *mountpoint, const gchar
     return TRUE;
 }
 
+/* one mount of a batch together with the fstab shared by the whole batch */
+typedef struct MountBatchData {
+    BDFSMountSpec *spec;
+    struct libmnt_table *fstab;
+} MountBatchData;
+
+static gboolean fs_batch_mount_op (FsBatchTask *task) {
+    MountBatchData *data = (MountBatchData *) task->op_data;
+    MountArgs args;
+
+    args.device = data->spec->device;
+    args.mountpoint = data->spec->mountpoint;
+    args.fstype = data->spec->fstype;
+    args.options = data->spec->options;
+    args.fstab = data->fstab;
+
+    return do_mount (&args, &task->error);
+}
+
+static gboolean fs_batch_unmount_op (FsBatchTask *task) {
+    BDFSUnmountSpec *spec = (BDFSUnmountSpec *) task->op_data;
+    MountArgs args;
+
+    args.spec = spec->spec;
+    args.lazy = spec->lazy;
+    args.force = spec->force;
+
+    return do_unmount (&args, &task->error);
+}
+
 /**
- * bd_fs_get_mountpoint:
- * @device: device to find mountpoint for
+ * bd_fs_mount_many:
+ * @specs: (array length=count): specifications of the mounts to perform
+ * @count: number of the specifications in @specs
+ * @max_parallel: maximum number of mounts running at the same time (0 for the
+ *                number of online CPUs)
+ * @item_errors: (out caller-allocates) (allow-none) (array length=count): place
+ *               to store the per-mount errors (%NULL for specs that were
+ *               successfully mounted) or %NULL
  * @error: (out): place to store error (if any)
  *
- * Get mountpoint for @device. If @device is mounted multiple times only
- * one mountpoint will be returned.
+ * Mounts the given specs concurrently with at most @max_parallel mounts in
+ * flight at any time. Every spec is processed the same way %bd_fs_mount would
+ * process it, an error on one mount doesn't stop the remaining mounts.
+ * The fstab is parsed only once and shared by all the mounts of the batch
+ * instead of every libmount context parsing it again. Combined progress of
+ * the whole batch is reported through the standard progress reporting
+ * machinery. Unlike with %bd_fs_mount there is no support for the
+ * 'run_as_uid'/'run_as_gid' extra options, the mounts are performed as the
+ * current user.
  *
- * Returns: (transfer full): mountpoint for @device, %NULL in case device is
- *                           not mounted or in case of an error (@error is set
- *                           in this case)
+ * Returns: whether all the specs were successfully mounted or not (see
+ *          @item_errors for the per-mount errors)
  *
  * Tech category: %BD_FS_TECH_MOUNT (no mode, ignored)
  */
-gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
+gboolean bd_fs_mount_many (BDFSMountSpec **specs, guint count, guint max_parallel, GError **item_errors, GError **error) {
+    FsBatchTask *tasks = NULL;
+    MountBatchData *data = NULL;
+    struct libmnt_table *fstab = NULL;
+    gboolean ret = FALSE;
+    guint i = 0;
+
+    if (count == 0)
+        return TRUE;
+
+    /* parse the fstab once for the whole batch; a missing or broken fstab is
+       only a problem for the specs that actually need it, those fail on their
+       own with a sensible error */
+    fstab = mnt_new_table_from_file (mnt_get_fstab_path ());
+
+    tasks = g_new0 (FsBatchTask, count);
+    data = g_new0 (MountBatchData, count);
+    for (i = 0; i < count; i++) {
+        tasks[i].device = specs[i]->device ? specs[i]->device : specs[i]->mountpoint;
+        data[i].spec = specs[i];
+        data[i].fstab = fstab;
+        tasks[i].op_data = &data[i];
+    }
+
+    ret = run_fs_batch (tasks, count, max_parallel, fs_batch_mount_op, "mounting", "mount", item_errors, error);
+    g_free (tasks);
+    g_free (data);
+    if (fstab)
+        mnt_unref_table (fstab);
+
+    return ret;
+}
+
+/**
+ * bd_fs_unmount_many:
+ * @specs: (array length=count): specifications of the unmounts to perform
+ * @count: number of the specifications in @specs
+ * @max_parallel: maximum number of unmounts running at the same time (0 for
+ *                the number of online CPUs)
+ * @item_errors: (out caller-allocates) (allow-none) (array length=count): place
+ *               to store the per-unmount errors (%NULL for specs that were
+ *               successfully unmounted) or %NULL
+ * @error: (out): place to store error (if any)
+ *
+ * Unmounts the given specs concurrently with at most @max_parallel unmounts
+ * in flight at any time. Every spec is processed the same way %bd_fs_unmount
+ * would process it, an error on one unmount doesn't stop the remaining
+ * unmounts. Combined progress of the whole batch is reported through the
+ * standard progress reporting machinery. Unlike with %bd_fs_unmount there is
+ * no support for the 'run_as_uid'/'run_as_gid' extra options, the unmounts
+ * are performed as the current user.
+ *
+ * Returns: whether all the specs were successfully unmounted or not (see
+ *          @item_errors for the per-unmount errors)
+ *
+ * Tech category: %BD_FS_TECH_MOUNT (no mode, ignored)
+ */
+gboolean bd_fs_unmount_many (BDFSUnmountSpec **specs, guint count, guint max_parallel, GError **item_errors, GError **error) {
+    FsBatchTask *tasks = NULL;
+    gboolean ret = FALSE;
+    guint i = 0;
+
+    if (count == 0)
+        return TRUE;
+
+    tasks = g_new0 (FsBatchTask, count);
+    for (i = 0; i < count; i++) {
+        tasks[i].device = specs[i]->spec;
+        tasks[i].op_data = specs[i];
+    }
+
+    ret = run_fs_batch (tasks, count, max_parallel, fs_batch_unmount_op, "unmounting", "unmount", item_errors, error);
+    g_free (tasks);
+
+    return ret;
+}
+
+/* parsed mountinfo table shared by the mountpoint queries; re-parsed only
+   when the kernel signals a mount table change on the mountinfo fd */
+static GMutex mount_table_lock;
+static struct libmnt_table *mount_table = NULL;
+static struct libmnt_cache *mount_table_cache = NULL;
+static int mountinfo_fd = -1;
+
+static void drop_mount_table (void) {
+    if (mount_table) {
+        mnt_free_table (mount_table);
+        mount_table = NULL;
+    }
+    if (mount_table_cache) {
+        mnt_free_cache (mount_table_cache);
+        mount_table_cache = NULL;
+    }
+}
+
+/**
+ * get_mount_table:
+ *
+ * Returns the shared parsed mountinfo table, re-parsing it only if the kernel
+ * signalled a mount table change since the last parse. The events are checked
+ * with a zero-timeout poll on an open /proc/self/mountinfo fd, so steady-state
+ * queries don't touch the mount table at all. @mount_table_lock must be held
+ * by the caller for the whole time the returned table is used.
+ *
+ * Returns: the shared table or %NULL in case of error (@error is set)
+ */
+static struct libmnt_table* get_mount_table (GError **error) {
     struct libmnt_table *table = NULL;
-    struct libmnt_fs *fs = NULL;
     struct libmnt_cache *cache = NULL;
+    struct pollfd pfd;
+    gboolean stale = TRUE;
     gint ret = 0;
-    gchar *mountpoint = NULL;
-    const gchar *target = NULL;
+
+    if (mount_table && (mountinfo_fd != -1)) {
+        pfd.fd = mountinfo_fd;
+        pfd.events = POLLPRI;
+        pfd.revents = 0;
+        if (poll (&pfd, 1, 0) == 0)
+            stale = FALSE;
+    }
+
+    if (!stale)
+        return mount_table;
+
+    drop_mount_table ();
+
+    /* the change event is only cleared by re-reading the file so the fd needs
+       to be reopened for the next poll to start from a clean state */
+    if (mountinfo_fd != -1)
+        close (mountinfo_fd);
+    mountinfo_fd = open ("/proc/self/mountinfo", O_RDONLY|O_CLOEXEC);
 
     table = mnt_new_table ();
     cache = mnt_new_cache ();
@@ -761,6 +944,7 @@ gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Failed to set cache for mount info table.");
         mnt_free_table (table);
+        mnt_free_cache (cache);
         return NULL;
     }
 
@@ -773,25 +957,69 @@ gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
         return NULL;
     }
 
+    mount_table = table;
+    mount_table_cache = cache;
+
+    return mount_table;
+}
+
+/**
+ * fs_mount_table_cleanup:
+ *
+ * Drops the shared parsed mountinfo table (if any) and closes the fd used for
+ * watching the mount table changes.
+ */
+void fs_mount_table_cleanup (void) {
+    g_mutex_lock (&mount_table_lock);
+    drop_mount_table ();
+    if (mountinfo_fd != -1) {
+        close (mountinfo_fd);
+        mountinfo_fd = -1;
+    }
+    g_mutex_unlock (&mount_table_lock);
+}
+
+/**
+ * bd_fs_get_mountpoint:
+ * @device: device to find mountpoint for
+ * @error: (out): place to store error (if any)
+ *
+ * Get mountpoint for @device. If @device is mounted multiple times only
+ * one mountpoint will be returned.
+ *
+ * Returns: (transfer full): mountpoint for @device, %NULL in case device is
+ *                           not mounted or in case of an error (@error is set
+ *                           in this case)
+ *
+ * Tech category: %BD_FS_TECH_MOUNT (no mode, ignored)
+ */
+gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
+    struct libmnt_table *table = NULL;
+    struct libmnt_fs *fs = NULL;
+    gchar *mountpoint = NULL;
+    const gchar *target = NULL;
+
+    g_mutex_lock (&mount_table_lock);
+    table = get_mount_table (error);
+    if (!table) {
+        g_mutex_unlock (&mount_table_lock);
+        return NULL;
+    }
+
     fs = mnt_table_find_source (table, device, MNT_ITER_FORWARD);
     if (!fs) {
-        mnt_free_table (table);
-        mnt_free_cache (cache);
+        g_mutex_unlock (&mount_table_lock);
         return NULL;
     }
 
     target = mnt_fs_get_target (fs);
     if (!target) {
-        mnt_free_fs (fs);
-        mnt_free_table (table);
-        mnt_free_cache (cache);
+        g_mutex_unlock (&mount_table_lock);
         return NULL;
     }
 
     mountpoint = g_strdup (target);
-    mnt_free_fs (fs);
-    mnt_free_table (table);
-    mnt_free_cache (cache);
+    g_mutex_unlock (&mount_table_lock);
     return mountpoint;
 }
 
@@ -807,47 +1035,23 @@ gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
 gboolean bd_fs_is_mountpoint (const gchar *path, GError **error) {
     struct libmnt_table *table = NULL;
     struct libmnt_fs *fs = NULL;
-    struct libmnt_cache *cache = NULL;
     const gchar *target = NULL;
-    gint ret = 0;
-
-    table = mnt_new_table ();
-    cache = mnt_new_cache ();
-
-    ret = mnt_table_set_cache (table, cache);
-    if (ret != 0) {
-        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                     "Failed to set cache for mount info table.");
-        mnt_free_table (table);
-        return FALSE;
-    }
 
-    ret = mnt_table_parse_mtab (table, NULL);
-    if (ret != 0) {
-        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                     "Failed to parse mount info.");
-        mnt_free_table (table);
-        mnt_free_cache (cache);
+    g_mutex_lock (&mount_table_lock);
+    table = get_mount_table (error);
+    if (!table) {
+        g_mutex_unlock (&mount_table_lock);
         return FALSE;
     }
 
     fs = mnt_table_find_target (table, path, MNT_ITER_BACKWARD);
     if (!fs) {
-        mnt_free_table (table);
-        mnt_free_cache (cache);
+        g_mutex_unlock (&mount_table_lock);
         return FALSE;
     }
 
     target = mnt_fs_get_target (fs);
-    if (!target) {
-        mnt_free_fs (fs);
-        mnt_free_table (table);
-        mnt_free_cache (cache);
-        return FALSE;
-    }
+    g_mutex_unlock (&mount_table_lock);
 
-    mnt_free_fs (fs);
-    mnt_free_table (table);
-    mnt_free_cache (cache);
-    return TRUE;
+    return target != NULL;
 }
@@ -6,7 +6,25 @@
 
 gboolean bd_fs_unmount (const gchar *spec, gboolean lazy, gboolean force, const BDExtraArg **extra, GError **error);
 gboolean bd_fs_mount (const gchar *device, const gchar *mountpoint, const gchar *fstype, const gchar *options, const BDExtraArg **extra, GError **error);
+
+typedef struct BDFSMountSpec {
+    const gchar *device;
+    const gchar *mountpoint;
+    const gchar *fstype;
+    const gchar *options;
+} BDFSMountSpec;
+
+typedef struct BDFSUnmountSpec {
+    const gchar *spec;
+    gboolean lazy;
+    gboolean force;
+} BDFSUnmountSpec;
+
+gboolean bd_fs_mount_many (BDFSMountSpec **specs, guint count, guint max_parallel, GError **item_errors, GError **error);
+gboolean bd_fs_unmount_many (BDFSUnmountSpec **specs, guint count, guint max_parallel, GError **item_errors, GError **error);
 gchar* bd_fs_get_mountpoint (const gchar *device, GError **error);
 gboolean bd_fs_is_mountpoint (const gchar *path, GError **error);
 
+void fs_mount_table_cleanup (void) __attribute__ ((visibility ("hidden")));
+
 #endif  /* BD_FS_MOUNT */
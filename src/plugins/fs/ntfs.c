@@ -321,6 +321,28 @@ gboolean bd_fs_ntfs_check_uuid (const gchar *uuid, GError **error) {
 }
 
 
+static gboolean extract_ntfsresize_progress (const gchar *line, guint8 *completion) {
+    /* ntfsresize redraws its progress in place ("12.34 percent completed\r")
+       so one line flushed to us may carry many updates, use the last one */
+    const gchar *cursor = NULL;
+    const gchar *last = NULL;
+    gdouble perc = 0.0;
+
+    for (cursor = strstr (line, "percent completed"); cursor; cursor = strstr (cursor + 1, "percent completed"))
+        last = cursor;
+    if (!last)
+        return FALSE;
+
+    /* walk back to the beginning of the number */
+    cursor = last;
+    while (cursor > line && (g_ascii_isdigit (*(cursor - 1)) || *(cursor - 1) == '.' || *(cursor - 1) == ' '))
+        cursor--;
+    perc = g_ascii_strtod (cursor, NULL);
+
+    *completion = (guint8) CLAMP (perc, 0.0, 100.0);
+    return TRUE;
+}
+
 /**
  * bd_fs_ntfs_resize:
  * @device: the device the file system of which to resize
@@ -339,6 +361,8 @@ gboolean bd_fs_ntfs_resize (const gchar *device, guint64 new_size, GError **erro
     if (!check_deps (&avail_deps, DEPS_NTFSRESIZE_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
+    gint status = 0;
+
     if (new_size != 0) {
         args[1] = "-s";
         args[2] = g_strdup_printf ("%"G_GUINT64_FORMAT, new_size);
@@ -346,7 +370,7 @@ gboolean bd_fs_ntfs_resize (const gchar *device, guint64 new_size, GError **erro
     } else {
         args[1] = device;
     }
-    ret = bd_utils_exec_and_report_error (args, NULL, error);
+    ret = bd_utils_exec_and_report_progress (args, NULL, extract_ntfsresize_progress, &status, error);
 
     g_free ((gchar *) args[2]);
     return ret;
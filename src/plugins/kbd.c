@@ -32,6 +32,8 @@
 
 #define SECTOR_SIZE 512
 
+#define UNUSED __attribute__((unused))
+
 /**
  * SECTION: kbd
  * @short_description: plugin for operations with kernel block devices
@@ -143,6 +145,9 @@ gboolean bd_kbd_init (void) {
  */
 void bd_kbd_close (void) {
     freelocale (c_locale);
+
+    /* disable the status caching and drop the cached data (if any) */
+    bd_kbd_set_bcache_status_cache (0, NULL);
 }
 
 /**
@@ -178,6 +183,7 @@ BDKBDZramStats* bd_kbd_zram_stats_copy (BDKBDZramStats *data) {
         return NULL;
 
     BDKBDZramStats *new = g_new0 (BDKBDZramStats, 1);
+    new->device = g_strdup (data->device);
     new->disksize = data->disksize;
     new->num_reads = data->num_reads;
     new->num_writes = data->num_writes;
@@ -196,6 +202,7 @@ void bd_kbd_zram_stats_free (BDKBDZramStats *data) {
     if (data == NULL)
         return;
 
+    g_free (data->device);
     g_free (data->comp_algorithm);
     g_free (data);
 }
@@ -206,6 +213,7 @@ BDKBDBcacheStats* bd_kbd_bcache_stats_copy (BDKBDBcacheStats *data) {
 
     BDKBDBcacheStats *new = g_new0 (BDKBDBcacheStats, 1);
 
+    new->device = g_strdup (data->device);
     new->state = g_strdup (data->state);
     new->block_size = data->block_size;
     new->cache_size = data->cache_size;
@@ -222,10 +230,54 @@ void bd_kbd_bcache_stats_free (BDKBDBcacheStats *data) {
     if (data == NULL)
         return;
 
+    g_free (data->device);
     g_free (data->state);
     g_free (data);
 }
 
+typedef struct ZramConfigTask {
+    guint64 dev_num;
+    guint64 size;
+    guint64 nstreams;           /* 0 == use the default */
+    GError *error;
+} ZramConfigTask;
+
+static void zram_config_task_func (gpointer task_data, gpointer data UNUSED) {
+    ZramConfigTask *task = task_data;
+    gchar *dir_path = NULL;
+    gchar *nstreams_str = NULL;
+    gchar *size_str = NULL;
+    BDUtilsSysfsAttr nstreams_attr;
+    BDUtilsSysfsAttr size_attr;
+    const BDUtilsSysfsAttr *attrs[3] = {NULL, NULL, NULL};
+    guint n_attrs = 0;
+
+    /* compression streams have to be specified before the device is activated
+       by setting its size */
+    if (task->nstreams > 0) {
+        nstreams_str = g_strdup_printf ("%"G_GUINT64_FORMAT, task->nstreams);
+        nstreams_attr.attr = "max_comp_streams";
+        nstreams_attr.value = nstreams_str;
+        attrs[n_attrs++] = &nstreams_attr;
+    }
+
+    /* activating the device by setting its size comes last */
+    size_str = g_strdup_printf ("%"G_GUINT64_FORMAT, task->size);
+    size_attr.attr = "disksize";
+    size_attr.value = size_str;
+    attrs[n_attrs++] = &size_attr;
+
+    /* the device's sysfs directory is opened and resolved only once for all
+       the attributes */
+    dir_path = g_strdup_printf ("/sys/block/zram%"G_GUINT64_FORMAT, task->dev_num);
+    if (!bd_utils_sysfs_write_attrs (dir_path, attrs, &task->error))
+        g_prefix_error (&task->error, "Failed to configure '/dev/zram%"G_GUINT64_FORMAT"': ", task->dev_num);
+
+    g_free (dir_path);
+    g_free (nstreams_str);
+    g_free (size_str);
+}
+
 /**
  * bd_kbd_zram_create_devices:
  * @num_devices: number of devices to create
@@ -239,15 +291,19 @@ void bd_kbd_bcache_stats_free (BDKBDBcacheStats *data) {
  *
  * **Lengths of @size and @nstreams (if given) have to be >= @num_devices!**
  *
+ * The per-device configuration (which is where the kernel synchronously
+ * allocates the device's structures) is done in parallel.
+ *
  * Tech category: %BD_KBD_TECH_ZRAM-%BD_KBD_TECH_MODE_CREATE
  */
 gboolean bd_kbd_zram_create_devices (guint64 num_devices, const guint64 *sizes, const guint64 *nstreams, GError **error) {
     gchar *opts = NULL;
     gboolean success = FALSE;
     guint64 i = 0;
-    gchar *num_str = NULL;
-    gchar *file_name = NULL;
     guint64 progress_id = 0;
+    ZramConfigTask *tasks = NULL;
+    GThreadPool *pool = NULL;
+    GError *first_error = NULL;
 
     if (!check_module_deps (&avail_module_deps, MODULE_DEPS_ZRAM_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return FALSE;
@@ -282,36 +338,36 @@ gboolean bd_kbd_zram_create_devices (guint64 num_devices, const guint64 *sizes,
         return FALSE;
     }
 
-    /* compression streams have to be specified before the device is activated
-       by setting its size */
-    if (nstreams)
-        for (i=0; i < num_devices; i++) {
-            file_name = g_strdup_printf ("/sys/block/zram%"G_GUINT64_FORMAT"/max_comp_streams", i);
-            num_str = g_strdup_printf ("%"G_GUINT64_FORMAT, nstreams[i]);
-            success = bd_utils_echo_str_to_file (num_str, file_name, error);
-            g_free (file_name);
-            g_free (num_str);
-            if (!success) {
-                g_prefix_error (error, "Failed to set number of compression streams for '/dev/zram%"G_GUINT64_FORMAT"': ",
-                                i);
-                bd_utils_report_finished (progress_id, (*error)->message);
-                return FALSE;
-            }
-        }
+    /* configure the devices (streams and sizes) in parallel -- setting the
+       size makes the kernel allocate the device's structures synchronously
+       which takes a while for each of the devices */
+    tasks = g_new0 (ZramConfigTask, num_devices);
+    pool = g_thread_pool_new (zram_config_task_func, NULL, MIN (num_devices, 2 * g_get_num_processors ()), FALSE, NULL);
+    for (i=0; i < num_devices; i++) {
+        tasks[i].dev_num = i;
+        tasks[i].size = sizes[i];
+        tasks[i].nstreams = nstreams ? nstreams[i] : 0;
+        /* a failure here just means the task stays queued */
+        g_thread_pool_push (pool, tasks + i, NULL);
+    }
+    /* wait for all the tasks to finish */
+    g_thread_pool_free (pool, FALSE, TRUE);
 
-    /* now activate the devices by setting their sizes */
     for (i=0; i < num_devices; i++) {
-        file_name = g_strdup_printf ("/sys/block/zram%"G_GUINT64_FORMAT"/disksize", i);
-        num_str = g_strdup_printf ("%"G_GUINT64_FORMAT, sizes[i]);
-        success = bd_utils_echo_str_to_file (num_str, file_name, error);
-        g_free (file_name);
-        g_free (num_str);
-        if (!success) {
-            g_prefix_error (error, "Failed to set size for '/dev/zram%"G_GUINT64_FORMAT"': ", i);
-            bd_utils_report_finished (progress_id, (*error)->message);
-            return FALSE;
+        if (tasks[i].error) {
+            if (!first_error)
+                first_error = tasks[i].error;
+            else
+                g_clear_error (&tasks[i].error);
         }
     }
+    g_free (tasks);
+
+    if (first_error) {
+        bd_utils_report_finished (progress_id, first_error->message);
+        g_propagate_error (error, first_error);
+        return FALSE;
+    }
 
     bd_utils_report_finished (progress_id, "Completed");
     return TRUE;
@@ -474,141 +530,79 @@ gboolean bd_kbd_zram_remove_device (const gchar *device, GError **error) {
     return success;
 }
 
-/* Get the zRAM stats using the "old" sysfs files --  /sys/block/zram<id>/num_reads,
-   /sys/block/zram<id>/invalid_io etc. */
-static gboolean get_zram_stats_old (const gchar *device, BDKBDZramStats* stats, GError **error) {
-    gchar *path = NULL;
+/* Read a number attribute from @dir, turning any failure into the usual zRAM
+   error for the attribute */
+static gboolean get_zram_number_attr (BDUtilsSysfsDir *dir, const gchar *device, const gchar *attr, guint64 *num, GError **error) {
+    GError *l_error = NULL;
 
-    path = g_strdup_printf ("/sys/block/%s/num_reads", device);
-    stats->num_reads = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
+    if (!bd_utils_sysfs_dir_read_num (dir, attr, num, &l_error)) {
+        g_clear_error (&l_error);
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'num_reads' for '%s' zRAM device", device);
-        return FALSE;
-    }
-
-    path = g_strdup_printf ("/sys/block/%s/num_writes", device);
-    stats->num_writes = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'num_writes' for '%s' zRAM device", device);
-        return FALSE;
-    }
-
-    path = g_strdup_printf ("/sys/block/%s/invalid_io", device);
-    stats->invalid_io = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'invalid_io' for '%s' zRAM device", device);
-        return FALSE;
-    }
-
-    path = g_strdup_printf ("/sys/block/%s/zero_pages", device);
-    stats->zero_pages = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'zero_pages' for '%s' zRAM device", device);
-        return FALSE;
-    }
-
-    path = g_strdup_printf ("/sys/block/%s/orig_data_size", device);
-    stats->orig_data_size = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'orig_data_size' for '%s' zRAM device", device);
-        return FALSE;
-    }
-
-    path = g_strdup_printf ("/sys/block/%s/compr_data_size", device);
-    stats->compr_data_size = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'compr_data_size' for '%s' zRAM device", device);
-        return FALSE;
-    }
-
-    path = g_strdup_printf ("/sys/block/%s/mem_used_total", device);
-    stats->mem_used_total = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'mem_used_total' for '%s' zRAM device", device);
+                     "Failed to get '%s' for '%s' zRAM device", attr, device);
         return FALSE;
     }
 
     return TRUE;
 }
 
+/* Get the zRAM stats using the "old" sysfs files --  /sys/block/zram<id>/num_reads,
+   /sys/block/zram<id>/invalid_io etc. */
+static gboolean get_zram_stats_old (const gchar *device, BDUtilsSysfsDir *dir, BDKBDZramStats* stats, GError **error) {
+    return get_zram_number_attr (dir, device, "num_reads", &stats->num_reads, error) &&
+           get_zram_number_attr (dir, device, "num_writes", &stats->num_writes, error) &&
+           get_zram_number_attr (dir, device, "invalid_io", &stats->invalid_io, error) &&
+           get_zram_number_attr (dir, device, "zero_pages", &stats->zero_pages, error) &&
+           get_zram_number_attr (dir, device, "orig_data_size", &stats->orig_data_size, error) &&
+           get_zram_number_attr (dir, device, "compr_data_size", &stats->compr_data_size, error) &&
+           get_zram_number_attr (dir, device, "mem_used_total", &stats->mem_used_total, error);
+}
+
 /* Get the zRAM stats using the "new" sysfs files -- /sys/block/zram<id>/stat,
   /sys/block/zram<id>/io_stat etc. */
-static gboolean get_zram_stats_new (const gchar *device, BDKBDZramStats* stats, GError **error) {
-    gchar *path = NULL;
-    gboolean success = FALSE;
+static gboolean get_zram_stats_new (const gchar *device, BDUtilsSysfsDir *dir, BDKBDZramStats* stats, GError **error) {
+    const gchar *content = NULL;
     gint scanned = 0;
-    gchar *content = NULL;
 
-    path = g_strdup_printf ("/sys/block/%s/stat", device);
-    success = g_file_get_contents (path, &content, NULL, error);
-    g_free (path);
-    if (!success) {
+    content = bd_utils_sysfs_dir_read (dir, "stat", error);
+    if (!content) {
         /* error is already populated */
         return FALSE;
     }
 
     scanned = sscanf (content,
-                      "%*[ \t]%" G_GUINT64_FORMAT "%*[ \t]%*[0-9]%*[ \t]%*[0-9]%*[ \t]%*[0-9]%" G_GUINT64_FORMAT "",
+                      "%" G_GUINT64_FORMAT "%*[ \t]%*[0-9]%*[ \t]%*[0-9]%*[ \t]%*[0-9]%" G_GUINT64_FORMAT "",
                       &stats->num_reads, &stats->num_writes);
-    g_free (content);
     if (scanned != 2) {
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
                      "Failed to get 'stat' for '%s' zRAM device", device);
         return FALSE;
     }
 
-    path = g_strdup_printf ("/sys/block/%s/io_stat", device);
-    success = g_file_get_contents (path, &content, NULL, error);
-    g_free (path);
-    if (!success) {
+    content = bd_utils_sysfs_dir_read (dir, "io_stat", error);
+    if (!content) {
         /* error is already populated */
         return FALSE;
     }
 
     scanned = sscanf (content,
-                      "%*[ \t]%*[0-9]%*[ \t]%*[0-9]%*[ \t]%" G_GUINT64_FORMAT "",
+                      "%*[0-9]%*[ \t]%*[0-9]%*[ \t]%" G_GUINT64_FORMAT "",
                       &stats->invalid_io);
-    g_free (content);
     if (scanned != 1) {
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
                      "Failed to get 'io_stat' for '%s' zRAM device", device);
         return FALSE;
     }
 
-    path = g_strdup_printf ("/sys/block/%s/mm_stat", device);
-    success = g_file_get_contents (path, &content, NULL, error);
-    g_free (path);
-    if (!success) {
+    content = bd_utils_sysfs_dir_read (dir, "mm_stat", error);
+    if (!content) {
         /* error is already populated */
         return FALSE;
     }
 
     scanned = sscanf (content,
-                      "%*[ \t]%" G_GUINT64_FORMAT "%*[ \t]%" G_GUINT64_FORMAT "%*[ \t]%" G_GUINT64_FORMAT \
+                      "%" G_GUINT64_FORMAT "%*[ \t]%" G_GUINT64_FORMAT "%*[ \t]%" G_GUINT64_FORMAT \
                       "%*[ \t]%*[0-9]%*[ \t]%" G_GUINT64_FORMAT "",
                       &stats->orig_data_size, &stats->compr_data_size, &stats->mem_used_total, &stats->zero_pages);
-    g_free (content);
     if (scanned != 4) {
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
                      "Failed to get 'mm_stat' for '%s' zRAM device", device);
@@ -618,6 +612,50 @@ static gboolean get_zram_stats_new (const gchar *device, BDKBDZramStats* stats,
     return TRUE;
 }
 
+/* Get all the stats of the @device zRAM device from its (open) sysfs directory */
+static BDKBDZramStats* get_zram_stats (const gchar *device, BDUtilsSysfsDir *dir, GError **error) {
+    BDKBDZramStats *ret = NULL;
+    const gchar *content = NULL;
+    gboolean success = FALSE;
+    GError *l_error = NULL;
+
+    ret = g_new0 (BDKBDZramStats, 1);
+    ret->device = g_strdup (device);
+
+    if (!get_zram_number_attr (dir, device, "disksize", &ret->disksize, error) ||
+        !get_zram_number_attr (dir, device, "max_comp_streams", &ret->max_comp_streams, error)) {
+        bd_kbd_zram_stats_free (ret);
+        return NULL;
+    }
+
+    content = bd_utils_sysfs_dir_read (dir, "comp_algorithm", &l_error);
+    if (!content) {
+        g_clear_error (&l_error);
+        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
+                     "Failed to get 'comp_algorithm' for '%s' zRAM device", device);
+        bd_kbd_zram_stats_free (ret);
+        return NULL;
+    }
+    ret->comp_algorithm = g_strdup (content);
+
+    /* We need to read stats from different files on new and old kernels.
+       e.g. "num_reads" exits only on old kernels and "stat" (that replaces
+       "num_reads/writes/etc.") exists only on newer kernels.
+    */
+    if (bd_utils_sysfs_dir_has_attr (dir, "num_reads"))
+        success = get_zram_stats_old (device, dir, ret, error);
+    else
+        success = get_zram_stats_new (device, dir, ret, error);
+
+    if (!success) {
+        /* error is already populated */
+        bd_kbd_zram_stats_free (ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
 
 /**
  * bd_kbd_zram_get_stats:
@@ -630,93 +668,166 @@ static gboolean get_zram_stats_new (const gchar *device, BDKBDZramStats* stats,
  */
 BDKBDZramStats* bd_kbd_zram_get_stats (const gchar *device, GError **error) {
     gchar *path = NULL;
-    gboolean success = FALSE;
+    BDUtilsSysfsDir *dir = NULL;
     BDKBDZramStats *ret = NULL;
+    GError *l_error = NULL;
 
     if (!check_module_deps (&avail_module_deps, MODULE_DEPS_ZRAM_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
-    ret = g_new0 (BDKBDZramStats, 1);
-
     if (g_str_has_prefix (device, "/dev/"))
         device += 5;
 
     path = g_strdup_printf ("/sys/block/%s", device);
-    if (access (path, R_OK) != 0) {
+    dir = bd_utils_sysfs_dir_open (path, &l_error);
+    g_free (path);
+    if (!dir) {
+        g_clear_error (&l_error);
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_NOEXIST,
                      "Device '%s' doesn't seem to exist", device);
-        g_free (path);
-        g_free (ret);
         return NULL;
     }
-    g_free (path);
 
-    path = g_strdup_printf ("/sys/block/%s/disksize", device);
-    ret->disksize = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'disksize' for '%s' zRAM device", device);
-        g_free (ret);
+    ret = get_zram_stats (device, dir, error);
+    bd_utils_sysfs_dir_close (dir);
+
+    return ret;
+}
+
+/**
+ * bd_kbd_zram_get_stats_all:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): statistics for all the
+ * existing zRAM devices (an empty list if there are none) or %NULL in case of
+ * error
+ *
+ * Compared to calling bd_kbd_zram_get_stats() for every device separately this
+ * gathers the stats in a single sweep over sysfs, opening each device's
+ * directory only once. The device a particular item of the list belongs to is
+ * identified by its 'device' field.
+ *
+ * Tech category: %BD_KBD_TECH_ZRAM-%BD_KBD_TECH_MODE_QUERY
+ */
+BDKBDZramStats** bd_kbd_zram_get_stats_all (GError **error) {
+    glob_t globbuf;
+    gint status = 0;
+    guint64 i = 0;
+    guint64 n_stats = 0;
+    const gchar *device = NULL;
+    BDUtilsSysfsDir *dir = NULL;
+    BDKBDZramStats **ret = NULL;
+    GError *l_error = NULL;
+
+    if (!check_module_deps (&avail_module_deps, MODULE_DEPS_ZRAM_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return NULL;
-    }
 
-    path = g_strdup_printf ("/sys/block/%s/max_comp_streams", device);
-    ret->max_comp_streams = get_number_from_file (path, error);
-    g_free (path);
-    if (*error) {
-        g_clear_error (error);
+    status = glob ("/sys/block/zram*", GLOB_NOSORT, NULL, &globbuf);
+    if (status == GLOB_NOMATCH)
+        /* no zRAM devices, just an empty list */
+        return g_new0 (BDKBDZramStats*, 1);
+    else if (status != 0) {
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'max_comp_streams' for '%s' zRAM device", device);
-        g_free (ret);
+                     "Failed to list the zRAM devices in '/sys/block'");
         return NULL;
     }
 
-    path = g_strdup_printf ("/sys/block/%s/comp_algorithm", device);
-    success = g_file_get_contents (path, &(ret->comp_algorithm), NULL, error);
-    g_free (path);
-    if (!success) {
-        g_clear_error (error);
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_ZRAM_INVAL,
-                     "Failed to get 'comp_algorithm' for '%s' zRAM device", device);
-        g_free (ret);
-        return NULL;
+    ret = g_new0 (BDKBDZramStats*, globbuf.gl_pathc + 1);
+    for (i = 0; i < globbuf.gl_pathc; i++) {
+        device = globbuf.gl_pathv[i] + sizeof ("/sys/block/") - 1;
+        dir = bd_utils_sysfs_dir_open (globbuf.gl_pathv[i], &l_error);
+        if (!dir) {
+            /* the device disappeared between the listing and now, just skip it */
+            g_clear_error (&l_error);
+            continue;
+        }
+        ret[n_stats] = get_zram_stats (device, dir, &l_error);
+        bd_utils_sysfs_dir_close (dir);
+        if (!ret[n_stats]) {
+            g_propagate_error (error, l_error);
+            for (i = 0; i < n_stats; i++)
+                bd_kbd_zram_stats_free (ret[i]);
+            g_free (ret);
+            globfree (&globbuf);
+            return NULL;
+        }
+        n_stats++;
     }
-    /* remove the trailing space and newline */
-    g_strstrip (ret->comp_algorithm);
+    globfree (&globbuf);
 
-    /* We need to read stats from different files on new and old kernels.
-       e.g. "num_reads" exits only on old kernels and "stat" (that replaces
-       "num_reads/writes/etc.") exists only on newer kernels.
-    */
-    path = g_strdup_printf ("/sys/block/%s/num_reads", device);
-    if (g_file_test (path, G_FILE_TEST_EXISTS))
-      success = get_zram_stats_old (device, ret, error);
-    else
-      success = get_zram_stats_new (device, ret, error);
-    g_free (path);
+    return ret;
+}
 
-    if (!success) {
-        /* error is already populated */
-        g_free (ret);
-        return NULL;
+
+/* how long to wait for the kernel/udev to register a bcache device (seconds) */
+#define BCACHE_UEVENT_TIMEOUT 50
+
+typedef gboolean (*BcacheDoneFunc) (gpointer data);
+
+typedef struct BcacheUeventWait {
+    GMutex lock;
+    GCond cond;
+} BcacheUeventWait;
+
+static void bcache_uevent_cb (const gchar *device UNUSED, BDUtilsDeviceAction action UNUSED, guint64 devno UNUSED, gpointer user_data) {
+    BcacheUeventWait *wait = user_data;
+
+    /* the arrival of the event is all that matters, the actual condition is
+       re-checked by the waiter */
+    g_mutex_lock (&wait->lock);
+    g_cond_broadcast (&wait->cond);
+    g_mutex_unlock (&wait->lock);
+}
+
+/* Wait (at most %BCACHE_UEVENT_TIMEOUT seconds) until @done returns %TRUE,
+   re-checking it whenever a uevent arrives on the "block" subsystem instead of
+   sleeping and polling. Returns %FALSE with @error unset on timeout. */
+static gboolean wait_for_bcache_uevent (BcacheDoneFunc done, gpointer data, GError **error) {
+    BcacheUeventWait wait;
+    GError *l_error = NULL;
+    gint64 deadline = 0;
+    guint sub_id = 0;
+    gboolean ret = FALSE;
+
+    g_mutex_init (&wait.lock);
+    g_cond_init (&wait.cond);
+
+    /* the subscription has to be in place before the first check, otherwise
+       an event arriving between the check and the setup would be lost */
+    sub_id = bd_utils_subscribe_device_events (bcache_uevent_cb, &wait, &l_error);
+    if (sub_id == 0) {
+        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_SETUP_FAIL,
+                     "Failed to set up a uevent subscription: %s", l_error->message);
+        g_clear_error (&l_error);
+        g_mutex_clear (&wait.lock);
+        g_cond_clear (&wait.cond);
+        return FALSE;
+    }
+
+    deadline = g_get_monotonic_time () + BCACHE_UEVENT_TIMEOUT * G_USEC_PER_SEC;
+    g_mutex_lock (&wait.lock);
+    while (!(ret = done (data))) {
+        if (!g_cond_wait_until (&wait.cond, &wait.lock, deadline))
+            /* timeout, let the caller report what it was waiting for */
+            break;
     }
+    g_mutex_unlock (&wait.lock);
 
+    bd_utils_unsubscribe_device_events (sub_id, NULL);
+    g_mutex_clear (&wait.lock);
+    g_cond_clear (&wait.cond);
     return ret;
 }
 
+/* check that both of the (NULL-terminated list of) paths exist */
+static gboolean bcache_paths_exist (gpointer data) {
+    const gchar **paths = data;
+    guint i = 0;
 
-static gboolean wait_for_file (const char *filename) {
-    gint count = 500;
-    while (count > 0) {
-        g_usleep (100000); /* microseconds */
-        if (g_file_test (filename, G_FILE_TEST_EXISTS)) {
-            return TRUE;
-        }
-        --count;
-    }
-    return FALSE;
+    for (i = 0; paths[i]; i++)
+        if (access (paths[i], F_OK) != 0)
+            return FALSE;
+    return TRUE;
 }
 
 /**
@@ -749,6 +860,7 @@ gboolean bd_kbd_bcache_create (const gchar *backing_device, const gchar *cache_d
     gchar *msg = NULL;
     guint n = 0;
     gchar device_uuid[2][64];
+    gchar *uuid_paths[3] = {NULL, NULL, NULL};
 
     if (!check_deps (&avail_deps, DEPS_MAKEBCACHE_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
@@ -770,7 +882,7 @@ gboolean bd_kbd_bcache_create (const gchar *backing_device, const gchar *cache_d
 
     lines = g_strsplit (output, "\n", 0);
 
-    regex = g_regex_new ("^UUID:\\s+([-a-z0-9]+)", 0, 0, error);
+    regex = bd_utils_get_regex ("^UUID:\\s+([-a-z0-9]+)", error);
     if (!regex) {
         /* error is already populated */
         g_free (output);
@@ -792,7 +904,6 @@ gboolean bd_kbd_bcache_create (const gchar *backing_device, const gchar *cache_d
             g_match_info_free (match_info);
         }
     }
-    g_regex_unref (regex);
     g_strfreev (lines);
 
     if (n != 2) {
@@ -804,17 +915,20 @@ gboolean bd_kbd_bcache_create (const gchar *backing_device, const gchar *cache_d
     }
     g_free (output);
 
-    /* Wait for the symlinks to show up, would it be better to do a udev settle? */
-    for (i=0; i < 2; i++) {
-        const char *uuid_file = g_strdup_printf ("/dev/disk/by-uuid/%s", device_uuid[i]);
-        gboolean present = wait_for_file (uuid_file);
-        g_free ((gpointer)uuid_file);
-        if (!present) {
+    /* wait for the uuid symlinks to show up (i.e. for udev to process both of
+       the devices), driven by the uevents instead of polling */
+    uuid_paths[0] = g_strdup_printf ("/dev/disk/by-uuid/%s", device_uuid[0]);
+    uuid_paths[1] = g_strdup_printf ("/dev/disk/by-uuid/%s", device_uuid[1]);
+    success = wait_for_bcache_uevent (bcache_paths_exist, uuid_paths, error);
+    g_free (uuid_paths[0]);
+    g_free (uuid_paths[1]);
+    if (!success) {
+        if (*error == NULL)
             g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_NOEXIST,
-                         "Failed to locate uuid symlink '%s'", device_uuid[i]);
-            return FALSE;
-        }
-     }
+                         "Failed to locate uuid symlinks for '%s' and '%s'", device_uuid[0], device_uuid[1]);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
 
     /* get the name of the bcache device based on the @backing_device being its slave */
     dev_name = strrchr (backing_device, '/');
@@ -870,6 +984,9 @@ gboolean bd_kbd_bcache_create (const gchar *backing_device, const gchar *cache_d
  *
  * Returns: whether the @c_set_uuid cache was successfully attached to @bcache_device or not
  *
+ * The function doesn't return until the cache is actually attached (as
+ * announced by the kernel with a uevent) or a timeout is hit.
+ *
  * Tech category: %BD_KBD_TECH_BCACHE-%BD_KBD_TECH_MODE_MODIFY
  */
 gboolean bd_kbd_bcache_attach (const gchar *c_set_uuid, const gchar *bcache_device, GError **error) {
@@ -877,6 +994,7 @@ gboolean bd_kbd_bcache_attach (const gchar *c_set_uuid, const gchar *bcache_devi
     gboolean success = FALSE;
     guint64 progress_id = 0;
     gchar *msg = NULL;
+    gchar *cache_paths[2] = {NULL, NULL};
 
     msg = g_strdup_printf ("Started attaching '%s' cache to bcache device '%s'", c_set_uuid, bcache_device);
     progress_id = bd_utils_report_started (msg);
@@ -888,14 +1006,167 @@ gboolean bd_kbd_bcache_attach (const gchar *c_set_uuid, const gchar *bcache_devi
     path = g_strdup_printf ("/sys/block/%s/bcache/attach", bcache_device);
     success = bd_utils_echo_str_to_file (c_set_uuid, path, error);
     g_free (path);
+    if (!success) {
+        /* error is already populated */
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
 
-    /* error is already populated (if any) */
-    if (!success)
+    /* wait for the cache to actually be attached (signalled by a "change"
+       uevent on the bcache device), driven by the uevents instead of polling */
+    cache_paths[0] = g_strdup_printf ("/sys/block/%s/bcache/cache", bcache_device);
+    success = wait_for_bcache_uevent (bcache_paths_exist, cache_paths, error);
+    g_free (cache_paths[0]);
+    if (!success) {
+        if (*error == NULL)
+            g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_NOT_ATTACHED,
+                         "Timed out waiting for the '%s' cache to be attached to '%s'", c_set_uuid, bcache_device);
         bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
+
+typedef struct BcacheAsyncTask {
+    gchar *backing_device;      /* create only */
+    gchar *cache_device;        /* create only */
+    BDExtraArg **extra;         /* create only */
+    gchar *c_set_uuid;          /* attach only */
+    gchar *bcache_device;       /* attach only */
+    BDKBDBcacheCallback callback;
+    gpointer user_data;
+} BcacheAsyncTask;
+
+static void bcache_async_task_free (BcacheAsyncTask *task) {
+    BDExtraArg **arg_p = NULL;
+
+    g_free (task->backing_device);
+    g_free (task->cache_device);
+    for (arg_p = task->extra; arg_p && *arg_p; arg_p++)
+        bd_extra_arg_free (*arg_p);
+    g_free (task->extra);
+    g_free (task->c_set_uuid);
+    g_free (task->bcache_device);
+    g_free (task);
+}
+
+static gpointer bcache_create_async_task_func (gpointer data) {
+    BcacheAsyncTask *task = data;
+    const gchar *bcache_device = NULL;
+    GError *error = NULL;
+
+    if (bd_kbd_bcache_create (task->backing_device, task->cache_device, (const BDExtraArg **) task->extra, &bcache_device, &error))
+        task->callback (bcache_device, NULL, task->user_data);
     else
-        bd_utils_report_finished (progress_id, "Completed");
+        /* the callback takes the ownership of the error */
+        task->callback (NULL, error, task->user_data);
 
-    return success;
+    g_free ((gchar *) bcache_device);
+    bcache_async_task_free (task);
+    return NULL;
+}
+
+static gpointer bcache_attach_async_task_func (gpointer data) {
+    BcacheAsyncTask *task = data;
+    GError *error = NULL;
+
+    if (bd_kbd_bcache_attach (task->c_set_uuid, task->bcache_device, &error))
+        task->callback (task->bcache_device, NULL, task->user_data);
+    else
+        /* the callback takes the ownership of the error */
+        task->callback (NULL, error, task->user_data);
+
+    bcache_async_task_free (task);
+    return NULL;
+}
+
+/**
+ * bd_kbd_bcache_create_async:
+ * @backing_device: backing (slow) device of the cache
+ * @cache_device: cache (fast) device of the cache
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the creation (right now
+ *                                                 passed to the 'make-bcache' utility)
+ * @callback: (scope async): function called when the creation finishes
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Starts the same operation as bd_kbd_bcache_create() in a separate thread and
+ * returns immediately. @callback is run (from that thread) once the operation
+ * finishes, getting either the name of the new bcache device or the error.
+ *
+ * Returns: whether the creation was successfully started or not
+ *
+ * Tech category: %BD_KBD_TECH_BCACHE-%BD_KBD_TECH_MODE_CREATE
+ */
+gboolean bd_kbd_bcache_create_async (const gchar *backing_device, const gchar *cache_device, const BDExtraArg **extra, BDKBDBcacheCallback callback, gpointer user_data, GError **error) {
+    BcacheAsyncTask *task = NULL;
+    GThread *thread = NULL;
+    guint64 n_extra = 0;
+    guint64 i = 0;
+
+    if (!check_deps (&avail_deps, DEPS_MAKEBCACHE_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    task = g_new0 (BcacheAsyncTask, 1);
+    task->backing_device = g_strdup (backing_device);
+    task->cache_device = g_strdup (cache_device);
+    if (extra) {
+        for (n_extra = 0; extra[n_extra]; n_extra++);
+        task->extra = g_new0 (BDExtraArg*, n_extra + 1);
+        for (i = 0; i < n_extra; i++)
+            task->extra[i] = bd_extra_arg_copy ((BDExtraArg *) extra[i]);
+    }
+    task->callback = callback;
+    task->user_data = user_data;
+
+    thread = g_thread_try_new ("bcache-create", bcache_create_async_task_func, task, error);
+    if (!thread) {
+        g_prefix_error (error, "Failed to start the bcache creation thread: ");
+        bcache_async_task_free (task);
+        return FALSE;
+    }
+    g_thread_unref (thread);
+
+    return TRUE;
+}
+
+/**
+ * bd_kbd_bcache_attach_async:
+ * @c_set_uuid: cache set UUID of the cache to attach
+ * @bcache_device: bcache device to attach @c_set_uuid cache to
+ * @callback: (scope async): function called when the attachment finishes
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Starts the same operation as bd_kbd_bcache_attach() in a separate thread and
+ * returns immediately. @callback is run (from that thread) once the operation
+ * finishes, getting either the name of @bcache_device or the error.
+ *
+ * Returns: whether the attachment was successfully started or not
+ *
+ * Tech category: %BD_KBD_TECH_BCACHE-%BD_KBD_TECH_MODE_MODIFY
+ */
+gboolean bd_kbd_bcache_attach_async (const gchar *c_set_uuid, const gchar *bcache_device, BDKBDBcacheCallback callback, gpointer user_data, GError **error) {
+    BcacheAsyncTask *task = NULL;
+    GThread *thread = NULL;
+
+    task = g_new0 (BcacheAsyncTask, 1);
+    task->c_set_uuid = g_strdup (c_set_uuid);
+    task->bcache_device = g_strdup (bcache_device);
+    task->callback = callback;
+    task->user_data = user_data;
+
+    thread = g_thread_try_new ("bcache-attach", bcache_attach_async_task_func, task, error);
+    if (!thread) {
+        g_prefix_error (error, "Failed to start the bcache attachment thread: ");
+        bcache_async_task_free (task);
+        return FALSE;
+    }
+    g_thread_unref (thread);
+
+    return TRUE;
 }
 
 /**
@@ -1309,17 +1580,18 @@ static guint64 get_bcache_block_size (const gchar *bcache_device, GError **error
     return ret;
 }
 
-/**
- * bd_kbd_bcache_status:
- * @bcache_device: bcache device to get status for
- * @error: (out): place to store error (if any)
- *
- * Returns: (transfer full): status of the @bcache_device or %NULL in case of
- *                           error (@error is set)
- *
- * Tech category: %BD_KBD_TECH_BCACHE-%BD_KBD_TECH_MODE_QUERY
- */
-BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **error) {
+/* per-cache-set numbers shared by all the bcache devices attached to the set */
+typedef struct BcacheSetInfo {
+    guint64 block_size;
+    guint64 cache_size;
+    guint64 cache_used;
+} BcacheSetInfo;
+
+/* Get the status of the @bcache_device (given without the "/dev/" prefix). If
+   @sets is given, the per-cache-set numbers (block size, cache size and usage)
+   are computed only once per cache set and shared between all the devices
+   attached to it. */
+static BDKBDBcacheStats* get_bcache_status (const gchar *bcache_device, GHashTable *sets, GError **error) {
     gchar *path = NULL;
     gboolean success = FALSE;
     BDKBDBcacheStats *ret = g_new0 (BDKBDBcacheStats, 1);
@@ -1327,17 +1599,19 @@ BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **err
     gchar **path_list;
     guint64 size = 0;
     guint64 used = 0;
+    gchar *link = NULL;
+    const gchar *set_uuid = NULL;
+    BcacheSetInfo *set_info = NULL;
     GError *loc_error = NULL;
 
-    if (g_str_has_prefix (bcache_device, "/dev/"))
-        bcache_device += 5;
+    ret->device = g_strdup (bcache_device);
 
     path = g_strdup_printf ("/sys/block/%s/bcache", bcache_device);
     if (access (path, R_OK) != 0) {
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_NOEXIST,
                      "Bcache device '%s' doesn't seem to exist", bcache_device);
         g_free (path);
-        g_free (ret);
+        bd_kbd_bcache_stats_free (ret);
         return NULL;
     }
     g_free (path);
@@ -1349,7 +1623,7 @@ BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **err
         g_clear_error (error);
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
                      "Failed to get 'state' for '%s' Bcache device", bcache_device);
-        g_free (ret);
+        bd_kbd_bcache_stats_free (ret);
         return NULL;
     }
     /* remove the trailing space and newline */
@@ -1359,42 +1633,73 @@ BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **err
         /* no cache, nothing more to get */
         return ret;
 
-    ret->block_size = get_bcache_block_size (bcache_device, &loc_error);
-    if (loc_error) {
-        g_propagate_prefixed_error (error, loc_error,
-                                    "Failed to get 'block_size' for '%s' Bcache device: ",
-                                    bcache_device);
-        g_free (ret);
-        return NULL;
-    }
-
-    path = g_strdup_printf ("/sys/block/%s/bcache/cache/cache*/", bcache_device);
-    if (glob (path, GLOB_NOSORT, NULL, &globbuf) != 0) {
-        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
-                     "Failed to get 'cache_size' for '%s' Bcache device", bcache_device);
+    if (sets) {
+        /* the 'cache' symlink points to /sys/fs/bcache/<SET_UUID> */
+        path = g_strdup_printf ("/sys/block/%s/bcache/cache", bcache_device);
+        link = g_file_read_link (path, NULL);
         g_free (path);
-        g_free (ret);
-        return NULL;
-    }
-    g_free (path);
+        if (link) {
+            set_uuid = strrchr (link, '/');
+            set_uuid = set_uuid ? set_uuid + 1 : NULL;
+        }
+        if (set_uuid)
+            set_info = g_hash_table_lookup (sets, set_uuid);
+    }
+
+    if (set_info) {
+        ret->block_size = set_info->block_size;
+        ret->cache_size = set_info->cache_size;
+        ret->cache_used = set_info->cache_used;
+    } else {
+        ret->block_size = get_bcache_block_size (bcache_device, &loc_error);
+        if (loc_error) {
+            g_propagate_prefixed_error (error, loc_error,
+                                        "Failed to get 'block_size' for '%s' Bcache device: ",
+                                        bcache_device);
+            g_free (link);
+            bd_kbd_bcache_stats_free (ret);
+            return NULL;
+        }
 
-    /* sum up sizes of all (potential) cache devices */
-    for (path_list=globbuf.gl_pathv; *path_list; path_list++) {
-        success = get_cache_size_used (*path_list, &size, &used, error);
-        if (!success) {
-            g_clear_error (error);
+        path = g_strdup_printf ("/sys/block/%s/bcache/cache/cache*/", bcache_device);
+        if (glob (path, GLOB_NOSORT, NULL, &globbuf) != 0) {
             g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
                          "Failed to get 'cache_size' for '%s' Bcache device", bcache_device);
-            globfree (&globbuf);
-            g_free (ret);
+            g_free (path);
+            g_free (link);
+            bd_kbd_bcache_stats_free (ret);
             return NULL;
-        } else {
-            // the /sys/*/size values are multiples of sector size
-            ret->cache_size += (SECTOR_SIZE * size);
-            ret->cache_used += (SECTOR_SIZE * used);
+        }
+        g_free (path);
+
+        /* sum up sizes of all (potential) cache devices */
+        for (path_list=globbuf.gl_pathv; *path_list; path_list++) {
+            success = get_cache_size_used (*path_list, &size, &used, error);
+            if (!success) {
+                g_clear_error (error);
+                g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
+                             "Failed to get 'cache_size' for '%s' Bcache device", bcache_device);
+                globfree (&globbuf);
+                g_free (link);
+                bd_kbd_bcache_stats_free (ret);
+                return NULL;
+            } else {
+                // the /sys/*/size values are multiples of sector size
+                ret->cache_size += (SECTOR_SIZE * size);
+                ret->cache_used += (SECTOR_SIZE * used);
+            }
+        }
+        globfree (&globbuf);
+
+        if (set_uuid) {
+            set_info = g_new0 (BcacheSetInfo, 1);
+            set_info->block_size = ret->block_size;
+            set_info->cache_size = ret->cache_size;
+            set_info->cache_used = ret->cache_used;
+            g_hash_table_insert (sets, g_strdup (set_uuid), set_info);
         }
     }
-    globfree (&globbuf);
+    g_free (link);
 
     path = g_strdup_printf ("/sys/block/%s/bcache/stats_total/cache_hits", bcache_device);
     ret->hits = get_number_from_file (path, error);
@@ -1403,7 +1708,7 @@ BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **err
         g_clear_error (error);
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
                      "Failed to get 'hits' for '%s' Bcache device", bcache_device);
-        g_free (ret);
+        bd_kbd_bcache_stats_free (ret);
         return NULL;
     }
 
@@ -1414,7 +1719,7 @@ BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **err
         g_clear_error (error);
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
                      "Failed to get 'misses' for '%s' Bcache device", bcache_device);
-        g_free (ret);
+        bd_kbd_bcache_stats_free (ret);
         return NULL;
     }
 
@@ -1425,7 +1730,7 @@ BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **err
         g_clear_error (error);
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
                      "Failed to get 'bypass_hits' for '%s' Bcache device", bcache_device);
-        g_free (ret);
+        bd_kbd_bcache_stats_free (ret);
         return NULL;
     }
 
@@ -1436,10 +1741,160 @@ BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **err
         g_clear_error (error);
         g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
                      "Failed to get 'bypass_misses' for '%s' Bcache device", bcache_device);
-        g_free (ret);
+        bd_kbd_bcache_stats_free (ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
+/**
+ * bd_kbd_bcache_status:
+ * @bcache_device: bcache device to get status for
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full): status of the @bcache_device or %NULL in case of
+ *                           error (@error is set)
+ *
+ * Tech category: %BD_KBD_TECH_BCACHE-%BD_KBD_TECH_MODE_QUERY
+ */
+BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **error) {
+    if (g_str_has_prefix (bcache_device, "/dev/"))
+        bcache_device += 5;
+
+    return get_bcache_status (bcache_device, NULL, error);
+}
+
+/* short-TTL cache for bd_kbd_bcache_status_all() (see bd_kbd_set_bcache_status_cache()) */
+static GMutex bcache_status_cache_lock;
+static BDKBDBcacheStats **bcache_status_cache = NULL;
+static gint64 bcache_status_cache_expires = 0;
+static guint64 bcache_status_cache_ttl = 0;
+
+static void bcache_status_list_free (BDKBDBcacheStats **list) {
+    guint64 i = 0;
+
+    if (!list)
+        return;
+    for (i = 0; list[i]; i++)
+        bd_kbd_bcache_stats_free (list[i]);
+    g_free (list);
+}
+
+static BDKBDBcacheStats** bcache_status_list_copy (BDKBDBcacheStats **list) {
+    guint64 n = 0;
+    guint64 i = 0;
+    BDKBDBcacheStats **ret = NULL;
+
+    for (n = 0; list[n]; n++);
+    ret = g_new0 (BDKBDBcacheStats*, n + 1);
+    for (i = 0; i < n; i++)
+        ret[i] = bd_kbd_bcache_stats_copy (list[i]);
+
+    return ret;
+}
+
+/**
+ * bd_kbd_set_bcache_status_cache:
+ * @ttl_ms: how long (in milliseconds) the results of bd_kbd_bcache_status_all()
+ *          should be kept and reused or 0 to disable the caching
+ * @error: (out): place to store error (if any)
+ *
+ * With the cache enabled bd_kbd_bcache_status_all() returns (a copy of) its
+ * last result for up to @ttl_ms milliseconds instead of re-reading sysfs which
+ * makes frequent sampling (e.g. by monitoring tools) cheap. Changes happening
+ * within the TTL window are of course only visible after it expires. The cache
+ * is disabled by default.
+ *
+ * Returns: whether the caching was successfully enabled/disabled or not
+ *
+ * Tech category: always provided/supported
+ */
+gboolean bd_kbd_set_bcache_status_cache (guint64 ttl_ms, GError **error UNUSED) {
+    g_mutex_lock (&bcache_status_cache_lock);
+    bcache_status_cache_ttl = ttl_ms;
+    bcache_status_list_free (bcache_status_cache);
+    bcache_status_cache = NULL;
+    g_mutex_unlock (&bcache_status_cache_lock);
+
+    return TRUE;
+}
+
+/**
+ * bd_kbd_bcache_status_all:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): status of all the
+ * existing bcache devices (an empty list if there are none) or %NULL in case
+ * of error
+ *
+ * Compared to calling bd_kbd_bcache_status() for every device separately this
+ * scans sysfs in a single pass, computing the per-cache-set numbers (cache
+ * size and usage) only once per cache set no matter how many devices are
+ * attached to it. The device a particular item of the list belongs to is
+ * identified by its 'device' field. See also bd_kbd_set_bcache_status_cache()
+ * for making repeated calls even cheaper.
+ *
+ * Tech category: %BD_KBD_TECH_BCACHE-%BD_KBD_TECH_MODE_QUERY
+ */
+BDKBDBcacheStats** bd_kbd_bcache_status_all (GError **error) {
+    glob_t globbuf;
+    gint status = 0;
+    guint64 i = 0;
+    guint64 n_stats = 0;
+    const gchar *device = NULL;
+    GHashTable *sets = NULL;
+    BDKBDBcacheStats **ret = NULL;
+    GError *l_error = NULL;
+
+    g_mutex_lock (&bcache_status_cache_lock);
+    if (bcache_status_cache && g_get_monotonic_time () < bcache_status_cache_expires) {
+        ret = bcache_status_list_copy (bcache_status_cache);
+        g_mutex_unlock (&bcache_status_cache_lock);
+        return ret;
+    }
+    g_mutex_unlock (&bcache_status_cache_lock);
+
+    status = glob ("/sys/block/bcache*", GLOB_NOSORT, NULL, &globbuf);
+    if (status == GLOB_NOMATCH)
+        /* no bcache devices, just an empty list */
+        return g_new0 (BDKBDBcacheStats*, 1);
+    else if (status != 0) {
+        g_set_error (error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_INVAL,
+                     "Failed to list the bcache devices in '/sys/block'");
         return NULL;
     }
 
+    sets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    ret = g_new0 (BDKBDBcacheStats*, globbuf.gl_pathc + 1);
+    for (i = 0; i < globbuf.gl_pathc; i++) {
+        device = globbuf.gl_pathv[i] + sizeof ("/sys/block/") - 1;
+        ret[n_stats] = get_bcache_status (device, sets, &l_error);
+        if (!ret[n_stats]) {
+            if (g_error_matches (l_error, BD_KBD_ERROR, BD_KBD_ERROR_BCACHE_NOEXIST)) {
+                /* the device disappeared between the listing and now, just skip it */
+                g_clear_error (&l_error);
+                continue;
+            }
+            g_propagate_error (error, l_error);
+            bcache_status_list_free (ret);
+            g_hash_table_destroy (sets);
+            globfree (&globbuf);
+            return NULL;
+        }
+        n_stats++;
+    }
+    g_hash_table_destroy (sets);
+    globfree (&globbuf);
+
+    g_mutex_lock (&bcache_status_cache_lock);
+    if (bcache_status_cache_ttl > 0) {
+        bcache_status_list_free (bcache_status_cache);
+        bcache_status_cache = bcache_status_list_copy (ret);
+        bcache_status_cache_expires = g_get_monotonic_time () + bcache_status_cache_ttl * 1000;
+    }
+    g_mutex_unlock (&bcache_status_cache_lock);
+
     return ret;
 }
 
@@ -30,8 +30,10 @@ typedef enum {
     BD_KBD_MODE_UNKNOWN,
 } BDKBDBcacheMode;
 
-/* see zRAM kernel documentation for details */
+/* see zRAM kernel documentation for details; 'device' holds the name of the
+   device (e.g. "zram0") the stats belong to */
 typedef struct BDKBDZramStats {
+    gchar *device;
     guint64 disksize;
     guint64 num_reads;
     guint64 num_writes;
@@ -47,7 +49,10 @@ typedef struct BDKBDZramStats {
 BDKBDZramStats* bd_kbd_zram_stats_copy (BDKBDZramStats *data);
 void bd_kbd_zram_stats_free (BDKBDZramStats *data);
 
+/* 'device' holds the name of the bcache device (e.g. "bcache0") the status
+   belongs to */
 typedef struct BDKBDBcacheStats {
+    gchar *device;
     gchar *state;
     guint64 block_size;
     guint64 cache_size;
@@ -94,9 +99,24 @@ gboolean bd_kbd_zram_destroy_devices (GError **error);
 gboolean bd_kbd_zram_add_device (guint64 size, guint64 nstreams, gchar **device, GError **error);
 gboolean bd_kbd_zram_remove_device (const gchar *device, GError **error);
 BDKBDZramStats* bd_kbd_zram_get_stats (const gchar *device, GError **error);
+BDKBDZramStats** bd_kbd_zram_get_stats_all (GError **error);
 
 gboolean bd_kbd_bcache_create (const gchar *backing_device, const gchar *cache_device, const BDExtraArg **extra, const gchar **bcache_device, GError **error);
 gboolean bd_kbd_bcache_attach (const gchar *c_set_uuid, const gchar *bcache_device, GError **error);
+
+/**
+ * BDKBDBcacheCallback:
+ * @bcache_device: (allow-none): name of the bcache device the operation created
+ *                 or modified or %NULL in case of error
+ * @error: (allow-none) (transfer full): error describing the failure or %NULL
+ * @user_data: data given to the function starting the operation
+ *
+ * Callback function run when an asynchronous bcache operation finishes.
+ */
+typedef void (*BDKBDBcacheCallback) (const gchar *bcache_device, GError *error, gpointer user_data);
+
+gboolean bd_kbd_bcache_create_async (const gchar *backing_device, const gchar *cache_device, const BDExtraArg **extra, BDKBDBcacheCallback callback, gpointer user_data, GError **error);
+gboolean bd_kbd_bcache_attach_async (const gchar *c_set_uuid, const gchar *bcache_device, BDKBDBcacheCallback callback, gpointer user_data, GError **error);
 gboolean bd_kbd_bcache_detach (const gchar *bcache_device, gchar **c_set_uuid, GError **error);
 gboolean bd_kbd_bcache_destroy (const gchar *bcache_device, GError **error);
 BDKBDBcacheMode bd_kbd_bcache_get_mode (const gchar *bcache_device, GError **error);
@@ -104,6 +124,8 @@ const gchar* bd_kbd_bcache_get_mode_str (BDKBDBcacheMode mode, GError **error);
 BDKBDBcacheMode bd_kbd_bcache_get_mode_from_str (const gchar *mode_str, GError **error);
 gboolean bd_kbd_bcache_set_mode (const gchar *bcache_device, BDKBDBcacheMode mode, GError **error);
 BDKBDBcacheStats* bd_kbd_bcache_status (const gchar *bcache_device, GError **error);
+BDKBDBcacheStats** bd_kbd_bcache_status_all (GError **error);
+gboolean bd_kbd_set_bcache_status_cache (guint64 ttl_ms, GError **error);
 gchar* bd_kbd_bcache_get_backing_device (const gchar *bcache_device, GError **error);
 gchar* bd_kbd_bcache_get_cache_device (const gchar *bcache_device, GError **error);
 
@@ -40,6 +40,24 @@
 
 static GMutex loop_control_lock;
 
+/* LOOP_CONFIGURE and the direct I/O support may be missing from the kernel
+   headers we build against even though the running kernel supports them */
+#ifndef LO_FLAGS_DIRECT_IO
+#define LO_FLAGS_DIRECT_IO 16
+#endif
+#ifndef LOOP_SET_DIRECT_IO
+#define LOOP_SET_DIRECT_IO 0x4C08
+#endif
+#ifndef LOOP_CONFIGURE
+#define LOOP_CONFIGURE 0x4C0A
+struct loop_config {
+    __u32 fd;
+    __u32 block_size;
+    struct loop_info64 info;
+    __u64 __reserved[8];
+};
+#endif
+
 /**
  * bd_loop_error_quark: (skip)
  */
@@ -212,6 +230,72 @@ gboolean bd_loop_setup (const gchar *file, guint64 offset, guint64 size, gboolea
     return ret;
 }
 
+/* Associate the @loop_fd device with the @fd backing file and configure it in
+   a single LOOP_CONFIGURE ioctl() where the kernel supports it, falling back
+   to the older LOOP_SET_FD + LOOP_SET_STATUS64 sequence otherwise. If the
+   device got taken by somebody else in the meantime, @busy is set to %TRUE
+   (together with the error) so the caller can retry with a fresh device. */
+static gboolean loop_configure (gint loop_fd, gint fd, const gchar *loop_device, const struct loop_info64 *li64, gboolean direct_io, gboolean *busy, GError **error) {
+    static gint have_loop_configure = -1;   /* -1 == not known (yet) */
+    struct loop_config config;
+    gint status = 0;
+    guint n_try = 0;
+
+    *busy = FALSE;
+
+    if (g_atomic_int_get (&have_loop_configure) != 0) {
+        memset (&config, '\0', sizeof (config));
+        config.fd = fd;
+        config.info = *li64;
+        if (direct_io)
+            config.info.lo_flags |= LO_FLAGS_DIRECT_IO;
+        if (ioctl (loop_fd, LOOP_CONFIGURE, &config) == 0) {
+            g_atomic_int_set (&have_loop_configure, 1);
+            return TRUE;
+        }
+        if ((errno == EINVAL || errno == ENOTTY) && g_atomic_int_get (&have_loop_configure) == -1)
+            /* running kernel doesn't know LOOP_CONFIGURE, fall back */
+            g_atomic_int_set (&have_loop_configure, 0);
+        else {
+            *busy = errno == EBUSY;
+            g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
+                         "Failed to configure the %s device: %m", loop_device);
+            return FALSE;
+        }
+    }
+
+    if (ioctl (loop_fd, LOOP_SET_FD, fd) < 0) {
+        *busy = errno == EBUSY;
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
+                     "Failed to associate the %s device with the file descriptor: %m", loop_device);
+        return FALSE;
+    }
+
+    /* we may need to try multiple times with some delays in case the device is
+       busy at the very moment */
+    for (n_try=10, status=-1; (status != 0) && (n_try > 0); n_try--) {
+        status = ioctl (loop_fd, LOOP_SET_STATUS64, li64);
+        if (status < 0 && errno == EAGAIN)
+            g_usleep (100 * 1000); /* microseconds */
+        else
+            break;
+    }
+
+    if (status != 0) {
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                     "Failed to set status for the %s device: %m", loop_device);
+        return FALSE;
+    }
+
+    if (direct_io && ioctl (loop_fd, LOOP_SET_DIRECT_IO, 1UL) < 0) {
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                     "Failed to enable direct I/O for the %s device: %m", loop_device);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /**
  * bd_loop_setup_from_fd:
  * @fd: file descriptor for a file to setup as a new loop device
@@ -233,8 +317,7 @@ gboolean bd_loop_setup_from_fd (gint fd, guint64 offset, guint64 size, gboolean
     gint loop_fd = -1;
     struct loop_info64 li64;
     guint64 progress_id = 0;
-    gint status = 0;
-    guint n_try = 0;
+    gboolean busy = FALSE;
 
     progress_id = bd_utils_report_started ("Started setting up loop device");
 
@@ -280,43 +363,204 @@ gboolean bd_loop_setup_from_fd (gint fd, guint64 offset, guint64 size, gboolean
         li64.lo_offset = offset;
     if (size > 0)
         li64.lo_sizelimit = size;
-    if (ioctl (loop_fd, LOOP_SET_FD, fd) < 0) {
-        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
-                     "Failed to associate the %s device with the file descriptor: %m", loop_device);
+
+    bd_utils_report_progress (progress_id, 66, "Associating the loop device");
+
+    if (!loop_configure (loop_fd, fd, loop_device, &li64, FALSE, &busy, error)) {
         g_free (loop_device);
         close (loop_fd);
         bd_utils_report_finished (progress_id, (*error)->message);
         return FALSE;
     }
 
-    bd_utils_report_progress (progress_id, 66, "Associated the loop device");
+    if (loop_name)
+        *loop_name = g_strdup_printf ("loop%d", loop_number);
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=10, status=-1; (status != 0) && (n_try > 0); n_try--) {
-        status = ioctl (loop_fd, LOOP_SET_STATUS64, &li64);
-        if (status < 0 && errno == EAGAIN)
-            g_usleep (100 * 1000); /* microseconds */
-        else
-            break;
+    g_free (loop_device);
+    close (loop_fd);
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
+
+typedef struct LoopSetupTask {
+    const gchar *file;
+    gboolean read_only;
+    gboolean part_scan;
+    gboolean direct_io;
+    gint loop_control_fd;
+    gchar *loop_name;
+    GError *error;
+} LoopSetupTask;
+
+static void loop_setup_task_func (gpointer task_data, gpointer data UNUSED) {
+    LoopSetupTask *task = task_data;
+    gint fd = -1;
+    gint loop_number = -1;
+    gchar *loop_device = NULL;
+    gint loop_fd = -1;
+    struct loop_info64 li64;
+    gboolean busy = FALSE;
+    guint n_try = 0;
+
+    /* open as RDWR so that read_only determines whether the device is
+       read-only or not */
+    fd = open (task->file, O_RDWR);
+    if (fd < 0) {
+        g_set_error (&task->error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                     "Failed to open the backing file '%s': %m", task->file);
+        return;
     }
 
-    if (status != 0) {
-        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
-                     "Failed to set status for the %s device: %m", loop_device);
+    memset (&li64, '\0', sizeof (li64));
+    if (task->read_only)
+        li64.lo_flags |= LO_FLAGS_READ_ONLY;
+    if (task->part_scan)
+        li64.lo_flags |= LO_FLAGS_PARTSCAN;
+
+    /* LOOP_CTL_GET_FREE doesn't reserve the device so another thread (or
+       process) may grab it before we get to configure it -- retry with a
+       fresh device in that case */
+    for (n_try=10; n_try > 0; n_try--) {
+        /* XXX: serialize access to loop-control (seems to be required, but it's not
+                documented anywhere) */
+        g_mutex_lock (&loop_control_lock);
+        loop_number = ioctl (task->loop_control_fd, LOOP_CTL_GET_FREE);
+        g_mutex_unlock (&loop_control_lock);
+        if (loop_number < 0) {
+            g_set_error (&task->error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                         "Failed to get a free loop device: %m");
+            close (fd);
+            return;
+        }
+
+        loop_device = g_strdup_printf ("/dev/loop%d", loop_number);
+        loop_fd = open (loop_device, task->read_only ? O_RDONLY : O_RDWR);
+        if (loop_fd == -1) {
+            g_set_error (&task->error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                         "Failed to open the %s device: %m", loop_device);
+            g_free (loop_device);
+            close (fd);
+            return;
+        }
+
+        if (loop_configure (loop_fd, fd, loop_device, &li64, task->direct_io, &busy, &task->error))
+            task->loop_name = g_strdup_printf ("loop%d", loop_number);
         g_free (loop_device);
         close (loop_fd);
+
+        if (task->loop_name || !busy)
+            break;
+        /* somebody else took the device, try another one */
+        g_clear_error (&task->error);
+    }
+
+    if (!task->loop_name && !task->error)
+        /* all the tries ended up with a busy device */
+        g_set_error (&task->error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
+                     "Failed to get a free loop device for '%s': all the free devices kept being taken", task->file);
+
+    close (fd);
+}
+
+/**
+ * bd_loop_setup_many:
+ * @files: (array zero-terminated=1): files to setup as loop devices
+ * @read_only: whether to setup the devices as read-only (%TRUE) or read-write (%FALSE)
+ * @part_scan: whether to enforce partition scan on the newly created devices or not
+ * @direct_io: whether to enable direct I/O on the devices (bypassing the page
+ *             cache for the backing files) or not
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): names of the created
+ * loop devices in the same order as @files or %NULL in case of error
+ *
+ * Sets up a loop device for every file in @files, opening the loop-control
+ * device only once and attaching the files in parallel (with the single-step
+ * LOOP_CONFIGURE ioctl() on kernels that support it). If any of the setups
+ * fails, the devices already set up by this call are torn down again.
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_CREATE
+ */
+gchar** bd_loop_setup_many (const gchar **files, gboolean read_only, gboolean part_scan, gboolean direct_io, GError **error) {
+    gint loop_control_fd = -1;
+    LoopSetupTask *tasks = NULL;
+    GThreadPool *pool = NULL;
+    guint64 n_files = 0;
+    guint64 i = 0;
+    gchar **ret = NULL;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    GError *first_error = NULL;
+    GError *l_error = NULL;
+
+    for (n_files = 0; files[n_files]; n_files++);
+
+    msg = g_strdup_printf ("Started setting up %"G_GUINT64_FORMAT" loop devices", n_files);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    if (n_files == 0) {
+        bd_utils_report_finished (progress_id, "Completed");
+        return g_new0 (gchar*, 1);
+    }
+
+    loop_control_fd = open ("/dev/loop-control", O_RDWR);
+    if (loop_control_fd == -1) {
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                     "Failed to open the loop-control device: %m");
         bd_utils_report_finished (progress_id, (*error)->message);
-        return FALSE;
+        return NULL;
     }
 
-    if (loop_name)
-        *loop_name = g_strdup_printf ("loop%d", loop_number);
+    tasks = g_new0 (LoopSetupTask, n_files);
+    pool = g_thread_pool_new (loop_setup_task_func, NULL, MIN (n_files, 2 * g_get_num_processors ()), FALSE, NULL);
+    for (i = 0; i < n_files; i++) {
+        tasks[i].file = files[i];
+        tasks[i].read_only = read_only;
+        tasks[i].part_scan = part_scan;
+        tasks[i].direct_io = direct_io;
+        tasks[i].loop_control_fd = loop_control_fd;
+        /* a failure here just means the task stays queued */
+        g_thread_pool_push (pool, tasks + i, NULL);
+    }
+    /* wait for all the tasks to finish */
+    g_thread_pool_free (pool, FALSE, TRUE);
+    close (loop_control_fd);
+
+    for (i = 0; i < n_files; i++) {
+        if (tasks[i].error) {
+            if (!first_error)
+                first_error = tasks[i].error;
+            else
+                g_clear_error (&tasks[i].error);
+        }
+    }
+
+    if (first_error) {
+        /* tear the already created devices down again, the call is all-or-nothing */
+        for (i = 0; i < n_files; i++) {
+            if (tasks[i].loop_name) {
+                if (!bd_loop_teardown (tasks[i].loop_name, &l_error)) {
+                    bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to tear down the %s device: %s",
+                                         tasks[i].loop_name, l_error->message);
+                    g_clear_error (&l_error);
+                }
+                g_free (tasks[i].loop_name);
+            }
+        }
+        g_free (tasks);
+        bd_utils_report_finished (progress_id, first_error->message);
+        g_propagate_error (error, first_error);
+        return NULL;
+    }
+
+    ret = g_new0 (gchar*, n_files + 1);
+    for (i = 0; i < n_files; i++)
+        ret[i] = tasks[i].loop_name;
+    g_free (tasks);
 
-    g_free (loop_device);
-    close (loop_fd);
     bd_utils_report_finished (progress_id, "Completed");
-    return TRUE;
+    return ret;
 }
 
 /**
@@ -480,3 +724,54 @@ gboolean bd_loop_set_autoclear (const gchar *loop, gboolean autoclear, GError **
     bd_utils_report_finished (progress_id, "Completed");
     return TRUE;
 }
+
+/**
+ * bd_loop_set_direct_io:
+ * @loop: path or name of the loop device
+ * @direct_io: whether to enable or disable direct I/O for the device
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables direct I/O on the @loop device, i.e. whether the I/O on
+ * the device bypasses the page cache for the backing file or goes through it.
+ *
+ * Returns: whether direct I/O was successfully enabled/disabled on the @loop
+ *          device or not
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_MODIFY
+ */
+gboolean bd_loop_set_direct_io (const gchar *loop, gboolean direct_io, GError **error) {
+    gchar *dev_loop = NULL;
+    gint fd = -1;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+
+    if (!g_str_has_prefix (loop, "/dev/"))
+        dev_loop = g_strdup_printf ("/dev/%s", loop);
+
+    msg = g_strdup_printf ("Started %s direct I/O on the %s device",
+                           direct_io ? "enabling" : "disabling", dev_loop ? dev_loop : loop);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    fd = open (dev_loop ? dev_loop : loop, O_RDWR);
+    g_free (dev_loop);
+    if (fd < 0) {
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
+                     "Failed to open device %s: %m", loop);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    if (ioctl (fd, LOOP_SET_DIRECT_IO, direct_io ? 1UL : 0UL) < 0) {
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                     "Failed to %s direct I/O on the device %s: %m",
+                     direct_io ? "enable" : "disable", loop);
+        close (fd);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    close (fd);
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
@@ -42,9 +42,11 @@ gchar* bd_loop_get_backing_file (const gchar *dev_name, GError **error);
 gchar* bd_loop_get_loop_name (const gchar *file, GError **error);
 gboolean bd_loop_setup (const gchar *file, guint64 offset, guint64 size, gboolean read_only, gboolean part_scan, const gchar **loop_name, GError **error);
 gboolean bd_loop_setup_from_fd (gint fd, guint64 offset, guint64 size, gboolean read_only, gboolean part_scan, const gchar **loop_name, GError **error);
+gchar** bd_loop_setup_many (const gchar **files, gboolean read_only, gboolean part_scan, gboolean direct_io, GError **error);
 gboolean bd_loop_teardown (const gchar *loop, GError **error);
 
 gboolean bd_loop_get_autoclear (const gchar *loop, GError **error);
 gboolean bd_loop_set_autoclear (const gchar *loop, gboolean autoclear, GError **error);
+gboolean bd_loop_set_direct_io (const gchar *loop, gboolean direct_io, GError **error);
 
 #endif  /* BD_LOOP */
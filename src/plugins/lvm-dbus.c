@@ -78,6 +78,8 @@ static gchar *global_config_str = NULL;
 
 #define UNUSED __attribute__((unused))
 
+static void teardown_obj_manager (void);
+
 static GDBusConnection *bus = NULL;
 
 /**
@@ -206,6 +208,91 @@ void bd_lvm_lvdata_free (BDLVMLVdata *data) {
     g_free (data);
 }
 
+BDLVMFullReport* bd_lvm_fullreport_copy (BDLVMFullReport *data) {
+    guint i = 0;
+    guint len = 0;
+
+    if (data == NULL)
+        return NULL;
+
+    BDLVMFullReport *new_data = g_new0 (BDLVMFullReport, 1);
+
+    for (len=0; data->pvs[len]; len++);
+    new_data->pvs = g_new0 (BDLVMPVdata*, len + 1);
+    for (i=0; i < len; i++)
+        new_data->pvs[i] = bd_lvm_pvdata_copy (data->pvs[i]);
+
+    for (len=0; data->vgs[len]; len++);
+    new_data->vgs = g_new0 (BDLVMVGdata*, len + 1);
+    for (i=0; i < len; i++)
+        new_data->vgs[i] = bd_lvm_vgdata_copy (data->vgs[i]);
+
+    for (len=0; data->lvs[len]; len++);
+    new_data->lvs = g_new0 (BDLVMLVdata*, len + 1);
+    for (i=0; i < len; i++)
+        new_data->lvs[i] = bd_lvm_lvdata_copy (data->lvs[i]);
+
+    return new_data;
+}
+
+void bd_lvm_fullreport_free (BDLVMFullReport *data) {
+    guint i = 0;
+
+    if (data == NULL)
+        return;
+
+    if (data->pvs)
+        for (i=0; data->pvs[i]; i++)
+            bd_lvm_pvdata_free (data->pvs[i]);
+    g_free (data->pvs);
+    if (data->vgs)
+        for (i=0; data->vgs[i]; i++)
+            bd_lvm_vgdata_free (data->vgs[i]);
+    g_free (data->vgs);
+    if (data->lvs)
+        for (i=0; data->lvs[i]; i++)
+            bd_lvm_lvdata_free (data->lvs[i]);
+    g_free (data->lvs);
+    g_free (data);
+}
+
+
+BDLVMLVTreeNode* bd_lvm_lvtreenode_copy (BDLVMLVTreeNode *data) {
+    guint i = 0;
+    guint len = 0;
+
+    if (data == NULL)
+        return NULL;
+
+    BDLVMLVTreeNode *new_data = g_new0 (BDLVMLVTreeNode, 1);
+
+    new_data->data = bd_lvm_lvdata_copy (data->data);
+    /* the copy is detached from the original's parent */
+    new_data->parent = NULL;
+    for (len=0; data->children[len]; len++);
+    new_data->children = g_new0 (BDLVMLVTreeNode*, len + 1);
+    for (i=0; i < len; i++) {
+        new_data->children[i] = bd_lvm_lvtreenode_copy (data->children[i]);
+        new_data->children[i]->parent = new_data;
+    }
+
+    return new_data;
+}
+
+void bd_lvm_lvtreenode_free (BDLVMLVTreeNode *data) {
+    guint i = 0;
+
+    if (data == NULL)
+        return;
+
+    if (data->children)
+        for (i=0; data->children[i]; i++)
+            bd_lvm_lvtreenode_free (data->children[i]);
+    g_free (data->children);
+    bd_lvm_lvdata_free (data->data);
+    g_free (data);
+}
+
 BDLVMCacheStats* bd_lvm_cache_stats_copy (BDLVMCacheStats *data) {
     if (data == NULL)
         return NULL;
@@ -232,28 +319,14 @@ void bd_lvm_cache_stats_free (BDLVMCacheStats *data) {
 }
 
 static gboolean setup_dbus_connection (GError **error) {
-    gchar *addr = NULL;
-
-    addr = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SYSTEM, NULL, error);
-    if (!addr) {
-        g_critical ("Failed to get system bus address: %s\n", (*error)->message);
+    /* the shared connection is created lazily, has exit-on-close disabled and
+       is transparently replaced when closed */
+    bus = bd_utils_dbus_get_connection (G_BUS_TYPE_SYSTEM, error);
+    if (!bus) {
+        g_critical ("Failed to get a connection for the system bus: %s\n", (*error)->message);
         return FALSE;
     }
 
-    bus = g_dbus_connection_new_for_address_sync (addr,
-                                                  G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT|
-                                                  G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
-                                                  NULL, NULL, error);
-
-    g_free (addr);
-
-    if (!bus || g_dbus_connection_is_closed (bus)) {
-        g_critical ("Failed to create a new connection for the system bus: %s\n", (*error)->message);
-        return FALSE;
-    }
-
-    g_dbus_connection_set_exit_on_close (bus, FALSE);
-
     return TRUE;
 }
 
@@ -356,6 +429,8 @@ gboolean bd_lvm_init (void) {
 void bd_lvm_close (void) {
     GError *error = NULL;
 
+    teardown_obj_manager ();
+
     /* the check() call should create the DBus connection for us, but let's not
        completely rely on it */
     if (!g_dbus_connection_flush_sync (bus, NULL, &error))
@@ -411,6 +486,160 @@ gboolean bd_lvm_is_tech_avail (BDLVMTech tech, guint64 mode, GError **error) {
     }
 }
 
+/* ObjectManager-based cache of the lvmdbusd objects and their properties --
+   seeded with one GetManagedObjects call and kept current by the
+   InterfacesAdded/InterfacesRemoved and PropertiesChanged signals which are
+   processed on a dedicated thread running its own main context */
+static GDBusObjectManager *obj_manager = NULL;
+static GMainContext *om_context = NULL;
+static GMainLoop *om_loop = NULL;
+static GThread *om_thread = NULL;
+static gboolean om_initialized = FALSE;
+static GMutex om_lock;
+
+typedef struct OMSetupData {
+    GMutex lock;
+    GCond cond;
+    gboolean done;
+} OMSetupData;
+
+static gpointer om_thread_func (gpointer data) {
+    OMSetupData *setup = (OMSetupData *) data;
+    GError *error = NULL;
+
+    g_main_context_push_thread_default (om_context);
+    obj_manager = g_dbus_object_manager_client_new_sync (bus, G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_DO_NOT_AUTO_START,
+                                                         LVM_BUS_NAME, LVM_OBJ_PREFIX,
+                                                         NULL, NULL, NULL, NULL, &error);
+    if (!obj_manager) {
+        bd_utils_log_format (BD_UTILS_LOG_WARNING,
+                             "Failed to create the lvmdbusd object manager, falling back to direct queries: %s",
+                             error->message);
+        g_clear_error (&error);
+    }
+
+    g_mutex_lock (&setup->lock);
+    setup->done = TRUE;
+    g_cond_signal (&setup->cond);
+    g_mutex_unlock (&setup->lock);
+
+    /* process the update signals and job tracking sources until the plugin is
+       closed (the loop is needed even without the object manager) */
+    g_main_loop_run (om_loop);
+    g_main_context_pop_thread_default (om_context);
+    return NULL;
+}
+
+static GDBusObjectManager* get_obj_manager (void) {
+    OMSetupData setup;
+    GDBusObjectManager *ret = NULL;
+
+    if (!bus)
+        return NULL;
+
+    g_mutex_lock (&om_lock);
+    if (!om_initialized) {
+        om_initialized = TRUE;
+        om_context = g_main_context_new ();
+        om_loop = g_main_loop_new (om_context, FALSE);
+        g_mutex_init (&setup.lock);
+        g_cond_init (&setup.cond);
+        setup.done = FALSE;
+        om_thread = g_thread_try_new ("lvm-dbus-om", om_thread_func, &setup, NULL);
+        if (om_thread) {
+            g_mutex_lock (&setup.lock);
+            while (!setup.done)
+                g_cond_wait (&setup.cond, &setup.lock);
+            g_mutex_unlock (&setup.lock);
+        }
+        g_mutex_clear (&setup.lock);
+        g_cond_clear (&setup.cond);
+    }
+    ret = obj_manager;
+    g_mutex_unlock (&om_lock);
+
+    return ret;
+}
+
+static GMainContext* get_om_context (void) {
+    GMainContext *ret = NULL;
+
+    /* make sure the worker thread and its context exist (the object manager
+       itself may have failed to come up which is fine here) */
+    get_obj_manager ();
+
+    g_mutex_lock (&om_lock);
+    if (om_thread)
+        ret = om_context;
+    g_mutex_unlock (&om_lock);
+
+    return ret;
+}
+
+static gboolean om_sync_cb (gpointer data) {
+    OMSetupData *sync = (OMSetupData *) data;
+
+    g_mutex_lock (&sync->lock);
+    sync->done = TRUE;
+    g_cond_signal (&sync->cond);
+    g_mutex_unlock (&sync->lock);
+    return G_SOURCE_REMOVE;
+}
+
+/* wait until the worker thread has dispatched every update signal received
+   before this call; the bus delivers a PropertiesChanged signal before the
+   reply of the modification call that caused it, but the signal and the reply
+   are dispatched on different threads, so without this barrier a query issued
+   right after one of our own modification calls returns could be served
+   properties from before that modification */
+static void om_cache_sync (void) {
+    OMSetupData sync;
+    GMainContext *context = NULL;
+
+    context = get_om_context ();
+    if (!context)
+        return;
+
+    g_mutex_init (&sync.lock);
+    g_cond_init (&sync.cond);
+    sync.done = FALSE;
+    /* runs the callback directly when called from the worker thread itself */
+    g_main_context_invoke (context, om_sync_cb, &sync);
+    g_mutex_lock (&sync.lock);
+    while (!sync.done)
+        g_cond_wait (&sync.cond, &sync.lock);
+    g_mutex_unlock (&sync.lock);
+    g_mutex_clear (&sync.lock);
+    g_cond_clear (&sync.cond);
+}
+
+static gboolean om_loop_quit (gpointer data UNUSED) {
+    g_main_loop_quit (om_loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void teardown_obj_manager (void) {
+    g_mutex_lock (&om_lock);
+    if (om_thread) {
+        /* deliver the quit through the loop's own context so it cannot be
+           missed if the loop is only about to start */
+        g_main_context_invoke (om_context, om_loop_quit, NULL);
+        g_thread_join (om_thread);
+        om_thread = NULL;
+    }
+    g_clear_object (&obj_manager);
+    if (om_loop) {
+        g_main_loop_unref (om_loop);
+        om_loop = NULL;
+    }
+    if (om_context) {
+        g_main_context_unref (om_context);
+        om_context = NULL;
+    }
+    om_initialized = FALSE;
+    g_mutex_unlock (&om_lock);
+}
+
 static gchar** get_existing_objects (const gchar *obj_prefix, GError **error) {
     GVariant *intro_v = NULL;
     gchar *intro_data = NULL;
@@ -419,6 +648,31 @@ static gchar** get_existing_objects (const gchar *obj_prefix, GError **error) {
     GDBusNodeInfo **nodes;
     guint64 n_nodes = 0;
     guint64 i = 0;
+    GDBusObjectManager *manager = NULL;
+    GList *objects = NULL;
+    GList *object_p = NULL;
+    GPtrArray *paths = NULL;
+    gchar *prefix = NULL;
+    const gchar *path = NULL;
+
+    manager = get_obj_manager ();
+    if (manager) {
+        /* in-memory lookup in the object cache, synchronized with the update
+           signals received so far */
+        om_cache_sync ();
+        paths = g_ptr_array_new ();
+        prefix = g_strdup_printf ("%s/", obj_prefix);
+        objects = g_dbus_object_manager_get_objects (manager);
+        for (object_p = objects; object_p; object_p = object_p->next) {
+            path = g_dbus_object_get_object_path (G_DBUS_OBJECT (object_p->data));
+            if (g_str_has_prefix (path, prefix))
+                g_ptr_array_add (paths, g_strdup (path));
+        }
+        g_list_free_full (objects, g_object_unref);
+        g_free (prefix);
+        g_ptr_array_add (paths, NULL);
+        return (gchar **) g_ptr_array_free (paths, FALSE);
+    }
 
     intro_v = g_dbus_connection_call_sync (bus, LVM_BUS_NAME, obj_prefix, DBUS_INTRO_IFACE,
                                            "Introspect", NULL, NULL, G_DBUS_CALL_FLAGS_NONE,
@@ -478,6 +732,21 @@ static GVariant* get_object_property (const gchar *obj_path, const gchar *iface,
     GVariant *args = NULL;
     GVariant *ret = NULL;
     GVariant *real_ret = NULL;
+    GDBusObjectManager *manager = NULL;
+    GDBusInterface *iface_proxy = NULL;
+
+    manager = get_obj_manager ();
+    if (manager) {
+        om_cache_sync ();
+        iface_proxy = g_dbus_object_manager_get_interface (manager, obj_path, iface);
+        if (iface_proxy) {
+            real_ret = g_dbus_proxy_get_cached_property (G_DBUS_PROXY (iface_proxy), property);
+            g_object_unref (iface_proxy);
+            if (real_ret)
+                return real_ret;
+        }
+        /* not in the cache (yet), fall back to a direct query */
+    }
 
     args = g_variant_new ("(ss)", iface, property);
 
@@ -818,6 +1087,242 @@ static void call_lvm_method_sync (const gchar *obj, const gchar *intf, const gch
     g_free (task_path);
 }
 
+typedef struct JobTrackData {
+    GTask *task;
+    gchar *task_path;
+    gchar *obj;
+    gchar *method;
+    guint64 log_task_id;
+    guint64 prog_id;
+} JobTrackData;
+
+static void job_track_data_free (JobTrackData *data) {
+    g_object_unref (data->task);
+    g_free (data->task_path);
+    g_free (data->obj);
+    g_free (data->method);
+    g_free (data);
+}
+
+static void job_remove (const gchar *task_path) {
+    GVariant *ret = NULL;
+
+    /* remove the job object and clean after ourselves */
+    ret = g_dbus_connection_call_sync (bus, LVM_BUS_NAME, task_path, JOB_INTF, "Remove", NULL,
+                                       NULL, G_DBUS_CALL_FLAGS_NONE, METHOD_CALL_TIMEOUT, NULL, NULL);
+    if (ret)
+        g_variant_unref (ret);
+}
+
+/* periodically invoked in the job tracking thread for every job being waited
+   for; one such thread serves any number of concurrent jobs */
+static gboolean job_poll_cb (gpointer user_data) {
+    JobTrackData *data = (JobTrackData *) user_data;
+    GVariant *ret = NULL;
+    GError *error = NULL;
+    gboolean completed = FALSE;
+    gdouble progress = 0.0;
+    gchar *obj_path = NULL;
+    gchar *log_msg = NULL;
+    gint64 error_code = 0;
+    gchar *error_msg = NULL;
+
+    if (g_task_return_error_if_cancelled (data->task)) {
+        /* stop tracking the job, lvmdbusd keeps running it */
+        bd_utils_log_task_status (data->log_task_id, "Cancelled");
+        bd_utils_report_finished (data->prog_id, "Cancelled");
+        job_track_data_free (data);
+        return G_SOURCE_REMOVE;
+    }
+
+    ret = get_object_property (data->task_path, JOB_INTF, "Complete", &error);
+    if (!ret) {
+        g_prefix_error (&error, "Waiting for '%s' method of the '%s' object to finish failed: ",
+                        data->method, data->obj);
+        bd_utils_report_finished (data->prog_id, error->message);
+        g_task_return_error (data->task, error);
+        job_track_data_free (data);
+        return G_SOURCE_REMOVE;
+    }
+    g_variant_get (ret, "b", &completed);
+    g_variant_unref (ret);
+
+    if (!completed) {
+        /* let's report progress and wait longer */
+        ret = get_object_property (data->task_path, JOB_INTF, "Percent", &error);
+        if (ret) {
+            g_variant_get (ret, "d", &progress);
+            bd_utils_report_progress (data->prog_id, (gint) progress, NULL);
+            g_variant_unref (ret);
+        } else {
+            g_debug ("Got error when getting progress: %s", error->message);
+            g_clear_error (&error);
+        }
+        log_msg = g_strdup_printf ("Still waiting for job '%s' to finish", data->task_path);
+        bd_utils_log_task_status (data->log_task_id, log_msg);
+        g_free (log_msg);
+        return G_SOURCE_CONTINUE;
+    }
+
+    log_msg = g_strdup_printf ("Job '%s' finished", data->task_path);
+    bd_utils_log_task_status (data->log_task_id, log_msg);
+    g_free (log_msg);
+
+    ret = get_object_property (data->task_path, JOB_INTF, "Result", &error);
+    if (!ret) {
+        g_prefix_error (&error, "Getting result after waiting for '%s' method of the '%s' object failed: ",
+                        data->method, data->obj);
+        bd_utils_report_finished (data->prog_id, error->message);
+        g_task_return_error (data->task, error);
+        job_track_data_free (data);
+        return G_SOURCE_REMOVE;
+    }
+    g_variant_get (ret, "o", &obj_path);
+    g_variant_unref (ret);
+    if (g_strcmp0 (obj_path, "/") != 0) {
+        log_msg = g_strdup_printf ("Got result: %s", obj_path);
+        bd_utils_log_task_status (data->log_task_id, log_msg);
+        g_free (log_msg);
+    } else {
+        ret = get_object_property (data->task_path, JOB_INTF, "GetError", &error);
+        if (ret) {
+            g_variant_get (ret, "(is)", &error_code, &error_msg);
+            g_variant_unref (ret);
+        } else
+            g_clear_error (&error);
+        if (error_code != 0) {
+            if (error_msg) {
+                log_msg = g_strdup_printf ("Got error: %s", error_msg);
+                bd_utils_log_task_status (data->log_task_id, log_msg);
+                bd_utils_report_finished (data->prog_id, log_msg);
+                g_free (log_msg);
+                g_task_return_new_error (data->task, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                                         "Running '%s' method on the '%s' object failed: %s",
+                                         data->method, data->obj, error_msg);
+                g_free (error_msg);
+            } else {
+                bd_utils_log_task_status (data->log_task_id, "Got unknown error");
+                bd_utils_report_finished (data->prog_id, "Got unknown error");
+                g_task_return_new_error (data->task, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                                         "Got unknown error when running '%s' method on the '%s' object.",
+                                         data->method, data->obj);
+            }
+            g_free (obj_path);
+            job_remove (data->task_path);
+            job_track_data_free (data);
+            return G_SOURCE_REMOVE;
+        } else {
+            bd_utils_log_task_status (data->log_task_id, "No result");
+            g_free (error_msg);
+        }
+    }
+    g_free (obj_path);
+
+    bd_utils_report_finished (data->prog_id, "Completed");
+    job_remove (data->task_path);
+    g_task_return_boolean (data->task, TRUE);
+    job_track_data_free (data);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean call_lvm_method_async (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error) {
+    GVariant *ret = NULL;
+    GMainContext *context = NULL;
+    GTask *task = NULL;
+    JobTrackData *data = NULL;
+    GSource *source = NULL;
+    gchar *obj_path = NULL;
+    gchar *task_path = NULL;
+    guint64 log_task_id = 0;
+    guint64 prog_id = 0;
+    gchar *log_msg = NULL;
+
+    /* the tracking thread must be up before the method is even called */
+    context = get_om_context ();
+    if (!context) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Failed to start the job tracking thread");
+        return FALSE;
+    }
+
+    ret = call_lvm_method (obj, intf, method, params, extra_params, extra_args, &log_task_id, &prog_id, lock_config, error);
+    if (!ret) {
+        if (prog_id != 0)
+            bd_utils_report_finished (prog_id, (*error)->message);
+        return FALSE;
+    }
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, call_lvm_method_async);
+
+    if (g_variant_check_format_string (ret, "((oo))", TRUE)) {
+        g_variant_get (ret, "((oo))", &obj_path, &task_path);
+        g_variant_unref (ret);
+        if (g_strcmp0 (obj_path, "/") != 0) {
+            log_msg = g_strdup_printf ("Got result: %s", obj_path);
+            bd_utils_log_task_status (log_task_id, log_msg);
+            g_free (log_msg);
+            /* got a valid result, no job to wait for */
+            bd_utils_report_finished (prog_id, "Completed");
+            g_task_return_boolean (task, TRUE);
+            g_object_unref (task);
+            g_free (obj_path);
+            g_free (task_path);
+            return TRUE;
+        }
+        g_free (obj_path);
+        if (g_strcmp0 (task_path, "/") == 0) {
+            bd_utils_log_task_status (log_task_id, "Task finished without result and without job started");
+            bd_utils_report_finished (prog_id, "Task finished without result and without job started");
+            g_task_return_new_error (task, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                                     "Running '%s' method on the '%s' object failed: "
+                                     "Task finished without result and without job started",
+                                     method, obj);
+            g_object_unref (task);
+            g_free (task_path);
+            return TRUE;
+        }
+    } else if (g_variant_check_format_string (ret, "(o)", TRUE)) {
+        g_variant_get (ret, "(o)", &task_path);
+        g_variant_unref (ret);
+        if (g_strcmp0 (task_path, "/") == 0) {
+            bd_utils_log_task_status (log_task_id, "No result, no job started");
+            bd_utils_report_finished (prog_id, "Completed");
+            g_task_return_boolean (task, TRUE);
+            g_object_unref (task);
+            g_free (task_path);
+            return TRUE;
+        }
+    } else {
+        g_variant_unref (ret);
+        bd_utils_log_task_status (log_task_id, "Failed to parse the returned value!");
+        bd_utils_report_finished (prog_id, "Failed to parse the returned value!");
+        g_task_return_new_error (task, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                                 "Failed to parse the returned value!");
+        g_object_unref (task);
+        return TRUE;
+    }
+
+    log_msg = g_strdup_printf ("Waiting for job '%s' to finish", task_path);
+    bd_utils_log_task_status (log_task_id, log_msg);
+    g_free (log_msg);
+
+    data = g_new0 (JobTrackData, 1);
+    data->task = task;
+    data->task_path = task_path;
+    data->obj = g_strdup (obj);
+    data->method = g_strdup (method);
+    data->log_task_id = log_task_id;
+    data->prog_id = prog_id;
+
+    source = g_timeout_source_new (PROGRESS_WAIT / 1000);
+    g_source_set_callback (source, job_poll_cb, data, NULL);
+    g_source_attach (source, context);
+    g_source_unref (source);
+
+    return TRUE;
+}
+
 static void call_lvm_obj_method_sync (const gchar *obj_id, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
     gchar *obj_path = get_object_path (obj_id, error);
     if (!obj_path)
@@ -857,6 +1362,34 @@ static GVariant* get_object_properties (const gchar *obj_path, const gchar *ifac
     GVariant *args = NULL;
     GVariant *ret = NULL;
     GVariant *real_ret = NULL;
+    GDBusObjectManager *manager = NULL;
+    GDBusInterface *iface_proxy = NULL;
+    gchar **prop_names = NULL;
+    GVariant *prop_val = NULL;
+    GVariantBuilder builder;
+    guint i = 0;
+
+    manager = get_obj_manager ();
+    if (manager) {
+        om_cache_sync ();
+        iface_proxy = g_dbus_object_manager_get_interface (manager, obj_path, iface);
+        if (iface_proxy) {
+            prop_names = g_dbus_proxy_get_cached_property_names (G_DBUS_PROXY (iface_proxy));
+            if (prop_names) {
+                g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+                for (i=0; prop_names[i]; i++) {
+                    prop_val = g_dbus_proxy_get_cached_property (G_DBUS_PROXY (iface_proxy), prop_names[i]);
+                    g_variant_builder_add (&builder, "{sv}", prop_names[i], prop_val);
+                    g_variant_unref (prop_val);
+                }
+                g_strfreev (prop_names);
+                g_object_unref (iface_proxy);
+                return g_variant_ref_sink (g_variant_builder_end (&builder));
+            }
+            g_object_unref (iface_proxy);
+        }
+        /* not in the cache (yet), fall back to a direct query */
+    }
 
     args = g_variant_new ("(s)", iface);
 
@@ -1614,26 +2147,10 @@ gboolean bd_lvm_pvremove (const gchar *device, const BDExtraArg **extra, GError
     return (*error == NULL);
 }
 
-/**
- * bd_lvm_pvmove:
- * @src: the PV device to move extents off of
- * @dest: (allow-none): the PV device to move extents onto or %NULL
- * @extra: (allow-none) (array zero-terminated=1): extra options for the PV move
- *                                                 (just passed to LVM as is)
- * @error: (out): place to store error (if any)
- *
- * Returns: whether the extents from the @src PV where successfully moved or not
- *
- * If @dest is %NULL, VG allocation rules are used for the extents from the @src
- * PV (see pvmove(8)).
- *
- * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
- */
-gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **extra, GError **error) {
+static GVariant* prepare_pvmove_params (const gchar *src, const gchar *dest, gchar **vg_obj_path, GError **error) {
     GVariant *prop = NULL;
     gchar *src_path = NULL;
     gchar *dest_path = NULL;
-    gchar *vg_obj_path = NULL;
     GVariantBuilder builder;
     GVariantType *type = NULL;
     GVariant *dest_var = NULL;
@@ -1644,7 +2161,7 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
         if (!(*error))
             g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
                          "The source PV '%s' doesn't exist", src);
-        return FALSE;
+        return NULL;
     }
     if (dest) {
         dest_path = get_object_path (dest, error);
@@ -1652,15 +2169,17 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
             if (!(*error))
                 g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
                              "The destination PV '%s' doesn't exist", dest);
-            return FALSE;
+            g_free (src_path);
+            return NULL;
         }
     }
     prop = get_object_property (src_path, PV_INTF, "Vg", error);
     if (!prop) {
         g_free (src_path);
-        return FALSE;
+        g_free (dest_path);
+        return NULL;
     }
-    g_variant_get (prop, "o", &vg_obj_path);
+    g_variant_get (prop, "o", vg_obj_path);
 
     g_variant_builder_init (&builder, G_VARIANT_TYPE_TUPLE);
     g_variant_builder_add_value (&builder, g_variant_new ("o", src_path));
@@ -1676,14 +2195,93 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    call_lvm_method_sync (vg_obj_path, VG_INTF, "Move", params, NULL, extra, TRUE, error);
-
     g_free (src_path);
     g_free (dest_path);
+    return params;
+}
+
+/**
+ * bd_lvm_pvmove:
+ * @src: the PV device to move extents off of
+ * @dest: (allow-none): the PV device to move extents onto or %NULL
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the PV move
+ *                                                 (just passed to LVM as is)
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: whether the extents from the @src PV where successfully moved or not
+ *
+ * If @dest is %NULL, VG allocation rules are used for the extents from the @src
+ * PV (see pvmove(8)).
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **extra, GError **error) {
+    gchar *vg_obj_path = NULL;
+    GVariant *params = NULL;
+
+    params = prepare_pvmove_params (src, dest, &vg_obj_path, error);
+    if (!params)
+        return FALSE;
+
+    call_lvm_method_sync (vg_obj_path, VG_INTF, "Move", params, NULL, extra, TRUE, error);
+
     g_free (vg_obj_path);
     return ((*error) == NULL);
 }
 
+/**
+ * bd_lvm_pvmove_async:
+ * @src: the PV device to move extents off of
+ * @dest: (allow-none): the PV device to move extents onto or %NULL
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the PV move
+ *                                                 (just passed to LVM as is)
+ * @cancellable: (allow-none): a #GCancellable to stop tracking the move or %NULL
+ * @callback: (scope async): function to call when the move is done
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Asynchronous variant of bd_lvm_pvmove(). The returned lvmdbusd job is
+ * tracked by a single shared thread, so any number of moves can be in flight
+ * at once without blocking the caller; progress is reported through the
+ * standard progress reporting machinery. Call bd_lvm_pvmove_finish() from
+ * @callback to get the result. Note that cancelling @cancellable only stops
+ * tracking the job, the move itself keeps running in lvmdbusd.
+ *
+ * Returns: whether the move was successfully started or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_async (const gchar *src, const gchar *dest, const BDExtraArg **extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error) {
+    gchar *vg_obj_path = NULL;
+    GVariant *params = NULL;
+    gboolean ret = FALSE;
+
+    params = prepare_pvmove_params (src, dest, &vg_obj_path, error);
+    if (!params)
+        return FALSE;
+
+    ret = call_lvm_method_async (vg_obj_path, VG_INTF, "Move", params, NULL, extra, TRUE, cancellable, callback, user_data, error);
+
+    g_free (vg_obj_path);
+    return ret;
+}
+
+/**
+ * bd_lvm_pvmove_finish:
+ * @result: the #GAsyncResult handed to the #GAsyncReadyCallback given to
+ *          bd_lvm_pvmove_async()
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: whether the extents from the source PV where successfully moved or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_finish (GAsyncResult *result, GError **error) {
+    g_warn_if_fail (g_task_is_valid (result, NULL));
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * bd_lvm_pvscan:
  * @device: (allow-none): the device to scan for PVs or %NULL
@@ -1729,6 +2327,64 @@ gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtr
     return ((*error) == NULL);
 }
 
+/**
+ * bd_lvm_pvscan_many:
+ * @devices: (array zero-terminated=1): devices to scan for PVs
+ * @update_cache: whether to update the lvmetad cache or not
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the PV scan
+ *                                                 (just passed to LVM as is)
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_lvm_pvscan() taking a whole batch of devices. All the devices
+ * are passed to lvmdbusd in a single 'PvScan' call so scanning many
+ * hotplugged devices takes one scan instead of one per device. The @devices
+ * argument is used only if @update_cache is %TRUE. Otherwise the whole system
+ * is scanned for PVs.
+ *
+ * Returns: whether the system or @devices were successfully scanned for PVs or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pvscan_many (const gchar **devices, gboolean update_cache, const BDExtraArg **extra, GError **error) {
+    GVariantBuilder builder;
+    GVariantType *type = NULL;
+    GVariant *params = NULL;
+    GVariant **device_vars = NULL;
+    guint n_devices = 0;
+    guint i = 0;
+
+    if (devices)
+        n_devices = g_strv_length ((gchar **) devices);
+    if (!update_cache && n_devices > 0)
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Ignoring the devices argument in pvscan (cache update not requested)");
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE_TUPLE);
+    /* update the cache and specify the devices (if any) */
+    g_variant_builder_add_value (&builder, g_variant_new_boolean (FALSE));
+    g_variant_builder_add_value (&builder, g_variant_new_boolean (update_cache));
+    if (update_cache && n_devices > 0) {
+        device_vars = g_new0 (GVariant*, n_devices + 1);
+        for (i = 0; i < n_devices; i++)
+            device_vars[i] = g_variant_new_string (devices[i]);
+        g_variant_builder_add_value (&builder, g_variant_new_array (G_VARIANT_TYPE_STRING, device_vars, n_devices));
+    } else {
+        type = g_variant_type_new ("as");
+        g_variant_builder_add_value (&builder, g_variant_new_array (type, NULL, 0));
+        g_variant_type_free (type);
+    }
+    /* (major, minor)`s, we never specify them */
+    type = g_variant_type_new ("a(ii)");
+    g_variant_builder_add_value (&builder, g_variant_new_array (type, NULL, 0));
+    g_variant_type_free (type);
+
+    params = g_variant_builder_end (&builder);
+    g_variant_builder_clear (&builder);
+
+    call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvScan", params, NULL, extra, TRUE, error);
+    g_free (device_vars);
+    return ((*error) == NULL);
+}
+
 
 static gboolean _manage_lvm_tags (const gchar *objpath, const gchar *pv_path, const gchar *intf, const gchar **tags, const gchar *func, GError **error) {
     guint num_tags = g_strv_length ((gchar **) tags);
@@ -1911,6 +2567,35 @@ BDLVMPVdata** bd_lvm_pvs (GError **error) {
     return ret;
 }
 
+/**
+ * bd_lvm_full_report:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full): information about all PVs, VGs and LVs found in
+ * the system. With the DBus API there is no per-object-type process to spawn,
+ * so this is just a convenience wrapper composing bd_lvm_pvs(), bd_lvm_vgs()
+ * and bd_lvm_lvs().
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMFullReport* bd_lvm_full_report (GError **error) {
+    BDLVMFullReport *report = NULL;
+
+    report = g_new0 (BDLVMFullReport, 1);
+    report->pvs = bd_lvm_pvs (error);
+    if (report->pvs)
+        report->vgs = bd_lvm_vgs (error);
+    if (report->vgs)
+        report->lvs = bd_lvm_lvs (NULL, error);
+    if (!report->lvs) {
+        /* error is already populated */
+        bd_lvm_fullreport_free (report);
+        return NULL;
+    }
+
+    return report;
+}
+
 /**
  * bd_lvm_vgcreate:
  * @name: name of the newly created VG
@@ -2800,6 +3485,131 @@ BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error) {
     return ret;
 }
 
+
+/* strip the brackets the reporting tools put around internal LV names */
+static gchar* lv_plain_name (const gchar *name) {
+    if (g_str_has_prefix (name, "[") && g_str_has_suffix (name, "]"))
+        return g_strndup (name + 1, strlen (name) - 2);
+    return g_strdup (name);
+}
+
+/* link the given LVs into parent/child trees, taking ownership of the
+   individual BDLVMLVdata items (but not of the array itself) */
+static BDLVMLVTreeNode** link_lv_tree (BDLVMLVdata **lvs) {
+    GHashTable *nodes_by_name = NULL;   /* "vg_name/lv_name" -> node */
+    BDLVMLVTreeNode **nodes = NULL;
+    BDLVMLVTreeNode *node = NULL;
+    GPtrArray *roots = NULL;
+    const gchar *parent_name = NULL;
+    const gchar *internal[2] = {NULL, NULL};
+    gchar *name = NULL;
+    gchar *key = NULL;
+    guint n_lvs = 0;
+    guint n_children = 0;
+    guint i = 0;
+    guint j = 0;
+
+    for (n_lvs=0; lvs[n_lvs]; n_lvs++);
+    nodes = g_new0 (BDLVMLVTreeNode*, n_lvs + 1);
+    nodes_by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    for (i=0; i < n_lvs; i++) {
+        nodes[i] = g_new0 (BDLVMLVTreeNode, 1);
+        nodes[i]->data = lvs[i];
+        name = lv_plain_name (lvs[i]->lv_name);
+        g_hash_table_replace (nodes_by_name,
+                              g_strdup_printf ("%s/%s", lvs[i]->vg_name, name),
+                              nodes[i]);
+        g_free (name);
+    }
+
+    /* thin and cached LVs hang under their pool, snapshots under their origin */
+    for (i=0; i < n_lvs; i++) {
+        parent_name = NULL;
+        if (nodes[i]->data->pool_lv && *(nodes[i]->data->pool_lv))
+            parent_name = nodes[i]->data->pool_lv;
+        else if (nodes[i]->data->origin && *(nodes[i]->data->origin))
+            parent_name = nodes[i]->data->origin;
+        if (parent_name) {
+            name = lv_plain_name (parent_name);
+            key = g_strdup_printf ("%s/%s", nodes[i]->data->vg_name, name);
+            nodes[i]->parent = g_hash_table_lookup (nodes_by_name, key);
+            g_free (key);
+            g_free (name);
+        }
+    }
+
+    /* internal data/metadata LVs hang under the pool referencing them */
+    for (i=0; i < n_lvs; i++) {
+        internal[0] = nodes[i]->data->data_lv;
+        internal[1] = nodes[i]->data->metadata_lv;
+        for (j=0; j < 2; j++) {
+            if (internal[j] && *(internal[j])) {
+                name = lv_plain_name (internal[j]);
+                key = g_strdup_printf ("%s/%s", nodes[i]->data->vg_name, name);
+                node = g_hash_table_lookup (nodes_by_name, key);
+                if (node && !node->parent && (node != nodes[i]))
+                    node->parent = nodes[i];
+                g_free (key);
+                g_free (name);
+            }
+        }
+    }
+
+    /* all the parents are known now, fill in the children arrays */
+    for (i=0; i < n_lvs; i++) {
+        n_children = 0;
+        for (j=0; j < n_lvs; j++)
+            if (nodes[j]->parent == nodes[i])
+                n_children++;
+        nodes[i]->children = g_new0 (BDLVMLVTreeNode*, n_children + 1);
+        n_children = 0;
+        for (j=0; j < n_lvs; j++)
+            if (nodes[j]->parent == nodes[i])
+                nodes[i]->children[n_children++] = nodes[j];
+    }
+
+    roots = g_ptr_array_new ();
+    for (i=0; i < n_lvs; i++)
+        if (!nodes[i]->parent)
+            g_ptr_array_add (roots, nodes[i]);
+    g_ptr_array_add (roots, NULL);
+
+    g_hash_table_destroy (nodes_by_name);
+    g_free (nodes);
+    return (BDLVMLVTreeNode **) g_ptr_array_free (roots, FALSE);
+}
+
+/**
+ * bd_lvm_lvs_tree:
+ * @vg_name: (allow-none): name of the VG to get the LV topology for or %NULL
+ *                         for all VGs
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): trees of the LVs
+ * (including the internal data and metadata LVs) found in the given @vg_name
+ * VG or in the system if @vg_name is %NULL, linked parent/child: thin and
+ * cached LVs hang under their pool, snapshots under their origin and the
+ * internal data/metadata LVs under the pool using them
+ *
+ * All the information is gathered in a single reporting call, so rendering a
+ * whole VG's topology doesn't need an extra query per LV.
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMLVTreeNode** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
+    BDLVMLVdata **lvs = NULL;
+    BDLVMLVTreeNode **roots = NULL;
+
+    lvs = bd_lvm_lvs (vg_name, error);
+    if (!lvs)
+        return NULL;
+
+    roots = link_lv_tree (lvs);
+    /* the nodes took over the individual items, only the array remains ours */
+    g_free (lvs);
+    return roots;
+}
+
 /**
  * bd_lvm_thpoolcreate:
  * @vg_name: name of the VG to create a thin pool in
@@ -2987,6 +3797,41 @@ gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error UNUSE
     return TRUE;
 }
 
+/**
+ * bd_lvm_set_shell_mode:
+ * @enabled: whether to run LVM commands in a persistent 'lvm shell' session
+ * @error: (out): place to store error (if any)
+ *
+ * The DBus plugin already talks to the long-lived lvmdbusd daemon, so there is
+ * no per-call process spawn to avoid. This function is a no-op here and only
+ * exists so that both LVM plugins provide the same API.
+ *
+ * Returns: whether the requested mode was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_set_shell_mode (gboolean enabled UNUSED, GError **error UNUSED) {
+    return TRUE;
+}
+
+/**
+ * bd_lvm_set_query_cache:
+ * @enabled: whether to serve VG/LV queries from an in-memory cache or not
+ * @error: (out): place to store error (if any)
+ *
+ * The DBus plugin keeps an ObjectManager-backed cache of the lvmdbusd objects
+ * and their properties which already serves queries from memory, so there is
+ * nothing extra to enable. This function is a no-op here and only exists so
+ * that both LVM plugins provide the same API.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_set_query_cache (gboolean enabled UNUSED, GError **error UNUSED) {
+    return TRUE;
+}
+
 /**
  * bd_lvm_get_global_config:
  * @error: (out): place to store error (if any)
@@ -4193,6 +5038,23 @@ GHashTable* bd_lvm_vdo_get_stats_full (const gchar *vg_name, const gchar *pool_n
     return vdo_get_stats_full(kvdo_name, error);
 }
 
+static BDLVMVDOStats* vdo_stats_from_full (GHashTable *full_stats) {
+    BDLVMVDOStats *stats = g_new0 (BDLVMVDOStats, 1);
+
+    get_stat_val64_default (full_stats, "block_size", &stats->block_size, -1);
+    get_stat_val64_default (full_stats, "logical_block_size", &stats->logical_block_size, -1);
+    get_stat_val64_default (full_stats, "physical_blocks", &stats->physical_blocks, -1);
+    get_stat_val64_default (full_stats, "data_blocks_used", &stats->data_blocks_used, -1);
+    get_stat_val64_default (full_stats, "overhead_blocks_used", &stats->overhead_blocks_used, -1);
+    get_stat_val64_default (full_stats, "logical_blocks_used", &stats->logical_blocks_used, -1);
+    get_stat_val64_default (full_stats, "usedPercent", &stats->used_percent, -1);
+    get_stat_val64_default (full_stats, "savingPercent", &stats->saving_percent, -1);
+    if (!get_stat_val_double (full_stats, "writeAmplificationRatio", &stats->write_amplification_ratio))
+        stats->write_amplification_ratio = -1;
+
+    return stats;
+}
+
 /**
  * bd_lvm_vdo_get_stats:
  * @vg_name: name of the VG that contains @pool_name VDO pool
@@ -4215,19 +5077,46 @@ BDLVMVDOStats* bd_lvm_vdo_get_stats (const gchar *vg_name, const gchar *pool_nam
     if (!full_stats)
         return NULL;
 
-    stats = g_new0 (BDLVMVDOStats, 1);
-    get_stat_val64_default (full_stats, "block_size", &stats->block_size, -1);
-    get_stat_val64_default (full_stats, "logical_block_size", &stats->logical_block_size, -1);
-    get_stat_val64_default (full_stats, "physical_blocks", &stats->physical_blocks, -1);
-    get_stat_val64_default (full_stats, "data_blocks_used", &stats->data_blocks_used, -1);
-    get_stat_val64_default (full_stats, "overhead_blocks_used", &stats->overhead_blocks_used, -1);
-    get_stat_val64_default (full_stats, "logical_blocks_used", &stats->logical_blocks_used, -1);
-    get_stat_val64_default (full_stats, "usedPercent", &stats->used_percent, -1);
-    get_stat_val64_default (full_stats, "savingPercent", &stats->saving_percent, -1);
-    if (!get_stat_val_double (full_stats, "writeAmplificationRatio", &stats->write_amplification_ratio))
-        stats->write_amplification_ratio = -1;
+    stats = vdo_stats_from_full (full_stats);
 
     g_hash_table_destroy (full_stats);
 
     return stats;
 }
+
+/**
+ * bd_lvm_vdo_get_all_stats:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (element-type utf8 BDLVMVDOStats): selected
+ *          statistics for all VDO volumes present in the system keyed by the
+ *          kvdo device name (`<vg_name>-<pool_name>-vpool`) or %NULL in case
+ *          of error (@error gets populated in those cases)
+ *
+ * In contrast to calling bd_lvm_vdo_get_stats() per volume this function
+ * walks the `/sys/kvdo` tree only once no matter how many VDO volumes there
+ * are, so periodically sampling many volumes costs a single directory scan.
+ *
+ * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+GHashTable* bd_lvm_vdo_get_all_stats (GError **error) {
+    GHashTable *all_full = NULL;
+    GHashTable *ret = NULL;
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+
+    all_full = vdo_get_all_stats (error);
+    if (!all_full)
+        return NULL;
+
+    ret = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                 (GDestroyNotify) bd_lvm_vdo_stats_free);
+    g_hash_table_iter_init (&iter, all_full);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+        g_hash_table_replace (ret, g_strdup ((gchar *) key),
+                              vdo_stats_from_full ((GHashTable *) value));
+    g_hash_table_destroy (all_full);
+
+    return ret;
+}
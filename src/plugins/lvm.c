@@ -21,6 +21,10 @@
 #include <math.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <libudev.h>
 #include <blockdev/utils.h>
 
 #include "lvm.h"
@@ -46,6 +50,9 @@
 
 #define LVM_MIN_VERSION "2.02.116"
 
+/* maximal number of devices passed to a single 'pvscan' invocation */
+#define PVSCAN_BATCH_SIZE 32
+
 static GMutex global_config_lock;
 static gchar *global_config_str = NULL;
 
@@ -175,6 +182,91 @@ void bd_lvm_lvdata_free (BDLVMLVdata *data) {
     g_free (data);
 }
 
+BDLVMFullReport* bd_lvm_fullreport_copy (BDLVMFullReport *data) {
+    guint i = 0;
+    guint len = 0;
+
+    if (data == NULL)
+        return NULL;
+
+    BDLVMFullReport *new_data = g_new0 (BDLVMFullReport, 1);
+
+    for (len=0; data->pvs[len]; len++);
+    new_data->pvs = g_new0 (BDLVMPVdata*, len + 1);
+    for (i=0; i < len; i++)
+        new_data->pvs[i] = bd_lvm_pvdata_copy (data->pvs[i]);
+
+    for (len=0; data->vgs[len]; len++);
+    new_data->vgs = g_new0 (BDLVMVGdata*, len + 1);
+    for (i=0; i < len; i++)
+        new_data->vgs[i] = bd_lvm_vgdata_copy (data->vgs[i]);
+
+    for (len=0; data->lvs[len]; len++);
+    new_data->lvs = g_new0 (BDLVMLVdata*, len + 1);
+    for (i=0; i < len; i++)
+        new_data->lvs[i] = bd_lvm_lvdata_copy (data->lvs[i]);
+
+    return new_data;
+}
+
+void bd_lvm_fullreport_free (BDLVMFullReport *data) {
+    guint i = 0;
+
+    if (data == NULL)
+        return;
+
+    if (data->pvs)
+        for (i=0; data->pvs[i]; i++)
+            bd_lvm_pvdata_free (data->pvs[i]);
+    g_free (data->pvs);
+    if (data->vgs)
+        for (i=0; data->vgs[i]; i++)
+            bd_lvm_vgdata_free (data->vgs[i]);
+    g_free (data->vgs);
+    if (data->lvs)
+        for (i=0; data->lvs[i]; i++)
+            bd_lvm_lvdata_free (data->lvs[i]);
+    g_free (data->lvs);
+    g_free (data);
+}
+
+
+BDLVMLVTreeNode* bd_lvm_lvtreenode_copy (BDLVMLVTreeNode *data) {
+    guint i = 0;
+    guint len = 0;
+
+    if (data == NULL)
+        return NULL;
+
+    BDLVMLVTreeNode *new_data = g_new0 (BDLVMLVTreeNode, 1);
+
+    new_data->data = bd_lvm_lvdata_copy (data->data);
+    /* the copy is detached from the original's parent */
+    new_data->parent = NULL;
+    for (len=0; data->children[len]; len++);
+    new_data->children = g_new0 (BDLVMLVTreeNode*, len + 1);
+    for (i=0; i < len; i++) {
+        new_data->children[i] = bd_lvm_lvtreenode_copy (data->children[i]);
+        new_data->children[i]->parent = new_data;
+    }
+
+    return new_data;
+}
+
+void bd_lvm_lvtreenode_free (BDLVMLVTreeNode *data) {
+    guint i = 0;
+
+    if (data == NULL)
+        return;
+
+    if (data->children)
+        for (i=0; data->children[i]; i++)
+            bd_lvm_lvtreenode_free (data->children[i]);
+    g_free (data->children);
+    bd_lvm_lvdata_free (data->data);
+    g_free (data);
+}
+
 BDLVMVDOPooldata* bd_lvm_vdopooldata_copy (BDLVMVDOPooldata *data) {
     if (data == NULL)
         return NULL;
@@ -256,8 +348,148 @@ static const UtilFeatureDep features[FEATURES_LAST] = {
 
 static const gchar*const module_deps[MODULE_DEPS_LAST] = { "kvdo" };
 
+/* prompt printed by 'lvm shell' when it is ready for the next command */
+#define LVM_SHELL_PROMPT "lvm> "
+
+static GMutex lvm_shell_lock;
+static gint lvm_shell_mode = 0;
+static GPid lvm_shell_pid = 0;
+static gint lvm_shell_in_fd = -1;
+static gint lvm_shell_out_fd = -1;
+
+static void stop_lvm_shell (void);
+
 #define UNUSED __attribute__((unused))
 
+/* opt-in in-memory cache for the VG/LV query APIs, invalidated by udev events
+   on block devices (see bd_lvm_set_query_cache()) */
+static GMutex lvm_cache_lock;
+static gboolean lvm_cache_enabled = FALSE;
+static guint64 lvm_cache_generation = 0;
+static GHashTable *vg_info_cache = NULL;    /* vg_name -> BDLVMVGdata */
+static GHashTable *lv_info_cache = NULL;    /* "vg_name/lv_name" -> BDLVMLVdata */
+static GThread *udev_watch_thread = NULL;
+static struct udev *udev_context = NULL;
+static struct udev_monitor *udev_mon = NULL;
+static gint udev_watch_pipe[2] = {-1, -1};
+
+static gboolean drop_vg_lvs (gpointer key, gpointer value UNUSED, gpointer user_data) {
+    return g_str_has_prefix ((const gchar *) key, (const gchar *) user_data);
+}
+
+static void invalidate_lvm_cache (const gchar *vg_name) {
+    gchar *prefix = NULL;
+
+    g_mutex_lock (&lvm_cache_lock);
+    if (!lvm_cache_enabled) {
+        g_mutex_unlock (&lvm_cache_lock);
+        return;
+    }
+    lvm_cache_generation++;
+    if (vg_name) {
+        g_hash_table_remove (vg_info_cache, vg_name);
+        prefix = g_strdup_printf ("%s/", vg_name);
+        g_hash_table_foreach_remove (lv_info_cache, drop_vg_lvs, prefix);
+        g_free (prefix);
+    } else {
+        g_hash_table_remove_all (vg_info_cache);
+        g_hash_table_remove_all (lv_info_cache);
+    }
+    g_mutex_unlock (&lvm_cache_lock);
+}
+
+static gpointer udev_watch_thread_func (gpointer data UNUSED) {
+    struct pollfd fds[2];
+    struct udev_device *device = NULL;
+    const gchar *vg_name = NULL;
+
+    fds[0].fd = udev_watch_pipe[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = udev_monitor_get_fd (udev_mon);
+    fds[1].events = POLLIN;
+
+    while (TRUE) {
+        if (poll (fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[0].revents)
+            /* told to quit */
+            break;
+        if (fds[1].revents) {
+            device = udev_monitor_receive_device (udev_mon);
+            if (!device)
+                continue;
+            /* events for DM devices carry the VG name so only the affected VG
+               needs to be dropped, any other block device may be a PV
+               appearing or disappearing and the whole cache has to go */
+            vg_name = udev_device_get_property_value (device, "DM_VG_NAME");
+            invalidate_lvm_cache (vg_name);
+            udev_device_unref (device);
+        }
+    }
+    return NULL;
+}
+
+static void stop_udev_watch (void) {
+    while (udev_watch_thread && write (udev_watch_pipe[1], "q", 1) < 0 && errno == EINTR)
+        ;
+    if (udev_watch_thread) {
+        g_thread_join (udev_watch_thread);
+        udev_watch_thread = NULL;
+    }
+    if (udev_watch_pipe[0] >= 0) {
+        close (udev_watch_pipe[0]);
+        close (udev_watch_pipe[1]);
+        udev_watch_pipe[0] = -1;
+        udev_watch_pipe[1] = -1;
+    }
+    if (udev_mon) {
+        udev_monitor_unref (udev_mon);
+        udev_mon = NULL;
+    }
+    if (udev_context) {
+        udev_unref (udev_context);
+        udev_context = NULL;
+    }
+}
+
+static gboolean start_udev_watch (GError **error) {
+    udev_context = udev_new ();
+    if (!udev_context) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Failed to create the udev context");
+        return FALSE;
+    }
+    udev_mon = udev_monitor_new_from_netlink (udev_context, "udev");
+    if (!udev_mon) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Failed to create the udev monitor");
+        stop_udev_watch ();
+        return FALSE;
+    }
+    udev_monitor_filter_add_match_subsystem_devtype (udev_mon, "block", NULL);
+    if (udev_monitor_enable_receiving (udev_mon) < 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Failed to start receiving udev events");
+        stop_udev_watch ();
+        return FALSE;
+    }
+    if (pipe (udev_watch_pipe) != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Failed to create the udev watch control pipe: %m");
+        stop_udev_watch ();
+        return FALSE;
+    }
+    udev_watch_thread = g_thread_try_new ("lvm-udev-watch", udev_watch_thread_func, NULL, error);
+    if (!udev_watch_thread) {
+        stop_udev_watch ();
+        return FALSE;
+    }
+    return TRUE;
+}
+
 /**
  * bd_lvm_check_deps:
  *
@@ -304,6 +536,10 @@ gboolean bd_lvm_init (void) {
     dm_log_init_verbose (LOG_INFO);
 #endif
 
+    /* warm up the utility version checks in the background so the first real
+       call doesn't have to wait for them */
+    check_deps_async (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock);
+
     return TRUE;
 };
 
@@ -317,6 +553,13 @@ gboolean bd_lvm_init (void) {
 void bd_lvm_close (void) {
     dm_log_with_errno_init (NULL);
     dm_log_init_verbose (0);
+
+    g_mutex_lock (&lvm_shell_lock);
+    stop_lvm_shell ();
+    g_atomic_int_set (&lvm_shell_mode, 0);
+    g_mutex_unlock (&lvm_shell_lock);
+
+    bd_lvm_set_query_cache (FALSE, NULL);
 }
 
 /**
@@ -357,9 +600,184 @@ gboolean bd_lvm_is_tech_avail (BDLVMTech tech, guint64 mode, GError **error) {
     }
 }
 
+/* must be called with lvm_shell_lock held */
+static void stop_lvm_shell (void) {
+    if (lvm_shell_pid == 0)
+        return;
+
+    /* closing its stdin makes the shell exit */
+    close (lvm_shell_in_fd);
+    close (lvm_shell_out_fd);
+    waitpid (lvm_shell_pid, NULL, 0);
+    g_spawn_close_pid (lvm_shell_pid);
+    lvm_shell_pid = 0;
+    lvm_shell_in_fd = -1;
+    lvm_shell_out_fd = -1;
+}
+
+/* read from the shell's output until the prompt appears, must be called with
+   lvm_shell_lock held */
+static gboolean lvm_shell_read_response (GString *buf, GError **error) {
+    gchar data[4096];
+    ssize_t n_read = 0;
+    gsize prompt_len = strlen (LVM_SHELL_PROMPT);
+
+    while ((buf->len < prompt_len) ||
+           (strcmp (buf->str + buf->len - prompt_len, LVM_SHELL_PROMPT) != 0)) {
+        n_read = read (lvm_shell_out_fd, data, sizeof (data));
+        if (n_read <= 0) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                         "The 'lvm shell' process died unexpectedly");
+            return FALSE;
+        }
+        g_string_append_len (buf, data, n_read);
+    }
+    return TRUE;
+}
+
+/* must be called with lvm_shell_lock held */
+static gboolean start_lvm_shell (GError **error) {
+    /* make the shell print a machine-readable status report after every
+       command (the JSON 'log' section with log_ret_code) and merge stderr
+       into stdout so error messages end up in the captured response */
+    const gchar *argv[] = {"sh", "-c",
+                           "exec lvm shell --config 'log {report_command_log=1 command_log_selection=\"log_type=status\"} report {output_format=json}' 2>&1",
+                           NULL};
+    GString *buf = NULL;
+    gboolean ret = FALSE;
+
+    ret = g_spawn_async_with_pipes (NULL, (gchar **) argv, NULL,
+                                    G_SPAWN_DEFAULT|G_SPAWN_SEARCH_PATH|G_SPAWN_DO_NOT_REAP_CHILD,
+                                    NULL, NULL, &lvm_shell_pid, &lvm_shell_in_fd, &lvm_shell_out_fd, NULL, error);
+    if (!ret) {
+        lvm_shell_pid = 0;
+        return FALSE;
+    }
+
+    /* wait for the shell to scan devices and print its first prompt */
+    buf = g_string_new (NULL);
+    ret = lvm_shell_read_response (buf, error);
+    g_string_free (buf, TRUE);
+    if (!ret)
+        stop_lvm_shell ();
+
+    return ret;
+}
+
+/* the lvm shell reads commands a line at a time, so an embedded newline would
+   terminate the command early and execute the remainder as a second, arbitrary
+   command (quoting cannot help); such arguments must go through direct
+   spawning instead */
+static gboolean args_lvm_shell_safe (const gchar **args) {
+    guint i = 0;
+
+    for (i = 0; args[i]; i++)
+        if (strpbrk (args[i], "\n\r"))
+            return FALSE;
+    return TRUE;
+}
+
+/* run a single command in the persistent shell, must be called with
+   lvm_shell_lock held; @fatal is set when the session itself broke (as
+   opposed to the command merely failing) */
+static gboolean call_lvm_in_shell (const gchar **args, gboolean *fatal, GError **error) {
+    guint i = 0;
+    GString *cmd = NULL;
+    GString *resp = NULL;
+    gchar *quoted = NULL;
+    gchar *status_pos = NULL;
+    const gchar *data = NULL;
+    gsize len = 0;
+    ssize_t n_written = 0;
+    guint64 ret_code = 0;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    gboolean success = FALSE;
+
+    if (!args_lvm_shell_safe (args)) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Arguments with newlines cannot be passed to the 'lvm shell' process");
+        *fatal = FALSE;
+        return FALSE;
+    }
+
+    cmd = g_string_new (NULL);
+    for (i=0; args[i]; i++) {
+        if (i > 0)
+            g_string_append_c (cmd, ' ');
+        if (strpbrk (args[i], " \t\n\r\"'")) {
+            quoted = g_shell_quote (args[i]);
+            g_string_append (cmd, quoted);
+            g_free (quoted);
+        } else
+            g_string_append (cmd, args[i]);
+    }
+
+    msg = g_strdup_printf ("Started 'lvm %s'", cmd->str);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    g_string_append_c (cmd, '\n');
+    data = cmd->str;
+    len = cmd->len;
+    while (len > 0) {
+        n_written = write (lvm_shell_in_fd, data, len);
+        if (n_written <= 0) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                         "Failed to write to the 'lvm shell' process");
+            bd_utils_report_finished (progress_id, (*error)->message);
+            g_string_free (cmd, TRUE);
+            *fatal = TRUE;
+            return FALSE;
+        }
+        data += n_written;
+        len -= n_written;
+    }
+    g_string_free (cmd, TRUE);
+
+    resp = g_string_new (NULL);
+    if (!lvm_shell_read_response (resp, error)) {
+        bd_utils_report_finished (progress_id, (*error)->message);
+        g_string_free (resp, TRUE);
+        *fatal = TRUE;
+        return FALSE;
+    }
+
+    /* the status report is the last 'log_ret_code' item in the response,
+       1 means success */
+    status_pos = g_strrstr (resp->str, "\"log_ret_code\"");
+    if (!status_pos) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Failed to find the status report in the 'lvm shell' output");
+        bd_utils_report_finished (progress_id, (*error)->message);
+        g_string_free (resp, TRUE);
+        *fatal = TRUE;
+        return FALSE;
+    }
+    status_pos = strchr (status_pos, ':');
+    while (status_pos && (*status_pos == ':' || *status_pos == ' ' || *status_pos == '"'))
+        status_pos++;
+    ret_code = g_ascii_strtoull (status_pos, NULL, 10);
+
+    success = (ret_code == 1);
+    if (success)
+        bd_utils_report_finished (progress_id, "Completed");
+    else {
+        /* strip the trailing prompt and report the rest as the error message */
+        g_string_truncate (resp, resp->len - strlen (LVM_SHELL_PROMPT));
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Process reported failure: %s", resp->str);
+        bd_utils_report_finished (progress_id, (*error)->message);
+    }
+    g_string_free (resp, TRUE);
+
+    return success;
+}
+
 static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg **extra, gboolean lock_config, GError **error) {
     gboolean success = FALSE;
     guint i = 0;
+    gboolean fatal = FALSE;
     guint args_length = g_strv_length ((gchar **) args);
 
     if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
@@ -379,6 +797,30 @@ static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg
     argv[args_length + 1] = global_config_str ? g_strdup_printf("--config=%s", global_config_str) : NULL;
     argv[args_length + 2] = NULL;
 
+    if (!extra && g_atomic_int_get (&lvm_shell_mode) && args_lvm_shell_safe (argv + 1)) {
+        g_mutex_lock (&lvm_shell_lock);
+        if (lvm_shell_pid != 0) {
+            /* argv + 1 is the NULL-terminated command without the "lvm" prefix */
+            success = call_lvm_in_shell (argv + 1, &fatal, error);
+            if (!fatal) {
+                g_mutex_unlock (&lvm_shell_lock);
+                if (lock_config)
+                    g_mutex_unlock (&global_config_lock);
+                g_free ((gchar *) argv[args_length + 1]);
+                g_free (argv);
+                return success;
+            }
+            /* the session broke, clean it up and fall back to spawning */
+            bd_utils_log_format (BD_UTILS_LOG_WARNING,
+                                 "The 'lvm shell' session broke (%s), falling back to spawning",
+                                 error && *error ? (*error)->message : "unknown error");
+            stop_lvm_shell ();
+            g_atomic_int_set (&lvm_shell_mode, 0);
+            g_clear_error (error);
+        }
+        g_mutex_unlock (&lvm_shell_lock);
+    }
+
     success = bd_utils_exec_and_report_error (argv, extra, error);
     if (lock_config)
         g_mutex_unlock (&global_config_lock);
@@ -422,31 +864,45 @@ static gboolean call_lvm_and_capture_output (const gchar **args, const BDExtraAr
  * @str: string to parse
  * @num_items: (out): number of parsed items
  *
+ * To keep the number of allocations low (a big listing means tens of
+ * thousands of key=value items) every item is copied just once -- the copy
+ * is split in place at the '=' character, the key owns the buffer and the
+ * value is an interior pointer into it, so destroying the table frees
+ * everything.
+ *
  * Returns: (transfer full): a GHashTable containing key-value items parsed from the @string
  */
 static GHashTable* parse_lvm_vars (const gchar *str, guint *num_items) {
     GHashTable *table = NULL;
-    gchar **items = NULL;
-    gchar **item_p = NULL;
-    gchar **key_val = NULL;
+    const gchar *pos = str;
+    gchar *token = NULL;
+    gchar *eq = NULL;
+    gsize len = 0;
 
-    table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
     *num_items = 0;
 
-    items = g_strsplit_set (str, " \t\n", 0);
-    for (item_p=items; *item_p; item_p++) {
-        key_val = g_strsplit (*item_p, "=", 2);
-        if (g_strv_length (key_val) == 2) {
-            /* we only want to process valid lines (with the '=' character) */
-            g_hash_table_insert (table, key_val[0], key_val[1]);
-            g_free (key_val);
+    while (*pos) {
+        len = strcspn (pos, " \t\n");
+        if (len == 0) {
+            pos++;
+            continue;
+        }
+        token = g_strndup (pos, len);
+        eq = strchr (token, '=');
+        if (eq && (eq != token)) {
+            /* we only want to process valid items (with the '=' character);
+               g_hash_table_replace() keeps the new key which the new value
+               points into */
+            *eq = '\0';
+            g_hash_table_replace (table, token, eq + 1);
             (*num_items)++;
         } else
-            /* invalid line, just free key_val */
-            g_strfreev (key_val);
+            /* invalid item, just free it */
+            g_free (token);
+        pos += len;
     }
 
-    g_strfreev (items);
     return table;
 }
 
@@ -1063,6 +1519,51 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
     return bd_utils_exec_and_report_progress (args, extra, extract_pvmove_progress, &status, error);
 }
 
+/**
+ * bd_lvm_pvmove_async:
+ * @src: the PV device to move extents off of
+ * @dest: (allow-none): the PV device to move extents onto or %NULL
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the PV move
+ *                                                 (just passed to LVM as is)
+ * @cancellable: (allow-none): a #GCancellable to kill the move or %NULL
+ * @callback: (scope async): function to call when the move is done
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Asynchronous variant of bd_lvm_pvmove(). The 'pvmove' utility runs in a
+ * worker thread with progress reported through the standard progress reporting
+ * machinery so any number of moves can be in flight at once without blocking
+ * the caller. Call bd_lvm_pvmove_finish() from @callback to get the result.
+ *
+ * Returns: whether the move was successfully started or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_async (const gchar *src, const gchar *dest, const BDExtraArg **extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error UNUSED) {
+    const gchar *args[6] = {"pvmove", "-i", "1", src, NULL, NULL};
+    if (dest)
+        args[4] = dest;
+
+    bd_utils_exec_and_report_progress_async (args, extra, extract_pvmove_progress, cancellable, callback, user_data);
+    return TRUE;
+}
+
+/**
+ * bd_lvm_pvmove_finish:
+ * @result: the #GAsyncResult handed to the #GAsyncReadyCallback given to
+ *          bd_lvm_pvmove_async()
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: whether the extents from the source PV where successfully moved or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_finish (GAsyncResult *result, GError **error) {
+    gint status = 0;
+
+    return bd_utils_exec_and_report_progress_finish (result, &status, error);
+}
+
 /**
  * bd_lvm_pvscan:
  * @device: (allow-none): the device to scan for PVs or %NULL
@@ -1091,6 +1592,61 @@ gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtr
     return call_lvm_and_report_error (args, extra, TRUE, error);
 }
 
+/**
+ * bd_lvm_pvscan_many:
+ * @devices: (array zero-terminated=1): devices to scan for PVs
+ * @update_cache: whether to update the lvmetad cache or not
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the PV scan
+ *                                                 (just passed to LVM as is)
+ * @error: (out): place to store error (if any)
+ *
+ * Variant of bd_lvm_pvscan() taking a whole batch of devices. The devices are
+ * passed to 'pvscan' in bounded batches so scanning many hotplugged devices
+ * takes a few invocations instead of one per device. The @devices argument is
+ * used only if @update_cache is %TRUE. Otherwise the whole system is scanned
+ * for PVs.
+ *
+ * Returns: whether the system or @devices were successfully scanned for PVs or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pvscan_many (const gchar **devices, gboolean update_cache, const BDExtraArg **extra, GError **error) {
+    const gchar **args = NULL;
+    guint n_devices = 0;
+    guint done = 0;
+    guint batch = 0;
+    guint i = 0;
+    gboolean success = FALSE;
+
+    if (devices)
+        n_devices = g_strv_length ((gchar **) devices);
+
+    if (!update_cache) {
+        if (n_devices > 0)
+            bd_utils_log_format (BD_UTILS_LOG_WARNING, "Ignoring the devices argument in pvscan (cache update not requested)");
+        return bd_lvm_pvscan (NULL, FALSE, extra, error);
+    }
+
+    if (n_devices == 0)
+        return bd_lvm_pvscan (NULL, TRUE, extra, error);
+
+    while (done < n_devices) {
+        batch = MIN (n_devices - done, PVSCAN_BATCH_SIZE);
+        args = g_new0 (const gchar*, batch + 3);
+        args[0] = "pvscan";
+        args[1] = "--cache";
+        for (i = 0; i < batch; i++)
+            args[i + 2] = devices[done + i];
+        success = call_lvm_and_report_error (args, extra, TRUE, error);
+        g_free (args);
+        if (!success)
+            return FALSE;
+        done += batch;
+    }
+
+    return TRUE;
+}
+
 static gboolean _manage_lvm_tags (const gchar *devspec, const gchar **tags, const gchar *action, const gchar *cmd, GError **error) {
     guint tags_len = g_strv_length ((gchar **) tags);
     const gchar **argv = g_new0 (const gchar*, 2 * tags_len + 3);
@@ -1257,6 +1813,95 @@ BDLVMPVdata** bd_lvm_pvs (GError **error) {
     return (BDLVMPVdata **) g_ptr_array_free (pvs, FALSE);
 }
 
+/**
+ * bd_lvm_full_report:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full): information about all PVs, VGs and LVs found in
+ * the system, obtained with a single 'lvm fullreport' call instead of running
+ * a separate reporting command per object type
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMFullReport* bd_lvm_full_report (GError **error) {
+    const gchar *args[24] = {"fullreport", "--noheadings", "--nosuffix", "--nameprefixes",
+                       "--unquoted", "--units=b", "-a",
+                       "--configreport", "pv",
+                       "-o", "pv_name,pv_uuid,pv_free,pv_size,pe_start,vg_name,vg_uuid,vg_size," \
+                       "vg_free,vg_extent_size,vg_extent_count,vg_free_count,pv_count,pv_tags",
+                       "--configreport", "vg",
+                       "-o", "name,uuid,size,free,extent_size,extent_count,free_count,pv_count,vg_exported,vg_tags",
+                       "--configreport", "lv",
+                       "-o", "vg_name,lv_name,lv_uuid,lv_size,lv_attr,segtype,origin,pool_lv,data_lv,metadata_lv,role,move_pv,data_percent,metadata_percent,copy_percent,lv_tags",
+                       /* the segment reports are not needed, shrink them to a single column */
+                       "--configreport", "seg", "-o", "lv_uuid",
+                       NULL};
+    GHashTable *table = NULL;
+    gboolean success = FALSE;
+    gchar *output = NULL;
+    gchar **lines = NULL;
+    gchar **lines_p = NULL;
+    guint num_items;
+    GPtrArray *pvs = NULL;
+    GPtrArray *vgs = NULL;
+    GPtrArray *lvs = NULL;
+    BDLVMFullReport *report = NULL;
+    gpointer data = NULL;
+
+    pvs = g_ptr_array_new ();
+    vgs = g_ptr_array_new ();
+    lvs = g_ptr_array_new ();
+
+    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    if (!success) {
+        if (g_error_matches (*error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT))
+            /* no output => empty topology, not an error */
+            g_clear_error (error);
+        else {
+            /* the error is already populated from the call */
+            g_ptr_array_free (pvs, TRUE);
+            g_ptr_array_free (vgs, TRUE);
+            g_ptr_array_free (lvs, TRUE);
+            return NULL;
+        }
+    }
+
+    /* the output interleaves rows from the PV, VG and LV sub-reports, tell
+       them apart by the number of fields and a field unique to each report */
+    lines = output ? g_strsplit (output, "\n", 0) : g_new0 (gchar*, 1);
+    g_free (output);
+    for (lines_p = lines; *lines_p; lines_p++) {
+        table = parse_lvm_vars ((*lines_p), &num_items);
+        if (!table)
+            continue;
+        if ((num_items == 14) && g_hash_table_lookup (table, "LVM2_PE_START")) {
+            data = get_pv_data_from_table (table, TRUE);
+            if (data)
+                g_ptr_array_add (pvs, data);
+        } else if ((num_items == 10) && g_hash_table_lookup (table, "LVM2_VG_EXPORTED")) {
+            data = get_vg_data_from_table (table, TRUE);
+            if (data)
+                g_ptr_array_add (vgs, data);
+        } else if ((num_items == 16) && g_hash_table_lookup (table, "LVM2_LV_UUID")) {
+            data = get_lv_data_from_table (table, TRUE);
+            if (data)
+                g_ptr_array_add (lvs, data);
+        } else
+            g_hash_table_destroy (table);
+    }
+    g_strfreev (lines);
+
+    report = g_new0 (BDLVMFullReport, 1);
+    g_ptr_array_add (pvs, NULL);
+    report->pvs = (BDLVMPVdata **) g_ptr_array_free (pvs, FALSE);
+    g_ptr_array_add (vgs, NULL);
+    report->vgs = (BDLVMVGdata **) g_ptr_array_free (vgs, FALSE);
+    g_ptr_array_add (lvs, NULL);
+    report->lvs = (BDLVMLVdata **) g_ptr_array_free (lvs, FALSE);
+
+    return report;
+}
+
 /**
  * bd_lvm_vgcreate:
  * @name: name of the newly created VG
@@ -1461,6 +2106,20 @@ BDLVMVGdata* bd_lvm_vginfo (const gchar *vg_name, GError **error) {
     gchar **lines = NULL;
     gchar **lines_p = NULL;
     guint num_items;
+    BDLVMVGdata *vgdata = NULL;
+    guint64 cache_gen = 0;
+
+    g_mutex_lock (&lvm_cache_lock);
+    if (lvm_cache_enabled) {
+        vgdata = (BDLVMVGdata *) g_hash_table_lookup (vg_info_cache, vg_name);
+        if (vgdata) {
+            vgdata = bd_lvm_vgdata_copy (vgdata);
+            g_mutex_unlock (&lvm_cache_lock);
+            return vgdata;
+        }
+    }
+    cache_gen = lvm_cache_generation;
+    g_mutex_unlock (&lvm_cache_lock);
 
     success = call_lvm_and_capture_output (args, NULL, &output, error);
     if (!success)
@@ -1474,7 +2133,14 @@ BDLVMVGdata* bd_lvm_vginfo (const gchar *vg_name, GError **error) {
         table = parse_lvm_vars ((*lines_p), &num_items);
         if (table && (num_items == 10)) {
             g_strfreev (lines);
-            return get_vg_data_from_table (table, TRUE);
+            vgdata = get_vg_data_from_table (table, TRUE);
+            g_mutex_lock (&lvm_cache_lock);
+            /* only cache the result if no event invalidated the cache while
+               the query was running */
+            if (lvm_cache_enabled && (cache_gen == lvm_cache_generation))
+                g_hash_table_replace (vg_info_cache, g_strdup (vg_name), bd_lvm_vgdata_copy (vgdata));
+            g_mutex_unlock (&lvm_cache_lock);
+            return vgdata;
         } else
             if (table)
                 g_hash_table_destroy (table);
@@ -1881,15 +2547,34 @@ BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError *
     gchar **lines = NULL;
     gchar **lines_p = NULL;
     guint num_items;
+    BDLVMLVdata *lvdata = NULL;
+    gchar *lvspec = NULL;
+    guint64 cache_gen = 0;
+
+    lvspec = g_strdup_printf ("%s/%s", vg_name, lv_name);
+
+    g_mutex_lock (&lvm_cache_lock);
+    if (lvm_cache_enabled) {
+        lvdata = (BDLVMLVdata *) g_hash_table_lookup (lv_info_cache, lvspec);
+        if (lvdata) {
+            lvdata = bd_lvm_lvdata_copy (lvdata);
+            g_mutex_unlock (&lvm_cache_lock);
+            g_free (lvspec);
+            return lvdata;
+        }
+    }
+    cache_gen = lvm_cache_generation;
+    g_mutex_unlock (&lvm_cache_lock);
 
-    args[9] = g_strdup_printf ("%s/%s", vg_name, lv_name);
+    args[9] = lvspec;
 
     success = call_lvm_and_capture_output (args, NULL, &output, error);
-    g_free ((gchar *) args[9]);
 
-    if (!success)
+    if (!success) {
         /* the error is already populated from the call */
+        g_free (lvspec);
         return NULL;
+    }
 
     lines = g_strsplit (output, "\n", 0);
     g_free (output);
@@ -1898,12 +2583,22 @@ BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError *
         table = parse_lvm_vars ((*lines_p), &num_items);
         if (table && (num_items == 16)) {
             g_strfreev (lines);
-            return get_lv_data_from_table (table, TRUE);
+            lvdata = get_lv_data_from_table (table, TRUE);
+            g_mutex_lock (&lvm_cache_lock);
+            /* only cache the result if no event invalidated the cache while
+               the query was running */
+            if (lvm_cache_enabled && (cache_gen == lvm_cache_generation))
+                g_hash_table_replace (lv_info_cache, lvspec, bd_lvm_lvdata_copy (lvdata));
+            else
+                g_free (lvspec);
+            g_mutex_unlock (&lvm_cache_lock);
+            return lvdata;
         } else
             if (table)
                 g_hash_table_destroy (table);
     }
     g_strfreev (lines);
+    g_free (lvspec);
 
     /* getting here means no usable info was found */
     g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -1986,6 +2681,131 @@ BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error) {
     return (BDLVMLVdata **) g_ptr_array_free (lvs, FALSE);
 }
 
+
+/* strip the brackets the reporting tools put around internal LV names */
+static gchar* lv_plain_name (const gchar *name) {
+    if (g_str_has_prefix (name, "[") && g_str_has_suffix (name, "]"))
+        return g_strndup (name + 1, strlen (name) - 2);
+    return g_strdup (name);
+}
+
+/* link the given LVs into parent/child trees, taking ownership of the
+   individual BDLVMLVdata items (but not of the array itself) */
+static BDLVMLVTreeNode** link_lv_tree (BDLVMLVdata **lvs) {
+    GHashTable *nodes_by_name = NULL;   /* "vg_name/lv_name" -> node */
+    BDLVMLVTreeNode **nodes = NULL;
+    BDLVMLVTreeNode *node = NULL;
+    GPtrArray *roots = NULL;
+    const gchar *parent_name = NULL;
+    const gchar *internal[2] = {NULL, NULL};
+    gchar *name = NULL;
+    gchar *key = NULL;
+    guint n_lvs = 0;
+    guint n_children = 0;
+    guint i = 0;
+    guint j = 0;
+
+    for (n_lvs=0; lvs[n_lvs]; n_lvs++);
+    nodes = g_new0 (BDLVMLVTreeNode*, n_lvs + 1);
+    nodes_by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    for (i=0; i < n_lvs; i++) {
+        nodes[i] = g_new0 (BDLVMLVTreeNode, 1);
+        nodes[i]->data = lvs[i];
+        name = lv_plain_name (lvs[i]->lv_name);
+        g_hash_table_replace (nodes_by_name,
+                              g_strdup_printf ("%s/%s", lvs[i]->vg_name, name),
+                              nodes[i]);
+        g_free (name);
+    }
+
+    /* thin and cached LVs hang under their pool, snapshots under their origin */
+    for (i=0; i < n_lvs; i++) {
+        parent_name = NULL;
+        if (nodes[i]->data->pool_lv && *(nodes[i]->data->pool_lv))
+            parent_name = nodes[i]->data->pool_lv;
+        else if (nodes[i]->data->origin && *(nodes[i]->data->origin))
+            parent_name = nodes[i]->data->origin;
+        if (parent_name) {
+            name = lv_plain_name (parent_name);
+            key = g_strdup_printf ("%s/%s", nodes[i]->data->vg_name, name);
+            nodes[i]->parent = g_hash_table_lookup (nodes_by_name, key);
+            g_free (key);
+            g_free (name);
+        }
+    }
+
+    /* internal data/metadata LVs hang under the pool referencing them */
+    for (i=0; i < n_lvs; i++) {
+        internal[0] = nodes[i]->data->data_lv;
+        internal[1] = nodes[i]->data->metadata_lv;
+        for (j=0; j < 2; j++) {
+            if (internal[j] && *(internal[j])) {
+                name = lv_plain_name (internal[j]);
+                key = g_strdup_printf ("%s/%s", nodes[i]->data->vg_name, name);
+                node = g_hash_table_lookup (nodes_by_name, key);
+                if (node && !node->parent && (node != nodes[i]))
+                    node->parent = nodes[i];
+                g_free (key);
+                g_free (name);
+            }
+        }
+    }
+
+    /* all the parents are known now, fill in the children arrays */
+    for (i=0; i < n_lvs; i++) {
+        n_children = 0;
+        for (j=0; j < n_lvs; j++)
+            if (nodes[j]->parent == nodes[i])
+                n_children++;
+        nodes[i]->children = g_new0 (BDLVMLVTreeNode*, n_children + 1);
+        n_children = 0;
+        for (j=0; j < n_lvs; j++)
+            if (nodes[j]->parent == nodes[i])
+                nodes[i]->children[n_children++] = nodes[j];
+    }
+
+    roots = g_ptr_array_new ();
+    for (i=0; i < n_lvs; i++)
+        if (!nodes[i]->parent)
+            g_ptr_array_add (roots, nodes[i]);
+    g_ptr_array_add (roots, NULL);
+
+    g_hash_table_destroy (nodes_by_name);
+    g_free (nodes);
+    return (BDLVMLVTreeNode **) g_ptr_array_free (roots, FALSE);
+}
+
+/**
+ * bd_lvm_lvs_tree:
+ * @vg_name: (allow-none): name of the VG to get the LV topology for or %NULL
+ *                         for all VGs
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): trees of the LVs
+ * (including the internal data and metadata LVs) found in the given @vg_name
+ * VG or in the system if @vg_name is %NULL, linked parent/child: thin and
+ * cached LVs hang under their pool, snapshots under their origin and the
+ * internal data/metadata LVs under the pool using them
+ *
+ * All the information is gathered in a single reporting call, so rendering a
+ * whole VG's topology doesn't need an extra query per LV.
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMLVTreeNode** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
+    BDLVMLVdata **lvs = NULL;
+    BDLVMLVTreeNode **roots = NULL;
+
+    lvs = bd_lvm_lvs (vg_name, error);
+    if (!lvs)
+        return NULL;
+
+    roots = link_lv_tree (lvs);
+    /* the nodes took over the individual items, only the array remains ours */
+    g_free (lvs);
+    return roots;
+}
+
 /**
  * bd_lvm_thpoolcreate:
  * @vg_name: name of the VG to create a thin pool in
@@ -2154,6 +2974,87 @@ gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error UNUSE
     return TRUE;
 }
 
+/**
+ * bd_lvm_set_shell_mode:
+ * @enabled: whether to run LVM commands in a persistent 'lvm shell' session
+ * @error: (out): place to store error (if any)
+ *
+ * When enabled, modification commands (pvcreate, lvcreate,...) are piped into
+ * a single long-lived 'lvm shell' process instead of spawning a new 'lvm'
+ * process (with its device scan) for every call. Reporting commands and calls
+ * with extra arguments keep spawning separate processes. If the session dies,
+ * the plugin automatically falls back to spawning.
+ *
+ * Returns: whether the requested mode was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_set_shell_mode (gboolean enabled, GError **error) {
+    gboolean ret = TRUE;
+
+    if (enabled && !check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    g_mutex_lock (&lvm_shell_lock);
+    if (enabled && lvm_shell_pid == 0)
+        ret = start_lvm_shell (error);
+    else if (!enabled)
+        stop_lvm_shell ();
+    g_atomic_int_set (&lvm_shell_mode, (enabled && ret) ? 1 : 0);
+    g_mutex_unlock (&lvm_shell_lock);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_set_query_cache:
+ * @enabled: whether to serve VG/LV queries from an in-memory cache or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables the in-memory cache for bd_lvm_vginfo() and
+ * bd_lvm_lvinfo(). With the cache enabled repeated queries are answered from
+ * memory without spawning the 'lvm' utility; cached entries are invalidated
+ * by udev events on block devices so out-of-band changes (e.g. another host
+ * or a manual 'lvchange') are picked up on the next query. The cache is
+ * disabled by default.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_set_query_cache (gboolean enabled, GError **error) {
+    g_mutex_lock (&lvm_cache_lock);
+    if (enabled == lvm_cache_enabled) {
+        g_mutex_unlock (&lvm_cache_lock);
+        return TRUE;
+    }
+    if (enabled) {
+        if (!start_udev_watch (error)) {
+            g_mutex_unlock (&lvm_cache_lock);
+            return FALSE;
+        }
+        vg_info_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                               (GDestroyNotify) bd_lvm_vgdata_free);
+        lv_info_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                               (GDestroyNotify) bd_lvm_lvdata_free);
+        lvm_cache_enabled = TRUE;
+        g_mutex_unlock (&lvm_cache_lock);
+    } else {
+        lvm_cache_enabled = FALSE;
+        lvm_cache_generation++;
+        g_hash_table_destroy (vg_info_cache);
+        g_hash_table_destroy (lv_info_cache);
+        vg_info_cache = NULL;
+        lv_info_cache = NULL;
+        /* join the watcher outside of the lock, it may just be blocked on it
+           in invalidate_lvm_cache() */
+        g_mutex_unlock (&lvm_cache_lock);
+        stop_udev_watch ();
+    }
+
+    return TRUE;
+}
+
 /**
  * bd_lvm_get_global_config:
  * @error: (out): place to store error (if any)
@@ -3325,6 +4226,23 @@ GHashTable* bd_lvm_vdo_get_stats_full (const gchar *vg_name, const gchar *pool_n
     return vdo_get_stats_full(kvdo_name, error);
 }
 
+static BDLVMVDOStats* vdo_stats_from_full (GHashTable *full_stats) {
+    BDLVMVDOStats *stats = g_new0 (BDLVMVDOStats, 1);
+
+    get_stat_val64_default (full_stats, "block_size", &stats->block_size, -1);
+    get_stat_val64_default (full_stats, "logical_block_size", &stats->logical_block_size, -1);
+    get_stat_val64_default (full_stats, "physical_blocks", &stats->physical_blocks, -1);
+    get_stat_val64_default (full_stats, "data_blocks_used", &stats->data_blocks_used, -1);
+    get_stat_val64_default (full_stats, "overhead_blocks_used", &stats->overhead_blocks_used, -1);
+    get_stat_val64_default (full_stats, "logical_blocks_used", &stats->logical_blocks_used, -1);
+    get_stat_val64_default (full_stats, "usedPercent", &stats->used_percent, -1);
+    get_stat_val64_default (full_stats, "savingPercent", &stats->saving_percent, -1);
+    if (!get_stat_val_double (full_stats, "writeAmplificationRatio", &stats->write_amplification_ratio))
+        stats->write_amplification_ratio = -1;
+
+    return stats;
+}
+
 /**
  * bd_lvm_vdo_get_stats:
  * @vg_name: name of the VG that contains @pool_name VDO pool
@@ -3347,19 +4265,46 @@ BDLVMVDOStats* bd_lvm_vdo_get_stats (const gchar *vg_name, const gchar *pool_nam
     if (!full_stats)
         return NULL;
 
-    stats = g_new0 (BDLVMVDOStats, 1);
-    get_stat_val64_default (full_stats, "block_size", &stats->block_size, -1);
-    get_stat_val64_default (full_stats, "logical_block_size", &stats->logical_block_size, -1);
-    get_stat_val64_default (full_stats, "physical_blocks", &stats->physical_blocks, -1);
-    get_stat_val64_default (full_stats, "data_blocks_used", &stats->data_blocks_used, -1);
-    get_stat_val64_default (full_stats, "overhead_blocks_used", &stats->overhead_blocks_used, -1);
-    get_stat_val64_default (full_stats, "logical_blocks_used", &stats->logical_blocks_used, -1);
-    get_stat_val64_default (full_stats, "usedPercent", &stats->used_percent, -1);
-    get_stat_val64_default (full_stats, "savingPercent", &stats->saving_percent, -1);
-    if (!get_stat_val_double (full_stats, "writeAmplificationRatio", &stats->write_amplification_ratio))
-        stats->write_amplification_ratio = -1;
+    stats = vdo_stats_from_full (full_stats);
 
     g_hash_table_destroy (full_stats);
 
     return stats;
 }
+
+/**
+ * bd_lvm_vdo_get_all_stats:
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: (transfer full) (element-type utf8 BDLVMVDOStats): selected
+ *          statistics for all VDO volumes present in the system keyed by the
+ *          kvdo device name (`<vg_name>-<pool_name>-vpool`) or %NULL in case
+ *          of error (@error gets populated in those cases)
+ *
+ * In contrast to calling bd_lvm_vdo_get_stats() per volume this function
+ * walks the `/sys/kvdo` tree only once no matter how many VDO volumes there
+ * are, so periodically sampling many volumes costs a single directory scan.
+ *
+ * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+GHashTable* bd_lvm_vdo_get_all_stats (GError **error) {
+    GHashTable *all_full = NULL;
+    GHashTable *ret = NULL;
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+
+    all_full = vdo_get_all_stats (error);
+    if (!all_full)
+        return NULL;
+
+    ret = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                 (GDestroyNotify) bd_lvm_vdo_stats_free);
+    g_hash_table_iter_init (&iter, all_full);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+        g_hash_table_replace (ret, g_strdup ((gchar *) key),
+                              vdo_stats_from_full ((GHashTable *) value));
+    g_hash_table_destroy (all_full);
+
+    return ret;
+}
@@ -148,6 +148,24 @@ typedef struct BDLVMLVdata {
 void bd_lvm_lvdata_free (BDLVMLVdata *data);
 BDLVMLVdata* bd_lvm_lvdata_copy (BDLVMLVdata *data);
 
+typedef struct BDLVMFullReport {
+    BDLVMPVdata **pvs;
+    BDLVMVGdata **vgs;
+    BDLVMLVdata **lvs;
+} BDLVMFullReport;
+
+void bd_lvm_fullreport_free (BDLVMFullReport *data);
+BDLVMFullReport* bd_lvm_fullreport_copy (BDLVMFullReport *data);
+
+typedef struct BDLVMLVTreeNode {
+    BDLVMLVdata *data;
+    struct BDLVMLVTreeNode *parent;
+    struct BDLVMLVTreeNode **children;
+} BDLVMLVTreeNode;
+
+void bd_lvm_lvtreenode_free (BDLVMLVTreeNode *data);
+BDLVMLVTreeNode* bd_lvm_lvtreenode_copy (BDLVMLVTreeNode *data);
+
 typedef struct BDLVMVDOPooldata {
     BDLVMVDOOperatingMode operating_mode;
     BDLVMVDOCompressionState compression_state;
@@ -245,11 +263,15 @@ gboolean bd_lvm_pvcreate (const gchar *device, guint64 data_alignment, guint64 m
 gboolean bd_lvm_pvresize (const gchar *device, guint64 size, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_pvremove (const gchar *device, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_pvmove_async (const gchar *src, const gchar *dest, const BDExtraArg **extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data, GError **error);
+gboolean bd_lvm_pvmove_finish (GAsyncResult *result, GError **error);
 gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_pvscan_many (const gchar **devices, gboolean update_cache, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_add_pv_tags (const gchar *device, const gchar **tags, GError **error);
 gboolean bd_lvm_delete_pv_tags (const gchar *device, const gchar **tags, GError **error);
 BDLVMPVdata* bd_lvm_pvinfo (const gchar *device, GError **error);
 BDLVMPVdata** bd_lvm_pvs (GError **error);
+BDLVMFullReport* bd_lvm_full_report (GError **error);
 
 gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_size, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError **error);
@@ -276,6 +298,7 @@ gboolean bd_lvm_add_lv_tags (const gchar *vg_name, const gchar *lv_name, const g
 gboolean bd_lvm_delete_lv_tags (const gchar *vg_name, const gchar *lv_name, const gchar **tags, GError **error);
 BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError **error);
 BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error);
+BDLVMLVTreeNode** bd_lvm_lvs_tree (const gchar *vg_name, GError **error);
 
 gboolean bd_lvm_thpoolcreate (const gchar *vg_name, const gchar *lv_name, guint64 size, guint64 md_size, guint64 chunk_size, const gchar *profile, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_thlvcreate (const gchar *vg_name, const gchar *pool_name, const gchar *lv_name, guint64 size, const BDExtraArg **extra, GError **error);
@@ -284,6 +307,8 @@ gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name
 
 gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error);
 gchar* bd_lvm_get_global_config (GError **error);
+gboolean bd_lvm_set_shell_mode (gboolean enabled, GError **error);
+gboolean bd_lvm_set_query_cache (gboolean enabled, GError **error);
 
 guint64 bd_lvm_cache_get_default_md_size (guint64 cache_size, GError **error);
 const gchar* bd_lvm_cache_get_mode_str (BDLVMCacheMode mode, GError **error);
@@ -325,5 +350,6 @@ BDLVMVDOWritePolicy bd_lvm_get_vdo_write_policy_from_str (const gchar *policy_st
 
 BDLVMVDOStats* bd_lvm_vdo_get_stats (const gchar *vg_name, const gchar *pool_name, GError **error);
 GHashTable* bd_lvm_vdo_get_stats_full (const gchar *vg_name, const gchar *pool_name, GError **error);
+GHashTable* bd_lvm_vdo_get_all_stats (GError **error);
 
 #endif /* BD_LVM */
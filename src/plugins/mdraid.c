@@ -21,6 +21,9 @@
 
 #include <glib.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <blockdev/utils.h>
 #include <string.h>
 #include <glob.h>
@@ -194,7 +197,9 @@ gboolean bd_md_check_deps (void) {
  *
  */
 gboolean bd_md_init (void) {
-    /* nothing to do here */
+    /* warm up the utility version checks in the background so the first real
+       call doesn't have to wait for them */
+    check_deps_async (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock);
     return TRUE;
 };
 
@@ -205,8 +210,10 @@ gboolean bd_md_init (void) {
  * library's functions that unload it.**
  *
  */
+static void md_sync_watch_shutdown (void);
+
 void bd_md_close (void) {
-    /* nothing to do here */
+    md_sync_watch_shutdown ();
 }
 
 #define UNUSED __attribute__((unused))
@@ -651,6 +658,78 @@ gboolean bd_md_create (const gchar *device_name, const gchar *level, const gchar
     return ret;
 }
 
+/* superblock zeroing of one member device run by the thread pool in
+   bd_md_create_prepared() */
+typedef struct MDPrepareTask {
+    const gchar *device;
+    gboolean success;
+    GError *error;
+} MDPrepareTask;
+
+static void md_prepare_task_func (gpointer task_data, gpointer user_data UNUSED) {
+    MDPrepareTask *task = (MDPrepareTask*) task_data;
+
+    task->success = bd_md_destroy (task->device, &task->error);
+}
+
+/**
+ * bd_md_create_prepared:
+ * @device_name: name of the device to create
+ * @level: RAID level (as understood by mdadm, see mdadm(8))
+ * @disks: (array zero-terminated=1): disks to use for the new RAID (including spares)
+ * @spares: number of spare devices
+ * @version: (allow-none): metadata version
+ * @bitmap: whether to create an internal bitmap on the device or not
+ * @chunk_size: chunk size of the device to create
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the creation (right now
+ *                                                 passed to the 'mdadm' utility)
+ * @error: (out): place to store error (if any)
+ *
+ * Same as bd_md_create(), but first zeroes the potential stale MD superblocks
+ * on all the @disks with a bounded number of 'mdadm --zero-superblock' calls
+ * running in parallel instead of requiring the caller to clean the members one
+ * by one. Disks with no MD superblock on them are fine and skipped (zeroing
+ * is best-effort -- a disk that really cannot be written to makes the
+ * following creation fail anyway).
+ *
+ * Returns: whether the new MD RAID device @device_name was successfully created or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_CREATE
+ */
+gboolean bd_md_create_prepared (const gchar *device_name, const gchar *level, const gchar **disks, guint64 spares, const gchar *version, gboolean bitmap, guint64 chunk_size, const BDExtraArg **extra, GError **error) {
+    GThreadPool *pool = NULL;
+    MDPrepareTask *tasks = NULL;
+    guint num_disks = 0;
+    guint i = 0;
+
+    if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    num_disks = g_strv_length ((gchar **) disks);
+
+    tasks = g_new0 (MDPrepareTask, num_disks);
+    for (i = 0; i < num_disks; i++)
+        tasks[i].device = disks[i];
+
+    pool = g_thread_pool_new (md_prepare_task_func, NULL, MIN (num_disks, 2 * g_get_num_processors ()), FALSE, NULL);
+    for (i = 0; i < num_disks; i++)
+        /* a failure here just means the task stays queued for the existing threads */
+        g_thread_pool_push (pool, tasks + i, NULL);
+    /* don't process the remaining queue (it's all pushed), wait for completion */
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i = 0; i < num_disks; i++) {
+        if (!tasks[i].success)
+            /* most likely just no (stale) superblock on the disk */
+            bd_utils_log_format (BD_UTILS_LOG_DEBUG, "bd_md_create_prepared(): failed to zero the superblock on '%s': %s",
+                                 tasks[i].device, tasks[i].error ? tasks[i].error->message : "unknown error");
+        g_clear_error (&(tasks[i].error));
+    }
+    g_free (tasks);
+
+    return bd_md_create (device_name, level, disks, spares, version, bitmap, chunk_size, extra, error);
+}
+
 /**
  * bd_md_destroy:
  * @device: device to destroy MD RAID metadata on
@@ -1101,6 +1180,86 @@ BDMDExamineData* bd_md_examine (const gchar *device, GError **error) {
     return ret;
 }
 
+/* a single bd_md_examine() call run by the thread pool in bd_md_examine_many() */
+typedef struct MDExamineTask {
+    const gchar *device;
+    BDMDExamineData *data;
+    GError *error;
+} MDExamineTask;
+
+static void md_examine_task_func (gpointer task_data, gpointer user_data UNUSED) {
+    MDExamineTask *task = (MDExamineTask*) task_data;
+
+    task->data = bd_md_examine (task->device, &task->error);
+}
+
+/**
+ * bd_md_examine_many:
+ * @devices: (array zero-terminated=1): names of the devices (members of MD RAIDs) to examine
+ * @error: (out): place to store error (if any)
+ *
+ * Examines all the @devices with a bounded number of 'mdadm' invocations
+ * running in parallel instead of processing the devices one by one which makes
+ * a big difference when examining many member devices (e.g. when assembling
+ * arrays at startup).
+ *
+ * Returns: (transfer full) (array zero-terminated=1): information about the MD
+ *          RAIDs extracted from the @devices (in the same order) or %NULL in
+ *          case of error
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+BDMDExamineData** bd_md_examine_many (const gchar **devices, GError **error) {
+    GThreadPool *pool = NULL;
+    MDExamineTask *tasks = NULL;
+    BDMDExamineData **ret = NULL;
+    guint n_devices = 0;
+    guint i = 0;
+    gboolean success = TRUE;
+
+    if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    n_devices = g_strv_length ((gchar **) devices);
+
+    tasks = g_new0 (MDExamineTask, n_devices);
+    for (i = 0; i < n_devices; i++)
+        tasks[i].device = devices[i];
+
+    pool = g_thread_pool_new (md_examine_task_func, NULL, MIN (n_devices, 2 * g_get_num_processors ()), FALSE, NULL);
+    for (i = 0; i < n_devices; i++)
+        /* a failure here just means the task stays queued for the existing threads */
+        g_thread_pool_push (pool, tasks + i, NULL);
+    /* don't process the remaining queue (it's all pushed), wait for completion */
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i = 0; i < n_devices; i++)
+        if (!tasks[i].data)
+            success = FALSE;
+
+    if (!success) {
+        for (i = 0; i < n_devices; i++) {
+            if (tasks[i].error) {
+                if (error && !(*error))
+                    g_propagate_prefixed_error (error, tasks[i].error, "Failed to examine the device '%s': ", tasks[i].device);
+                else
+                    g_clear_error (&(tasks[i].error));
+            }
+            if (tasks[i].data)
+                bd_md_examine_data_free (tasks[i].data);
+        }
+        g_free (tasks);
+        return NULL;
+    }
+
+    ret = g_new0 (BDMDExamineData*, n_devices + 1);
+    for (i = 0; i < n_devices; i++)
+        ret[i] = tasks[i].data;
+    g_free (tasks);
+
+    return ret;
+}
+
 /**
  * bd_md_detail:
  * @raid_spec: specification of the RAID device (name, node or path) to examine
@@ -1168,6 +1327,121 @@ BDMDDetailData* bd_md_detail (const gchar *raid_spec, GError **error) {
     return ret;
 }
 
+/* read (and strip) the contents of the @attr sysfs attribute of @node or NULL */
+static gchar* get_sysfs_attr (const gchar *node, const gchar *attr) {
+    gchar *path = NULL;
+    gchar *content = NULL;
+
+    path = g_strdup_printf ("/sys/class/block/%s/%s", node, attr);
+    if (!g_file_get_contents (path, &content, NULL, NULL)) {
+        g_free (path);
+        return NULL;
+    }
+    g_free (path);
+
+    return g_strstrip (content);
+}
+
+static guint64 get_sysfs_attr_num (const gchar *node, const gchar *attr) {
+    gchar *content = NULL;
+    guint64 ret = 0;
+
+    content = get_sysfs_attr (node, attr);
+    if (!content)
+        return 0;
+
+    ret = g_ascii_strtoull (content, NULL, 0);
+    g_free (content);
+
+    return ret;
+}
+
+/**
+ * bd_md_detail_from_sysfs:
+ * @raid_spec: specification of the RAID device (name, node or path) to examine
+ * @error: (out): place to store error (if any)
+ *
+ * Gets the same information about the running MD RAID @raid_spec as
+ * bd_md_detail() does, but reads it from the kernel's view of the array under
+ * /sys/block/mdX/md/ instead of spawning 'mdadm'. This makes it cheap
+ * enough for periodic health polling of many arrays. The array has to be
+ * running (its data is not published in sysfs otherwise).
+ *
+ * The creation time is not exported by the kernel and is always %NULL in the
+ * result; the UUID may be %NULL on older kernels that do not publish it.
+ *
+ * Returns: information about the MD RAID @raid_spec
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+BDMDDetailData* bd_md_detail_from_sysfs (const gchar *raid_spec, GError **error) {
+    BDMDDetailData *ret = NULL;
+    glob_t glob_buf;
+    gchar **path_p = NULL;
+    gchar *raid_node = NULL;
+    gchar *pattern = NULL;
+    gchar *value = NULL;
+    gchar *state = NULL;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return NULL;
+
+    value = get_sysfs_attr (raid_node, "md/level");
+    if (!value) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_NO_MATCH,
+                     "No data found in sysfs for the device '%s' (not a running MD RAID?)", raid_node);
+        g_free (raid_node);
+        return NULL;
+    }
+
+    ret = g_new0 (BDMDDetailData, 1);
+    ret->level = value;
+    ret->device = g_strdup_printf ("/dev/%s", raid_node);
+    ret->name = bd_md_name_from_node (raid_node, NULL);
+    ret->metadata = get_sysfs_attr (raid_node, "md/metadata_version");
+    ret->uuid = get_sysfs_attr (raid_node, "md/uuid");
+    /* the creation time is not exported by the kernel */
+    ret->creation_time = NULL;
+
+    /* the sizes are in KiB (just like in the 'mdadm --detail' output), the
+       whole-device size in sysfs is in 512 B sectors */
+    ret->array_size = get_sysfs_attr_num (raid_node, "size") / 2;
+    ret->use_dev_size = get_sysfs_attr_num (raid_node, "md/component_size");
+    ret->raid_devices = get_sysfs_attr_num (raid_node, "md/raid_disks");
+
+    state = get_sysfs_attr (raid_node, "md/array_state");
+    ret->clean = (g_strcmp0 (state, "clean") == 0);
+    g_free (state);
+
+    /* count the members by their state the same way mdadm does: active are the
+       in-sync ones, working are all the non-faulty ones */
+    pattern = g_strdup_printf ("/sys/class/block/%s/md/dev-*/state", raid_node);
+    if (glob (pattern, GLOB_NOSORT, NULL, &glob_buf) == 0) {
+        for (path_p = glob_buf.gl_pathv; *path_p; path_p++) {
+            if (!g_file_get_contents (*path_p, &state, NULL, NULL))
+                continue;
+            ret->total_devices++;
+            if (strstr (state, "faulty"))
+                ret->failed_devices++;
+            else {
+                ret->working_devices++;
+                if (strstr (state, "in_sync"))
+                    ret->active_devices++;
+                else if (strstr (state, "spare"))
+                    ret->spare_devices++;
+            }
+            g_free (state);
+        }
+        globfree (&glob_buf);
+    }
+    g_free (pattern);
+    g_free (raid_node);
+
+    return ret;
+}
+
 /**
  * bd_md_canonicalize_uuid:
  * @uuid: UUID to canonicalize
@@ -1186,7 +1460,7 @@ gchar* bd_md_canonicalize_uuid (const gchar *uuid, GError **error) {
     gchar *dest = ret;
     GRegex *regex = NULL;
 
-    regex = g_regex_new ("[0-9a-f]{8}:[0-9a-f]{8}:[0-9a-f]{8}:[0-9a-f]{8}", 0, 0, error);
+    regex = bd_utils_get_regex ("[0-9a-f]{8}:[0-9a-f]{8}:[0-9a-f]{8}:[0-9a-f]{8}", error);
     if (!regex) {
         /* error is already populated */
         g_free (ret);
@@ -1196,11 +1470,9 @@ gchar* bd_md_canonicalize_uuid (const gchar *uuid, GError **error) {
     if (!g_regex_match (regex, uuid, 0, NULL)) {
         g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_BAD_FORMAT,
                      "malformed or invalid UUID: %s", uuid);
-        g_regex_unref (regex);
         g_free (ret);
         return NULL;
     }
-    g_regex_unref (regex);
 
     /* first 8 symbols */
     memcpy (dest, next_set, 8);
@@ -1261,7 +1533,7 @@ gchar* bd_md_get_md_uuid (const gchar *uuid, GError **error) {
     gchar *dest = ret;
     GRegex *regex = NULL;
 
-    regex = g_regex_new ("[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}", 0, 0, error);
+    regex = bd_utils_get_regex ("[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}", error);
     if (!regex) {
         /* error is already populated */
         g_free (ret);
@@ -1271,11 +1543,9 @@ gchar* bd_md_get_md_uuid (const gchar *uuid, GError **error) {
     if (!g_regex_match (regex, uuid, 0, NULL)) {
         g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_BAD_FORMAT,
                      "malformed or invalid UUID: %s", uuid);
-        g_regex_unref (regex);
         g_free (ret);
         return NULL;
     }
-    g_regex_unref (regex);
 
     /* first 8 symbols */
     memcpy (dest, next_set, 8);
@@ -1541,3 +1811,328 @@ gboolean bd_md_request_sync_action (const gchar *raid_spec, const gchar *action,
 
     return TRUE;
 }
+
+/* one array watched by the sync-progress watch thread */
+typedef struct MDSyncWatch {
+    gchar *node;
+    gint action_fd;
+    gint completed_fd;
+    BDMDSyncCallback callback;
+    gpointer user_data;
+    guint64 progress_id;
+    gboolean in_progress;
+    gboolean removed;
+} MDSyncWatch;
+
+static GMutex md_sync_watch_lock;
+/* node name -> #MDSyncWatch (the key is owned by the value) */
+static GHashTable *md_sync_watches = NULL;
+/* watches removed by bd_md_unwatch_sync(), closed and freed by the watch
+   thread once it stops polling their files */
+static GSList *md_sync_watches_dead = NULL;
+static GThread *md_sync_watch_thread = NULL;
+static gint md_sync_watch_pipe[2] = {-1, -1};
+
+static void md_sync_watch_free (MDSyncWatch *watch) {
+    if (watch->in_progress)
+        bd_utils_report_finished (watch->progress_id, "Stopped watching");
+    close (watch->action_fd);
+    close (watch->completed_fd);
+    g_free (watch->node);
+    g_free (watch);
+}
+
+/* read the current sync state of the watched array (which also re-arms the
+   poll() on the sysfs files), report the progress and run the callback (runs
+   in the watch thread) */
+static void process_sync_watch (MDSyncWatch *watch) {
+    gchar action[64] = {0};
+    gchar completed[64] = {0};
+    gchar *msg = NULL;
+    gchar *pos = NULL;
+    guint64 sync_completed = 0;
+    guint64 sync_total = 0;
+
+    if (pread (watch->action_fd, action, sizeof (action) - 1, 0) < 0)
+        return;
+    if (pread (watch->completed_fd, completed, sizeof (completed) - 1, 0) < 0)
+        return;
+    g_strstrip (action);
+
+    /* "12345 / 67890" during a sync, "none" or "delayed" otherwise */
+    pos = strchr (completed, '/');
+    if (pos) {
+        sync_completed = g_ascii_strtoull (completed, NULL, 0);
+        sync_total = g_ascii_strtoull (pos + 1, NULL, 0);
+    }
+
+    if (!watch->in_progress && (g_strcmp0 (action, "idle") != 0)) {
+        msg = g_strdup_printf ("Started %s of '/dev/%s'", action, watch->node);
+        watch->progress_id = bd_utils_report_started (msg);
+        g_free (msg);
+        watch->in_progress = TRUE;
+    }
+    if (watch->in_progress && (sync_total > 0))
+        bd_utils_report_progress (watch->progress_id, MIN (100 * sync_completed / sync_total, 100), "Syncing");
+    if (watch->in_progress && (g_strcmp0 (action, "idle") == 0)) {
+        bd_utils_report_finished (watch->progress_id, "Completed");
+        watch->in_progress = FALSE;
+    }
+
+    if (watch->callback && !watch->removed)
+        watch->callback (watch->node, action, sync_completed, sync_total, watch->user_data);
+}
+
+static gpointer md_sync_watch_thread_func (gpointer data UNUSED) {
+    struct pollfd *fds = NULL;
+    MDSyncWatch **watches = NULL;
+    GHashTableIter iter;
+    gpointer value = NULL;
+    guint n_watches = 0;
+    guint i = 0;
+    gint status = 0;
+    gchar buf = ' ';
+    gboolean done = FALSE;
+
+    while (!done) {
+        /* (re)build the list of polled files */
+        g_mutex_lock (&md_sync_watch_lock);
+        /* nothing is polling the files of the removed watches anymore */
+        g_slist_free_full (md_sync_watches_dead, (GDestroyNotify) md_sync_watch_free);
+        md_sync_watches_dead = NULL;
+
+        n_watches = md_sync_watches ? g_hash_table_size (md_sync_watches) : 0;
+        fds = g_renew (struct pollfd, fds, 1 + 2 * n_watches);
+        watches = g_renew (MDSyncWatch*, watches, n_watches);
+        fds[0].fd = md_sync_watch_pipe[0];
+        fds[0].events = POLLIN;
+        i = 0;
+        if (md_sync_watches) {
+            g_hash_table_iter_init (&iter, md_sync_watches);
+            while (g_hash_table_iter_next (&iter, NULL, &value)) {
+                watches[i] = (MDSyncWatch*) value;
+                /* sysfs attributes signal changes with POLLPRI */
+                fds[1 + 2*i].fd = watches[i]->action_fd;
+                fds[1 + 2*i].events = POLLPRI;
+                fds[2 + 2*i].fd = watches[i]->completed_fd;
+                fds[2 + 2*i].events = POLLPRI;
+                i++;
+            }
+        }
+        g_mutex_unlock (&md_sync_watch_lock);
+
+        status = poll (fds, 1 + 2 * n_watches, -1);
+        if (status == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (fds[0].revents) {
+            while (read (md_sync_watch_pipe[0], &buf, 1) == -1 && errno == EINTR)
+                ;
+            if (buf == 'q')
+                done = TRUE;
+            /* otherwise just rebuild the list of polled files (the pending
+               sysfs events stay pending until the files are read) */
+            continue;
+        }
+
+        for (i = 0; i < n_watches; i++)
+            if (fds[1 + 2*i].revents || fds[2 + 2*i].revents)
+                process_sync_watch (watches[i]);
+    }
+
+    g_free (fds);
+    g_free (watches);
+    return NULL;
+}
+
+/* stop the sync watch thread (if running) and throw away all the watches */
+static void md_sync_watch_shutdown (void) {
+    GThread *thread = NULL;
+    GHashTableIter iter;
+    gpointer value = NULL;
+
+    g_mutex_lock (&md_sync_watch_lock);
+    thread = md_sync_watch_thread;
+    md_sync_watch_thread = NULL;
+    g_mutex_unlock (&md_sync_watch_lock);
+
+    if (!thread)
+        return;
+
+    while (write (md_sync_watch_pipe[1], "q", 1) == -1 && errno == EINTR)
+        ;
+    g_thread_join (thread);
+
+    g_mutex_lock (&md_sync_watch_lock);
+    close (md_sync_watch_pipe[0]);
+    close (md_sync_watch_pipe[1]);
+    md_sync_watch_pipe[0] = -1;
+    md_sync_watch_pipe[1] = -1;
+    g_slist_free_full (md_sync_watches_dead, (GDestroyNotify) md_sync_watch_free);
+    md_sync_watches_dead = NULL;
+    if (md_sync_watches) {
+        g_hash_table_iter_init (&iter, md_sync_watches);
+        while (g_hash_table_iter_next (&iter, NULL, &value))
+            md_sync_watch_free ((MDSyncWatch*) value);
+        g_hash_table_destroy (md_sync_watches);
+        md_sync_watches = NULL;
+    }
+    g_mutex_unlock (&md_sync_watch_lock);
+}
+
+/**
+ * bd_md_watch_sync:
+ * @raid_spec: specification of the RAID device (name, node or path) to watch
+ * @callback: (scope notified) (allow-none): function called on every change of
+ *            the sync state of the array (or %NULL to only feed the progress
+ *            reporting)
+ * @user_data: (closure): data passed to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Starts watching the sync (resync/recovery/check/repair) state of the
+ * @raid_spec RAID. A single background thread poll()s the array's sync_action
+ * and sync_completed sysfs files -- which the kernel signals on every change
+ * -- so the progress of rebuilds of many arrays can be tracked with no process
+ * spawns and no polling of bd_md_detail(). @callback is run from the watch
+ * thread; running syncs are also fed to the standard progress reporting (see
+ * bd_utils_init_prog_reporting()) as one task per sync operation.
+ *
+ * The watch lasts until bd_md_unwatch_sync() is called for the array or the
+ * plugin is unloaded. @callback must not call bd_md_watch_sync() or
+ * bd_md_unwatch_sync() itself.
+ *
+ * Returns: whether the watch was successfully started or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+gboolean bd_md_watch_sync (const gchar *raid_spec, BDMDSyncCallback callback, gpointer user_data, GError **error) {
+    MDSyncWatch *watch = NULL;
+    gchar *raid_node = NULL;
+    gchar *sys_path = NULL;
+    gchar buf[64] = {0};
+    gint action_fd = -1;
+    gint completed_fd = -1;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return FALSE;
+
+    sys_path = g_strdup_printf ("/sys/class/block/%s/md/sync_action", raid_node);
+    action_fd = open (sys_path, O_RDONLY|O_CLOEXEC);
+    g_free (sys_path);
+    sys_path = g_strdup_printf ("/sys/class/block/%s/md/sync_completed", raid_node);
+    completed_fd = open (sys_path, O_RDONLY|O_CLOEXEC);
+    g_free (sys_path);
+
+    /* the files have to be read once for the poll() to only report changes */
+    if ((action_fd < 0) || (completed_fd < 0) ||
+        (pread (action_fd, buf, sizeof (buf) - 1, 0) < 0) ||
+        (pread (completed_fd, buf, sizeof (buf) - 1, 0) < 0)) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_NO_MATCH,
+                     "No sync status found in sysfs for the device '%s' (not a running MD RAID?)", raid_node);
+        if (action_fd >= 0)
+            close (action_fd);
+        if (completed_fd >= 0)
+            close (completed_fd);
+        g_free (raid_node);
+        return FALSE;
+    }
+
+    g_mutex_lock (&md_sync_watch_lock);
+    if (md_sync_watches && g_hash_table_contains (md_sync_watches, raid_node)) {
+        g_mutex_unlock (&md_sync_watch_lock);
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "The device '%s' is already being watched", raid_node);
+        close (action_fd);
+        close (completed_fd);
+        g_free (raid_node);
+        return FALSE;
+    }
+
+    if (!md_sync_watch_thread) {
+        if (pipe (md_sync_watch_pipe) != 0) {
+            g_mutex_unlock (&md_sync_watch_lock);
+            g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_FAIL,
+                         "Failed to create a pipe for the sync watch thread");
+            close (action_fd);
+            close (completed_fd);
+            g_free (raid_node);
+            return FALSE;
+        }
+        md_sync_watch_thread = g_thread_try_new ("md-sync-watch", md_sync_watch_thread_func, NULL, error);
+        if (!md_sync_watch_thread) {
+            close (md_sync_watch_pipe[0]);
+            close (md_sync_watch_pipe[1]);
+            md_sync_watch_pipe[0] = -1;
+            md_sync_watch_pipe[1] = -1;
+            g_mutex_unlock (&md_sync_watch_lock);
+            close (action_fd);
+            close (completed_fd);
+            g_free (raid_node);
+            return FALSE;
+        }
+    } else
+        /* wake the thread up to pick the new watch up */
+        while (write (md_sync_watch_pipe[1], "r", 1) == -1 && errno == EINTR)
+            ;
+
+    if (!md_sync_watches)
+        md_sync_watches = g_hash_table_new (g_str_hash, g_str_equal);
+    watch = g_new0 (MDSyncWatch, 1);
+    watch->node = raid_node;
+    watch->action_fd = action_fd;
+    watch->completed_fd = completed_fd;
+    watch->callback = callback;
+    watch->user_data = user_data;
+    g_hash_table_replace (md_sync_watches, watch->node, watch);
+    g_mutex_unlock (&md_sync_watch_lock);
+
+    return TRUE;
+}
+
+/**
+ * bd_md_unwatch_sync:
+ * @raid_spec: specification of the RAID device (name, node or path) to stop watching
+ * @error: (out): place to store error (if any)
+ *
+ * Stops the watch on the sync state of the @raid_spec RAID started by
+ * bd_md_watch_sync(). No new runs of the callback happen after this function
+ * returns (a run already in flight may still finish).
+ *
+ * Returns: whether the watch was successfully removed or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+gboolean bd_md_unwatch_sync (const gchar *raid_spec, GError **error) {
+    MDSyncWatch *watch = NULL;
+    gchar *raid_node = NULL;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return FALSE;
+
+    g_mutex_lock (&md_sync_watch_lock);
+    watch = md_sync_watches ? g_hash_table_lookup (md_sync_watches, raid_node) : NULL;
+    if (!watch) {
+        g_mutex_unlock (&md_sync_watch_lock);
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_NO_MATCH,
+                     "The device '%s' is not being watched", raid_node);
+        g_free (raid_node);
+        return FALSE;
+    }
+    g_hash_table_steal (md_sync_watches, watch->node);
+    watch->removed = TRUE;
+    /* the watch thread may still be polling the files, let it do the closing */
+    md_sync_watches_dead = g_slist_prepend (md_sync_watches_dead, watch);
+    while (write (md_sync_watch_pipe[1], "r", 1) == -1 && errno == EINTR)
+        ;
+    g_mutex_unlock (&md_sync_watch_lock);
+    g_free (raid_node);
+
+    return TRUE;
+}
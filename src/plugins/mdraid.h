@@ -87,6 +87,7 @@ gboolean bd_md_is_tech_avail (BDMDTech tech, guint64 mode, GError **error);
 
 guint64 bd_md_get_superblock_size (guint64 member_size, const gchar *version, GError **error);
 gboolean bd_md_create (const gchar *device_name, const gchar *level, const gchar **disks, guint64 spares, const gchar *version, gboolean bitmap, guint64 chunk_size, const BDExtraArg **extra, GError **error);
+gboolean bd_md_create_prepared (const gchar *device_name, const gchar *level, const gchar **disks, guint64 spares, const gchar *version, gboolean bitmap, guint64 chunk_size, const BDExtraArg **extra, GError **error);
 gboolean bd_md_destroy (const gchar *device, GError **error);
 gboolean bd_md_deactivate (const gchar *raid_spec, GError **error);
 gboolean bd_md_activate (const gchar *raid_spec, const gchar **members, const gchar *uuid, gboolean start_degraded, const BDExtraArg **extra, GError **error);
@@ -96,7 +97,9 @@ gboolean bd_md_denominate (const gchar *device, GError **error);
 gboolean bd_md_add (const gchar *raid_spec, const gchar *device, guint64 raid_devs, const BDExtraArg **extra, GError **error);
 gboolean bd_md_remove (const gchar *raid_spec, const gchar *device, gboolean fail, const BDExtraArg **extra, GError **error);
 BDMDExamineData* bd_md_examine (const gchar *device, GError **error);
+BDMDExamineData** bd_md_examine_many (const gchar **devices, GError **error);
 BDMDDetailData* bd_md_detail (const gchar *raid_spec, GError **error);
+BDMDDetailData* bd_md_detail_from_sysfs (const gchar *raid_spec, GError **error);
 gchar* bd_md_canonicalize_uuid (const gchar *uuid, GError **error);
 gchar* bd_md_get_md_uuid (const gchar *uuid, GError **error);
 gchar* bd_md_node_from_name (const gchar *name, GError **error);
@@ -106,4 +109,21 @@ gboolean bd_md_set_bitmap_location (const gchar *raid_spec, const gchar *locatio
 gchar* bd_md_get_bitmap_location (const gchar *raid_spec, GError **error);
 gboolean bd_md_request_sync_action (const gchar *raid_spec, const gchar *action, GError **error);
 
+/**
+ * BDMDSyncCallback:
+ * @node: node name of the MD RAID (e.g. "md0") the change happened on
+ * @sync_action: the current sync action ("idle", "resync", "recover", "check",...)
+ * @sync_completed: number of sectors of the sync completed so far (0 if no sync
+ *                  is running)
+ * @sync_total: total number of sectors of the sync (0 if no sync is running)
+ * @user_data: data given to bd_md_watch_sync()
+ *
+ * Callback function run by the sync watch (see bd_md_watch_sync()) on every
+ * change of the sync state of a watched MD RAID.
+ */
+typedef void (*BDMDSyncCallback) (const gchar *node, const gchar *sync_action, guint64 sync_completed, guint64 sync_total, gpointer user_data);
+
+gboolean bd_md_watch_sync (const gchar *raid_spec, BDMDSyncCallback callback, gpointer user_data, GError **error);
+gboolean bd_md_unwatch_sync (const gchar *raid_spec, GError **error);
+
 #endif  /* BD_MD */
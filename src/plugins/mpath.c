@@ -342,64 +342,42 @@ static gchar** get_map_deps (const gchar *map_name, guint64 *n_deps, GError **er
     return dep_devs;
 }
 
-/**
- * bd_mpath_is_mpath_member:
- * @device: device to test
- * @error: (out): place to store error (if any)
- *
- * Returns: %TRUE if the device is a multipath member, %FALSE if not or an error
- * appeared when queried (@error is set in those cases)
- *
- * Tech category: %BD_MPATH_TECH_BASE-%BD_MPATH_TECH_MODE_QUERY
- */
-gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error) {
+static gchar** get_mpath_members (GError **error) {
     struct dm_task *task_names = NULL;
-	struct dm_names *names = NULL;
-    gchar *dev_path = NULL;
+    struct dm_names *names = NULL;
     guint64 next = 0;
     gchar **deps = NULL;
     gchar **dev_name = NULL;
-    gboolean ret = FALSE;
+    guint64 n_deps = 0;
+    guint64 n_devs = 0;
+    guint64 top_dev = 0;
+    gchar **ret = NULL;
 
     if (geteuid () != 0) {
         g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_NOT_ROOT,
                      "Not running as root, cannot query DM maps");
-        return FALSE;
+        return NULL;
     }
 
-    /* we check if the 'device' is a dependency of any multipath map  */
     /* get maps */
     task_names = dm_task_create(DM_DEVICE_LIST);
     if (!task_names) {
         bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create DM task");
         g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
                      "Failed to create DM task");
-        return FALSE;
+        return NULL;
     }
 
     dm_task_run(task_names);
     names = dm_task_get_names(task_names);
 
-    if (!names || !names->dev)
-        return FALSE;
-
-    /* in case the device is dev_path, we need to resolve it because maps's deps
-       are devices and not their dev_paths */
-    if (g_str_has_prefix (device, "/dev/mapper/") || g_str_has_prefix (device, "/dev/md/")) {
-        dev_path = bd_utils_resolve_device (device, error);
-        if (!dev_path) {
-            /* the device doesn't exist and thus is not an mpath member */
-            g_clear_error (error);
-            dm_task_destroy (task_names);
-            return FALSE;
-        }
-
-        /* the dev_path starts with "../" */
-        device = dev_path + 3;
+    if (!names || !names->dev) {
+        dm_task_destroy (task_names);
+        return NULL;
     }
 
-    if (g_str_has_prefix (device, "/dev/"))
-        device += 5;
+    ret = g_new0 (gchar*, 1);
+    n_devs = 1;
 
     /* check all maps */
     do {
@@ -408,26 +386,85 @@ gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error) {
 
         /* we are only interested in multipath maps */
         if (map_is_multipath (names->name, error)) {
-            deps = get_map_deps (names->name, NULL, error);
+            deps = get_map_deps (names->name, &n_deps, error);
             if (*error) {
                 g_prefix_error (error, "Failed to determine deps for '%s'", names->name);
-                g_free (dev_path);
                 dm_task_destroy (task_names);
-                return FALSE;
+                g_free (deps);
+                ret[top_dev] = NULL;
+                g_strfreev (ret);
+                return NULL;
+            }
+            if (deps) {
+                n_devs += n_deps;
+                ret = g_renew (gchar*, ret, n_devs);
+                for (dev_name=deps; *dev_name; dev_name++) {
+                    ret[top_dev] = *dev_name;
+                    top_dev += 1;
+                }
+                g_free (deps);
             }
-            for (dev_name = deps; !ret && *dev_name; dev_name++)
-                ret = (g_strcmp0 (*dev_name, device) == 0);
-            g_strfreev (deps);
         } else if (*error) {
             g_prefix_error (error, "Failed to determine map's target for '%s'", names->name);
-            g_free (dev_path);
             dm_task_destroy (task_names);
+            ret[top_dev] = NULL;
+            g_strfreev (ret);
+            return NULL;
+        }
+    } while (next);
+
+    ret[top_dev] = NULL;
+    dm_task_destroy (task_names);
+
+    return ret;
+}
+
+/**
+ * bd_mpath_is_mpath_member:
+ * @device: device to test
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: %TRUE if the device is a multipath member, %FALSE if not or an error
+ * appeared when queried (@error is set in those cases)
+ *
+ * Tech category: %BD_MPATH_TECH_BASE-%BD_MPATH_TECH_MODE_QUERY
+ */
+gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error) {
+    gchar *dev_path = NULL;
+    gchar **members = NULL;
+    gchar **member = NULL;
+    gboolean ret = FALSE;
+
+    /* in case the device is dev_path, we need to resolve it because maps's deps
+       are devices and not their dev_paths */
+    if (g_str_has_prefix (device, "/dev/mapper/") || g_str_has_prefix (device, "/dev/md/")) {
+        dev_path = bd_utils_resolve_device (device, error);
+        if (!dev_path) {
+            /* the device doesn't exist and thus is not an mpath member */
+            g_clear_error (error);
             return FALSE;
         }
-    } while (!ret && next);
 
+        /* the dev_path starts with "../" */
+        device = dev_path + 3;
+    }
+
+    if (g_str_has_prefix (device, "/dev/"))
+        device += 5;
+
+    /* get members of all the multipath maps in a single sweep and check if the
+       device is one of them */
+    members = get_mpath_members (error);
+    if (*error) {
+        g_free (dev_path);
+        return FALSE;
+    }
+
+    for (member = members; member && !ret && *member; member++)
+        ret = (g_strcmp0 (*member, device) == 0);
+
+    g_strfreev (members);
     g_free (dev_path);
-    dm_task_destroy (task_names);
     return ret;
 }
 
@@ -442,79 +479,18 @@ gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error) {
  * Tech category: %BD_MPATH_TECH_BASE-%BD_MPATH_TECH_MODE_QUERY
  */
 gchar** bd_mpath_get_mpath_members (GError **error) {
-    struct dm_task *task_names = NULL;
-	struct dm_names *names = NULL;
-    guint64 next = 0;
-    gchar **deps = NULL;
-    gchar **dev_name = NULL;
-    guint64 n_deps = 0;
-    guint64 n_devs = 0;
-    guint64 top_dev = 0;
     gchar **ret = NULL;
     guint64 progress_id = 0;
 
     progress_id = bd_utils_report_started ("Started getting mpath members");
 
-    if (geteuid () != 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_NOT_ROOT,
-                     "Not running as root, cannot query DM maps");
-        bd_utils_report_finished (progress_id, (*error)->message);
-        return NULL;
-    }
-
-    /* we check if the 'device' is a dependency of any multipath map  */
-    /* get maps */
-    task_names = dm_task_create(DM_DEVICE_LIST);
-	if (!task_names) {
-        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create DM task");
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to create DM task");
+    ret = get_mpath_members (error);
+    if (*error) {
         bd_utils_report_finished (progress_id, (*error)->message);
         return NULL;
     }
 
-    dm_task_run(task_names);
-	names = dm_task_get_names(task_names);
-
-    if (!names || !names->dev) {
-        bd_utils_report_finished (progress_id, "Completed");
-        return NULL;
-    }
-
-    ret = g_new0 (gchar*, 1);
-    n_devs = 1;
-
-    /* check all maps */
-    do {
-        names = (void *)names + next;
-        next = names->next;
-
-        /* we are only interested in multipath maps */
-        if (map_is_multipath (names->name, error)) {
-            deps = get_map_deps (names->name, &n_deps, error);
-            if (*error) {
-                g_prefix_error (error, "Failed to determine deps for '%s'", names->name);
-                dm_task_destroy (task_names);
-                bd_utils_report_finished (progress_id, (*error)->message);
-                g_free (deps);
-                g_free (ret);
-                return NULL;
-            }
-            if (deps) {
-                n_devs += n_deps;
-                ret = g_renew (gchar*, ret, n_devs);
-                for (dev_name=deps; *dev_name; dev_name++) {
-                    ret[top_dev] = *dev_name;
-                    top_dev += 1;
-                }
-                g_free (deps);
-            }
-        }
-    } while (next);
-
-    ret[top_dev] = NULL;
     bd_utils_report_finished (progress_id, "Completed");
-
     return ret;
 }
 
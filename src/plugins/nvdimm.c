@@ -18,7 +18,11 @@
  */
 
 #include <glib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
 #include <blockdev/utils.h>
+#include <libudev.h>
 #include <ndctl/libndctl.h>
 #include <uuid.h>
 #include <string.h>
@@ -83,6 +87,195 @@ static const UtilDep deps[DEPS_LAST] = {
     {"ndctl", NULL, NULL, NULL},
 };
 
+/* opt-in cache of the ndctl context (and with it the whole libndctl object
+   tree), invalidated by udev events on NVDIMM devices (see
+   bd_nvdimm_set_context_cache()) */
+static GMutex ndctl_ctx_lock;
+static gboolean ndctl_ctx_cache_enabled = FALSE;
+static struct ndctl_ctx *cached_ndctl_ctx = NULL;
+static GThread *udev_watch_thread = NULL;
+static struct udev *udev_context = NULL;
+static struct udev_monitor *udev_mon = NULL;
+static gint udev_watch_pipe[2] = {-1, -1};
+
+static void invalidate_ndctl_ctx (void) {
+    g_mutex_lock (&ndctl_ctx_lock);
+    if (cached_ndctl_ctx) {
+        ndctl_unref (cached_ndctl_ctx);
+        cached_ndctl_ctx = NULL;
+    }
+    g_mutex_unlock (&ndctl_ctx_lock);
+}
+
+static gpointer udev_watch_thread_func (gpointer data __attribute__((unused))) {
+    struct pollfd fds[2];
+    struct udev_device *device = NULL;
+
+    fds[0].fd = udev_watch_pipe[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = udev_monitor_get_fd (udev_mon);
+    fds[1].events = POLLIN;
+
+    while (TRUE) {
+        if (poll (fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[0].revents)
+            /* told to quit */
+            break;
+        if (fds[1].revents) {
+            device = udev_monitor_receive_device (udev_mon);
+            if (!device)
+                continue;
+            /* any event on an NVDIMM device means the cached object tree may
+               be stale */
+            invalidate_ndctl_ctx ();
+            udev_device_unref (device);
+        }
+    }
+    return NULL;
+}
+
+static void stop_udev_watch (void) {
+    while (udev_watch_thread && write (udev_watch_pipe[1], "q", 1) < 0 && errno == EINTR)
+        ;
+    if (udev_watch_thread) {
+        g_thread_join (udev_watch_thread);
+        udev_watch_thread = NULL;
+    }
+    if (udev_watch_pipe[0] >= 0) {
+        close (udev_watch_pipe[0]);
+        close (udev_watch_pipe[1]);
+        udev_watch_pipe[0] = -1;
+        udev_watch_pipe[1] = -1;
+    }
+    if (udev_mon) {
+        udev_monitor_unref (udev_mon);
+        udev_mon = NULL;
+    }
+    if (udev_context) {
+        udev_unref (udev_context);
+        udev_context = NULL;
+    }
+}
+
+static gboolean start_udev_watch (GError **error) {
+    udev_context = udev_new ();
+    if (!udev_context) {
+        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
+                     "Failed to create the udev context");
+        return FALSE;
+    }
+    udev_mon = udev_monitor_new_from_netlink (udev_context, "udev");
+    if (!udev_mon) {
+        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
+                     "Failed to create the udev monitor");
+        stop_udev_watch ();
+        return FALSE;
+    }
+    /* the 'nd' subsystem covers regions, namespaces, BTTs, etc., 'nvdimm' the
+       DIMM devices themselves */
+    udev_monitor_filter_add_match_subsystem_devtype (udev_mon, "nd", NULL);
+    udev_monitor_filter_add_match_subsystem_devtype (udev_mon, "nvdimm", NULL);
+    if (udev_monitor_enable_receiving (udev_mon) < 0) {
+        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
+                     "Failed to start receiving udev events");
+        stop_udev_watch ();
+        return FALSE;
+    }
+    if (pipe (udev_watch_pipe) != 0) {
+        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
+                     "Failed to create the udev watch control pipe: %m");
+        stop_udev_watch ();
+        return FALSE;
+    }
+    udev_watch_thread = g_thread_try_new ("nvdimm-udev-watch", udev_watch_thread_func, NULL, error);
+    if (!udev_watch_thread) {
+        stop_udev_watch ();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* get an ndctl context to use for a query -- a new reference to the cached
+   one (creating it if needed) or a freshly created one -- the caller is
+   responsible for dropping the reference with ndctl_unref() */
+static gboolean get_ndctl_ctx (struct ndctl_ctx **ctx, GError **error) {
+    gint ret = 0;
+
+    g_mutex_lock (&ndctl_ctx_lock);
+    if (ndctl_ctx_cache_enabled) {
+        if (!cached_ndctl_ctx) {
+            ret = ndctl_new (&cached_ndctl_ctx);
+            if (ret != 0) {
+                cached_ndctl_ctx = NULL;
+                g_mutex_unlock (&ndctl_ctx_lock);
+                g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
+                             "Failed to create ndctl context");
+                return FALSE;
+            }
+        }
+        *ctx = ndctl_ref (cached_ndctl_ctx);
+        g_mutex_unlock (&ndctl_ctx_lock);
+        return TRUE;
+    }
+    g_mutex_unlock (&ndctl_ctx_lock);
+
+    ret = ndctl_new (ctx);
+    if (ret != 0) {
+        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
+                     "Failed to create ndctl context");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * bd_nvdimm_set_context_cache:
+ * @enabled: whether to cache the ndctl context between queries or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables caching of the ndctl context (and with it the whole
+ * libndctl object tree). With the cache enabled, queries like
+ * bd_nvdimm_namespace_info() reuse a single context instead of rebuilding
+ * the object tree on every call; the cached context is dropped on udev
+ * events for NVDIMM devices so out-of-band changes are picked up by the
+ * next query. Disabled by default.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ *
+ * Tech category: %BD_NVDIMM_TECH_NAMESPACE-%BD_NVDIMM_TECH_MODE_QUERY
+ */
+gboolean bd_nvdimm_set_context_cache (gboolean enabled, GError **error) {
+    g_mutex_lock (&ndctl_ctx_lock);
+    if (enabled == ndctl_ctx_cache_enabled) {
+        g_mutex_unlock (&ndctl_ctx_lock);
+        return TRUE;
+    }
+    if (enabled) {
+        if (!start_udev_watch (error)) {
+            g_mutex_unlock (&ndctl_ctx_lock);
+            return FALSE;
+        }
+        ndctl_ctx_cache_enabled = TRUE;
+        g_mutex_unlock (&ndctl_ctx_lock);
+    } else {
+        ndctl_ctx_cache_enabled = FALSE;
+        if (cached_ndctl_ctx) {
+            ndctl_unref (cached_ndctl_ctx);
+            cached_ndctl_ctx = NULL;
+        }
+        /* join the watcher outside of the lock, it may just be blocked on it
+           in invalidate_ndctl_ctx() */
+        g_mutex_unlock (&ndctl_ctx_lock);
+        stop_udev_watch ();
+    }
+
+    return TRUE;
+}
+
 /**
  * bd_nvdimm_check_deps:
  *
@@ -134,8 +327,8 @@ gboolean bd_nvdimm_init (void) {
  *
  */
 void bd_nvdimm_close (void) {
-    /* nothing to do here */
-    return;
+    /* disable the context caching and drop the cached context (if any) */
+    bd_nvdimm_set_context_cache (FALSE, NULL);
 }
 
 #define UNUSED __attribute__((unused))
@@ -247,19 +440,14 @@ gchar* bd_nvdimm_namespace_get_devname (const gchar *device, GError **error) {
     struct ndctl_namespace *ndns = NULL;
     struct ndctl_region *region = NULL;
     struct ndctl_bus *bus = NULL;
-    gint success = 0;
     gchar *ret = NULL;
 
     /* get rid of the "/dev/" prefix (if any) */
     if (g_str_has_prefix (device, "/dev/"))
         device = device + 5;
 
-    success = ndctl_new (&ctx);
-    if (success != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
-        return FALSE;
-    }
+    if (!get_ndctl_ctx (&ctx, error))
+        return NULL;
 
     ndctl_bus_foreach (ctx, bus) {
         ndctl_region_foreach (bus, region) {
@@ -309,17 +497,14 @@ gboolean bd_nvdimm_namespace_enable (const gchar *namespace, const BDExtraArg **
     struct ndctl_namespace *ndns = NULL;
     gint ret = 0;
 
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    if (!get_ndctl_ctx (&ctx, error))
         return FALSE;
-    }
 
     ndns = get_namespace_by_name (namespace, ctx);
     if (!ndns) {
         g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_NOEXIST,
                      "Failed to enable namespace: namespace '%s' not found.", namespace);
+        ndctl_unref (ctx);
         return FALSE;
     }
 
@@ -350,17 +535,14 @@ gboolean bd_nvdimm_namespace_disable (const gchar *namespace, const BDExtraArg *
     struct ndctl_namespace *ndns = NULL;
     gint ret = 0;
 
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    if (!get_ndctl_ctx (&ctx, error))
         return FALSE;
-    }
 
     ndns = get_namespace_by_name (namespace, ctx);
     if (!ndns) {
         g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_NOEXIST,
                      "Failed to disable namespace: namespace '%s' not found.", namespace);
+        ndctl_unref (ctx);
         return FALSE;
     }
 
@@ -511,14 +693,9 @@ BDNVDIMMNamespaceInfo* bd_nvdimm_namespace_info (const gchar *namespace, const B
     struct ndctl_ctx *ctx = NULL;
     struct ndctl_namespace *ndns = NULL;
     BDNVDIMMNamespaceInfo *info = NULL;
-    gint ret = 0;
 
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    if (!get_ndctl_ctx (&ctx, error))
         return NULL;
-    }
 
     ndns = get_namespace_by_name (namespace, ctx);
     if (ndns) {
@@ -551,15 +728,12 @@ BDNVDIMMNamespaceInfo** bd_nvdimm_list_namespaces (const gchar *bus_name, const
     struct ndctl_namespace *ndns = NULL;
     struct ndctl_region *region = NULL;
     struct ndctl_bus *bus = NULL;
-    gint ret = 0;
     BDNVDIMMNamespaceInfo **info = NULL;
 
     GPtrArray *namespaces = g_ptr_array_new ();
 
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    if (!get_ndctl_ctx (&ctx, error)) {
+        g_ptr_array_free (namespaces, TRUE);
         return NULL;
     }
 
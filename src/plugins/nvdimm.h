@@ -64,6 +64,8 @@ void bd_nvdimm_close (void);
 
 gboolean bd_nvdimm_is_tech_avail (BDNVDIMMTech tech, guint64 mode, GError **error);
 
+gboolean bd_nvdimm_set_context_cache (gboolean enabled, GError **error);
+
 BDNVDIMMNamespaceMode bd_nvdimm_namespace_get_mode_from_str (const gchar *mode_str, GError **error);
 const gchar* bd_nvdimm_namespace_get_mode_str (BDNVDIMMNamespaceMode mode, GError **error);
 
@@ -23,10 +23,14 @@
 #include <math.h>
 #include <inttypes.h>
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <linux/fs.h>
+#include <libudev.h>
 #include <blockdev/utils.h>
 #include <libfdisk.h>
 #include <locale.h>
@@ -239,10 +243,252 @@ static int fdisk_ask_callback (struct fdisk_context *cxt UNUSED, struct fdisk_as
     return 0;
 }
 
+/* a cached open libfdisk context; @in_use means some thread currently works
+   with the context (other threads have to open their own one), @stale means
+   the on-disk table changed under the context's hands and it has to be closed
+   once its current user is done with it */
+typedef struct PartDeviceCacheEntry {
+    struct fdisk_context *cxt;
+    gboolean in_use;
+    gboolean stale;
+} PartDeviceCacheEntry;
+
+/* per-disk index of the free regions for the best-fit lookups, sorted by
+   (size, start); only maintained while the device cache is enabled */
+typedef struct FreeRegionIndex {
+    GSequence *regions; /* of #BDPartSpec */
+    gboolean has_logical; /* there's an extended partition on the disk */
+} FreeRegionIndex;
+
+static void free_region_index_free (gpointer data) {
+    FreeRegionIndex *index = data;
+
+    g_sequence_free (index->regions);
+    g_free (index);
+}
+
+static gint free_region_cmp (gconstpointer a, gconstpointer b, gpointer data UNUSED) {
+    const BDPartSpec *reg_a = a;
+    const BDPartSpec *reg_b = b;
+
+    if (reg_a->size != reg_b->size)
+        return (reg_a->size < reg_b->size) ? -1 : 1;
+    if (reg_a->start != reg_b->start)
+        return (reg_a->start < reg_b->start) ? -1 : 1;
+    return 0;
+}
+
+static GMutex part_device_cache_lock;
+static gboolean part_device_cache_enabled = FALSE;
+/* devno -> #PartDeviceCacheEntry */
+static GHashTable *part_device_cache = NULL;
+/* devno -> #FreeRegionIndex */
+static GHashTable *part_free_regions = NULL;
+static GThread *part_udev_watch_thread = NULL;
+static struct udev *part_udev_context = NULL;
+static struct udev_monitor *part_udev_mon = NULL;
+static int part_udev_watch_pipe[2] = {-1, -1};
+
+static guint64 part_device_devno (const gchar *device) {
+    struct stat st;
+
+    if (!device || stat (device, &st) != 0 || !S_ISBLK (st.st_mode))
+        return 0;
+
+    return (guint64) st.st_rdev;
+}
+
+static void do_close_context (struct fdisk_context *cxt) {
+    gint ret = 0;
+
+    ret = fdisk_deassign_device (cxt, 0); /* context, nosync */
+
+    if (ret != 0)
+        /* XXX: should report error here? */
+        g_warning ("Failed to close and sync the device: %s", strerror_l (-ret, c_locale));
+
+    fdisk_unref_context (cxt);
+}
+
+static void part_device_cache_entry_free (gpointer data) {
+    PartDeviceCacheEntry *entry = data;
+
+    do_close_context (entry->cxt);
+    g_free (entry);
+}
+
+static gpointer part_udev_watch_thread_func (gpointer data __attribute__((unused))) {
+    struct pollfd fds[2];
+    struct udev_device *dev = NULL;
+    PartDeviceCacheEntry *entry = NULL;
+    guint64 devno = 0;
+    gint status = 0;
+
+    fds[0].fd = part_udev_watch_pipe[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = udev_monitor_get_fd (part_udev_mon);
+    fds[1].events = POLLIN;
+
+    while (TRUE) {
+        status = poll (fds, 2, -1);
+        if (status == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[0].revents)
+            /* shutdown requested */
+            break;
+        if (fds[1].revents) {
+            dev = udev_monitor_receive_device (part_udev_mon);
+            if (dev) {
+                devno = (guint64) udev_device_get_devnum (dev);
+                g_mutex_lock (&part_device_cache_lock);
+                if (part_device_cache_enabled && (devno != 0)) {
+                    entry = g_hash_table_lookup (part_device_cache, &devno);
+                    if (entry) {
+                        if (entry->in_use)
+                            entry->stale = TRUE;
+                        else
+                            g_hash_table_remove (part_device_cache, &devno);
+                    }
+                    g_hash_table_remove (part_free_regions, &devno);
+                }
+                g_mutex_unlock (&part_device_cache_lock);
+                udev_device_unref (dev);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void stop_part_udev_watch (void) {
+    if (part_udev_watch_thread) {
+        while (write (part_udev_watch_pipe[1], "q", 1) == -1 && errno == EINTR)
+            ;
+        g_thread_join (part_udev_watch_thread);
+        part_udev_watch_thread = NULL;
+    }
+    if (part_udev_watch_pipe[0] != -1) {
+        close (part_udev_watch_pipe[0]);
+        close (part_udev_watch_pipe[1]);
+        part_udev_watch_pipe[0] = -1;
+        part_udev_watch_pipe[1] = -1;
+    }
+    if (part_udev_mon) {
+        udev_monitor_unref (part_udev_mon);
+        part_udev_mon = NULL;
+    }
+    if (part_udev_context) {
+        udev_unref (part_udev_context);
+        part_udev_context = NULL;
+    }
+}
+
+static gboolean start_part_udev_watch (GError **error) {
+    part_udev_context = udev_new ();
+    if (!part_udev_context) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to create a udev context");
+        return FALSE;
+    }
+
+    part_udev_mon = udev_monitor_new_from_netlink (part_udev_context, "udev");
+    if (!part_udev_mon) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to create a udev monitor");
+        stop_part_udev_watch ();
+        return FALSE;
+    }
+
+    if (udev_monitor_filter_add_match_subsystem_devtype (part_udev_mon, "block", NULL) < 0 ||
+        udev_monitor_enable_receiving (part_udev_mon) < 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to set up the udev monitor");
+        stop_part_udev_watch ();
+        return FALSE;
+    }
+
+    if (pipe (part_udev_watch_pipe) != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to create a pipe for the udev watch thread");
+        stop_part_udev_watch ();
+        return FALSE;
+    }
+
+    part_udev_watch_thread = g_thread_try_new ("part-udev-watch", part_udev_watch_thread_func, NULL, error);
+    if (!part_udev_watch_thread) {
+        stop_part_udev_watch ();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* an open partition-editing transaction pinning one libfdisk context so that
+   all the operations on the disk stage their changes on a single in-memory
+   table; @orig_table is the layout snapshot from the begin time used for the
+   single kernel rescan at commit time */
+typedef struct PartTxn {
+    struct fdisk_context *cxt;
+    struct fdisk_table *orig_table;
+    gboolean dirty;
+    gboolean force_reread;
+} PartTxn;
+
+static GMutex part_txn_lock;
+/* devno -> #PartTxn */
+static GHashTable *part_txn_table = NULL;
+
+/* get the open transaction owning @cxt (or the one for @devno if @cxt is NULL) */
+static PartTxn* get_txn (guint64 devno, struct fdisk_context *cxt) {
+    PartTxn *txn = NULL;
+
+    if (!part_txn_table || devno == 0)
+        return NULL;
+
+    txn = g_hash_table_lookup (part_txn_table, &devno);
+    if (txn && cxt && txn->cxt != cxt)
+        return NULL;
+
+    return txn;
+}
+
 static struct fdisk_context* get_device_context (const gchar *disk, GError **error) {
-    struct fdisk_context *cxt = fdisk_new_context ();
+    struct fdisk_context *cxt = NULL;
+    PartDeviceCacheEntry *entry = NULL;
+    PartTxn *txn = NULL;
+    guint64 devno = 0;
+    guint64 *key = NULL;
     gint ret = 0;
 
+    /* an open transaction pins the context for the disk, all operations have
+       to work on top of it to see the staged changes */
+    g_mutex_lock (&part_txn_lock);
+    txn = get_txn (part_device_devno (disk), NULL);
+    if (txn)
+        cxt = txn->cxt;
+    g_mutex_unlock (&part_txn_lock);
+    if (cxt)
+        return cxt;
+
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled) {
+        devno = part_device_devno (disk);
+        if (devno != 0) {
+            entry = g_hash_table_lookup (part_device_cache, &devno);
+            if (entry && !entry->in_use && !entry->stale) {
+                entry->in_use = TRUE;
+                cxt = entry->cxt;
+            }
+        }
+    }
+    g_mutex_unlock (&part_device_cache_lock);
+    if (cxt)
+        return cxt;
+
+    cxt = fdisk_new_context ();
     if (!cxt) {
         g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to create a new context");
@@ -259,25 +505,315 @@ static struct fdisk_context* get_device_context (const gchar *disk, GError **err
 
     fdisk_disable_dialogs(cxt, 1);
     fdisk_set_ask (cxt, fdisk_ask_callback, NULL);
+
+    /* track the context right away (as in use) so that the udev watch can mark
+       it stale if the on-disk table changes before it is returned to the cache */
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled && (devno != 0) &&
+        !g_hash_table_contains (part_device_cache, &devno)) {
+        key = g_new (guint64, 1);
+        *key = devno;
+        entry = g_new0 (PartDeviceCacheEntry, 1);
+        entry->cxt = cxt;
+        entry->in_use = TRUE;
+        g_hash_table_replace (part_device_cache, key, entry);
+    }
+    g_mutex_unlock (&part_device_cache_lock);
+
     return cxt;
 }
 
 static void close_context (struct fdisk_context *cxt) {
-    gint ret = 0;
+    PartDeviceCacheEntry *entry = NULL;
+    PartTxn *txn = NULL;
+    guint64 devno = 0;
+    gboolean cached = FALSE;
+
+    /* contexts pinned by an open transaction are closed by the transaction's
+       commit/abort, not by the individual operations */
+    g_mutex_lock (&part_txn_lock);
+    txn = get_txn (part_device_devno (fdisk_get_devname (cxt)), cxt);
+    g_mutex_unlock (&part_txn_lock);
+    if (txn)
+        return;
 
-    ret = fdisk_deassign_device (cxt, 0); /* context, nosync */
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled) {
+        devno = part_device_devno (fdisk_get_devname (cxt));
+        if (devno != 0) {
+            entry = g_hash_table_lookup (part_device_cache, &devno);
+            if (entry && entry->cxt == cxt) {
+                if (entry->stale)
+                    /* the on-disk table changed under our hands, close the context */
+                    g_hash_table_remove (part_device_cache, &devno);
+                else
+                    entry->in_use = FALSE;
+                cached = TRUE;
+            }
+        }
+    }
+    g_mutex_unlock (&part_device_cache_lock);
 
-    if (ret != 0)
-        /* XXX: should report error here? */
-        g_warning ("Failed to close and sync the device: %s", strerror_l (-ret, c_locale));
+    if (!cached)
+        do_close_context (cxt);
+}
 
-    fdisk_unref_context (cxt);
+/* close @cxt without handing it back to the device cache -- for contexts whose
+   in-memory table no longer matches what is (going to be) on the disk */
+static void discard_context (struct fdisk_context *cxt) {
+    PartDeviceCacheEntry *entry = NULL;
+    guint64 devno = 0;
+    gboolean cached = FALSE;
+
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled) {
+        devno = part_device_devno (fdisk_get_devname (cxt));
+        if (devno != 0) {
+            entry = g_hash_table_lookup (part_device_cache, &devno);
+            if (entry && entry->cxt == cxt) {
+                /* closes the context (including ours) */
+                g_hash_table_remove (part_device_cache, &devno);
+                cached = TRUE;
+            }
+        }
+    }
+    g_mutex_unlock (&part_device_cache_lock);
+
+    if (!cached)
+        do_close_context (cxt);
+}
+
+/* drop the cached free-region index for @disk (if any) */
+static void free_regions_invalidate (const gchar *disk) {
+    guint64 devno = 0;
+
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled) {
+        devno = part_device_devno (disk);
+        if (devno != 0)
+            g_hash_table_remove (part_free_regions, &devno);
+    }
+    g_mutex_unlock (&part_device_cache_lock);
+}
+
+/* index the free regions of @disk (a NULL-terminated list of specs owned by
+   the caller) for the future best-fit lookups */
+static void free_regions_store (const gchar *disk, BDPartSpec **free_regs) {
+    FreeRegionIndex *index = NULL;
+    BDPartSpec **free_reg_p = NULL;
+    guint64 devno = 0;
+    guint64 *key = NULL;
+
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled) {
+        devno = part_device_devno (disk);
+        if (devno != 0) {
+            index = g_new0 (FreeRegionIndex, 1);
+            index->regions = g_sequence_new ((GDestroyNotify) bd_part_spec_free);
+            for (free_reg_p = free_regs; *free_reg_p; free_reg_p++) {
+                g_sequence_insert_sorted (index->regions, bd_part_spec_copy (*free_reg_p), free_region_cmp, NULL);
+                if ((*free_reg_p)->type & BD_PART_TYPE_LOGICAL)
+                    index->has_logical = TRUE;
+            }
+            key = g_new (guint64, 1);
+            *key = devno;
+            g_hash_table_replace (part_free_regions, key, index);
+        }
+    }
+    g_mutex_unlock (&part_device_cache_lock);
+}
+
+/* do the best-fit lookup for bd_part_get_best_free_region() in the cached
+   index; @found tells whether there was an index for @disk to search in (a
+   %NULL return with @found set means no suitable region exists) */
+static BDPartSpec* free_regions_lookup (const gchar *disk, BDPartType type, guint64 size, gboolean *found) {
+    FreeRegionIndex *index = NULL;
+    BDPartSpec *ret = NULL;
+    BDPartSpec *reg = NULL;
+    BDPartSpec probe = {NULL, NULL, NULL, 0, G_MAXUINT64, size, 0};
+    GSequenceIter *iter = NULL;
+    guint64 devno = 0;
+
+    *found = FALSE;
+
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled) {
+        devno = part_device_devno (disk);
+        if (devno != 0)
+            index = g_hash_table_lookup (part_free_regions, &devno);
+    }
+    if (index) {
+        *found = TRUE;
+        if (type == BD_PART_TYPE_EXTENDED && index->has_logical)
+            /* there already is an extended partition on the disk */
+            ret = NULL;
+        else if (type == BD_PART_TYPE_EXTENDED) {
+            /* the biggest suitable region -- scan from the end */
+            iter = g_sequence_get_end_iter (index->regions);
+            while (!ret && !g_sequence_iter_is_begin (iter)) {
+                iter = g_sequence_iter_prev (iter);
+                reg = g_sequence_get (iter);
+                if (reg->size > size)
+                    ret = bd_part_spec_copy (reg);
+                else
+                    /* the regions before this one are even smaller */
+                    break;
+            }
+        } else {
+            /* the smallest suitable region -- a binary search for the first
+               region bigger than @size and a scan from there for the first one
+               of the right kind */
+            iter = g_sequence_search (index->regions, &probe, free_region_cmp, NULL);
+            while (!ret && !g_sequence_iter_is_end (iter)) {
+                reg = g_sequence_get (iter);
+                if ((type == BD_PART_TYPE_LOGICAL) == ((reg->type & BD_PART_TYPE_LOGICAL) != 0))
+                    ret = bd_part_spec_copy (reg);
+                iter = g_sequence_iter_next (iter);
+            }
+        }
+    }
+    g_mutex_unlock (&part_device_cache_lock);
+
+    return ret;
+}
+
+/* update the cached free-region index for @disk after a partition was created
+   at [@start, @start + @size) -- shrink or split the free region the new
+   partition was carved out of */
+static void free_regions_note_created (const gchar *disk, guint64 start, guint64 size) {
+    FreeRegionIndex *index = NULL;
+    BDPartSpec *reg = NULL;
+    BDPartSpec *part = NULL;
+    GSequenceIter *iter = NULL;
+    guint64 devno = 0;
+
+    g_mutex_lock (&part_device_cache_lock);
+    if (part_device_cache_enabled) {
+        devno = part_device_devno (disk);
+        if (devno != 0)
+            index = g_hash_table_lookup (part_free_regions, &devno);
+    }
+    if (index) {
+        iter = g_sequence_get_begin_iter (index->regions);
+        while (!reg && !g_sequence_iter_is_end (iter)) {
+            part = g_sequence_get (iter);
+            if ((part->start <= start) && (start < part->start + part->size))
+                reg = part;
+            else
+                iter = g_sequence_iter_next (iter);
+        }
+        if (reg && (start + size <= reg->start + reg->size)) {
+            /* the remainders of the region (both strictly smaller than @reg so
+               the insertions cannot shift @iter) */
+            if (start > reg->start) {
+                part = bd_part_spec_copy (reg);
+                part->size = start - reg->start;
+                g_sequence_insert_sorted (index->regions, part, free_region_cmp, NULL);
+            }
+            if (start + size < reg->start + reg->size) {
+                part = bd_part_spec_copy (reg);
+                part->start = start + size;
+                part->size = (reg->start + reg->size) - (start + size);
+                g_sequence_insert_sorted (index->regions, part, free_region_cmp, NULL);
+            }
+            g_sequence_remove (iter);
+        } else if (reg)
+            /* the new partition is not fully inside the region, the index
+               cannot be fixed up reliably */
+            g_hash_table_remove (part_free_regions, &devno);
+    }
+    g_mutex_unlock (&part_device_cache_lock);
+}
+
+/**
+ * bd_part_set_device_cache:
+ * @enabled: whether to keep open device handles between the partitioning
+ *           operations or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables the in-memory cache for open libfdisk device handles.
+ * Every partitioning operation normally opens the disk and reads and validates
+ * its whole partition table; with the cache enabled consecutive operations on
+ * one disk reuse a single open handle and thus a single in-memory copy of the
+ * table. Cached handles are dropped on udev events for the respective block
+ * devices so out-of-band changes are picked up by the next operation. The
+ * cache is disabled by default.
+ *
+ * With the cache enabled a per-disk index of the free regions is also
+ * maintained for the bd_part_get_best_free_region() lookups.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ *
+ * Tech category: always provided/supported
+ */
+gboolean bd_part_set_device_cache (gboolean enabled, GError **error) {
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+    PartDeviceCacheEntry *entry = NULL;
+
+    g_mutex_lock (&part_device_cache_lock);
+    if (enabled == part_device_cache_enabled) {
+        g_mutex_unlock (&part_device_cache_lock);
+        return TRUE;
+    }
+
+    if (enabled) {
+        if (!start_part_udev_watch (error)) {
+            g_mutex_unlock (&part_device_cache_lock);
+            return FALSE;
+        }
+        part_device_cache = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, part_device_cache_entry_free);
+        part_free_regions = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, free_region_index_free);
+        part_device_cache_enabled = TRUE;
+        g_mutex_unlock (&part_device_cache_lock);
+    } else {
+        part_device_cache_enabled = FALSE;
+        /* contexts currently in use are closed by their users (close_context()
+           sees the cache as disabled), the idle ones are closed here */
+        g_hash_table_iter_init (&iter, part_device_cache);
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+            entry = value;
+            if (entry->in_use) {
+                g_hash_table_iter_steal (&iter);
+                g_free (key);
+                g_free (entry);
+            } else
+                g_hash_table_iter_remove (&iter);
+        }
+        g_hash_table_destroy (part_device_cache);
+        part_device_cache = NULL;
+        g_hash_table_destroy (part_free_regions);
+        part_free_regions = NULL;
+        g_mutex_unlock (&part_device_cache_lock);
+
+        /* the watch thread may be blocked on the lock right now so the thread
+           can only be joined after releasing it */
+        stop_part_udev_watch ();
+    }
+
+    return TRUE;
 }
 
 static gboolean write_label (struct fdisk_context *cxt, struct fdisk_table *orig, const gchar *disk, gboolean force, GError **error) {
     gint ret = 0;
     gint dev_fd = 0;
     guint num_tries = 1;
+    PartTxn *txn = NULL;
+
+    /* within an open transaction the write is deferred until the commit */
+    g_mutex_lock (&part_txn_lock);
+    txn = get_txn (part_device_devno (disk), cxt);
+    if (txn) {
+        txn->dirty = TRUE;
+        /* without the layout snapshot from before this change a partial kernel
+           rescan is not possible at commit time */
+        if (force || !orig)
+            txn->force_reread = TRUE;
+        g_mutex_unlock (&part_txn_lock);
+        return TRUE;
+    }
+    g_mutex_unlock (&part_txn_lock);
 
     /* XXX: try to grab a lock for the device so that udev doesn't step in
        between the two operations we need to perform (see below) with its
@@ -334,6 +870,185 @@ static gboolean write_label (struct fdisk_context *cxt, struct fdisk_table *orig
     return TRUE;
 }
 
+/* remove the transaction for @devno from the table (without destroying it) */
+static PartTxn* steal_txn (guint64 devno) {
+    PartTxn *txn = NULL;
+
+    g_mutex_lock (&part_txn_lock);
+    txn = get_txn (devno, NULL);
+    if (txn)
+        g_hash_table_remove (part_txn_table, &devno);
+    g_mutex_unlock (&part_txn_lock);
+
+    return txn;
+}
+
+/**
+ * bd_part_edit_begin:
+ * @disk: path of the disk block device to open an edit transaction for
+ * @error: (out): place to store error (if any)
+ *
+ * Opens a partition-editing transaction for @disk. All the partitioning
+ * operations on @disk called afterwards (like bd_part_create_table(),
+ * bd_part_create_part() or bd_part_set_part_name()) only stage their changes
+ * on a single in-memory copy of the partition table instead of writing to the
+ * disk one by one; bd_part_edit_commit() then writes all the staged changes
+ * with a single write and a single kernel partition rescan. Until the commit
+ * the queries on @disk report the staged state and the partition device nodes
+ * of the staged partitions do not exist yet.
+ *
+ * Only one transaction per disk can be open at a time and the transaction is
+ * not thread-safe -- all the operations within it have to be called from one
+ * thread.
+ *
+ * Returns: whether the transaction was successfully opened or not
+ *
+ * Tech category: always provided/supported
+ */
+gboolean bd_part_edit_begin (const gchar *disk, GError **error) {
+    struct fdisk_context *cxt = NULL;
+    struct fdisk_table *table = NULL;
+    PartTxn *txn = NULL;
+    guint64 devno = 0;
+    guint64 *key = NULL;
+    gint status = 0;
+
+    devno = part_device_devno (disk);
+    if (devno == 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                     "Invalid or non-existing block device: '%s'", disk);
+        return FALSE;
+    }
+
+    g_mutex_lock (&part_txn_lock);
+    if (get_txn (devno, NULL)) {
+        g_mutex_unlock (&part_txn_lock);
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_EXISTS,
+                     "There already is an open edit transaction for the device '%s'", disk);
+        return FALSE;
+    }
+    g_mutex_unlock (&part_txn_lock);
+
+    cxt = get_device_context (disk, error);
+    if (!cxt)
+        /* error is already populated */
+        return FALSE;
+
+    /* snapshot of the current layout for the kernel rescan at commit time (on
+       a disk without a label there's nothing to snapshot and the commit does a
+       full rescan) */
+    status = fdisk_get_partitions (cxt, &table);
+    if (status != 0)
+        table = NULL;
+
+    g_mutex_lock (&part_txn_lock);
+    if (!part_txn_table)
+        part_txn_table = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
+    if (g_hash_table_contains (part_txn_table, &devno)) {
+        /* raced with another bd_part_edit_begin() call */
+        g_mutex_unlock (&part_txn_lock);
+        if (table)
+            fdisk_unref_table (table);
+        close_context (cxt);
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_EXISTS,
+                     "There already is an open edit transaction for the device '%s'", disk);
+        return FALSE;
+    }
+    txn = g_new0 (PartTxn, 1);
+    txn->cxt = cxt;
+    txn->orig_table = table;
+    key = g_new (guint64, 1);
+    *key = devno;
+    g_hash_table_replace (part_txn_table, key, txn);
+    g_mutex_unlock (&part_txn_lock);
+
+    return TRUE;
+}
+
+/**
+ * bd_part_edit_commit:
+ * @disk: path of the disk block device to commit the open edit transaction on
+ * @error: (out): place to store error (if any)
+ *
+ * Writes all the changes staged in the transaction opened by
+ * bd_part_edit_begin() to @disk with a single write of the partition table and
+ * a single kernel partition rescan and closes the transaction. If no changes
+ * were staged, only closes the transaction.
+ *
+ * Returns: whether the staged changes were successfully written to @disk or not
+ *
+ * Tech category: always provided/supported
+ */
+gboolean bd_part_edit_commit (const gchar *disk, GError **error) {
+    PartTxn *txn = NULL;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    gboolean success = TRUE;
+
+    msg = g_strdup_printf ("Started committing staged partition changes to '%s'", disk);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    txn = steal_txn (part_device_devno (disk));
+    if (!txn) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                     "No open edit transaction for the device '%s'", disk);
+        bd_utils_report_finished (progress_id, (*error)->message);
+        return FALSE;
+    }
+
+    if (txn->dirty)
+        success = write_label (txn->cxt, txn->orig_table, disk, txn->force_reread, error);
+
+    if (txn->orig_table)
+        fdisk_unref_table (txn->orig_table);
+    if (success)
+        close_context (txn->cxt);
+    else {
+        /* the in-memory table doesn't match the disk, don't reuse the context
+           and throw away the free-region index tracking the staged state */
+        discard_context (txn->cxt);
+        free_regions_invalidate (disk);
+    }
+    g_free (txn);
+
+    bd_utils_report_finished (progress_id, success ? "Completed" : (*error)->message);
+    return success;
+}
+
+/**
+ * bd_part_edit_abort:
+ * @disk: path of the disk block device to abort the open edit transaction on
+ * @error: (out): place to store error (if any)
+ *
+ * Closes the transaction opened by bd_part_edit_begin() throwing away all the
+ * staged changes without writing anything to @disk.
+ *
+ * Returns: whether the transaction was successfully aborted or not
+ *
+ * Tech category: always provided/supported
+ */
+gboolean bd_part_edit_abort (const gchar *disk, GError **error) {
+    PartTxn *txn = NULL;
+
+    txn = steal_txn (part_device_devno (disk));
+    if (!txn) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                     "No open edit transaction for the device '%s'", disk);
+        return FALSE;
+    }
+
+    if (txn->orig_table)
+        fdisk_unref_table (txn->orig_table);
+    /* the context carries the staged changes, it must not be reused and the
+       free-region index may be tracking the staged state */
+    discard_context (txn->cxt);
+    free_regions_invalidate (disk);
+    g_free (txn);
+
+    return TRUE;
+}
+
 /**
  * bd_part_check_deps:
  *
@@ -369,6 +1084,30 @@ gboolean bd_part_init (void) {
  *
  */
 void bd_part_close (void) {
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+    PartTxn *txn = NULL;
+
+    /* throw away the transactions left open */
+    g_mutex_lock (&part_txn_lock);
+    if (part_txn_table) {
+        g_hash_table_iter_init (&iter, part_txn_table);
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+            txn = value;
+            g_hash_table_iter_steal (&iter);
+            g_free (key);
+            if (txn->orig_table)
+                fdisk_unref_table (txn->orig_table);
+            do_close_context (txn->cxt);
+            g_free (txn);
+        }
+        g_hash_table_destroy (part_txn_table);
+        part_txn_table = NULL;
+    }
+    g_mutex_unlock (&part_txn_lock);
+
+    bd_part_set_device_cache (FALSE, NULL);
     c_locale = (locale_t) 0;
 }
 
@@ -451,6 +1190,7 @@ gboolean bd_part_create_table (const gchar *disk, BDPartTableType type, gboolean
     }
 
     close_context (cxt);
+    free_regions_invalidate (disk);
     bd_utils_report_finished (progress_id, "Completed");
     return TRUE;
 }
@@ -679,12 +1419,252 @@ static BDPartSpec* get_part_spec_fdisk (struct fdisk_context *cxt, struct fdisk_
     return ret;
 }
 
+/* minimal read-only GPT parser -- the read-only queries only need the GPT
+   header and the partition entry array (two small on-disk structures), reading
+   and CRC-checking those directly is much cheaper than setting up a full
+   libfdisk context */
+
+#define GPT_SIGNATURE 0x5452415020494645ULL /* "EFI PART" (little-endian) */
+
+typedef struct __attribute__ ((packed)) GPTHeader {
+    guint64 signature;
+    guint32 revision;
+    guint32 header_size;
+    guint32 header_crc32;
+    guint32 reserved;
+    guint64 my_lba;
+    guint64 alternate_lba;
+    guint64 first_usable_lba;
+    guint64 last_usable_lba;
+    guint8  disk_guid[16];
+    guint64 partition_entry_lba;
+    guint32 num_partition_entries;
+    guint32 partition_entry_size;
+    guint32 partition_entry_array_crc32;
+} GPTHeader;
+
+typedef struct __attribute__ ((packed)) GPTPartEntry {
+    guint8  type_guid[16];
+    guint8  unique_guid[16];
+    guint64 start_lba;
+    guint64 end_lba;
+    guint64 attributes;
+    guint16 name[36];
+} GPTPartEntry;
+
+static guint32 crc32_le (const guint8 *buf, gsize len) {
+    guint32 crc = 0xFFFFFFFF;
+    gsize i = 0;
+    gint j = 0;
+
+    for (i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (-(crc & 1)));
+    }
+
+    return ~crc;
+}
+
+/* GUIDs are stored with the first three fields little-endian */
+static gchar* gpt_format_guid (const guint8 *guid) {
+    return g_strdup_printf ("%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+                            guid[3], guid[2], guid[1], guid[0],
+                            guid[5], guid[4], guid[7], guid[6],
+                            guid[8], guid[9], guid[10], guid[11],
+                            guid[12], guid[13], guid[14], guid[15]);
+}
+
+/* read and CRC-check the GPT header and partition entry array of @disk;
+   returns the (raw) entry array or %NULL if @disk has no valid GPT; @pmbr_boot
+   (if not %NULL) also costs a read of the protective MBR */
+static guint8* gpt_read_table (const gchar *disk, GPTHeader *header, guint64 *sector_size, guint64 *disk_size, gboolean *pmbr_boot) {
+    gint fd = -1;
+    gint ssize = 0;
+    guint64 size = 0;
+    guint8 *sector = NULL;
+    guint8 *entries = NULL;
+    guint32 crc = 0;
+    guint32 entry_size = 0;
+    guint32 num_entries = 0;
+    gsize entries_len = 0;
+    PartTxn *txn = NULL;
+
+    /* during an open transaction the staged state has to be reported, not what
+       is currently on the disk */
+    g_mutex_lock (&part_txn_lock);
+    txn = get_txn (part_device_devno (disk), NULL);
+    g_mutex_unlock (&part_txn_lock);
+    if (txn)
+        return NULL;
+
+    fd = open (disk, O_RDONLY|O_CLOEXEC);
+    if (fd == -1)
+        return NULL;
+
+    if (ioctl (fd, BLKSSZGET, &ssize) != 0 || ssize < 512 ||
+        ioctl (fd, BLKGETSIZE64, &size) != 0) {
+        close (fd);
+        return NULL;
+    }
+
+    sector = g_malloc (ssize);
+
+    if (pmbr_boot) {
+        *pmbr_boot = FALSE;
+        if (pread (fd, sector, ssize, 0) != ssize) {
+            g_free (sector);
+            close (fd);
+            return NULL;
+        }
+        /* the four MBR partition records start at offset 446, the protective
+           ("0xEE") one carries the boot flag in its first byte */
+        for (guint n = 0; n < 4; n++)
+            if (sector[446 + n * 16 + 4] == 0xEE && sector[446 + n * 16] == 0x80)
+                *pmbr_boot = TRUE;
+    }
+
+    /* primary GPT header lives in the second sector */
+    if (pread (fd, sector, ssize, ssize) != ssize) {
+        g_free (sector);
+        close (fd);
+        return NULL;
+    }
+    memcpy (header, sector, sizeof (GPTHeader));
+    header->signature = GUINT64_FROM_LE (header->signature);
+    header->header_size = GUINT32_FROM_LE (header->header_size);
+    header->header_crc32 = GUINT32_FROM_LE (header->header_crc32);
+    header->first_usable_lba = GUINT64_FROM_LE (header->first_usable_lba);
+    header->last_usable_lba = GUINT64_FROM_LE (header->last_usable_lba);
+    header->partition_entry_lba = GUINT64_FROM_LE (header->partition_entry_lba);
+    header->num_partition_entries = GUINT32_FROM_LE (header->num_partition_entries);
+    header->partition_entry_size = GUINT32_FROM_LE (header->partition_entry_size);
+    header->partition_entry_array_crc32 = GUINT32_FROM_LE (header->partition_entry_array_crc32);
+
+    if (header->signature != GPT_SIGNATURE ||
+        header->header_size < 92 || header->header_size > (guint32) ssize) {
+        g_free (sector);
+        close (fd);
+        return NULL;
+    }
+
+    /* the header CRC is computed with the CRC field itself zeroed */
+    memset (sector + 16, 0, 4);
+    crc = crc32_le (sector, header->header_size);
+    g_free (sector);
+    if (crc != header->header_crc32) {
+        close (fd);
+        return NULL;
+    }
+
+    entry_size = header->partition_entry_size;
+    num_entries = header->num_partition_entries;
+    if (entry_size < sizeof (GPTPartEntry) || (entry_size % 8) != 0 ||
+        num_entries == 0 || ((guint64) entry_size * num_entries) > (4 MiB)) {
+        close (fd);
+        return NULL;
+    }
+
+    entries_len = (gsize) entry_size * num_entries;
+    entries = g_malloc (entries_len);
+    if (pread (fd, entries, entries_len, header->partition_entry_lba * ssize) != (gssize) entries_len ||
+        crc32_le (entries, entries_len) != header->partition_entry_array_crc32) {
+        g_free (entries);
+        close (fd);
+        return NULL;
+    }
+    close (fd);
+
+    if (sector_size)
+        *sector_size = (guint64) ssize;
+    if (disk_size)
+        *disk_size = size;
+
+    return entries;
+}
+
+/* build the spec of the (1-based) partition @part_num of the GPT disk @disk
+   with the minimal built-in parser; returns %NULL if that is not possible (the
+   caller falls back to libfdisk) */
+static BDPartSpec* gpt_get_part_spec_fast (const gchar *disk, gint part_num) {
+    GPTHeader header;
+    guint8 *entries = NULL;
+    GPTPartEntry entry;
+    guint64 sector_size = 0;
+    guint64 attrs = 0;
+    guint16 name_utf16[36];
+    glong name_len = 0;
+    gboolean empty = TRUE;
+    BDPartSpec *ret = NULL;
+    BDPartFlag bd_flag;
+
+    entries = gpt_read_table (disk, &header, &sector_size, NULL, NULL);
+    if (!entries)
+        return NULL;
+
+    if (part_num < 1 || (guint32) part_num > header.num_partition_entries) {
+        g_free (entries);
+        return NULL;
+    }
+
+    memcpy (&entry, entries + (gsize) (part_num - 1) * header.partition_entry_size, sizeof (GPTPartEntry));
+    g_free (entries);
+
+    for (guint n = 0; empty && n < 16; n++)
+        empty = entry.type_guid[n] == 0;
+    if (empty)
+        /* no such partition, let the libfdisk path report the error */
+        return NULL;
+
+    ret = g_new0 (BDPartSpec, 1);
+
+    if (isdigit (disk[strlen (disk) - 1]))
+        ret->path = g_strdup_printf ("%sp%d", disk, part_num);
+    else
+        ret->path = g_strdup_printf ("%s%d", disk, part_num);
+
+    ret->type = BD_PART_TYPE_NORMAL;
+    ret->start = GUINT64_FROM_LE (entry.start_lba) * sector_size;
+    ret->size = (GUINT64_FROM_LE (entry.end_lba) - GUINT64_FROM_LE (entry.start_lba) + 1) * sector_size;
+    ret->type_guid = gpt_format_guid (entry.type_guid);
+
+    for (name_len = 0; name_len < 36; name_len++) {
+        name_utf16[name_len] = GUINT16_FROM_LE (entry.name[name_len]);
+        if (name_utf16[name_len] == 0)
+            break;
+    }
+    ret->name = g_utf16_to_utf8 (name_utf16, name_len, NULL, NULL, NULL);
+    if (!ret->name)
+        ret->name = g_strdup ("");
+
+    attrs = GUINT64_FROM_LE (entry.attributes);
+    if (attrs & 1) /* 1 << 0 */
+        ret->flags |= BD_PART_FLAG_GPT_SYSTEM_PART;
+    if (attrs & 4) /* 1 << 2 */
+        ret->flags |= BD_PART_FLAG_LEGACY_BOOT;
+    if (attrs & 0x1000000000000000) /* 1 << 60 */
+        ret->flags |= BD_PART_FLAG_GPT_READ_ONLY;
+    if (attrs & 0x4000000000000000) /* 1 << 62 */
+        ret->flags |= BD_PART_FLAG_GPT_HIDDEN;
+    if (attrs & 0x8000000000000000) /* 1 << 63 */
+        ret->flags |= BD_PART_FLAG_GPT_NO_AUTOMOUNT;
+
+    bd_flag = get_flag_from_guid (ret->type_guid);
+    if (bd_flag != BD_PART_FLAG_BASIC_LAST)
+        ret->flags |= bd_flag;
+
+    return ret;
+}
+
 /**
  * bd_part_get_part_spec:
  * @disk: disk to remove the partition from
  * @part: partition to get spec for
  * @error: (out): place to store error (if any)
  *
+ * On GPT disks the information is read with a minimal built-in parser (two
+ * reads and CRC checks) instead of a full partition table parsing run.
+ *
  * Returns: (transfer full): spec of the @part partition from @disk or %NULL in case of error
  *
  * Tech category: %BD_PART_TECH_MODE_QUERY_PART + the tech according to the partition table type
@@ -700,6 +1680,11 @@ BDPartSpec* bd_part_get_part_spec (const gchar *disk, const gchar *part, GError
     if (part_num == -1)
         return NULL;
 
+    /* try the cheap built-in GPT parser first */
+    ret = gpt_get_part_spec_fast (disk, part_num);
+    if (ret)
+        return ret;
+
     /* first partition in fdisk is 0 */
     part_num--;
 
@@ -918,6 +1903,9 @@ static gboolean get_pmbr_boot_flag (struct fdisk_context *cxt) {
  * @disk: disk to get information about
  * @error: (out): place to store error (if any)
  *
+ * On GPT disks the information is read with a minimal built-in parser (two
+ * reads and CRC checks) instead of a full partition table parsing run.
+ *
  * Returns: (transfer full): information about the given @disk or %NULL (in case of error)
  *
  * Tech category: %BD_PART_TECH_MODE_QUERY_TABLE + the tech according to the partition table type
@@ -929,6 +1917,25 @@ BDPartDiskSpec* bd_part_get_disk_spec (const gchar *disk, GError **error) {
     const gchar *label_name = NULL;
     BDPartTableType type = BD_PART_TABLE_UNDEF;
     gboolean found = FALSE;
+    GPTHeader header;
+    guint8 *entries = NULL;
+    guint64 sector_size = 0;
+    guint64 disk_size = 0;
+    gboolean pmbr_boot = FALSE;
+
+    /* try the cheap built-in GPT parser first */
+    entries = gpt_read_table (disk, &header, &sector_size, &disk_size, &pmbr_boot);
+    if (entries) {
+        g_free (entries);
+        ret = g_new0 (BDPartDiskSpec, 1);
+        ret->path = g_strdup (disk);
+        ret->table_type = BD_PART_TABLE_GPT;
+        ret->sector_size = sector_size;
+        ret->size = disk_size;
+        if (pmbr_boot)
+            ret->flags = BD_PART_DISK_FLAG_GPT_PMBR_BOOT;
+        return ret;
+    }
 
     cxt = get_device_context (disk, error);
     if (!cxt) {
@@ -964,16 +1971,255 @@ BDPartDiskSpec* bd_part_get_disk_spec (const gchar *disk, GError **error) {
     return ret;
 }
 
+/* decode the \xXX escapes produced by udev's string encoding */
+static gchar* udev_decode_string (const gchar *str) {
+    GString *ret = g_string_new (NULL);
+    const gchar *p = NULL;
+
+    for (p = str; *p; ) {
+        if (p[0] == '\\' && p[1] == 'x' && g_ascii_isxdigit (p[2]) && g_ascii_isxdigit (p[3])) {
+            g_string_append_c (ret, (gchar) ((g_ascii_xdigit_value (p[2]) << 4) | g_ascii_xdigit_value (p[3])));
+            p += 4;
+        } else
+            g_string_append_c (ret, *p++);
+    }
+
+    return g_string_free (ret, FALSE);
+}
+
+/* the same ordering as get_disk_parts() produces */
+static gint part_spec_cmp_start (gconstpointer a, gconstpointer b) {
+    const BDPartSpec *spec_a = *(BDPartSpec * const *) a;
+    const BDPartSpec *spec_b = *(BDPartSpec * const *) b;
+
+    if (spec_a->start < spec_b->start)
+        return -1;
+    if (spec_a->start > spec_b->start)
+        return 1;
+    return 0;
+}
+
+/* build a partition spec from sysfs attributes and the udev database without
+   touching the disk; returns NULL if some required piece of information is
+   missing (the caller falls back to reading the partition table) */
+static BDPartSpec* get_part_spec_udev (struct udev_device *dev, gboolean on_gpt) {
+    BDPartSpec *ret = NULL;
+    const gchar *devname = NULL;
+    const gchar *start_str = NULL;
+    const gchar *size_str = NULL;
+    const gchar *partno_str = NULL;
+    const gchar *scheme = NULL;
+    const gchar *ptype = NULL;
+    const gchar *pflags = NULL;
+    const gchar *pname = NULL;
+    const gchar *entry_size = NULL;
+    guint64 attrs = 0;
+    guint part_id = 0;
+    guint partno = 0;
+    BDPartFlag bd_flag;
+
+    devname = udev_device_get_devnode (dev);
+    start_str = udev_device_get_sysattr_value (dev, "start");
+    size_str = udev_device_get_sysattr_value (dev, "size");
+    partno_str = udev_device_get_sysattr_value (dev, "partition");
+    scheme = udev_device_get_property_value (dev, "ID_PART_ENTRY_SCHEME");
+    ptype = udev_device_get_property_value (dev, "ID_PART_ENTRY_TYPE");
+    if (!devname || !start_str || !size_str || !partno_str || !scheme || !ptype)
+        return NULL;
+    if (g_strcmp0 (scheme, on_gpt ? "gpt" : "dos") != 0)
+        /* the udev database doesn't match the disk's current partition table */
+        return NULL;
+
+    pflags = udev_device_get_property_value (dev, "ID_PART_ENTRY_FLAGS");
+    partno = (guint) g_ascii_strtoull (partno_str, NULL, 0);
+
+    ret = g_new0 (BDPartSpec, 1);
+    ret->path = g_strdup (devname);
+    /* sysfs reports start and size in 512 byte units */
+    ret->start = g_ascii_strtoull (start_str, NULL, 0) * 512;
+    ret->size = g_ascii_strtoull (size_str, NULL, 0) * 512;
+
+    if (on_gpt) {
+        ret->type = BD_PART_TYPE_NORMAL;
+        ret->type_guid = g_ascii_strup (ptype, -1);
+
+        pname = udev_device_get_property_value (dev, "ID_PART_ENTRY_NAME");
+        if (pname && *pname != '\0')
+            ret->name = udev_decode_string (pname);
+
+        if (pflags) {
+            attrs = g_ascii_strtoull (pflags, NULL, 16);
+            if (attrs & 1) /* 1 << 0 */
+                ret->flags |= BD_PART_FLAG_GPT_SYSTEM_PART;
+            if (attrs & 4) /* 1 << 2 */
+                ret->flags |= BD_PART_FLAG_LEGACY_BOOT;
+            if (attrs & 0x1000000000000000) /* 1 << 60 */
+                ret->flags |= BD_PART_FLAG_GPT_READ_ONLY;
+            if (attrs & 0x4000000000000000) /* 1 << 62 */
+                ret->flags |= BD_PART_FLAG_GPT_HIDDEN;
+            if (attrs & 0x8000000000000000) /* 1 << 63 */
+                ret->flags |= BD_PART_FLAG_GPT_NO_AUTOMOUNT;
+        }
+
+        bd_flag = get_flag_from_guid (ret->type_guid);
+        if (bd_flag != BD_PART_FLAG_BASIC_LAST)
+            ret->flags |= bd_flag;
+    } else {
+        part_id = (guint) g_ascii_strtoull (ptype, NULL, 16);
+        if (part_id == 0x05 || part_id == 0x0f || part_id == 0x85) {
+            ret->type = BD_PART_TYPE_EXTENDED;
+            /* the kernel caps the sysfs size of DOS extended partitions at
+               two sectors (to keep the EBRs writable), take the real size
+               from the udev-probed table entry instead */
+            entry_size = udev_device_get_property_value (dev, "ID_PART_ENTRY_SIZE");
+            if (!entry_size) {
+                bd_part_spec_free (ret);
+                return NULL;
+            }
+            ret->size = g_ascii_strtoull (entry_size, NULL, 0) * 512;
+        } else if (partno > 4)
+            ret->type = BD_PART_TYPE_LOGICAL;
+        else
+            ret->type = BD_PART_TYPE_NORMAL;
+
+        if (pflags && (g_ascii_strtoull (pflags, NULL, 16) & 0x80))
+            ret->flags |= BD_PART_FLAG_BOOT;
+
+        if (ret->type == BD_PART_TYPE_NORMAL || ret->type == BD_PART_TYPE_LOGICAL) {
+            if (part_id & _PART_FLAG_HIDDEN)
+                ret->flags |= BD_PART_FLAG_HIDDEN;
+            if (part_id == _PART_FAT16_LBA || part_id == (_PART_FAT16_LBA | _PART_FLAG_HIDDEN) ||
+                part_id == _PART_FAT32_LBA || part_id == (_PART_FAT32_LBA | _PART_FLAG_HIDDEN))
+                ret->flags |= BD_PART_FLAG_LBA;
+
+            bd_flag = get_flag_from_id (part_id);
+            if (bd_flag != BD_PART_FLAG_BASIC_LAST)
+                ret->flags |= bd_flag;
+        }
+    }
+
+    return ret;
+}
+
+/* enumerate the partitions of @disk from sysfs and the udev database without
+   reading the partition table from the disk; returns NULL if the information
+   is not (fully) available there (the caller falls back to libfdisk) */
+static BDPartSpec** get_disk_parts_sysfs (const gchar *disk) {
+    struct udev *ctx = NULL;
+    struct udev_device *dev = NULL;
+    struct udev_device *part_dev = NULL;
+    struct udev_enumerate *enumerate = NULL;
+    struct udev_list_entry *entry = NULL;
+    const gchar *table_type = NULL;
+    const gchar *syspath = NULL;
+    BDPartSpec *spec = NULL;
+    GPtrArray *array = NULL;
+    PartTxn *txn = NULL;
+    gboolean on_gpt = FALSE;
+    guint64 devno = 0;
+
+    devno = part_device_devno (disk);
+    if (devno == 0)
+        return NULL;
+
+    /* during an open transaction the staged state has to be reported, not what
+       the kernel knows about the disk */
+    g_mutex_lock (&part_txn_lock);
+    txn = get_txn (devno, NULL);
+    g_mutex_unlock (&part_txn_lock);
+    if (txn)
+        return NULL;
+
+    ctx = udev_new ();
+    if (!ctx)
+        return NULL;
+
+    dev = udev_device_new_from_devnum (ctx, 'b', (dev_t) devno);
+    if (!dev || g_strcmp0 (udev_device_get_devtype (dev), "disk") != 0) {
+        if (dev)
+            udev_device_unref (dev);
+        udev_unref (ctx);
+        return NULL;
+    }
+
+    table_type = udev_device_get_property_value (dev, "ID_PART_TABLE_TYPE");
+    on_gpt = g_strcmp0 (table_type, "gpt") == 0;
+    if (!on_gpt && g_strcmp0 (table_type, "dos") != 0) {
+        /* no or unsupported table according to the udev database -- let the
+           slow path decide whether that's an error or an empty list */
+        udev_device_unref (dev);
+        udev_unref (ctx);
+        return NULL;
+    }
+
+    enumerate = udev_enumerate_new (ctx);
+    if (!enumerate) {
+        udev_device_unref (dev);
+        udev_unref (ctx);
+        return NULL;
+    }
+
+    udev_enumerate_add_match_parent (enumerate, dev);
+    udev_enumerate_add_match_subsystem (enumerate, "block");
+    udev_enumerate_scan_devices (enumerate);
+
+    array = g_ptr_array_new_with_free_func ((GDestroyNotify) (void *) bd_part_spec_free);
+
+    udev_list_entry_foreach (entry, udev_enumerate_get_list_entry (enumerate)) {
+        syspath = udev_list_entry_get_name (entry);
+        part_dev = udev_device_new_from_syspath (ctx, syspath);
+        if (!part_dev) {
+            g_ptr_array_free (array, TRUE);
+            array = NULL;
+            break;
+        }
+        if (!udev_device_get_sysattr_value (part_dev, "partition")) {
+            /* the disk itself */
+            udev_device_unref (part_dev);
+            continue;
+        }
+        spec = get_part_spec_udev (part_dev, on_gpt);
+        udev_device_unref (part_dev);
+        if (!spec) {
+            g_ptr_array_free (array, TRUE);
+            array = NULL;
+            break;
+        }
+        g_ptr_array_add (array, spec);
+    }
+
+    udev_enumerate_unref (enumerate);
+    udev_device_unref (dev);
+    udev_unref (ctx);
+
+    if (!array)
+        return NULL;
+
+    g_ptr_array_sort (array, part_spec_cmp_start);
+    g_ptr_array_add (array, NULL);
+    return (BDPartSpec **) g_ptr_array_free (array, FALSE);
+}
+
 /**
  * bd_part_get_disk_parts:
  * @disk: disk to get information about partitions for
  * @error: (out): place to store error (if any)
  *
+ * The partition specs are built from sysfs and the udev database if all the
+ * information is available there, without reading the partition table from
+ * @disk; otherwise the table is read and parsed as a fallback.
+ *
  * Returns: (transfer full) (array zero-terminated=1): specs of the partitions from @disk or %NULL in case of error
  *
  * Tech category: %BD_PART_TECH_MODE_QUERY_TABLE + the tech according to the partition table type
  */
 BDPartSpec** bd_part_get_disk_parts (const gchar *disk, GError **error) {
+    BDPartSpec **ret = NULL;
+
+    ret = get_disk_parts_sysfs (disk);
+    if (ret)
+        return ret;
+
     return get_disk_parts (disk, TRUE, FALSE, FALSE, error);
 }
 
@@ -1006,17 +2252,29 @@ BDPartSpec** bd_part_get_disk_free_regions (const gchar *disk, GError **error) {
  *       partition is found. For %BD_PART_TYPE_EXTENDED, the biggest possible space is found as long as there
  *       is no other extended partition (there can only be one).
  *
+ * Note: With the device cache enabled (see bd_part_set_device_cache()) the free
+ *       regions of @disk are indexed on the first call and the following
+ *       lookups are answered from the index (which is kept up to date as
+ *       partitions are created) without reading the disk.
+ *
  * Tech category: %BD_PART_TECH_MODE_QUERY_TABLE + the tech according to the partition table type
  */
 BDPartSpec* bd_part_get_best_free_region (const gchar *disk, BDPartType type, guint64 size, GError **error) {
     BDPartSpec **free_regs = NULL;
     BDPartSpec **free_reg_p = NULL;
     BDPartSpec *ret = NULL;
+    gboolean indexed = FALSE;
+
+    ret = free_regions_lookup (disk, type, size, &indexed);
+    if (indexed)
+        return ret;
 
     free_regs = bd_part_get_disk_free_regions (disk, error);
     if (!free_regs)
         /* error should be populated */
         return NULL;
+
+    free_regions_store (disk, free_regs);
     if (!(*free_regs)) {
         /* no free regions */
         g_free (free_regs);
@@ -1452,6 +2710,13 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
     ret = bd_part_get_part_spec (disk, ppath, error);
     g_free (ppath);
 
+    if (ret && !new_extended)
+        free_regions_note_created (disk, ret->start, ret->size);
+    else
+        /* a new extended partition changes the nature (primary vs. logical) of
+           the free space it covers, the index has to be rebuilt */
+        free_regions_invalidate (disk);
+
     bd_utils_report_finished (progress_id, "Completed");
 
     return ret;
@@ -1523,6 +2788,8 @@ gboolean bd_part_delete_part (const gchar *disk, const gchar *part, GError **err
     fdisk_unref_table (table);
     close_context (cxt);
 
+    free_regions_invalidate (disk);
+
     bd_utils_report_finished (progress_id, "Completed");
 
     return TRUE;
@@ -1796,6 +3063,8 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
     fdisk_unref_partition (pa); */
     close_context (cxt);
 
+    free_regions_invalidate (disk);
+
     bd_utils_report_finished (progress_id, "Completed");
 
     return TRUE;
@@ -135,6 +135,12 @@ void bd_part_close (void);
 
 gboolean bd_part_is_tech_avail (BDPartTech tech, guint64 mode, GError **error);
 
+gboolean bd_part_set_device_cache (gboolean enabled, GError **error);
+
+gboolean bd_part_edit_begin (const gchar *disk, GError **error);
+gboolean bd_part_edit_commit (const gchar *disk, GError **error);
+gboolean bd_part_edit_abort (const gchar *disk, GError **error);
+
 gboolean bd_part_create_table (const gchar *disk, BDPartTableType type, gboolean ignore_existing, GError **error);
 
 BDPartSpec* bd_part_get_part_spec (const gchar *disk, const gchar *part, GError **error);
@@ -141,6 +141,22 @@ gboolean bd_s390_is_tech_avail (BDS390Tech tech, guint64 mode, GError **error) {
     }
 }
 
+static gboolean extract_dasdfmt_progress (const gchar *line, guint8 *completion) {
+    const gchar *pos = NULL;
+    guint8 try_completion = 0;
+
+    /* with the '--percentage' option dasdfmt prints a line like
+       "cyl     123 of    3339 |  3%" for every formatted cylinder */
+    pos = strrchr (line, '|');
+    if (!pos)
+        return FALSE;
+    if (sscanf (pos + 1, "%hhu", &try_completion) == 1) {
+        *completion = try_completion;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 /**
  * bd_s390_dasd_format:
  * @dasd: dasd to format
@@ -150,22 +166,110 @@ gboolean bd_s390_is_tech_avail (BDS390Tech tech, guint64 mode, GError **error) {
  *
  * Returns: whether dasdfmt was successful or not
  *
+ * Progress of the formatting is reported ('dasdfmt' is run with the
+ * '--percentage' option and its output is parsed).
+ *
  * Tech category: %BD_S390_TECH_DASD-%BD_S390_TECH_MODE_MODIFY
  */
 gboolean bd_s390_dasd_format (const gchar *dasd, const BDExtraArg **extra, GError **error) {
     gboolean rc = FALSE;
-    const gchar *argv[8] = {"dasdfmt", "-y", "-d", "cdl", "-b", "4096", NULL, NULL};
+    gint status = 0;
+    const gchar *argv[9] = {"dasdfmt", "-y", "--percentage", "-d", "cdl", "-b", "4096", NULL, NULL};
 
     if (!check_deps (&avail_deps, DEPS_DASDFMT_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
-    argv[6] = g_strdup_printf ("/dev/%s", dasd);
+    argv[7] = g_strdup_printf ("/dev/%s", dasd);
 
-    rc = bd_utils_exec_and_report_error (argv, extra, error);
-    g_free ((gchar *) argv[6]);
+    rc = bd_utils_exec_and_report_progress (argv, extra, extract_dasdfmt_progress, &status, error);
+    g_free ((gchar *) argv[7]);
     return rc;
 }
 
+#define UNUSED __attribute__((unused))
+
+typedef struct DasdFormatTask {
+    const gchar *dasd;
+    const BDExtraArg **extra;
+    GError *error;
+} DasdFormatTask;
+
+static void dasd_format_task_func (gpointer task_data, gpointer user_data UNUSED) {
+    DasdFormatTask *task = task_data;
+
+    bd_s390_dasd_format (task->dasd, task->extra, &task->error);
+}
+
+/**
+ * bd_s390_dasd_format_many:
+ * @dasds: (array zero-terminated=1): dasds to format
+ * @extra: (allow-none) (array zero-terminated=1): extra options for the formatting (right now
+ *                                                 passed to the 'dasdfmt' utility)
+ * @error: (out): place to store error (if any)
+ *
+ * Returns: whether all the @dasds were successfully formatted or not
+ *
+ * The DASDs are formatted in parallel with a bounded number of concurrent
+ * 'dasdfmt' invocations, each reporting its own progress. If formatting of
+ * some of the DASDs fails, the remaining ones still run to completion and
+ * the first error is reported.
+ *
+ * Tech category: %BD_S390_TECH_DASD-%BD_S390_TECH_MODE_MODIFY
+ */
+gboolean bd_s390_dasd_format_many (const gchar **dasds, const BDExtraArg **extra, GError **error) {
+    guint64 n_dasds = 0;
+    guint64 i = 0;
+    DasdFormatTask *tasks = NULL;
+    GThreadPool *pool = NULL;
+    GError *first_error = NULL;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+
+    if (!check_deps (&avail_deps, DEPS_DASDFMT_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    for (n_dasds=0; dasds[n_dasds]; n_dasds++);
+
+    msg = g_strdup_printf ("Started formatting %"G_GUINT64_FORMAT" DASDs", n_dasds);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    if (n_dasds == 0) {
+        bd_utils_report_finished (progress_id, "Completed");
+        return TRUE;
+    }
+
+    tasks = g_new0 (DasdFormatTask, n_dasds);
+    pool = g_thread_pool_new (dasd_format_task_func, NULL, MIN (n_dasds, 2 * g_get_num_processors ()), FALSE, NULL);
+    for (i=0; i < n_dasds; i++) {
+        tasks[i].dasd = dasds[i];
+        tasks[i].extra = extra;
+        /* a failure here just means the task stays queued */
+        g_thread_pool_push (pool, tasks + i, NULL);
+    }
+    /* wait for all the tasks to finish */
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i=0; i < n_dasds; i++) {
+        if (tasks[i].error) {
+            if (!first_error)
+                first_error = tasks[i].error;
+            else
+                g_clear_error (&tasks[i].error);
+        }
+    }
+    g_free (tasks);
+
+    if (first_error) {
+        bd_utils_report_finished (progress_id, first_error->message);
+        g_propagate_error (error, first_error);
+        return FALSE;
+    }
+
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
+
 /**
  * bd_s390_dasd_needs_format:
  * @dasd: dasd to check, given as device number
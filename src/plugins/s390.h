@@ -37,6 +37,7 @@ void bd_s390_close (void);
 gboolean bd_s390_is_tech_avail (BDS390Tech tech, guint64 mode, GError **error);
 
 gboolean bd_s390_dasd_format (const gchar *dasd, const BDExtraArg **extra, GError **error);
+gboolean bd_s390_dasd_format_many (const gchar **dasds, const BDExtraArg **extra, GError **error);
 gboolean bd_s390_dasd_needs_format (const gchar *dasd, GError **error);
 gboolean bd_s390_dasd_online (const gchar *dasd, GError **error);
 gboolean bd_s390_dasd_is_ldl (const gchar *dasd, GError **error);
@@ -114,11 +114,85 @@ gboolean bd_swap_init (void) {
  *
  */
 void bd_swap_close (void) {
-    /* nothing to do here */
+    /* disable the swaps caching and drop the cached data (if any) */
+    bd_swap_set_swaps_cache (FALSE, NULL);
 }
 
 #define UNUSED __attribute__((unused))
 
+/* cache of the parsed /proc/swaps table (a set of the active swap device
+   paths) together with the raw content it was parsed from which serves as its
+   generation tag -- procfs files provide no usable modification time stamp */
+static GMutex swaps_cache_lock;
+static GHashTable *swaps_cache = NULL;
+static gchar *swaps_cache_content = NULL;
+static gboolean swaps_cache_enabled = FALSE;
+
+static void invalidate_swaps_cache (void) {
+    g_mutex_lock (&swaps_cache_lock);
+    if (swaps_cache) {
+        g_hash_table_destroy (swaps_cache);
+        swaps_cache = NULL;
+    }
+    g_free (swaps_cache_content);
+    swaps_cache_content = NULL;
+    g_mutex_unlock (&swaps_cache_lock);
+}
+
+static GHashTable* parse_swaps (const gchar *content) {
+    GHashTable *table = NULL;
+    gchar **lines = NULL;
+    gchar **line_p = NULL;
+    gsize dev_len = 0;
+
+    table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    lines = g_strsplit (content, "\n", 0);
+    /* the first line is just the header, the device path is the first field of
+       each of the following lines */
+    for (line_p = lines + 1; *line_p; line_p++) {
+        dev_len = strcspn (*line_p, " \t");
+        if (dev_len == 0)
+            continue;
+        g_hash_table_add (table, g_strndup (*line_p, dev_len));
+    }
+    g_strfreev (lines);
+
+    return table;
+}
+
+/**
+ * bd_swap_set_swaps_cache:
+ * @enabled: whether to serve bd_swap_swapstatus() queries from a parsed
+ *           /proc/swaps table cache or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables caching of the parsed /proc/swaps table for the
+ * bd_swap_swapstatus() queries. With the cache enabled the file is still read
+ * on every query (to detect out-of-band changes), but it is only parsed again
+ * when its content actually changed and the per-device status checks become
+ * hash table lookups. The cache is also refreshed when swap is activated or
+ * deactivated through this plugin. Disabled by default.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ *
+ * Tech category: always provided/supported
+ */
+gboolean bd_swap_set_swaps_cache (gboolean enabled, GError **error UNUSED) {
+    g_mutex_lock (&swaps_cache_lock);
+    swaps_cache_enabled = enabled;
+    if (!enabled) {
+        if (swaps_cache) {
+            g_hash_table_destroy (swaps_cache);
+            swaps_cache = NULL;
+        }
+        g_free (swaps_cache_content);
+        swaps_cache_content = NULL;
+    }
+    g_mutex_unlock (&swaps_cache_lock);
+
+    return TRUE;
+}
+
 /**
  * bd_swap_is_tech_avail:
  * @tech: the queried tech
@@ -354,7 +428,8 @@ gboolean bd_swap_swapon (const gchar *device, gint priority, GError **error) {
         g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_ACTIVATE,
                      "Failed to activate swap on %s: %m", device);
         bd_utils_report_finished (progress_id, (*error)->message);
-    }
+    } else
+        invalidate_swaps_cache ();
 
     bd_utils_report_finished (progress_id, "Completed");
     return ret == 0;
@@ -383,7 +458,8 @@ gboolean bd_swap_swapoff (const gchar *device, GError **error) {
         g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_ACTIVATE,
                      "Failed to deactivate swap on %s: %m", device);
         bd_utils_report_finished (progress_id, (*error)->message);
-    }
+    } else
+        invalidate_swaps_cache ();
 
     bd_utils_report_finished (progress_id, "Completed");
     return ret == 0;
@@ -405,6 +481,7 @@ gboolean bd_swap_swapstatus (const gchar *device, GError **error) {
     gsize length;
     gchar *next_line;
     gboolean success;
+    gboolean active = FALSE;
 
     success = g_file_get_contents ("/proc/swaps", &file_content, &length, error);
     if (!success) {
@@ -424,6 +501,25 @@ gboolean bd_swap_swapstatus (const gchar *device, GError **error) {
         }
     }
 
+    g_mutex_lock (&swaps_cache_lock);
+    if (swaps_cache_enabled) {
+        /* only (re)parse the table if its content changed since the last query */
+        if (g_strcmp0 (file_content, swaps_cache_content) != 0) {
+            if (swaps_cache)
+                g_hash_table_destroy (swaps_cache);
+            swaps_cache = parse_swaps (file_content);
+            g_free (swaps_cache_content);
+            swaps_cache_content = file_content;
+            file_content = NULL;
+        }
+        active = g_hash_table_contains (swaps_cache, real_device ? real_device : device);
+        g_mutex_unlock (&swaps_cache_lock);
+        g_free (real_device);
+        g_free (file_content);
+        return active;
+    }
+    g_mutex_unlock (&swaps_cache_lock);
+
     if (g_str_has_prefix (file_content, real_device ? real_device : device)) {
         g_free (real_device);
         g_free (file_content);
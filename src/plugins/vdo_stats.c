@@ -20,11 +20,17 @@
 #include <glib.h>
 #include <parted/parted.h>
 #include <blockdev/utils.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 
 #include "vdo_stats.h"
 
 #define VDO_SYS_PATH "/sys/kvdo"
 
+/* big enough for any single value exposed in the statistics tree */
+#define STAT_FILE_BUF_SIZE 256
+
 
 gboolean __attribute__ ((visibility ("hidden")))
 get_stat_val64 (GHashTable *stats, const gchar *key, gint64 *val) {
@@ -133,6 +139,32 @@ static void add_computed_stats (GHashTable *stats) {
     add_journal_stats (stats);
 }
 
+/* read a small sysfs statistics file into the caller-provided buffer with a
+   single read, avoiding a heap allocation per field */
+static gboolean read_stat_file (const gchar *path, gchar *buf, gsize buf_size, GError **error) {
+    gint fd = -1;
+    gssize n_read = -1;
+
+    fd = open (path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Failed to open '%s': %m", path);
+        return FALSE;
+    }
+    do {
+        n_read = read (fd, buf, buf_size - 1);
+    } while (n_read < 0 && errno == EINTR);
+    if (n_read < 0) {
+        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                     "Failed to read '%s': %m", path);
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+    buf[n_read] = '\0';
+    return TRUE;
+}
+
 GHashTable __attribute__ ((visibility ("hidden")))
 *vdo_get_stats_full (const gchar *name, GError **error) {
     GHashTable *stats;
@@ -140,7 +172,7 @@ GHashTable __attribute__ ((visibility ("hidden")))
     gchar *stats_dir;
     const gchar *direntry;
     gchar *s;
-    gchar *val = NULL;
+    gchar buf[STAT_FILE_BUF_SIZE];
 
     /* TODO: does the `name` need to be escaped? */
     stats_dir = g_build_path (G_DIR_SEPARATOR_S, VDO_SYS_PATH, name, "statistics", NULL);
@@ -154,15 +186,14 @@ GHashTable __attribute__ ((visibility ("hidden")))
     stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
     while ((direntry = g_dir_read_name (dir))) {
         s = g_build_filename (stats_dir, direntry, NULL);
-        if (! g_file_get_contents (s, &val, NULL, error)) {
+        if (! read_stat_file (s, buf, sizeof (buf), error)) {
             g_prefix_error (error, "Error reading statistics from %s: ", s);
             g_free (s);
             g_hash_table_destroy (stats);
             stats = NULL;
             break;
         }
-        g_hash_table_replace (stats, g_strdup (direntry), g_strdup (g_strstrip (val)));
-        g_free (val);
+        g_hash_table_replace (stats, g_strdup (direntry), g_strdup (g_strstrip (buf)));
         g_free (s);
     }
     g_dir_close (dir);
@@ -173,3 +204,42 @@ GHashTable __attribute__ ((visibility ("hidden")))
 
     return stats;
 }
+
+GHashTable __attribute__ ((visibility ("hidden")))
+*vdo_get_all_stats (GError **error) {
+    GHashTable *all_stats = NULL;
+    GHashTable *stats = NULL;
+    GDir *dir;
+    const gchar *direntry;
+    gchar *stats_dir = NULL;
+    gboolean is_volume = FALSE;
+
+    dir = g_dir_open (VDO_SYS_PATH, 0, error);
+    if (dir == NULL) {
+        g_prefix_error (error, "Error reading VDO volumes from %s: ", VDO_SYS_PATH);
+        return NULL;
+    }
+
+    all_stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       (GDestroyNotify) g_hash_table_destroy);
+    while ((direntry = g_dir_read_name (dir))) {
+        /* skip the module-level attributes, volumes are the subdirectories
+           with a 'statistics' directory in them */
+        stats_dir = g_build_path (G_DIR_SEPARATOR_S, VDO_SYS_PATH, direntry, "statistics", NULL);
+        is_volume = g_file_test (stats_dir, G_FILE_TEST_IS_DIR);
+        g_free (stats_dir);
+        if (!is_volume)
+            continue;
+
+        stats = vdo_get_stats_full (direntry, error);
+        if (stats == NULL) {
+            g_dir_close (dir);
+            g_hash_table_destroy (all_stats);
+            return NULL;
+        }
+        g_hash_table_replace (all_stats, g_strdup (direntry), stats);
+    }
+    g_dir_close (dir);
+
+    return all_stats;
+}
@@ -24,3 +24,4 @@ gboolean get_stat_val64 (GHashTable *stats, const gchar *key, gint64 *val);
 gboolean get_stat_val64_default (GHashTable *stats, const gchar *key, gint64 *val, gint64 def);
 
 GHashTable* vdo_get_stats_full (const gchar *name, GError **error);
+GHashTable* vdo_get_all_stats (GError **error);
@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2026  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Hand-written CPython fast paths for a few hot read-only libblockdev calls.
+ *
+ * The GObject-introspection bindings (gi.overrides.BlockDev) remain the
+ * canonical Python API; they cost tens of microseconds of marshalling per
+ * call, though, which dominates when query functions returning thousands of
+ * records (e.g. lvs over a big VG) are called in a loop. This module calls
+ * the C API directly and converts the results straight to plain Python
+ * objects (dicts, lists, bools) without any GObject boxing.
+ *
+ * The library and its plugins must already be initialized, typically through
+ * the GI bindings (BlockDev.ensure_init ()); this module does no
+ * initialization of its own. Errors are raised as _blockdevfast.BlockDevError
+ * with the GError message.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <blockdev/blockdev.h>
+#include <blockdev/lvm.h>
+#include <blockdev/part.h>
+#include <blockdev/fs.h>
+#include <blockdev/utils.h>
+
+static PyObject *BlockDevError = NULL;
+
+/* raise BlockDevError from @error (taking it over) or from a fallback message */
+static void set_error (GError *error, const gchar *fallback) {
+    PyErr_SetString (BlockDevError, error ? error->message : fallback);
+    g_clear_error (&error);
+}
+
+/* NULL-safe gchar* -> str|None conversion */
+static PyObject* str_or_none (const gchar *str) {
+    if (!str)
+        Py_RETURN_NONE;
+    return PyUnicode_FromString (str);
+}
+
+/* NULL-terminated gchar** -> list of str ([] for NULL) */
+static PyObject* strv_to_list (gchar **strv) {
+    PyObject *list = NULL;
+    PyObject *item = NULL;
+    gchar **str_p = NULL;
+
+    list = PyList_New (0);
+    if (!list)
+        return NULL;
+
+    for (str_p = strv; str_p && *str_p; str_p++) {
+        item = PyUnicode_FromString (*str_p);
+        if (!item || PyList_Append (list, item) != 0) {
+            Py_XDECREF (item);
+            Py_DECREF (list);
+            return NULL;
+        }
+        Py_DECREF (item);
+    }
+
+    return list;
+}
+
+/* helpers to populate a dict, keeping the per-field error handling short */
+static int dict_set_steal (PyObject *dict, const char *key, PyObject *value) {
+    int ret = -1;
+
+    if (!value)
+        return -1;
+    ret = PyDict_SetItemString (dict, key, value);
+    Py_DECREF (value);
+    return ret;
+}
+
+static int dict_set_str (PyObject *dict, const char *key, const gchar *value) {
+    return dict_set_steal (dict, key, str_or_none (value));
+}
+
+static int dict_set_uint64 (PyObject *dict, const char *key, guint64 value) {
+    return dict_set_steal (dict, key, PyLong_FromUnsignedLongLong (value));
+}
+
+static PyObject* lvdata_to_dict (BDLVMLVdata *data) {
+    PyObject *dict = NULL;
+
+    dict = PyDict_New ();
+    if (!dict)
+        return NULL;
+
+    if (dict_set_str (dict, "lv_name", data->lv_name) != 0 ||
+        dict_set_str (dict, "vg_name", data->vg_name) != 0 ||
+        dict_set_str (dict, "uuid", data->uuid) != 0 ||
+        dict_set_uint64 (dict, "size", data->size) != 0 ||
+        dict_set_str (dict, "attr", data->attr) != 0 ||
+        dict_set_str (dict, "segtype", data->segtype) != 0 ||
+        dict_set_str (dict, "origin", data->origin) != 0 ||
+        dict_set_str (dict, "pool_lv", data->pool_lv) != 0 ||
+        dict_set_str (dict, "data_lv", data->data_lv) != 0 ||
+        dict_set_str (dict, "metadata_lv", data->metadata_lv) != 0 ||
+        dict_set_str (dict, "roles", data->roles) != 0 ||
+        dict_set_str (dict, "move_pv", data->move_pv) != 0 ||
+        dict_set_uint64 (dict, "data_percent", data->data_percent) != 0 ||
+        dict_set_uint64 (dict, "metadata_percent", data->metadata_percent) != 0 ||
+        dict_set_uint64 (dict, "copy_percent", data->copy_percent) != 0 ||
+        dict_set_steal (dict, "lv_tags", strv_to_list (data->lv_tags)) != 0) {
+        Py_DECREF (dict);
+        return NULL;
+    }
+
+    return dict;
+}
+
+PyDoc_STRVAR (lvm_lvs_doc,
+"lvm_lvs(vg_name=None) -> list of dicts\n\n"
+"Information about LVs found in the given VG (or all VGs if vg_name is\n"
+"None), one dict per LV. Fast-path equivalent of BlockDev.lvm_lvs().");
+
+static PyObject* py_lvm_lvs (PyObject *self __attribute__((unused)), PyObject *args) {
+    const char *vg_name = NULL;
+    BDLVMLVdata **lvs = NULL;
+    BDLVMLVdata **lv_p = NULL;
+    PyObject *list = NULL;
+    PyObject *item = NULL;
+    GError *error = NULL;
+
+    if (!PyArg_ParseTuple (args, "|z:lvm_lvs", &vg_name))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    lvs = bd_lvm_lvs (vg_name, &error);
+    Py_END_ALLOW_THREADS
+    if (!lvs) {
+        if (error) {
+            set_error (error, NULL);
+            return NULL;
+        }
+        /* no LVs is a valid result */
+        return PyList_New (0);
+    }
+
+    list = PyList_New (0);
+    for (lv_p = lvs; list && *lv_p; lv_p++) {
+        item = lvdata_to_dict (*lv_p);
+        if (!item || PyList_Append (list, item) != 0) {
+            Py_XDECREF (item);
+            Py_CLEAR (list);
+            break;
+        }
+        Py_DECREF (item);
+    }
+
+    for (lv_p = lvs; *lv_p; lv_p++)
+        bd_lvm_lvdata_free (*lv_p);
+    g_free (lvs);
+
+    return list;
+}
+
+PyDoc_STRVAR (fs_is_mountpoint_doc,
+"fs_is_mountpoint(path) -> bool\n\n"
+"Whether path is a mountpoint. Fast-path equivalent of\n"
+"BlockDev.fs_is_mountpoint().");
+
+static PyObject* py_fs_is_mountpoint (PyObject *self __attribute__((unused)), PyObject *args) {
+    const char *path = NULL;
+    gboolean ret = FALSE;
+    GError *error = NULL;
+
+    if (!PyArg_ParseTuple (args, "s:fs_is_mountpoint", &path))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    ret = bd_fs_is_mountpoint (path, &error);
+    Py_END_ALLOW_THREADS
+    if (!ret && error) {
+        set_error (error, NULL);
+        return NULL;
+    }
+
+    return PyBool_FromLong (ret);
+}
+
+static PyObject* part_spec_to_dict (BDPartSpec *spec) {
+    PyObject *dict = NULL;
+
+    dict = PyDict_New ();
+    if (!dict)
+        return NULL;
+
+    if (dict_set_str (dict, "path", spec->path) != 0 ||
+        dict_set_str (dict, "name", spec->name) != 0 ||
+        dict_set_str (dict, "type_guid", spec->type_guid) != 0 ||
+        dict_set_uint64 (dict, "type", spec->type) != 0 ||
+        dict_set_uint64 (dict, "start", spec->start) != 0 ||
+        dict_set_uint64 (dict, "size", spec->size) != 0 ||
+        dict_set_uint64 (dict, "flags", spec->flags) != 0) {
+        Py_DECREF (dict);
+        return NULL;
+    }
+
+    return dict;
+}
+
+PyDoc_STRVAR (part_get_disk_parts_doc,
+"part_get_disk_parts(disk) -> list of dicts\n\n"
+"Specs of all the partitions on the given disk, one dict per partition.\n"
+"Fast-path equivalent of BlockDev.part_get_disk_parts().");
+
+static PyObject* py_part_get_disk_parts (PyObject *self __attribute__((unused)), PyObject *args) {
+    const char *disk = NULL;
+    BDPartSpec **parts = NULL;
+    BDPartSpec **part_p = NULL;
+    PyObject *list = NULL;
+    PyObject *item = NULL;
+    GError *error = NULL;
+
+    if (!PyArg_ParseTuple (args, "s:part_get_disk_parts", &disk))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    parts = bd_part_get_disk_parts (disk, &error);
+    Py_END_ALLOW_THREADS
+    if (!parts) {
+        if (error) {
+            set_error (error, NULL);
+            return NULL;
+        }
+        /* a disk with no partitions is a valid result */
+        return PyList_New (0);
+    }
+
+    list = PyList_New (0);
+    for (part_p = parts; list && *part_p; part_p++) {
+        item = part_spec_to_dict (*part_p);
+        if (!item || PyList_Append (list, item) != 0) {
+            Py_XDECREF (item);
+            Py_CLEAR (list);
+            break;
+        }
+        Py_DECREF (item);
+    }
+
+    for (part_p = parts; *part_p; part_p++)
+        bd_part_spec_free (*part_p);
+    g_free (parts);
+
+    return list;
+}
+
+PyDoc_STRVAR (utils_get_metrics_doc,
+"utils_get_metrics() -> dict\n\n"
+"Snapshot of the library's runtime metrics: 'spawns', 'child_cpu_usec' and\n"
+"'funcs' (a list of per-function dicts with 'plugin', 'func', 'calls',\n"
+"'total_usec' and 'max_usec'). Fast-path equivalent of\n"
+"BlockDev.utils_get_metrics().");
+
+static PyObject* py_utils_get_metrics (PyObject *self __attribute__((unused)), PyObject *args __attribute__((unused))) {
+    BDUtilsMetrics *metrics = NULL;
+    BDUtilsFuncMetrics **func_p = NULL;
+    PyObject *dict = NULL;
+    PyObject *funcs = NULL;
+    PyObject *item = NULL;
+
+    metrics = bd_utils_get_metrics ();
+    if (!metrics) {
+        set_error (NULL, "Failed to get the metrics");
+        return NULL;
+    }
+
+    dict = PyDict_New ();
+    if (!dict ||
+        dict_set_uint64 (dict, "spawns", metrics->spawns) != 0 ||
+        dict_set_uint64 (dict, "child_cpu_usec", metrics->child_cpu_usec) != 0) {
+        Py_XDECREF (dict);
+        bd_utils_metrics_free (metrics);
+        return NULL;
+    }
+
+    funcs = PyList_New (0);
+    for (func_p = metrics->funcs; funcs && *func_p; func_p++) {
+        item = PyDict_New ();
+        if (!item ||
+            dict_set_str (item, "plugin", (*func_p)->plugin) != 0 ||
+            dict_set_str (item, "func", (*func_p)->func) != 0 ||
+            dict_set_uint64 (item, "calls", (*func_p)->calls) != 0 ||
+            dict_set_uint64 (item, "total_usec", (*func_p)->total_usec) != 0 ||
+            dict_set_uint64 (item, "max_usec", (*func_p)->max_usec) != 0 ||
+            PyList_Append (funcs, item) != 0) {
+            Py_XDECREF (item);
+            Py_CLEAR (funcs);
+            break;
+        }
+        Py_DECREF (item);
+    }
+    bd_utils_metrics_free (metrics);
+
+    if (!funcs || dict_set_steal (dict, "funcs", funcs) != 0) {
+        Py_DECREF (dict);
+        return NULL;
+    }
+
+    return dict;
+}
+
+static PyMethodDef blockdevfast_methods[] = {
+    { "lvm_lvs", py_lvm_lvs, METH_VARARGS, lvm_lvs_doc },
+    { "fs_is_mountpoint", py_fs_is_mountpoint, METH_VARARGS, fs_is_mountpoint_doc },
+    { "part_get_disk_parts", py_part_get_disk_parts, METH_VARARGS, part_get_disk_parts_doc },
+    { "utils_get_metrics", py_utils_get_metrics, METH_NOARGS, utils_get_metrics_doc },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef blockdevfast_module = {
+    PyModuleDef_HEAD_INIT,
+    "_blockdevfast",
+    "Hand-written fast paths for hot read-only libblockdev query calls;\n"
+    "see gi.overrides.BlockDev for the full (introspection-based) API.",
+    -1,
+    blockdevfast_methods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit__blockdevfast (void) {
+    PyObject *module = NULL;
+
+    module = PyModule_Create (&blockdevfast_module);
+    if (!module)
+        return NULL;
+
+    BlockDevError = PyErr_NewException ("_blockdevfast.BlockDevError", NULL, NULL);
+    if (!BlockDevError || PyModule_AddObject (module, "BlockDevError", BlockDevError) != 0) {
+        Py_XDECREF (BlockDevError);
+        Py_DECREF (module);
+        return NULL;
+    }
+
+    return module;
+}
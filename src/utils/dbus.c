@@ -36,6 +36,76 @@ GQuark bd_utils_dbus_error_quark (void)
     return g_quark_from_static_string ("g-bd-utils-dbus-error-quark");
 }
 
+/* shared bus connections (system and session), created lazily and replaced
+   automatically when closed */
+static GDBusConnection *connections[2] = { NULL, NULL };
+
+G_LOCK_DEFINE_STATIC (connections);
+
+/**
+ * bd_utils_dbus_get_connection:
+ * @bus_type: bus type (system or session) to get the connection for
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns a shared connection to the given bus. The connection is established
+ * lazily on first use and then reused by all callers (connection setup plus
+ * the Hello handshake costs several milliseconds per connection, which adds
+ * up when every availability check opens its own). A connection that was
+ * closed in the meantime is transparently replaced by a new one.
+ *
+ * Returns: (transfer full): the shared connection for @bus_type or %NULL in
+ *          case of error
+ */
+GDBusConnection* bd_utils_dbus_get_connection (GBusType bus_type, GError **error) {
+    GDBusConnection *conn = NULL;
+    gchar *addr = NULL;
+    guint idx = 0;
+
+    if (bus_type == G_BUS_TYPE_SYSTEM)
+        idx = 0;
+    else if (bus_type == G_BUS_TYPE_SESSION)
+        idx = 1;
+    else {
+        g_set_error (error, BD_UTILS_DBUS_ERROR, BD_UTILS_DBUS_ERROR_FAIL,
+                     "Unsupported bus type");
+        return NULL;
+    }
+
+    G_LOCK (connections);
+    if (connections[idx] && g_dbus_connection_is_closed (connections[idx]))
+        /* stale connection, replace it below */
+        g_clear_object (&connections[idx]);
+
+    if (!connections[idx]) {
+        addr = g_dbus_address_get_for_bus_sync (bus_type, NULL, error);
+        if (!addr) {
+            G_UNLOCK (connections);
+            g_prefix_error (error, "Failed to get bus address: ");
+            return NULL;
+        }
+
+        conn = g_dbus_connection_new_for_address_sync (addr,
+                                                       G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT|
+                                                       G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                                       NULL, NULL, error);
+        g_free (addr);
+
+        if (!conn) {
+            G_UNLOCK (connections);
+            g_prefix_error (error, "Failed to create a new connection for the bus: ");
+            return NULL;
+        }
+
+        g_dbus_connection_set_exit_on_close (conn, FALSE);
+        connections[idx] = conn;
+    }
+
+    conn = g_object_ref (connections[idx]);
+    G_UNLOCK (connections);
+
+    return conn;
+}
+
 /**
  * bd_utils_dbus_service_available:
  * @connection: (allow-none): existing GDBusConnection or %NULL
@@ -57,7 +127,7 @@ gboolean bd_utils_dbus_service_available (GDBusConnection *connection, GBusType
     if (connection)
         bus = g_object_ref (connection);
     else {
-        bus = g_bus_get_sync (bus_type, NULL, error);
+        bus = bd_utils_dbus_get_connection (bus_type, error);
         if (!bus) {
             g_prefix_error (error, "Failed to get system bus: ");
             return FALSE;
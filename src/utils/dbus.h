@@ -11,6 +11,7 @@ typedef enum {
     BD_UTILS_DBUS_ERROR_NOEXIST,
 } BDUtilsDBusError;
 
+GDBusConnection* bd_utils_dbus_get_connection (GBusType bus_type, GError **error);
 gboolean bd_utils_dbus_service_available (GDBusConnection *connection, GBusType bus_type, const gchar *bus_name, const gchar *obj_prefix, GError **error);
 
 #endif  /* BD_UTILS_DBUS */
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2026  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <libudev.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "dev_events.h"
+
+/**
+ * SECTION: dev_events
+ * @short_description: library-level notifications about block device changes
+ * @title: DevEvents
+ * @include: dev_events.h
+ *
+ * A single shared listener for block device uevents. The first subscription
+ * starts one thread watching the udev netlink socket, every other subscriber
+ * (the plugins invalidating their caches, code waiting for a device to
+ * appear,...) just gets its callback hooked up to the same listener instead
+ * of each of them running its own monitor. The listener is stopped again when
+ * the last subscription is dropped, so a process that never subscribes pays
+ * nothing.
+ */
+
+/**
+ * bd_utils_dev_events_error_quark: (skip)
+ */
+GQuark bd_utils_dev_events_error_quark (void)
+{
+    return g_quark_from_static_string ("g-bd-utils-dev-events-error-quark");
+}
+
+typedef struct DeviceEventSubscription {
+    guint id;
+    BDUtilsDeviceEventFunc func;
+    gpointer user_data;
+} DeviceEventSubscription;
+
+/* resources owned by one run of the watch thread; handed over to the thread
+   when it is started so that stopping the watch can safely detach the global
+   state before joining the thread */
+typedef struct DeviceEventWatch {
+    struct udev *context;
+    struct udev_monitor *monitor;
+    gint shutdown_fd;
+} DeviceEventWatch;
+
+static GMutex dev_events_lock;
+static GSList *dev_events_subs = NULL;
+static guint dev_events_next_id = 1;
+static GThread *dev_events_thread = NULL;
+static DeviceEventWatch *dev_events_watch = NULL;
+static gint dev_events_shutdown_pipe[2] = {-1, -1};
+
+static BDUtilsDeviceAction map_uevent_action (const gchar *action) {
+    if (g_strcmp0 (action, "add") == 0)
+        return BD_UTILS_DEVICE_ADD;
+    if (g_strcmp0 (action, "remove") == 0)
+        return BD_UTILS_DEVICE_REMOVE;
+    /* "change", "move", "online", "offline",... */
+    return BD_UTILS_DEVICE_CHANGE;
+}
+
+static gpointer dev_events_thread_func (gpointer data) {
+    DeviceEventWatch *watch = data;
+    struct pollfd fds[2];
+    struct udev_device *dev = NULL;
+    BDUtilsDeviceAction action;
+    const gchar *devnode = NULL;
+    guint64 devno = 0;
+    GSList *item = NULL;
+    gint status = 0;
+
+    fds[0].fd = watch->shutdown_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = udev_monitor_get_fd (watch->monitor);
+    fds[1].events = POLLIN;
+
+    while (TRUE) {
+        status = poll (fds, 2, -1);
+        if (status == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[0].revents)
+            /* shutdown requested */
+            break;
+        if (fds[1].revents) {
+            dev = udev_monitor_receive_device (watch->monitor);
+            if (dev) {
+                action = map_uevent_action (udev_device_get_action (dev));
+                devnode = udev_device_get_devnode (dev);
+                devno = (guint64) udev_device_get_devnum (dev);
+
+                /* dispatch under the lock -- unsubscribing is thus guaranteed
+                   not to return while the callback is still running */
+                g_mutex_lock (&dev_events_lock);
+                for (item = dev_events_subs; item; item = item->next) {
+                    DeviceEventSubscription *sub = item->data;
+                    sub->func (devnode, action, devno, sub->user_data);
+                }
+                g_mutex_unlock (&dev_events_lock);
+
+                udev_device_unref (dev);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void dev_events_watch_free (DeviceEventWatch *watch) {
+    if (watch->monitor)
+        udev_monitor_unref (watch->monitor);
+    if (watch->context)
+        udev_unref (watch->context);
+    g_free (watch);
+}
+
+/* needs to be called with the lock held */
+static gboolean start_dev_events_watch (GError **error) {
+    DeviceEventWatch *watch = NULL;
+
+    watch = g_new0 (DeviceEventWatch, 1);
+    watch->context = udev_new ();
+    if (!watch->context) {
+        g_set_error (error, BD_UTILS_DEV_EVENTS_ERROR, BD_UTILS_DEV_EVENTS_ERROR_FAILED,
+                     "Failed to create a udev context");
+        dev_events_watch_free (watch);
+        return FALSE;
+    }
+
+    watch->monitor = udev_monitor_new_from_netlink (watch->context, "udev");
+    if (!watch->monitor) {
+        g_set_error (error, BD_UTILS_DEV_EVENTS_ERROR, BD_UTILS_DEV_EVENTS_ERROR_FAILED,
+                     "Failed to create a udev monitor");
+        dev_events_watch_free (watch);
+        return FALSE;
+    }
+
+    if (udev_monitor_filter_add_match_subsystem_devtype (watch->monitor, "block", NULL) < 0 ||
+        udev_monitor_enable_receiving (watch->monitor) < 0) {
+        g_set_error (error, BD_UTILS_DEV_EVENTS_ERROR, BD_UTILS_DEV_EVENTS_ERROR_FAILED,
+                     "Failed to set up the udev monitor");
+        dev_events_watch_free (watch);
+        return FALSE;
+    }
+
+    if (pipe (dev_events_shutdown_pipe) != 0) {
+        g_set_error (error, BD_UTILS_DEV_EVENTS_ERROR, BD_UTILS_DEV_EVENTS_ERROR_FAILED,
+                     "Failed to create a pipe for the device event thread");
+        dev_events_watch_free (watch);
+        return FALSE;
+    }
+    watch->shutdown_fd = dev_events_shutdown_pipe[0];
+
+    dev_events_thread = g_thread_try_new ("bd-dev-events", dev_events_thread_func, watch, error);
+    if (!dev_events_thread) {
+        close (dev_events_shutdown_pipe[0]);
+        close (dev_events_shutdown_pipe[1]);
+        dev_events_shutdown_pipe[0] = -1;
+        dev_events_shutdown_pipe[1] = -1;
+        dev_events_watch_free (watch);
+        return FALSE;
+    }
+    dev_events_watch = watch;
+
+    return TRUE;
+}
+
+/* stops the watch thread if there are no subscribers (left); must NOT be
+   called with the lock held -- the thread may be blocked on it in the
+   dispatch and could then never process the shutdown request */
+static void maybe_stop_dev_events_watch (void) {
+    DeviceEventWatch *watch = NULL;
+    GThread *thread = NULL;
+    gint pipe_wr = -1;
+
+    g_mutex_lock (&dev_events_lock);
+    if (dev_events_subs == NULL && dev_events_thread != NULL) {
+        /* detach everything so that a concurrent subscription starts a fresh
+           watch instead of racing with this one being torn down */
+        thread = dev_events_thread;
+        watch = dev_events_watch;
+        pipe_wr = dev_events_shutdown_pipe[1];
+        dev_events_thread = NULL;
+        dev_events_watch = NULL;
+        dev_events_shutdown_pipe[0] = -1;
+        dev_events_shutdown_pipe[1] = -1;
+    }
+    g_mutex_unlock (&dev_events_lock);
+
+    if (thread) {
+        while (write (pipe_wr, "q", 1) == -1 && errno == EINTR)
+            ;
+        g_thread_join (thread);
+        close (watch->shutdown_fd);
+        close (pipe_wr);
+        dev_events_watch_free (watch);
+    }
+}
+
+/**
+ * bd_utils_subscribe_device_events:
+ * @callback: (scope notified): function to call for every block device uevent
+ * @user_data: (closure): data to pass to @callback
+ * @error: (out): place to store error (if any)
+ *
+ * Subscribes @callback to the add/change/remove events of block devices. The
+ * first subscription starts a single shared thread listening for the uevents,
+ * later subscriptions reuse it. See #BDUtilsDeviceEventFunc for the
+ * restrictions the callback has to follow.
+ *
+ * Returns: a non-zero subscription ID to pass to
+ *          bd_utils_unsubscribe_device_events() or 0 in case of error
+ */
+guint bd_utils_subscribe_device_events (BDUtilsDeviceEventFunc callback, gpointer user_data, GError **error) {
+    DeviceEventSubscription *sub = NULL;
+    guint id = 0;
+
+    if (!callback) {
+        g_set_error (error, BD_UTILS_DEV_EVENTS_ERROR, BD_UTILS_DEV_EVENTS_ERROR_FAILED,
+                     "No callback given");
+        return 0;
+    }
+
+    g_mutex_lock (&dev_events_lock);
+    if (!dev_events_thread && !start_dev_events_watch (error)) {
+        g_mutex_unlock (&dev_events_lock);
+        return 0;
+    }
+
+    sub = g_new0 (DeviceEventSubscription, 1);
+    sub->id = dev_events_next_id++;
+    sub->func = callback;
+    sub->user_data = user_data;
+    dev_events_subs = g_slist_append (dev_events_subs, sub);
+    id = sub->id;
+    g_mutex_unlock (&dev_events_lock);
+
+    return id;
+}
+
+/**
+ * bd_utils_unsubscribe_device_events:
+ * @subscription_id: the subscription to cancel (as returned by
+ *                   bd_utils_subscribe_device_events())
+ * @error: (out): place to store error (if any)
+ *
+ * Cancels a device event subscription. Once this returns the callback is
+ * guaranteed not to be running and never to be called again. The shared
+ * listener is stopped together with the last subscription.
+ *
+ * Returns: whether the subscription was found and cancelled or not
+ */
+gboolean bd_utils_unsubscribe_device_events (guint subscription_id, GError **error) {
+    GSList *item = NULL;
+    gboolean found = FALSE;
+
+    g_mutex_lock (&dev_events_lock);
+    for (item = dev_events_subs; item; item = item->next) {
+        DeviceEventSubscription *sub = item->data;
+        if (sub->id == subscription_id) {
+            dev_events_subs = g_slist_delete_link (dev_events_subs, item);
+            g_free (sub);
+            found = TRUE;
+            break;
+        }
+    }
+    g_mutex_unlock (&dev_events_lock);
+
+    if (!found) {
+        g_set_error (error, BD_UTILS_DEV_EVENTS_ERROR, BD_UTILS_DEV_EVENTS_ERROR_FAILED,
+                     "No device event subscription with the ID %u", subscription_id);
+        return FALSE;
+    }
+
+    maybe_stop_dev_events_watch ();
+
+    return TRUE;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_UTILS_DEV_EVENTS
+#define BD_UTILS_DEV_EVENTS
+
+GQuark bd_utils_dev_events_error_quark (void);
+#define BD_UTILS_DEV_EVENTS_ERROR bd_utils_dev_events_error_quark ()
+
+typedef enum {
+    BD_UTILS_DEV_EVENTS_ERROR_FAILED,
+} BDUtilsDevEventsError;
+
+/**
+ * BDUtilsDeviceAction:
+ * @BD_UTILS_DEVICE_ADD: a block device appeared
+ * @BD_UTILS_DEVICE_CHANGE: a block device changed (also covers the rarer
+ *                          uevent actions like "move" or "online")
+ * @BD_UTILS_DEVICE_REMOVE: a block device disappeared
+ */
+typedef enum {
+    BD_UTILS_DEVICE_ADD,
+    BD_UTILS_DEVICE_CHANGE,
+    BD_UTILS_DEVICE_REMOVE,
+} BDUtilsDeviceAction;
+
+/**
+ * BDUtilsDeviceEventFunc:
+ * @device: (allow-none): device node of the device the event happened on (or
+ *          %NULL if the device has no device node)
+ * @action: what happened to the device
+ * @devno: device number of the device (or 0 if unknown)
+ * @user_data: user data given when subscribing
+ *
+ * Callback invoked for every block device uevent. The callback runs in the
+ * internal event-watching thread so it should be quick and it must not call
+ * bd_utils_subscribe_device_events() or bd_utils_unsubscribe_device_events()
+ * itself.
+ */
+typedef void (*BDUtilsDeviceEventFunc) (const gchar *device, BDUtilsDeviceAction action, guint64 devno, gpointer user_data);
+
+guint bd_utils_subscribe_device_events (BDUtilsDeviceEventFunc callback, gpointer user_data, GError **error);
+gboolean bd_utils_unsubscribe_device_events (guint subscription_id, GError **error);
+
+#endif  /* BD_UTILS_DEV_EVENTS */
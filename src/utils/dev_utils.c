@@ -19,8 +19,21 @@
 
 #include <glib.h>
 #include <libudev.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
 
 #include "dev_utils.h"
+#include "dev_events.h"
+#include "probe.h"
+
+struct BDUtilsSysfsDir {
+    gint fd;
+    gchar *path;
+    /* single buffer reused by all the reads from the directory */
+    gchar buf[4096];
+};
 
 /**
  * bd_utils_dev_utils_error_quark: (skip)
@@ -30,6 +43,83 @@ GQuark bd_utils_dev_utils_error_quark (void)
     return g_quark_from_static_string ("g-bd-utils-dev_utils-error-quark");
 }
 
+static GMutex resolve_cache_lock;
+/* dev_spec -> resolved path */
+static GHashTable *resolve_cache = NULL;
+static guint64 resolve_cache_generation = 0;
+static guint resolve_events_sub = 0;
+
+static void resolve_cache_event_cb (const gchar *device __attribute__((unused)), BDUtilsDeviceAction action __attribute__((unused)), guint64 devno __attribute__((unused)), gpointer user_data __attribute__((unused))) {
+    /* any block device event may create, remove or repoint the /dev/disk
+       symlinks, there is no way to tell which of the cached specifications it
+       affects so everything is dropped (resolutions are cheap to redo, the
+       cache only pays off for the repeated sweeps in between the events) */
+    g_mutex_lock (&resolve_cache_lock);
+    if (resolve_cache) {
+        resolve_cache_generation++;
+        g_hash_table_remove_all (resolve_cache);
+    }
+    g_mutex_unlock (&resolve_cache_lock);
+}
+
+/**
+ * bd_utils_set_resolve_cache:
+ * @enabled: whether to serve repeated device name resolutions from an
+ *           in-memory cache or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables the cache for bd_utils_resolve_device() results. With
+ * the cache enabled the readlink/stat chain resolving a stable name (e.g. a
+ * "/dev/disk/by-id/..." symlink) runs only once and later resolutions of the
+ * same specification are a hash lookup; the cache is dropped whenever a block
+ * device uevent arrives so renamed or repointed symlinks are picked up again.
+ * The cache is disabled by default.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ */
+gboolean bd_utils_set_resolve_cache (gboolean enabled, GError **error) {
+    guint sub_id = 0;
+
+    if (enabled) {
+        /* the subscription has to be in place before the cache is enabled,
+           otherwise an event arriving in between would be missed; it also
+           cannot be created with the lock held -- the callback takes the same
+           lock and the event thread dispatches under its own one */
+        sub_id = bd_utils_subscribe_device_events (resolve_cache_event_cb, NULL, error);
+        if (sub_id == 0)
+            return FALSE;
+
+        g_mutex_lock (&resolve_cache_lock);
+        if (resolve_cache) {
+            /* already enabled by someone else in the meantime */
+            g_mutex_unlock (&resolve_cache_lock);
+            bd_utils_unsubscribe_device_events (sub_id, NULL);
+            return TRUE;
+        }
+        resolve_events_sub = sub_id;
+        resolve_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+        g_mutex_unlock (&resolve_cache_lock);
+    } else {
+        g_mutex_lock (&resolve_cache_lock);
+        if (!resolve_cache) {
+            g_mutex_unlock (&resolve_cache_lock);
+            return TRUE;
+        }
+        sub_id = resolve_events_sub;
+        resolve_events_sub = 0;
+        resolve_cache_generation++;
+        g_hash_table_destroy (resolve_cache);
+        resolve_cache = NULL;
+        g_mutex_unlock (&resolve_cache_lock);
+
+        /* the callback may be blocked on the lock right now so the
+           subscription can only be cancelled after releasing it */
+        bd_utils_unsubscribe_device_events (sub_id, NULL);
+    }
+
+    return TRUE;
+}
+
 /**
  * bd_utils_resolve_device:
  * @dev_spec: specification of the device (e.g. "/dev/sda", any symlink, or the name of a file
@@ -42,10 +132,24 @@ GQuark bd_utils_dev_utils_error_quark (void)
 gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error) {
     gchar *path = NULL;
     gchar *symlink = NULL;
+    const gchar *cached = NULL;
+    guint64 generation = 0;
     GError *l_error = NULL;
 
     /* TODO: check that the resulting path is a block device? */
 
+    g_mutex_lock (&resolve_cache_lock);
+    if (resolve_cache) {
+        cached = g_hash_table_lookup (resolve_cache, dev_spec);
+        if (cached) {
+            path = g_strdup (cached);
+            g_mutex_unlock (&resolve_cache_lock);
+            return path;
+        }
+        generation = resolve_cache_generation;
+    }
+    g_mutex_unlock (&resolve_cache_lock);
+
     if (!g_str_has_prefix (dev_spec, "/dev/"))
         path = g_strdup_printf ("/dev/%s", dev_spec);
     else
@@ -56,25 +160,66 @@ gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error) {
         if (g_error_matches (l_error, G_FILE_ERROR, G_FILE_ERROR_INVAL)) {
             /* invalid argument -> not a symlink -> nothing to resolve */
             g_clear_error (&l_error);
-            return path;
         } else {
             /* some other error, just report it */
             g_propagate_error (error, l_error);
             g_free (path);
             return NULL;
         }
+    } else {
+        g_free (path);
+
+        if (g_str_has_prefix (symlink, "../"))
+            path = g_strdup_printf ("/dev/%s", symlink + 3);
+        else
+            path = g_strdup_printf ("/dev/%s", symlink);
+        g_free (symlink);
     }
-    g_free (path);
 
-    if (g_str_has_prefix (symlink, "../"))
-        path = g_strdup_printf ("/dev/%s", symlink + 3);
-    else
-        path = g_strdup_printf ("/dev/%s", symlink);
-    g_free (symlink);
+    g_mutex_lock (&resolve_cache_lock);
+    /* the generation snapshot prevents a resolution that raced with an
+       invalidating event from being cached */
+    if (resolve_cache && (generation == resolve_cache_generation))
+        g_hash_table_replace (resolve_cache, g_strdup (dev_spec), g_strdup (path));
+    g_mutex_unlock (&resolve_cache_lock);
 
     return path;
 }
 
+/**
+ * bd_utils_resolve_devices:
+ * @dev_specs: (array zero-terminated=1): specifications of the devices to
+ *             resolve (see bd_utils_resolve_device())
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Resolves all the given device specifications in one go. With the resolve
+ * cache enabled (see bd_utils_set_resolve_cache()) a repeated sweep over a
+ * stable set of names costs one hash lookup per device.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the full real paths of
+ *          the devices (in the order of @dev_specs) or %NULL if any of them
+ *          cannot be resolved
+ */
+gchar** bd_utils_resolve_devices (const gchar **dev_specs, GError **error) {
+    gchar **ret = NULL;
+    guint n = 0;
+    guint i = 0;
+
+    for (n = 0; dev_specs[n]; n++);
+
+    ret = g_new0 (gchar*, n + 1);
+    for (i = 0; i < n; i++) {
+        ret[i] = bd_utils_resolve_device (dev_specs[i], error);
+        if (!ret[i]) {
+            g_prefix_error (error, "Failed to resolve the device '%s': ", dev_specs[i]);
+            g_strfreev (ret);
+            return NULL;
+        }
+    }
+
+    return ret;
+}
+
 /**
  * bd_utils_get_device_symlinks:
  * @dev_spec: specification of the device (e.g. "/dev/sda", any symlink, or the name of a file
@@ -142,3 +287,561 @@ gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error) {
 
     return ret;
 }
+
+/**
+ * bd_utils_sysfs_dir_open: (skip)
+ * @path: path of the sysfs directory to open (e.g. "/sys/block/sda")
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Opens @path for batched attribute reads with bd_utils_sysfs_dir_read() and
+ * bd_utils_sysfs_dir_read_num(). The attributes are opened relative to the
+ * directory (with openat()) and read into a single buffer owned by the
+ * directory so reading many attributes only resolves and allocates once.
+ *
+ * Returns: the open directory or %NULL in case of error (to be closed with
+ *          bd_utils_sysfs_dir_close())
+ */
+BDUtilsSysfsDir* bd_utils_sysfs_dir_open (const gchar *path, GError **error) {
+    BDUtilsSysfsDir *dir = NULL;
+    gint fd = -1;
+
+    fd = open (path, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to open the directory '%s': %m", path);
+        return NULL;
+    }
+
+    dir = g_new0 (BDUtilsSysfsDir, 1);
+    dir->fd = fd;
+    dir->path = g_strdup (path);
+
+    return dir;
+}
+
+/**
+ * bd_utils_sysfs_dir_has_attr: (skip)
+ * @dir: directory to check the attribute in
+ * @attr: name of the attribute (file in @dir)
+ *
+ * Returns: whether the @attr attribute exists in @dir or not
+ */
+gboolean bd_utils_sysfs_dir_has_attr (BDUtilsSysfsDir *dir, const gchar *attr) {
+    return faccessat (dir->fd, attr, F_OK, 0) == 0;
+}
+
+/**
+ * bd_utils_sysfs_dir_read: (skip)
+ * @dir: directory to read the attribute from
+ * @attr: name of the attribute (file in @dir) to read
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: (transfer none): contents of the @attr attribute with leading and
+ *          trailing whitespace stripped or %NULL in case of error. The string
+ *          points into a buffer owned by @dir and is only valid until the next
+ *          read from @dir or until @dir is closed.
+ */
+const gchar* bd_utils_sysfs_dir_read (BDUtilsSysfsDir *dir, const gchar *attr, GError **error) {
+    gint fd = -1;
+    gssize n_read = -1;
+
+    fd = openat (dir->fd, attr, O_RDONLY|O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to open the attribute '%s' of '%s': %m", attr, dir->path);
+        return NULL;
+    }
+
+    do
+        n_read = read (fd, dir->buf, sizeof (dir->buf) - 1);
+    while (n_read < 0 && errno == EINTR);
+    if (n_read < 0) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to read the attribute '%s' of '%s': %m", attr, dir->path);
+        close (fd);
+        return NULL;
+    }
+    close (fd);
+
+    dir->buf[n_read] = '\0';
+    return g_strstrip (dir->buf);
+}
+
+/**
+ * bd_utils_sysfs_dir_read_num: (skip)
+ * @dir: directory to read the attribute from
+ * @attr: name of the attribute (file in @dir) to read
+ * @num: (out): place to store the value of the attribute
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: whether the @attr attribute was successfully read as a number or not
+ */
+gboolean bd_utils_sysfs_dir_read_num (BDUtilsSysfsDir *dir, const gchar *attr, guint64 *num, GError **error) {
+    const gchar *content = NULL;
+
+    content = bd_utils_sysfs_dir_read (dir, attr, error);
+    if (!content)
+        return FALSE;
+
+    *num = g_ascii_strtoull (content, NULL, 0);
+    return TRUE;
+}
+
+/**
+ * bd_utils_sysfs_dir_write: (skip)
+ * @dir: directory to write the attribute in
+ * @attr: name of the attribute (file in @dir) to write
+ * @value: value to write to the attribute
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: whether @value was successfully written to the @attr attribute or not
+ */
+gboolean bd_utils_sysfs_dir_write (BDUtilsSysfsDir *dir, const gchar *attr, const gchar *value, GError **error) {
+    gint fd = -1;
+    gssize n_written = -1;
+
+    fd = openat (dir->fd, attr, O_WRONLY|O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to open the attribute '%s' of '%s' for writing: %m", attr, dir->path);
+        return FALSE;
+    }
+
+    /* sysfs attributes consume the whole value in a single write */
+    do
+        n_written = write (fd, value, strlen (value));
+    while (n_written < 0 && errno == EINTR);
+    if (n_written < 0) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to write '%s' to the attribute '%s' of '%s': %m", value, attr, dir->path);
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_sysfs_dir_write_attrs: (skip)
+ * @dir: directory to write the attributes in
+ * @attrs: (array zero-terminated=1): attribute-value pairs to write, in order
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Writes all the given attribute-value pairs to @dir in the given order (the
+ * order matters for attributes like the zram 'disksize' that activate the
+ * device and make other attributes read-only), stopping at the first failed
+ * write.
+ *
+ * Returns: whether all the attributes were successfully written or not
+ */
+gboolean bd_utils_sysfs_dir_write_attrs (BDUtilsSysfsDir *dir, const BDUtilsSysfsAttr **attrs, GError **error) {
+    const BDUtilsSysfsAttr **attr_p = NULL;
+
+    for (attr_p = attrs; *attr_p; attr_p++)
+        if (!bd_utils_sysfs_dir_write (dir, (*attr_p)->attr, (*attr_p)->value, error))
+            return FALSE;
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_sysfs_write_attrs: (skip)
+ * @path: path of the sysfs directory to write the attributes in
+ * @attrs: (array zero-terminated=1): attribute-value pairs to write, in order
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Convenience wrapper opening @path, writing all the given attribute-value
+ * pairs relative to it (see bd_utils_sysfs_dir_write_attrs()) and closing it
+ * again. The directory is resolved only once no matter how many attributes
+ * are written.
+ *
+ * Returns: whether all the attributes were successfully written or not
+ */
+gboolean bd_utils_sysfs_write_attrs (const gchar *path, const BDUtilsSysfsAttr **attrs, GError **error) {
+    BDUtilsSysfsDir *dir = NULL;
+    gboolean ret = FALSE;
+
+    dir = bd_utils_sysfs_dir_open (path, error);
+    if (!dir)
+        return FALSE;
+
+    ret = bd_utils_sysfs_dir_write_attrs (dir, attrs, error);
+    bd_utils_sysfs_dir_close (dir);
+
+    return ret;
+}
+
+/* one directory of a batched attribute write */
+typedef struct SysfsWriteTask {
+    const gchar *path;
+    const BDUtilsSysfsAttr **attrs;
+    GError *error;
+    gboolean success;
+    struct SysfsWriteState *state;
+} SysfsWriteTask;
+
+/* state shared by all directories of a batched attribute write */
+typedef struct SysfsWriteState {
+    GMutex lock;
+    GCond cond;
+    guint remaining;
+} SysfsWriteState;
+
+static void sysfs_write_worker (gpointer data, gpointer pool_data __attribute__((unused))) {
+    SysfsWriteTask *task = (SysfsWriteTask *) data;
+    SysfsWriteState *state = task->state;
+
+    task->success = bd_utils_sysfs_write_attrs (task->path, task->attrs, &task->error);
+
+    g_mutex_lock (&state->lock);
+    state->remaining--;
+    g_cond_signal (&state->cond);
+    g_mutex_unlock (&state->lock);
+}
+
+/**
+ * bd_utils_sysfs_write_attrs_many: (skip)
+ * @paths: (array length=count): paths of the sysfs directories to write in
+ * @attrs: (array length=count): for every path a zero-terminated array of the
+ *         attribute-value pairs to write there, in order
+ * @count: number of the directories in @paths
+ * @max_parallel: maximum number of directories written to at the same time
+ *                (0 for the number of online CPUs)
+ * @item_errors: (out caller-allocates) (allow-none) (array length=count): place
+ *               to store the per-directory errors (%NULL for directories that
+ *               were successfully written) or %NULL
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Writes the attributes of many devices concurrently with at most
+ * @max_parallel directories being written to at any time. Within one
+ * directory the attributes are written in the given order, a failure in one
+ * directory doesn't stop the writes to the remaining ones.
+ *
+ * Returns: whether all the attributes of all the directories were
+ *          successfully written or not (see @item_errors for the
+ *          per-directory errors)
+ */
+gboolean bd_utils_sysfs_write_attrs_many (const gchar **paths, const BDUtilsSysfsAttr ***attrs, guint count, guint max_parallel, GError **item_errors, GError **error) {
+    GThreadPool *pool = NULL;
+    SysfsWriteTask *tasks = NULL;
+    SysfsWriteState state;
+    guint i = 0;
+    guint n_failed = 0;
+    GError *l_error = NULL;
+
+    if (count == 0)
+        return TRUE;
+    if (max_parallel == 0)
+        max_parallel = g_get_num_processors ();
+
+    g_mutex_init (&state.lock);
+    g_cond_init (&state.cond);
+    state.remaining = count;
+
+    pool = g_thread_pool_new (sysfs_write_worker, NULL, (gint) max_parallel, FALSE, &l_error);
+    if (!pool) {
+        g_propagate_error (error, l_error);
+        g_mutex_clear (&state.lock);
+        g_cond_clear (&state.cond);
+        return FALSE;
+    }
+
+    tasks = g_new0 (SysfsWriteTask, count);
+    for (i = 0; i < count; i++) {
+        tasks[i].path = paths[i];
+        tasks[i].attrs = attrs[i];
+        tasks[i].state = &state;
+        g_thread_pool_push (pool, &tasks[i], NULL);
+    }
+
+    g_mutex_lock (&state.lock);
+    while (state.remaining > 0)
+        g_cond_wait (&state.cond, &state.lock);
+    g_mutex_unlock (&state.lock);
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i = 0; i < count; i++) {
+        if (!tasks[i].success)
+            n_failed++;
+        if (item_errors)
+            item_errors[i] = tasks[i].error;
+        else
+            g_clear_error (&tasks[i].error);
+    }
+    g_free (tasks);
+
+    if (n_failed > 0)
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to write the attributes of %u of the %u directories", n_failed, count);
+
+    g_mutex_clear (&state.lock);
+    g_cond_clear (&state.cond);
+
+    return n_failed == 0;
+}
+
+/**
+ * bd_utils_sysfs_dir_close: (skip)
+ * @dir: (allow-none): directory to close
+ *
+ * Closes the directory opened with bd_utils_sysfs_dir_open() (doing nothing
+ * if %NULL is given).
+ */
+void bd_utils_sysfs_dir_close (BDUtilsSysfsDir *dir) {
+    if (!dir)
+        return;
+
+    close (dir->fd);
+    g_free (dir->path);
+    g_free (dir);
+}
+
+/**
+ * bd_utils_device_graph_node_copy: (skip)
+ *
+ * Creates a new copy of @node.
+ */
+BDUtilsDeviceGraphNode* bd_utils_device_graph_node_copy (BDUtilsDeviceGraphNode *node) {
+    BDUtilsDeviceGraphNode *ret = NULL;
+
+    if (node == NULL)
+        return NULL;
+
+    ret = g_new0 (BDUtilsDeviceGraphNode, 1);
+    ret->name = g_strdup (node->name);
+    ret->major = node->major;
+    ret->minor = node->minor;
+    ret->size = node->size;
+    ret->device_type = g_strdup (node->device_type);
+    ret->fstype = g_strdup (node->fstype);
+    ret->parents = g_strdupv (node->parents);
+    ret->children = g_strdupv (node->children);
+
+    return ret;
+}
+
+/**
+ * bd_utils_device_graph_node_free: (skip)
+ *
+ * Frees @node.
+ */
+void bd_utils_device_graph_node_free (BDUtilsDeviceGraphNode *node) {
+    if (node == NULL)
+        return;
+
+    g_free (node->name);
+    g_free (node->device_type);
+    g_free (node->fstype);
+    g_strfreev (node->parents);
+    g_strfreev (node->children);
+    g_free (node);
+}
+
+GType bd_utils_device_graph_node_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsDeviceGraphNode",
+                                             (GBoxedCopyFunc) bd_utils_device_graph_node_copy,
+                                             (GBoxedFreeFunc) bd_utils_device_graph_node_free);
+
+    return type;
+}
+
+/* lists the names in the given directory into the given array (devices may
+   come and go during the sweep so a directory that cannot be opened is simply
+   treated as empty) */
+static void collect_dir_names (const gchar *path, GPtrArray *names) {
+    GDir *dir = NULL;
+    const gchar *name = NULL;
+
+    dir = g_dir_open (path, 0, NULL);
+    if (!dir)
+        return;
+
+    while ((name = g_dir_read_name (dir)))
+        g_ptr_array_add (names, g_strdup (name));
+    g_dir_close (dir);
+}
+
+static gchar** strv_from_names (GPtrArray *names) {
+    g_ptr_array_add (names, NULL);
+    return (gchar **) g_ptr_array_free (names, FALSE);
+}
+
+static gchar* detect_device_type (BDUtilsSysfsDir *dir, const gchar *name, gboolean partition) {
+    const gchar *uuid = NULL;
+
+    if (partition)
+        return g_strdup ("partition");
+
+    if (bd_utils_sysfs_dir_has_attr (dir, "dm/uuid")) {
+        uuid = bd_utils_sysfs_dir_read (dir, "dm/uuid", NULL);
+        if (uuid) {
+            if (g_str_has_prefix (uuid, "LVM-"))
+                return g_strdup ("lvm");
+            if (g_str_has_prefix (uuid, "CRYPT-"))
+                return g_strdup ("crypt");
+            if (g_str_has_prefix (uuid, "mpath-"))
+                return g_strdup ("mpath");
+        }
+        return g_strdup ("dm");
+    }
+
+    if (bd_utils_sysfs_dir_has_attr (dir, "md"))
+        return g_strdup ("md");
+    if (g_str_has_prefix (name, "loop"))
+        return g_strdup ("loop");
+    if (g_str_has_prefix (name, "zram"))
+        return g_strdup ("zram");
+
+    return g_strdup ("disk");
+}
+
+/* fills in everything except the parents/children which only the caller can
+   assemble; returns NULL if the device disappeared during the sweep */
+static BDUtilsDeviceGraphNode* device_graph_node_new (const gchar *sysfs_path, const gchar *name, gboolean partition) {
+    BDUtilsDeviceGraphNode *node = NULL;
+    BDUtilsSysfsDir *dir = NULL;
+    const gchar *dev_str = NULL;
+    gchar *endptr = NULL;
+    gchar *devnode = NULL;
+    guint64 sectors = 0;
+
+    dir = bd_utils_sysfs_dir_open (sysfs_path, NULL);
+    if (!dir)
+        return NULL;
+
+    node = g_new0 (BDUtilsDeviceGraphNode, 1);
+    node->name = g_strdup (name);
+
+    dev_str = bd_utils_sysfs_dir_read (dir, "dev", NULL);
+    if (dev_str) {
+        node->major = g_ascii_strtoull (dev_str, &endptr, 10);
+        if (endptr && *endptr == ':')
+            node->minor = g_ascii_strtoull (endptr + 1, NULL, 10);
+    }
+
+    if (bd_utils_sysfs_dir_read_num (dir, "size", &sectors, NULL))
+        node->size = sectors * 512;
+
+    node->device_type = detect_device_type (dir, name, partition);
+    bd_utils_sysfs_dir_close (dir);
+
+    /* the probe cache is only consulted, never populated here -- a cache miss
+       just leaves the signature type unknown instead of costing a probe */
+    devnode = g_strdup_printf ("/dev/%s", name);
+    bd_utils_probe_cache_lookup (devnode, NULL, &node->fstype, NULL, NULL);
+    g_free (devnode);
+
+    return node;
+}
+
+/**
+ * bd_utils_get_device_graph:
+ * @error: (out): place to store error (if any)
+ *
+ * Builds the complete parent/child graph of the block devices on the system
+ * (including partitions) from a single sweep over /sys/block, using the
+ * holders/ and slaves/ links the kernel maintains for every device. No
+ * external utilities are spawned and no device is opened; the signature type
+ * of a device is filled in only when the probe cache already knows it.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the nodes of the graph
+ *          or %NULL in case of error (@error is set in that case)
+ */
+BDUtilsDeviceGraphNode** bd_utils_get_device_graph (GError **error) {
+    GDir *block_dir = NULL;
+    GPtrArray *nodes = NULL;
+    BDUtilsDeviceGraphNode *node = NULL;
+    const gchar *disk_name = NULL;
+    gchar *disk_path = NULL;
+    gchar *part_path = NULL;
+    gchar *sub_path = NULL;
+    GPtrArray *relatives = NULL;
+    GPtrArray *part_names = NULL;
+    GError *l_error = NULL;
+    guint i = 0;
+
+    block_dir = g_dir_open ("/sys/block", 0, &l_error);
+    if (!block_dir) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to open /sys/block: %s", l_error->message);
+        g_clear_error (&l_error);
+        return NULL;
+    }
+
+    nodes = g_ptr_array_new ();
+    while ((disk_name = g_dir_read_name (block_dir))) {
+        disk_path = g_strdup_printf ("/sys/block/%s", disk_name);
+
+        node = device_graph_node_new (disk_path, disk_name, FALSE);
+        if (!node) {
+            /* the device disappeared during the sweep */
+            g_free (disk_path);
+            continue;
+        }
+
+        relatives = g_ptr_array_new ();
+        sub_path = g_strdup_printf ("%s/slaves", disk_path);
+        collect_dir_names (sub_path, relatives);
+        g_free (sub_path);
+        node->parents = strv_from_names (relatives);
+
+        /* the partitions of the disk are subdirectories with a 'partition'
+           attribute and count among its children next to the holders */
+        part_names = g_ptr_array_new_with_free_func (g_free);
+        collect_dir_names (disk_path, part_names);
+        for (i = 0; i < part_names->len; ) {
+            part_path = g_strdup_printf ("%s/%s/partition", disk_path, (gchar *) g_ptr_array_index (part_names, i));
+            if (g_file_test (part_path, G_FILE_TEST_EXISTS))
+                i++;
+            else
+                g_ptr_array_remove_index_fast (part_names, i);
+            g_free (part_path);
+        }
+
+        relatives = g_ptr_array_new ();
+        sub_path = g_strdup_printf ("%s/holders", disk_path);
+        collect_dir_names (sub_path, relatives);
+        g_free (sub_path);
+        for (i = 0; i < part_names->len; i++)
+            g_ptr_array_add (relatives, g_strdup (g_ptr_array_index (part_names, i)));
+        node->children = strv_from_names (relatives);
+
+        g_ptr_array_add (nodes, node);
+
+        for (i = 0; i < part_names->len; i++) {
+            const gchar *part_name = g_ptr_array_index (part_names, i);
+
+            part_path = g_strdup_printf ("%s/%s", disk_path, part_name);
+            node = device_graph_node_new (part_path, part_name, TRUE);
+            if (!node) {
+                g_free (part_path);
+                continue;
+            }
+
+            /* a partition sits on its disk only */
+            relatives = g_ptr_array_new ();
+            g_ptr_array_add (relatives, g_strdup (disk_name));
+            node->parents = strv_from_names (relatives);
+
+            relatives = g_ptr_array_new ();
+            sub_path = g_strdup_printf ("%s/holders", part_path);
+            collect_dir_names (sub_path, relatives);
+            g_free (sub_path);
+            node->children = strv_from_names (relatives);
+
+            g_ptr_array_add (nodes, node);
+            g_free (part_path);
+        }
+
+        g_ptr_array_free (part_names, TRUE);
+        g_free (disk_path);
+    }
+    g_dir_close (block_dir);
+
+    g_ptr_array_add (nodes, NULL);
+    return (BDUtilsDeviceGraphNode **) g_ptr_array_free (nodes, FALSE);
+}
@@ -18,6 +18,7 @@
  */
 
 #include <glib.h>
+#include <glib-object.h>
 
 #ifndef BD_UTILS_DEV_UTILS
 #define BD_UTILS_DEV_UTILS
@@ -29,7 +30,65 @@ typedef enum {
     BD_UTILS_DEV_UTILS_ERROR_FAILED,
 } BDUtilsDevUtilsError;
 
+gboolean bd_utils_set_resolve_cache (gboolean enabled, GError **error);
 gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error);
+gchar** bd_utils_resolve_devices (const gchar **dev_specs, GError **error);
 gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error);
 
+typedef struct BDUtilsSysfsDir BDUtilsSysfsDir;
+
+/**
+ * BDUtilsSysfsAttr:
+ * @attr: name of the attribute (file in the sysfs directory)
+ * @value: value to write to the attribute
+ */
+typedef struct BDUtilsSysfsAttr {
+    const gchar *attr;
+    const gchar *value;
+} BDUtilsSysfsAttr;
+
+BDUtilsSysfsDir* bd_utils_sysfs_dir_open (const gchar *path, GError **error);
+gboolean bd_utils_sysfs_dir_has_attr (BDUtilsSysfsDir *dir, const gchar *attr);
+const gchar* bd_utils_sysfs_dir_read (BDUtilsSysfsDir *dir, const gchar *attr, GError **error);
+gboolean bd_utils_sysfs_dir_read_num (BDUtilsSysfsDir *dir, const gchar *attr, guint64 *num, GError **error);
+gboolean bd_utils_sysfs_dir_write (BDUtilsSysfsDir *dir, const gchar *attr, const gchar *value, GError **error);
+gboolean bd_utils_sysfs_dir_write_attrs (BDUtilsSysfsDir *dir, const BDUtilsSysfsAttr **attrs, GError **error);
+gboolean bd_utils_sysfs_write_attrs (const gchar *path, const BDUtilsSysfsAttr **attrs, GError **error);
+gboolean bd_utils_sysfs_write_attrs_many (const gchar **paths, const BDUtilsSysfsAttr ***attrs, guint count, guint max_parallel, GError **item_errors, GError **error);
+void bd_utils_sysfs_dir_close (BDUtilsSysfsDir *dir);
+
+#define BD_UTILS_TYPE_DEVICE_GRAPH_NODE (bd_utils_device_graph_node_get_type ())
+GType bd_utils_device_graph_node_get_type (void);
+
+/**
+ * BDUtilsDeviceGraphNode:
+ * @name: kernel name of the device (e.g. "sda" or "dm-0")
+ * @major: major number of the device
+ * @minor: minor number of the device
+ * @size: size of the device in bytes
+ * @device_type: type of the device detected from sysfs ("disk", "partition",
+ *               "lvm", "crypt", "mpath", "dm", "md", "loop", "zram")
+ * @fstype: (allow-none): type of the signature on the device as cached by the
+ *          probe cache or %NULL if not cached
+ * @parents: (array zero-terminated=1): kernel names of the devices this
+ *           device sits on top of
+ * @children: (array zero-terminated=1): kernel names of the devices sitting
+ *            on top of this device
+ */
+typedef struct BDUtilsDeviceGraphNode {
+    gchar *name;
+    guint64 major;
+    guint64 minor;
+    guint64 size;
+    gchar *device_type;
+    gchar *fstype;
+    gchar **parents;
+    gchar **children;
+} BDUtilsDeviceGraphNode;
+
+BDUtilsDeviceGraphNode* bd_utils_device_graph_node_copy (BDUtilsDeviceGraphNode *node);
+void bd_utils_device_graph_node_free (BDUtilsDeviceGraphNode *node);
+
+BDUtilsDeviceGraphNode** bd_utils_get_device_graph (GError **error);
+
 #endif  /* BD_UTILS_DEV_UTILS */
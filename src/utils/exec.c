@@ -17,16 +17,25 @@
  * Author: Vratislav Podzimek <vpodzime@redhat.com>
  */
 
+#define _GNU_SOURCE
 #include <glib.h>
+#include <glib/gstdio.h>
 #include "exec.h"
 #include "extra_arg.h"
 #include "logging.h"
+#include "metrics.h"
+#include "trace.h"
 #include <stdlib.h>
+#include <string.h>
+#include <spawn.h>
 #include <poll.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <errno.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
 #ifdef __clang__
@@ -37,13 +46,137 @@
 
 extern char **environ;
 
-static GMutex id_counter_lock;
+/* both counters are only ever manipulated atomically */
 static guint64 id_counter = 0;
-
-static GMutex task_id_counter_lock;
 static guint64 task_id_counter = 0;
 static BDUtilsProgFunc prog_func = NULL;
 static __thread BDUtilsProgFunc thread_prog_func = NULL;
+static __thread BDUtilsProgContextFunc thread_prog_context_func = NULL;
+static __thread gpointer thread_prog_context_data = NULL;
+
+static gboolean helper_pool_active (void);
+static gboolean helper_pool_exec (const gchar **argv, gint *status, gchar **stdout_data, gchar **stderr_data, gboolean *used_pool, GError **error);
+
+static gboolean exec_use_posix_spawn = FALSE;
+
+/**
+ * bd_utils_exec_set_posix_spawn:
+ * @enabled: whether to spawn utilities using posix_spawn() or not
+ *
+ * Makes the exec helpers spawn utilities using posix_spawn() instead of
+ * fork()-based g_spawn. posix_spawn() avoids duplicating the page tables of
+ * the calling process which for processes with a large address space can
+ * dominate the cost of running small utilities. Off by default.
+ */
+void bd_utils_exec_set_posix_spawn (gboolean enabled) {
+    exec_use_posix_spawn = enabled;
+}
+
+/* spawn @argv using posix_spawnp() with the given pipes connected to the
+   child's stdin/stdout/stderr; @in_fd may be NULL when no input is needed */
+static gboolean spawn_posix (gchar **argv, gchar **env, GPid *pid, gint *in_fd, gint *out_fd, gint *err_fd, GError **error) {
+    posix_spawn_file_actions_t actions;
+    int in_pipe[2] = {-1, -1};
+    int out_pipe[2] = {-1, -1};
+    int err_pipe[2] = {-1, -1};
+    pid_t child = 0;
+    int ret = 0;
+
+    /* O_CLOEXEC so that a concurrently forked sibling child cannot inherit
+       the write ends and keep the reader from ever seeing EOF; the dup2 file
+       actions below clear the flag on the fds the child actually uses */
+    if (pipe2 (out_pipe, O_CLOEXEC) != 0 || pipe2 (err_pipe, O_CLOEXEC) != 0 || (in_fd && pipe2 (in_pipe, O_CLOEXEC) != 0)) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Failed to create pipes for the process: %m");
+        if (out_pipe[0] >= 0) {
+            close (out_pipe[0]);
+            close (out_pipe[1]);
+        }
+        if (err_pipe[0] >= 0) {
+            close (err_pipe[0]);
+            close (err_pipe[1]);
+        }
+        return FALSE;
+    }
+
+    posix_spawn_file_actions_init (&actions);
+    if (in_fd)
+        posix_spawn_file_actions_adddup2 (&actions, in_pipe[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2 (&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2 (&actions, err_pipe[1], STDERR_FILENO);
+    if (in_fd) {
+        posix_spawn_file_actions_addclose (&actions, in_pipe[0]);
+        posix_spawn_file_actions_addclose (&actions, in_pipe[1]);
+    }
+    posix_spawn_file_actions_addclose (&actions, out_pipe[0]);
+    posix_spawn_file_actions_addclose (&actions, out_pipe[1]);
+    posix_spawn_file_actions_addclose (&actions, err_pipe[0]);
+    posix_spawn_file_actions_addclose (&actions, err_pipe[1]);
+
+    ret = posix_spawnp (&child, argv[0], &actions, NULL, argv, env);
+    posix_spawn_file_actions_destroy (&actions);
+
+    /* close the child's ends in any case */
+    if (in_fd)
+        close (in_pipe[0]);
+    close (out_pipe[1]);
+    close (err_pipe[1]);
+
+    if (ret != 0) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Failed to spawn the process '%s': %s", argv[0], g_strerror (ret));
+        if (in_fd)
+            close (in_pipe[1]);
+        close (out_pipe[0]);
+        close (err_pipe[0]);
+        return FALSE;
+    }
+
+    *pid = child;
+    if (in_fd)
+        *in_fd = in_pipe[1];
+    *out_fd = out_pipe[0];
+    *err_fd = err_pipe[0];
+    return TRUE;
+}
+
+/* merge @argv and the options/values from @extra into a newly allocated
+   NULL-terminated array (the strings are not copied); returns NULL when
+   there is nothing to merge and @argv can be used directly */
+static const gchar** merge_extra_args (const gchar **argv, const BDExtraArg **extra) {
+    const gchar **args = NULL;
+    guint args_len = 0;
+    const gchar **arg_p = NULL;
+    const BDExtraArg **extra_p = NULL;
+    guint i = 0;
+
+    if (!extra)
+        return NULL;
+
+    args_len = g_strv_length ((gchar **) argv);
+    for (extra_p=extra; *extra_p; extra_p++) {
+        if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0))
+            args_len++;
+        if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0))
+            args_len++;
+    }
+    args = g_new0 (const gchar*, args_len + 1);
+    for (arg_p=argv; *arg_p; arg_p++, i++)
+        args[i] = *arg_p;
+    for (extra_p=extra; *extra_p; extra_p++) {
+        if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0)) {
+            args[i] = (*extra_p)->opt;
+            i++;
+        }
+        if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0)) {
+            args[i] = (*extra_p)->val;
+            i++;
+        }
+    }
+    args[i] = NULL;
+
+    return args;
+}
 
 /**
  * bd_utils_exec_error_quark: (skip)
@@ -57,14 +190,7 @@ GQuark bd_utils_exec_error_quark (void)
  * bd_utils_get_next_task_id:
  */
 guint64 bd_utils_get_next_task_id (void) {
-    guint64 task_id = 0;
-
-    g_mutex_lock (&id_counter_lock);
-    id_counter++;
-    task_id = id_counter;
-    g_mutex_unlock (&id_counter_lock);
-
-    return task_id;
+    return __atomic_add_fetch (&id_counter, 1, __ATOMIC_RELAXED);
 }
 
 /**
@@ -73,11 +199,7 @@ guint64 bd_utils_get_next_task_id (void) {
  * @msg: log message
  */
 void bd_utils_log_task_status (guint64 task_id, const gchar *msg) {
-    gchar *log_msg = NULL;
-
-    log_msg = g_strdup_printf ("[%"G_GUINT64_FORMAT"] %s", task_id, msg);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "[%"G_GUINT64_FORMAT"] %s", task_id, msg);
 }
 
 /**
@@ -88,15 +210,21 @@ void bd_utils_log_task_status (guint64 task_id, const gchar *msg) {
 static guint64 log_running (const gchar **argv) {
     guint64 task_id = 0;
     gchar *str_argv = NULL;
-    gchar *log_msg = NULL;
 
     task_id = bd_utils_get_next_task_id ();
+    bd_utils_metrics_record_spawn ();
 
+#ifdef WITH_BD_SDT
+    /* the tracepoint wants the joined argv even when logging is off */
     str_argv = g_strjoinv (" ", (gchar **) argv);
-    log_msg = g_strdup_printf ("Running [%"G_GUINT64_FORMAT"] %s ...", task_id, str_argv);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
+    BD_TRACE (exec_spawn, task_id, str_argv);
+#endif
+    if (bd_utils_log_would_log (BD_UTILS_LOG_INFO)) {
+        if (!str_argv)
+            str_argv = g_strjoinv (" ", (gchar **) argv);
+        bd_utils_log_format (BD_UTILS_LOG_INFO, "Running [%"G_GUINT64_FORMAT"] %s ...", task_id, str_argv);
+    }
     g_free (str_argv);
-    g_free (log_msg);
 
     return task_id;
 }
@@ -106,32 +234,43 @@ static guint64 log_running (const gchar **argv) {
  *
  */
 static void log_out (guint64 task_id, const gchar *stdout, const gchar *stderr) {
-    gchar *log_msg = NULL;
-
-    log_msg = g_strdup_printf ("stdout[%"G_GUINT64_FORMAT"]: %s", task_id, stdout);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
-
-    log_msg = g_strdup_printf ("stderr[%"G_GUINT64_FORMAT"]: %s", task_id, stderr);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "stdout[%"G_GUINT64_FORMAT"]: %s", task_id, stdout);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "stderr[%"G_GUINT64_FORMAT"]: %s", task_id, stderr);
 
     return;
 }
 
+/* CPU time (user + system, in microseconds) from a reaped child's rusage */
+static guint64 rusage_cpu_usec (const struct rusage *ru) {
+    return (guint64) ru->ru_utime.tv_sec * G_USEC_PER_SEC + ru->ru_utime.tv_usec +
+           (guint64) ru->ru_stime.tv_sec * G_USEC_PER_SEC + ru->ru_stime.tv_usec;
+}
+
 /**
  * log_done: (skip)
  *
  */
 static void log_done (guint64 task_id, gint exit_code) {
-    gchar *log_msg = NULL;
+    BD_TRACE (exec_reap, task_id, exit_code);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "...done [%"G_GUINT64_FORMAT"] (exit code: %d)", task_id, exit_code);
 
-    log_msg = g_strdup_printf ("...done [%"G_GUINT64_FORMAT"] (exit code: %d)", task_id, exit_code);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
+    return;
+}
 
+/* environment for the spawned utilities: the process environment with LC_ALL
+   forced to "C" so that their output can be parsed reliably; snapshotted once
+   on the first exec instead of being re-duplicated for every call (changes
+   made to the process environment afterwards are thus not propagated to the
+   utilities) */
+static gchar** exec_child_env (void) {
+    static gchar **child_env = NULL;
+
+    if (g_once_init_enter (&child_env)) {
+        gchar **env = g_environ_setenv (g_get_environ (), "LC_ALL", "C", TRUE);
+        g_once_init_leave (&child_env, env);
+    }
 
-    return;
+    return child_env;
 }
 
 /**
@@ -178,75 +317,56 @@ gboolean bd_utils_exec_and_report_status_error (const gchar **argv, const BDExtr
     gchar *stderr_data = NULL;
     guint64 task_id = 0;
     const gchar **args = NULL;
-    guint args_len = 0;
-    const gchar **arg_p = NULL;
-    const BDExtraArg **extra_p = NULL;
     gint exit_status = 0;
-    guint i = 0;
-    gchar **old_env = NULL;
-    gchar **new_env = NULL;
+    gboolean used_pool = FALSE;
     GError *l_error = NULL;
 
-    if (extra) {
-        args_len = g_strv_length ((gchar **) argv);
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0))
-                args_len++;
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0))
-                args_len++;
-        }
-        args = g_new0 (const gchar*, args_len + 1);
-        for (arg_p=argv; *arg_p; arg_p++, i++)
-            args[i] = *arg_p;
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0)) {
-                args[i] = (*extra_p)->opt;
-                i++;
-            }
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0)) {
-                args[i] = (*extra_p)->val;
-                i++;
-            }
-        }
-        args[i] = NULL;
-    }
-
-    old_env = g_get_environ ();
-    new_env = g_environ_setenv (old_env, "LC_ALL", "C", TRUE);
+    args = merge_extra_args (argv, extra);
 
     task_id = log_running (args ? args : argv);
-    success = g_spawn_sync (NULL, args ? (gchar **) args : (gchar **) argv, new_env, G_SPAWN_SEARCH_PATH,
-                            NULL, NULL, &stdout_data, &stderr_data, &exit_status, error);
-    if (!success) {
-        /* error is already populated from the call */
-        g_strfreev (new_env);
-        g_free (stdout_data);
-        g_free (stderr_data);
-        return FALSE;
-    }
-    g_strfreev (new_env);
-
-    /* g_spawn_sync set the status in the same way waitpid() does, we need
-       to get the process exit code manually (this is similar to calling
-       WEXITSTATUS but also sets the error for terminated processes */
 
-    #if !GLIB_CHECK_VERSION(2, 69, 0)
-    #define g_spawn_check_wait_status(x) (g_spawn_check_exit_status (x))
-    #endif
-
-    if (!g_spawn_check_wait_status (exit_status, &l_error)) {
-        if (g_error_matches (l_error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED)) {
-            /* process was terminated abnormally (e.g. using a signal) */
+    if (helper_pool_active ()) {
+        /* route the call through a pre-forked broker process; the pool may be
+           shut down concurrently in which case we fall back to spawning */
+        success = helper_pool_exec (args ? args : argv, status, &stdout_data, &stderr_data, &used_pool, error);
+        if (!success && used_pool) {
+            /* error is already populated from the call */
+            g_free (args);
+            return FALSE;
+        }
+    }
+    if (!used_pool) {
+        success = g_spawn_sync (NULL, args ? (gchar **) args : (gchar **) argv, exec_child_env (), G_SPAWN_SEARCH_PATH,
+                                NULL, NULL, &stdout_data, &stderr_data, &exit_status, error);
+        if (!success) {
+            /* error is already populated from the call */
             g_free (stdout_data);
             g_free (stderr_data);
-            g_propagate_error (error, l_error);
             return FALSE;
         }
 
-        *status = l_error->code;
-        g_clear_error (&l_error);
-    } else
-        *status = 0;
+        /* g_spawn_sync set the status in the same way waitpid() does, we need
+           to get the process exit code manually (this is similar to calling
+           WEXITSTATUS but also sets the error for terminated processes */
+
+        #if !GLIB_CHECK_VERSION(2, 69, 0)
+        #define g_spawn_check_wait_status(x) (g_spawn_check_exit_status (x))
+        #endif
+
+        if (!g_spawn_check_wait_status (exit_status, &l_error)) {
+            if (g_error_matches (l_error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED)) {
+                /* process was terminated abnormally (e.g. using a signal) */
+                g_free (stdout_data);
+                g_free (stderr_data);
+                g_propagate_error (error, l_error);
+                return FALSE;
+            }
+
+            *status = l_error->code;
+            g_clear_error (&l_error);
+        } else
+            *status = 0;
+    }
 
     log_out (task_id, stdout_data, stderr_data);
     log_done (task_id, *status);
@@ -354,12 +474,12 @@ _process_fd_event (gint fd, struct pollfd *poll_fd, GString *read_buffer, GStrin
     return TRUE;
 }
 
-static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, const gchar *input, gint *proc_status, gchar **stdout, gchar **stderr, GError **error) {
+/* how often (in ms) to interrupt the poll to check for cancellation */
+#define CANCEL_CHECK_INTERVAL 200
+
+static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, const gchar *input, guint timeout_msec, GCancellable *cancellable, gint *proc_status, gchar **stdout, gchar **stderr, GError **error) {
     const gchar **args = NULL;
-    guint args_len = 0;
-    const gchar **arg_p = NULL;
     gchar *args_str = NULL;
-    const BDExtraArg **extra_p = NULL;
     guint64 task_id = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
@@ -369,9 +489,9 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     gint in_fd = 0;
     gint child_ret = -1;
     gint status = 0;
+    struct rusage ru = ZERO_INIT;
     gboolean ret = FALSE;
     gint poll_status = 0;
-    guint i = 0;
     guint8 completion = 0;
     struct pollfd fds[2] = { ZERO_INIT, ZERO_INIT };
     int flags;
@@ -383,46 +503,25 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     GString *stderr_buffer;
     gsize stdout_buffer_pos = 0;
     gsize stderr_buffer_pos = 0;
-    gchar **old_env = NULL;
-    gchar **new_env = NULL;
     gboolean success = TRUE;
+    gint64 deadline = 0;
+    gint poll_timeout = -1;
     GError *l_error = NULL;
 
-    /* TODO: share this code between functions */
-    if (extra) {
-        args_len = g_strv_length ((gchar **) argv);
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0))
-                args_len++;
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0))
-                args_len++;
-        }
-        args = g_new0 (const gchar*, args_len + 1);
-        for (arg_p=argv; *arg_p; arg_p++, i++)
-            args[i] = *arg_p;
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0)) {
-                args[i] = (*extra_p)->opt;
-                i++;
-            }
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0)) {
-                args[i] = (*extra_p)->val;
-                i++;
-            }
-        }
-        args[i] = NULL;
-    }
+    if (timeout_msec > 0)
+        deadline = g_get_monotonic_time () + (gint64) timeout_msec * 1000;
 
-    task_id = log_running (args ? args : argv);
-
-    old_env = g_get_environ ();
-    new_env = g_environ_setenv (old_env, "LC_ALL", "C", TRUE);
+    args = merge_extra_args (argv, extra);
 
-    ret = g_spawn_async_with_pipes (NULL, args ? (gchar**) args : (gchar**) argv, new_env,
-                                    G_SPAWN_DEFAULT|G_SPAWN_SEARCH_PATH|G_SPAWN_DO_NOT_REAP_CHILD,
-                                    NULL, NULL, &pid, input ? &in_fd : NULL, &out_fd, &err_fd, error);
+    task_id = log_running (args ? args : argv);
 
-    g_strfreev (new_env);
+    if (exec_use_posix_spawn)
+        ret = spawn_posix (args ? (gchar**) args : (gchar**) argv, exec_child_env (), &pid,
+                           input ? &in_fd : NULL, &out_fd, &err_fd, error);
+    else
+        ret = g_spawn_async_with_pipes (NULL, args ? (gchar**) args : (gchar**) argv, exec_child_env (),
+                                        G_SPAWN_DEFAULT|G_SPAWN_SEARCH_PATH|G_SPAWN_DO_NOT_REAP_CHILD,
+                                        NULL, NULL, &pid, input ? &in_fd : NULL, &out_fd, &err_fd, error);
 
     if (!ret) {
         /* error is already populated */
@@ -430,10 +529,17 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
         return FALSE;
     }
 
-    args_str = g_strjoinv (" ", args ? (gchar **) args : (gchar **) argv);
-    msg = g_strdup_printf ("Started '%s'", args_str);
-    progress_id = bd_utils_report_started (msg);
-    g_free (args_str);
+#ifndef WITH_BD_SDT
+    /* don't bother joining the argv for the 'started' message when nobody
+       would see it (the progress_started tracepoint wants it, though) */
+    if (bd_utils_prog_reporting_initialized ())
+#endif
+    {
+        args_str = g_strjoinv (" ", args ? (gchar **) args : (gchar **) argv);
+        msg = g_strdup_printf ("Started '%s'", args_str);
+        g_free (args_str);
+    }
+    progress_id = bd_utils_report_started (msg ? msg : "");
     g_free (args);
     g_free (msg);
 
@@ -478,8 +584,16 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     fds[0].events = POLLIN | POLLHUP | POLLERR;
     fds[1].events = POLLIN | POLLHUP | POLLERR;
     while (! (out_done && err_done)) {
-        poll_status = poll (fds, 2, -1 /* timeout */);
-        g_warn_if_fail (poll_status != 0);  /* no timeout specified, zero should never be returned */
+        if (deadline != 0) {
+            poll_timeout = (gint) ((deadline - g_get_monotonic_time ()) / 1000);
+            if (poll_timeout < 0)
+                poll_timeout = 0;
+            if (cancellable && poll_timeout > CANCEL_CHECK_INTERVAL)
+                poll_timeout = CANCEL_CHECK_INTERVAL;
+        } else
+            poll_timeout = cancellable ? CANCEL_CHECK_INTERVAL : -1;
+
+        poll_status = poll (fds, 2, poll_timeout);
         if (poll_status < 0) {
             if (errno == EAGAIN || errno == EINTR)
                 continue;
@@ -491,6 +605,30 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
             break;
         }
 
+        if (cancellable && g_cancellable_is_cancelled (cancellable)) {
+            kill (pid, SIGKILL);
+            g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_CANCELLED,
+                         "The execution was cancelled, the process was killed");
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            success = FALSE;
+            break;
+        }
+
+        if (deadline != 0 && g_get_monotonic_time () >= deadline) {
+            kill (pid, SIGKILL);
+            g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_TIMED_OUT,
+                         "The process didn't finish within the %u ms limit, killed", timeout_msec);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            success = FALSE;
+            break;
+        }
+
+        if (poll_status == 0)
+            /* just a cancellation/deadline check tick, nothing to read */
+            continue;
+
         if (!out_done) {
             if (! _process_fd_event (out_fd, &fds[0], stdout_buffer, stdout_data, &stdout_buffer_pos, &out_done, progress_id, &completion, prog_extract, &l_error)) {
                 bd_utils_report_finished (progress_id, l_error->message);
@@ -515,8 +653,10 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     close (out_fd);
     close (err_fd);
 
-    child_ret = waitpid (pid, &status, 0);
+    child_ret = wait4 (pid, &status, 0, &ru);
     *proc_status = WEXITSTATUS (status);
+    if (child_ret > 0)
+        bd_utils_metrics_record_child_cpu (rusage_cpu_usec (&ru));
     if (success) {
         if (child_ret > 0) {
             if (*proc_status != 0) {
@@ -579,7 +719,31 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
  * Returns: whether the @argv was successfully executed (no error and exit code 0) or not
  */
 gboolean bd_utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, gint *proc_status, GError **error) {
-    return _utils_exec_and_report_progress (argv, extra, prog_extract, NULL, proc_status, NULL, NULL, error);
+    return _utils_exec_and_report_progress (argv, extra, prog_extract, NULL, 0, NULL, proc_status, NULL, NULL, error);
+}
+
+/**
+ * bd_utils_exec_and_report_progress_cancellable:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (allow-none) (array zero-terminated=1): extra arguments
+ * @prog_extract: (scope notified) (nullable): function for extracting progress information
+ * @timeout_msec: maximum time (in milliseconds) the process is allowed to run
+ *                or 0 for no limit
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @proc_status: (out): place to store the process exit status
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Like bd_utils_exec_and_report_progress() but the execution can be limited in
+ * time. If @timeout_msec elapses before the process finishes, the process is
+ * killed and %BD_UTILS_EXEC_ERROR_TIMED_OUT is reported; if @cancellable is
+ * triggered, the process is killed and %BD_UTILS_EXEC_ERROR_CANCELLED is
+ * reported. This makes it possible to put a deadline on utilities that may
+ * block indefinitely (e.g. on a dying disk).
+ *
+ * Returns: whether the @argv was successfully executed (no error and exit code 0) or not
+ */
+gboolean bd_utils_exec_and_report_progress_cancellable (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, guint timeout_msec, GCancellable *cancellable, gint *proc_status, GError **error) {
+    return _utils_exec_and_report_progress (argv, extra, prog_extract, NULL, timeout_msec, cancellable, proc_status, NULL, NULL, error);
 }
 
 /**
@@ -595,7 +759,7 @@ gboolean bd_utils_exec_with_input (const gchar **argv, const gchar *input, const
     gint status = 0;
     /* just use the "stronger" function providing dumb progress reporting (just
        'started' and 'finished') and throw away the returned status */
-    return _utils_exec_and_report_progress (argv, extra, NULL, input, &status, NULL, NULL, error);
+    return _utils_exec_and_report_progress (argv, extra, NULL, input, 0, NULL, &status, NULL, NULL, error);
 }
 
 /**
@@ -611,12 +775,34 @@ gboolean bd_utils_exec_with_input (const gchar **argv, const gchar *input, const
  * Returns: whether the @argv was successfully executed capturing the output or not
  */
 gboolean bd_utils_exec_and_capture_output (const gchar **argv, const BDExtraArg **extra, gchar **output, GError **error) {
+    return bd_utils_exec_and_capture_output_cancellable (argv, extra, 0, NULL, output, error);
+}
+
+/**
+ * bd_utils_exec_and_capture_output_cancellable:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (allow-none) (array zero-terminated=1): extra arguments
+ * @timeout_msec: maximum time (in milliseconds) the process is allowed to run
+ *                or 0 for no limit
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @output: (out): variable to store output to
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Like bd_utils_exec_and_capture_output() but the execution can be limited in
+ * time. If @timeout_msec elapses before the process finishes, the process is
+ * killed and %BD_UTILS_EXEC_ERROR_TIMED_OUT is reported; if @cancellable is
+ * triggered, the process is killed and %BD_UTILS_EXEC_ERROR_CANCELLED is
+ * reported.
+ *
+ * Returns: whether the @argv was successfully executed capturing the output or not
+ */
+gboolean bd_utils_exec_and_capture_output_cancellable (const gchar **argv, const BDExtraArg **extra, guint timeout_msec, GCancellable *cancellable, gchar **output, GError **error) {
     gint status = 0;
     gchar *stdout = NULL;
     gchar *stderr = NULL;
     gboolean ret = FALSE;
 
-    ret = _utils_exec_and_report_progress (argv, extra, NULL, NULL, &status, &stdout, &stderr, error);
+    ret = _utils_exec_and_report_progress (argv, extra, NULL, NULL, timeout_msec, cancellable, &status, &stdout, &stderr, error);
     if (!ret)
         return ret;
 
@@ -640,122 +826,1179 @@ gboolean bd_utils_exec_and_capture_output (const gchar **argv, const BDExtraArg
     }
 }
 
+/* state of a streaming (pull-based) execution, opaque to callers */
+struct _BDUtilsExecIter {
+    GPid pid;
+    gint out_fd;
+    gint err_fd;
+    GString *out_buf;
+    GString *err_buf;
+    gchar *line;
+    gboolean out_eof;
+    gboolean err_eof;
+    guint64 task_id;
+};
+
+/* read everything currently available from @fd into @buf, returns FALSE on
+   a read error, sets @eof on end of the stream */
+static gboolean iter_drain_fd (gint fd, GString *buf, gboolean *eof, GError **error) {
+    gchar chunk[_EXEC_BUF_SIZE];
+    ssize_t num_read;
+
+    while ((num_read = read (fd, chunk, _EXEC_BUF_SIZE)) > 0)
+        g_string_append_len (buf, chunk, num_read);
+
+    if (num_read == 0) {
+        *eof = TRUE;
+        return TRUE;
+    }
+    if (errno == EAGAIN || errno == EINTR)
+        return TRUE;
+
+    g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                 "Error reading from pipe: %m");
+    return FALSE;
+}
+
 /**
- * bd_utils_version_cmp:
- * @ver_string1: first version string
- * @ver_string2: second version string
+ * bd_utils_exec_iterate_start:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (allow-none) (array zero-terminated=1): extra arguments
  * @error: (out) (allow-none): place to store error (if any)
  *
- * Returns: -1, 0 or 1 if @ver_string1 is lower, the same or higher version as
- *          @ver_string2 respectively. If an error occurs, returns -2 and @error
- *          is set.
+ * Starts the given utility for line-by-line consumption of its standard
+ * output via bd_utils_exec_iterate_next(). Unlike
+ * bd_utils_exec_and_capture_output() the output is never accumulated in
+ * memory as a whole, so large reports (e.g. 'lvs' over thousands of LVs) can
+ * be parsed with O(line) memory.
  *
- * **ONLY SUPPORTS VERSION STRINGS OF FORMAT X[.Y[.Z[.Z2[.Z3...[-R]]]]] where all components
- *   are natural numbers!**
+ * The returned iterator must always be closed with
+ * bd_utils_exec_iterate_finish(), no matter whether all lines were consumed
+ * or not.
+ *
+ * Returns: (transfer full): a new iterator over the utility's output or %NULL
+ *          in case of error
  */
-gint bd_utils_version_cmp (const gchar *ver_string1, const gchar *ver_string2, GError **error) {
-    gchar **v1_fields = NULL;
-    gchar **v2_fields = NULL;
-    guint v1_fields_len = 0;
-    guint v2_fields_len = 0;
-    guint64 v1_value = 0;
-    guint64 v2_value = 0;
-    GRegex *regex = NULL;
-    gboolean success = FALSE;
-    gint ret = -2;
+BDUtilsExecIter* bd_utils_exec_iterate_start (const gchar **argv, const BDExtraArg **extra, GError **error) {
+    BDUtilsExecIter *iter = NULL;
+    const gchar **args = NULL;
+    gboolean ret = FALSE;
+    GPid pid = 0;
+    gint out_fd = 0;
+    gint err_fd = 0;
+    guint64 task_id = 0;
+    int flags;
 
-    regex = g_regex_new ("^(\\d+)(\\.\\d+)*(-\\d)?$", 0, 0, error);
-    if (!regex) {
-        /* error is already populated */
-        return -2;
-    }
+    args = merge_extra_args (argv, extra);
 
-    success = g_regex_match (regex, ver_string1, 0, NULL);
-    if (!success) {
-        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_VER,
-                     "Invalid or unsupported version (1) format: %s", ver_string1);
-        return -2;
-    }
-    success = g_regex_match (regex, ver_string2, 0, NULL);
-    if (!success) {
-        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_VER,
-                     "Invalid or unsupported version (2) format: %s", ver_string2);
-        return -2;
-    }
-    g_regex_unref (regex);
+    task_id = log_running (args ? args : argv);
 
-    v1_fields = g_strsplit_set (ver_string1, ".-", 0);
-    v2_fields = g_strsplit_set (ver_string2, ".-", 0);
-    v1_fields_len = g_strv_length (v1_fields);
-    v2_fields_len = g_strv_length (v2_fields);
+    if (exec_use_posix_spawn)
+        ret = spawn_posix (args ? (gchar**) args : (gchar**) argv, exec_child_env (), &pid,
+                           NULL, &out_fd, &err_fd, error);
+    else
+        ret = g_spawn_async_with_pipes (NULL, args ? (gchar**) args : (gchar**) argv, exec_child_env (),
+                                        G_SPAWN_DEFAULT|G_SPAWN_SEARCH_PATH|G_SPAWN_DO_NOT_REAP_CHILD,
+                                        NULL, NULL, &pid, NULL, &out_fd, &err_fd, error);
+    g_free (args);
 
-    for (guint i=0; (i < v1_fields_len) && (i < v2_fields_len) && ret == -2; i++) {
-        v1_value = g_ascii_strtoull (v1_fields[i], NULL, 0);
-        v2_value = g_ascii_strtoull (v2_fields[i], NULL, 0);
-        if (v1_value < v2_value)
-            ret = -1;
-        else if (v1_value > v2_value)
-            ret = 1;
-    }
+    if (!ret)
+        /* error is already populated */
+        return NULL;
 
-    if (ret == -2) {
-        if (v1_fields_len < v2_fields_len)
-            ret = -1;
-        else if (v1_fields_len > v2_fields_len)
-            ret = 1;
-        else
-            ret = 0;
-    }
+    flags = fcntl (out_fd, F_GETFL, 0);
+    if (fcntl (out_fd, F_SETFL, flags | O_NONBLOCK))
+        bd_utils_log_format (BD_UTILS_LOG_WARNING,
+                             "bd_utils_exec_iterate_start: Failed to set out_fd non-blocking: %m");
+    flags = fcntl (err_fd, F_GETFL, 0);
+    if (fcntl (err_fd, F_SETFL, flags | O_NONBLOCK))
+        bd_utils_log_format (BD_UTILS_LOG_WARNING,
+                             "bd_utils_exec_iterate_start: Failed to set err_fd non-blocking: %m");
 
-    g_strfreev (v1_fields);
-    g_strfreev (v2_fields);
+    iter = g_new0 (BDUtilsExecIter, 1);
+    iter->pid = pid;
+    iter->out_fd = out_fd;
+    iter->err_fd = err_fd;
+    iter->out_buf = g_string_new (NULL);
+    iter->err_buf = g_string_new (NULL);
+    iter->task_id = task_id;
 
-    return ret;
+    return iter;
 }
 
 /**
- * bd_utils_check_util_version:
- * @util: name of the utility to check
- * @version: (allow-none): minimum required version of the utility or %NULL
- *           if no version is required
- * @version_arg: (allow-none): argument to use with the @util to get version
- *               info or %NULL to use "--version"
- * @version_regexp: (allow-none): regexp to extract version from the version
- *                  info or %NULL if only version is printed by "$ @util @version_arg"
+ * bd_utils_exec_iterate_next:
+ * @iter: iterator obtained from bd_utils_exec_iterate_start()
  * @error: (out) (allow-none): place to store error (if any)
  *
- * Returns: whether the @util is available in a version >= @version or not
- *          (@error is set in such case).
+ * Pulls the next line (including the trailing newline character, if any) from
+ * the utility's standard output, blocking until one is available or the
+ * stream ends. The returned string is owned by @iter and only valid until the
+ * next call of this function or bd_utils_exec_iterate_finish().
+ *
+ * Returns: (transfer none) (nullable): the next output line or %NULL when the
+ *          output is exhausted or an error occurred (@error distinguishes the
+ *          two cases)
  */
-gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, const gchar *version_arg, const gchar *version_regexp, GError **error) {
-    gchar *util_path = NULL;
-    const gchar *argv[] = {util, version_arg ? version_arg : "--version", NULL};
-    gchar *output = NULL;
-    gboolean succ = FALSE;
-    GRegex *regex = NULL;
-    GMatchInfo *match_info = NULL;
-    gchar *version_str = NULL;
-    GError *l_error = NULL;
+const gchar* bd_utils_exec_iterate_next (BDUtilsExecIter *iter, GError **error) {
+    struct pollfd fds[2] = { ZERO_INIT, ZERO_INIT };
+    gchar *newline_pos = NULL;
+    gint poll_status = 0;
 
-    util_path = g_find_program_in_path (util);
-    if (!util_path) {
-        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_UNAVAILABLE,
-                     "The '%s' utility is not available", util);
-        return FALSE;
-    }
-    g_free (util_path);
+    g_clear_pointer (&iter->line, g_free);
 
-    if (!version)
-        /* nothing more to do here */
-        return TRUE;
+    fds[0].events = POLLIN | POLLHUP | POLLERR;
+    fds[1].events = POLLIN | POLLHUP | POLLERR;
 
-    succ = bd_utils_exec_and_capture_output (argv, NULL, &output, &l_error);
-    if (!succ) {
-        /* if we got nothing on STDOUT, try using STDERR data from error message */
-        if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
-            output = g_strdup (l_error->message);
-            g_clear_error (&l_error);
-        } else if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED)) {
+    for (;;) {
+        newline_pos = bd_strchr_len_null (iter->out_buf->str, iter->out_buf->len, '\n');
+        if (newline_pos) {
+            iter->line = g_strndup (iter->out_buf->str, newline_pos - iter->out_buf->str + 1);
+            g_string_erase (iter->out_buf, 0, newline_pos - iter->out_buf->str + 1);
+            return iter->line;
+        }
+        if (iter->out_eof) {
+            if (iter->out_buf->len > 0) {
+                /* remaining output without a trailing newline */
+                iter->line = g_strndup (iter->out_buf->str, iter->out_buf->len);
+                g_string_truncate (iter->out_buf, 0);
+                return iter->line;
+            }
+            return NULL;
+        }
+
+        fds[0].fd = iter->out_fd;
+        fds[1].fd = iter->err_eof ? -1 : iter->err_fd;
+        poll_status = poll (fds, 2, -1 /* timeout */);
+        if (poll_status < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Failed to poll output FDs: %m");
+            return NULL;
+        }
+
+        if (!iter_drain_fd (iter->out_fd, iter->out_buf, &iter->out_eof, error))
+            return NULL;
+        /* keep the stderr pipe drained so the utility cannot block on it */
+        if (!iter->err_eof && !iter_drain_fd (iter->err_fd, iter->err_buf, &iter->err_eof, error))
+            return NULL;
+    }
+}
+
+/**
+ * bd_utils_exec_iterate_finish:
+ * @iter: (transfer full): iterator obtained from bd_utils_exec_iterate_start()
+ * @status: (out): place to store the process exit status
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Waits for the utility to exit and frees @iter. Output not consumed via
+ * bd_utils_exec_iterate_next() is read and discarded first.
+ *
+ * Returns: whether the utility was successfully executed (no error and exit
+ *          code 0) or not
+ */
+gboolean bd_utils_exec_iterate_finish (BDUtilsExecIter *iter, gint *status, GError **error) {
+    gint wait_status = 0;
+    gint child_ret = -1;
+    struct rusage ru = ZERO_INIT;
+    gboolean success = TRUE;
+    struct pollfd fds[2] = { ZERO_INIT, ZERO_INIT };
+    gint poll_status = 0;
+
+    /* drain both pipes so the child is not stuck writing */
+    fds[0].events = POLLIN | POLLHUP | POLLERR;
+    fds[1].events = POLLIN | POLLHUP | POLLERR;
+    while (success && ! (iter->out_eof && iter->err_eof)) {
+        fds[0].fd = iter->out_eof ? -1 : iter->out_fd;
+        fds[1].fd = iter->err_eof ? -1 : iter->err_fd;
+        poll_status = poll (fds, 2, -1 /* timeout */);
+        if (poll_status < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Failed to poll output FDs: %m");
+            success = FALSE;
+            break;
+        }
+        if (!iter->out_eof) {
+            success = iter_drain_fd (iter->out_fd, iter->out_buf, &iter->out_eof, error);
+            g_string_truncate (iter->out_buf, 0);
+        }
+        if (success && !iter->err_eof)
+            success = iter_drain_fd (iter->err_fd, iter->err_buf, &iter->err_eof, error);
+    }
+
+    close (iter->out_fd);
+    close (iter->err_fd);
+
+    child_ret = wait4 (iter->pid, &wait_status, 0, &ru);
+    *status = WEXITSTATUS (wait_status);
+    if (child_ret > 0)
+        bd_utils_metrics_record_child_cpu (rusage_cpu_usec (&ru));
+    if (success) {
+        if (child_ret > 0 && WIFSIGNALED (wait_status)) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Process killed with a signal");
+            success = FALSE;
+        } else if (*status != 0) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Process reported exit code %d: %s", *status, iter->err_buf->str);
+            success = FALSE;
+        }
+    }
+
+    log_out (iter->task_id, "<streamed>", iter->err_buf->str);
+    log_done (iter->task_id, *status);
+
+    g_string_free (iter->out_buf, TRUE);
+    g_string_free (iter->err_buf, TRUE);
+    g_free (iter->line);
+    g_free (iter);
+
+    return success;
+}
+
+/* data describing a single asynchronously executed utility call */
+typedef struct ExecAsyncData {
+    gchar **argv;
+    BDExtraArg **extra;
+    BDUtilsProgExtract prog_extract;
+    gchar *input;
+    gboolean capture;
+    gint proc_status;
+    gchar *output;
+} ExecAsyncData;
+
+static BDExtraArg** copy_extra_args (const BDExtraArg **extra) {
+    BDExtraArg **ret = NULL;
+    const BDExtraArg **extra_p = NULL;
+    guint len = 0;
+    guint i = 0;
+
+    if (!extra)
+        return NULL;
+
+    for (extra_p=extra; *extra_p; extra_p++)
+        len++;
+    ret = g_new0 (BDExtraArg*, len + 1);
+    for (i=0; i < len; i++)
+        ret[i] = bd_extra_arg_copy ((BDExtraArg *) extra[i]);
+    ret[len] = NULL;
+
+    return ret;
+}
+
+static void exec_async_data_free (ExecAsyncData *data) {
+    BDExtraArg **extra_p = NULL;
+
+    g_strfreev (data->argv);
+    if (data->extra) {
+        for (extra_p=data->extra; *extra_p; extra_p++)
+            bd_extra_arg_free (*extra_p);
+        g_free (data->extra);
+    }
+    g_free (data->input);
+    g_free (data->output);
+    g_free (data);
+}
+
+static void exec_async_thread (GTask *task, gpointer source_object __attribute__((unused)), gpointer task_data, GCancellable *cancellable) {
+    ExecAsyncData *data = (ExecAsyncData *) task_data;
+    gboolean success = FALSE;
+    GError *l_error = NULL;
+
+    /* the cancellable is checked by GTask before this function is invoked,
+       check once more here in case cancellation happened while the task was
+       waiting for a thread */
+    if (g_task_return_error_if_cancelled (task))
+        return;
+
+    /* the cancellable is also watched while the process runs so a cancellation
+       mid-run kills the spawned process */
+    success = _utils_exec_and_report_progress ((const gchar **) data->argv, (const BDExtraArg **) data->extra,
+                                               data->prog_extract, data->input, 0, cancellable, &data->proc_status,
+                                               data->capture ? &data->output : NULL, NULL, &l_error);
+    if (!success)
+        g_task_return_error (task, l_error);
+    else
+        g_task_return_boolean (task, TRUE);
+}
+
+static GTask* exec_async_task_new (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, const gchar *input, gboolean capture, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data) {
+    GTask *task = NULL;
+    ExecAsyncData *data = NULL;
+
+    data = g_new0 (ExecAsyncData, 1);
+    data->argv = g_strdupv ((gchar **) argv);
+    data->extra = copy_extra_args (extra);
+    data->prog_extract = prog_extract;
+    data->input = g_strdup (input);
+    data->capture = capture;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_task_data (task, data, (GDestroyNotify) exec_async_data_free);
+    g_task_set_return_on_cancel (task, FALSE);
+
+    return task;
+}
+
+/**
+ * bd_utils_exec_and_report_progress_async:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (allow-none) (array zero-terminated=1): extra arguments
+ * @prog_extract: (scope notified) (nullable): function for extracting progress information
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): function to call when the execution is finished
+ * @user_data: data to pass to @callback
+ *
+ * Asynchronous variant of bd_utils_exec_and_report_progress(). The utility is
+ * spawned and driven from a worker thread so the caller's thread is never
+ * blocked and many invocations may be in flight at the same time. Progress is
+ * reported through the same machinery as for the synchronous variants.
+ *
+ * Call bd_utils_exec_and_report_progress_finish() from @callback to get the
+ * result. The @argv and @extra arrays are copied and may be freed right after
+ * this function returns.
+ */
+void bd_utils_exec_and_report_progress_async (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data) {
+    GTask *task = NULL;
+
+    task = exec_async_task_new (argv, extra, prog_extract, NULL, FALSE, cancellable, callback, user_data);
+    g_task_run_in_thread (task, exec_async_thread);
+    g_object_unref (task);
+}
+
+/**
+ * bd_utils_exec_and_report_progress_finish:
+ * @result: a #GAsyncResult obtained from the #GAsyncReadyCallback passed to
+ *          bd_utils_exec_and_report_progress_async()
+ * @proc_status: (out): place to store the process exit status
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: whether the utility was successfully executed (no error and exit
+ *          code 0) or not
+ */
+gboolean bd_utils_exec_and_report_progress_finish (GAsyncResult *result, gint *proc_status, GError **error) {
+    ExecAsyncData *data = NULL;
+
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+    data = (ExecAsyncData *) g_task_get_task_data (G_TASK (result));
+    *proc_status = data->proc_status;
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * bd_utils_exec_and_capture_output_async:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (allow-none) (array zero-terminated=1): extra arguments
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): function to call when the execution is finished
+ * @user_data: data to pass to @callback
+ *
+ * Asynchronous variant of bd_utils_exec_and_capture_output(). Call
+ * bd_utils_exec_and_capture_output_finish() from @callback to get the result.
+ */
+void bd_utils_exec_and_capture_output_async (const gchar **argv, const BDExtraArg **extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data) {
+    GTask *task = NULL;
+
+    task = exec_async_task_new (argv, extra, NULL, NULL, TRUE, cancellable, callback, user_data);
+    g_task_run_in_thread (task, exec_async_thread);
+    g_object_unref (task);
+}
+
+/**
+ * bd_utils_exec_and_capture_output_finish:
+ * @result: a #GAsyncResult obtained from the #GAsyncReadyCallback passed to
+ *          bd_utils_exec_and_capture_output_async()
+ * @output: (out): variable to store output to
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: whether the utility was successfully executed capturing the output
+ *          or not
+ */
+gboolean bd_utils_exec_and_capture_output_finish (GAsyncResult *result, gchar **output, GError **error) {
+    ExecAsyncData *data = NULL;
+
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+    if (!g_task_propagate_boolean (G_TASK (result), error))
+        return FALSE;
+
+    data = (ExecAsyncData *) g_task_get_task_data (G_TASK (result));
+    if (g_strcmp0 (data->output, "") == 0) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT,
+                     "Process didn't provide any data on standard output.");
+        return FALSE;
+    }
+    *output = g_steal_pointer (&data->output);
+
+    return TRUE;
+}
+
+/* one item of a batched execution */
+typedef struct ExecBatchItem {
+    const gchar **argv;
+    const BDExtraArg **extra;
+    gint status;
+    GError *error;
+    gboolean success;
+    struct ExecBatchState *state;
+} ExecBatchItem;
+
+/* state shared by all items of a batched execution */
+typedef struct ExecBatchState {
+    GMutex lock;
+    GCond cond;
+    guint remaining;
+    guint done;
+    guint total;
+    guint64 progress_id;
+} ExecBatchState;
+
+static void exec_batch_worker (gpointer data, gpointer pool_data __attribute__((unused))) {
+    ExecBatchItem *item = (ExecBatchItem *) data;
+    ExecBatchState *state = item->state;
+
+    /* progress of the individual items is muted, only the combined progress
+       of the whole batch is reported */
+    bd_utils_mute_prog_reporting_thread (NULL);
+
+    item->success = bd_utils_exec_and_report_status_error (item->argv, item->extra, &item->status, &item->error);
+
+    /* unmute before reporting the combined progress and so that the mute does
+       not leak into unrelated work later scheduled on this (shared) pool
+       thread */
+    bd_utils_unmute_prog_reporting_thread (NULL);
+
+    g_mutex_lock (&state->lock);
+    state->done++;
+    state->remaining--;
+    bd_utils_report_progress (state->progress_id, (state->done * 100) / state->total, NULL);
+    g_cond_signal (&state->cond);
+    g_mutex_unlock (&state->lock);
+}
+
+/**
+ * bd_utils_exec_batch:
+ * @argvs: (array length=count): array of argv arrays (each zero-terminated) to execute
+ * @count: number of the argv arrays in @argvs
+ * @max_parallel: maximum number of invocations running at the same time (0 for
+ *                the number of online CPUs)
+ * @extra: (allow-none) (array zero-terminated=1): extra arguments appended to
+ *         every invocation
+ * @statuses: (out caller-allocates) (allow-none) (array length=count): place to
+ *            store the per-item exit statuses or %NULL
+ * @item_errors: (out caller-allocates) (allow-none) (array length=count): place
+ *               to store the per-item errors (%NULL for items that succeeded)
+ *               or %NULL
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Runs the given argv vectors concurrently with at most @max_parallel of them
+ * in flight at any time. Combined progress of the whole batch is reported
+ * through the standard progress reporting machinery (one percent step per
+ * completed item, scaled to 100); progress of the individual invocations is
+ * muted.
+ *
+ * Returns: whether all the invocations were successfully executed (no error
+ *          and exit code 0) or not
+ */
+gboolean bd_utils_exec_batch (const gchar ***argvs, guint count, guint max_parallel, const BDExtraArg **extra, gint *statuses, GError **item_errors, GError **error) {
+    GThreadPool *pool = NULL;
+    ExecBatchItem *items = NULL;
+    ExecBatchState state;
+    guint i = 0;
+    guint n_failed = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    if (count == 0)
+        return TRUE;
+    if (max_parallel == 0)
+        max_parallel = g_get_num_processors ();
+
+    g_mutex_init (&state.lock);
+    g_cond_init (&state.cond);
+    state.remaining = count;
+    state.done = 0;
+    state.total = count;
+
+    msg = g_strdup_printf ("Started batch of %u utility calls", count);
+    state.progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    pool = g_thread_pool_new (exec_batch_worker, NULL, max_parallel, FALSE, &l_error);
+    if (!pool) {
+        bd_utils_report_finished (state.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        g_mutex_clear (&state.lock);
+        g_cond_clear (&state.cond);
+        return FALSE;
+    }
+
+    items = g_new0 (ExecBatchItem, count);
+    for (i = 0; i < count; i++) {
+        items[i].argv = argvs[i];
+        items[i].extra = extra;
+        items[i].state = &state;
+        g_thread_pool_push (pool, &items[i], NULL);
+    }
+
+    g_mutex_lock (&state.lock);
+    while (state.remaining > 0)
+        g_cond_wait (&state.cond, &state.lock);
+    g_mutex_unlock (&state.lock);
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i = 0; i < count; i++) {
+        if (statuses)
+            statuses[i] = items[i].status;
+        if (!items[i].success)
+            n_failed++;
+        if (item_errors)
+            item_errors[i] = items[i].error;
+        else
+            g_clear_error (&items[i].error);
+    }
+
+    if (n_failed > 0) {
+        g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "%u of %u batched utility calls failed", n_failed, count);
+        bd_utils_report_finished (state.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+    } else
+        bd_utils_report_finished (state.progress_id, "Completed");
+
+    g_free (items);
+    g_mutex_clear (&state.lock);
+    g_cond_clear (&state.cond);
+
+    return n_failed == 0;
+}
+
+/* Opt-in pool of pre-forked broker processes. A broker is forked early (while
+   the process image is still small), receives argv vectors over a socketpair,
+   spawns the utility itself and relays stdout/stderr/exit status back. This
+   way repeated short utility calls avoid fork()ing the potentially huge
+   calling process for every invocation. */
+
+typedef struct BrokerProc {
+    pid_t pid;
+    int fd;
+} BrokerProc;
+
+static GMutex helper_pool_lock;
+static GAsyncQueue *helper_pool_queue = NULL;
+static BrokerProc *helper_pool_procs = NULL;
+static guint helper_pool_size = 0;
+
+static gboolean full_write (int fd, const void *buf, size_t count) {
+    const char *p = buf;
+    ssize_t n;
+
+    while (count > 0) {
+        n = write (fd, p, count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        p += n;
+        count -= n;
+    }
+    return TRUE;
+}
+
+static gboolean full_read (int fd, void *buf, size_t count) {
+    char *p = buf;
+    ssize_t n;
+
+    while (count > 0) {
+        n = read (fd, p, count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        if (n == 0)
+            return FALSE;
+        p += n;
+        count -= n;
+    }
+    return TRUE;
+}
+
+/* drain both pipes concurrently -- reading them one after the other would
+   deadlock with a child that fills the capacity of the not-yet-read pipe
+   before closing the other one */
+static gboolean broker_read_both_fds (int out_fd, int err_fd, char **out_data, guint32 *out_len, char **err_data, guint32 *err_len) {
+    char *bufs[2] = { NULL, NULL };
+    size_t allocs[2] = { 4096, 4096 };
+    size_t used[2] = { 0, 0 };
+    struct pollfd pfds[2];
+    int n_open = 2;
+    int i;
+    ssize_t n;
+
+    pfds[0].fd = out_fd;
+    pfds[1].fd = err_fd;
+    pfds[0].events = POLLIN;
+    pfds[1].events = POLLIN;
+
+    for (i = 0; i < 2; i++) {
+        bufs[i] = malloc (allocs[i]);
+        if (!bufs[i])
+            goto err;
+    }
+
+    while (n_open > 0) {
+        if (poll (pfds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            goto err;
+        }
+        for (i = 0; i < 2; i++) {
+            if (pfds[i].fd < 0 || !(pfds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            if (used[i] == allocs[i]) {
+                char *nbuf;
+                allocs[i] *= 2;
+                nbuf = realloc (bufs[i], allocs[i]);
+                if (!nbuf)
+                    goto err;
+                bufs[i] = nbuf;
+            }
+            n = read (pfds[i].fd, bufs[i] + used[i], allocs[i] - used[i]);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                goto err;
+            }
+            if (n == 0) {
+                /* EOF, stop polling this stream (poll ignores negative fds) */
+                pfds[i].fd = -1;
+                n_open--;
+            } else
+                used[i] += n;
+        }
+    }
+
+    *out_data = bufs[0];
+    *out_len = used[0];
+    *err_data = bufs[1];
+    *err_len = used[1];
+    return TRUE;
+
+  err:
+    free (bufs[0]);
+    free (bufs[1]);
+    return FALSE;
+}
+
+/* main loop of a broker process; only plain libc is used here, the inherited
+   glib state is never touched again after the fork */
+static void broker_main (int fd) {
+    guint32 argc = 0;
+    guint32 len = 0;
+    guint32 i;
+    char **argv = NULL;
+    int out_pipe[2];
+    int err_pipe[2];
+    pid_t child;
+    int status = 0;
+    gint32 exit_code;
+    char *out_data = NULL;
+    char *err_data = NULL;
+    guint32 out_len = 0;
+    guint32 err_len = 0;
+
+    for (;;) {
+        if (!full_read (fd, &argc, sizeof argc) || argc == 0)
+            _exit (0);
+
+        argv = calloc (argc + 1, sizeof (char *));
+        if (!argv)
+            _exit (1);
+        for (i = 0; i < argc; i++) {
+            if (!full_read (fd, &len, sizeof len))
+                _exit (1);
+            argv[i] = malloc (len + 1);
+            if (!argv[i] || !full_read (fd, argv[i], len))
+                _exit (1);
+            argv[i][len] = '\0';
+        }
+
+        if (pipe (out_pipe) != 0 || pipe (err_pipe) != 0)
+            _exit (1);
+
+        child = fork ();
+        if (child < 0)
+            _exit (1);
+        if (child == 0) {
+            close (out_pipe[0]);
+            close (err_pipe[0]);
+            close (fd);
+            dup2 (out_pipe[1], STDOUT_FILENO);
+            dup2 (err_pipe[1], STDERR_FILENO);
+            close (out_pipe[1]);
+            close (err_pipe[1]);
+            putenv ((char *) "LC_ALL=C");
+            execvp (argv[0], argv);
+            _exit (127);
+        }
+        close (out_pipe[1]);
+        close (err_pipe[1]);
+
+        if (!broker_read_both_fds (out_pipe[0], err_pipe[0], &out_data, &out_len, &err_data, &err_len))
+            _exit (1);
+        close (out_pipe[0]);
+        close (err_pipe[0]);
+
+        while (waitpid (child, &status, 0) < 0 && errno == EINTR)
+            ;
+        if (WIFEXITED (status))
+            exit_code = WEXITSTATUS (status);
+        else
+            exit_code = -WTERMSIG (status);
+
+        if (!full_write (fd, &exit_code, sizeof exit_code) ||
+            !full_write (fd, &out_len, sizeof out_len) ||
+            !full_write (fd, out_data, out_len) ||
+            !full_write (fd, &err_len, sizeof err_len) ||
+            !full_write (fd, err_data, err_len))
+            _exit (1);
+
+        free (out_data);
+        free (err_data);
+        for (i = 0; i < argc; i++)
+            free (argv[i]);
+        free (argv);
+    }
+}
+
+/**
+ * bd_utils_exec_helper_pool_init:
+ * @size: number of broker processes to pre-fork (0 for the default of 2)
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Pre-forks a pool of small broker processes that spawn utilities on behalf of
+ * this process. With the pool active, the standard exec helpers route plain
+ * (no-progress) invocations through a broker, so frequent short utility calls
+ * do not pay the cost of fork()ing the full process image every time.
+ *
+ * This function should be called early, before the process grows large and
+ * before additional threads are created. Calling it when the pool is already
+ * initialized is an error.
+ *
+ * Returns: whether the helper pool was successfully initialized or not
+ */
+gboolean bd_utils_exec_helper_pool_init (guint size, GError **error) {
+    guint i;
+    int fds[2];
+    pid_t pid;
+
+    if (size == 0)
+        size = 2;
+
+    g_mutex_lock (&helper_pool_lock);
+    if (helper_pool_queue) {
+        g_mutex_unlock (&helper_pool_lock);
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "The exec helper pool is already initialized");
+        return FALSE;
+    }
+
+    helper_pool_procs = g_new0 (BrokerProc, size);
+    helper_pool_queue = g_async_queue_new ();
+
+    for (i = 0; i < size; i++) {
+        if (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Failed to create a socket pair for the helper pool: %m");
+            break;
+        }
+        pid = fork ();
+        if (pid < 0) {
+            close (fds[0]);
+            close (fds[1]);
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Failed to fork a broker process: %m");
+            break;
+        }
+        if (pid == 0) {
+            close (fds[0]);
+            broker_main (fds[1]);
+            /* not reached */
+            _exit (1);
+        }
+        close (fds[1]);
+        helper_pool_procs[i].pid = pid;
+        helper_pool_procs[i].fd = fds[0];
+        helper_pool_size++;
+        g_async_queue_push (helper_pool_queue, &helper_pool_procs[i]);
+    }
+
+    if (helper_pool_size != size) {
+        /* error is set above, tear down whatever was started */
+        g_mutex_unlock (&helper_pool_lock);
+        bd_utils_exec_helper_pool_shutdown ();
+        return FALSE;
+    }
+
+    g_mutex_unlock (&helper_pool_lock);
+    return TRUE;
+}
+
+/**
+ * bd_utils_exec_helper_pool_shutdown:
+ *
+ * Shuts the helper pool down (if active). In-flight invocations are finished
+ * first, subsequent exec calls fall back to direct spawning.
+ */
+void bd_utils_exec_helper_pool_shutdown (void) {
+    guint i;
+    guint32 zero = 0;
+
+    g_mutex_lock (&helper_pool_lock);
+    if (!helper_pool_queue) {
+        g_mutex_unlock (&helper_pool_lock);
+        return;
+    }
+
+    /* wait for all brokers to become free so nothing is in flight */
+    for (i = 0; i < helper_pool_size; i++)
+        g_async_queue_pop (helper_pool_queue);
+
+    for (i = 0; i < helper_pool_size; i++) {
+        full_write (helper_pool_procs[i].fd, &zero, sizeof zero);
+        close (helper_pool_procs[i].fd);
+        while (waitpid (helper_pool_procs[i].pid, NULL, 0) < 0 && errno == EINTR)
+            ;
+    }
+
+    g_async_queue_unref (helper_pool_queue);
+    helper_pool_queue = NULL;
+    g_free (helper_pool_procs);
+    helper_pool_procs = NULL;
+    helper_pool_size = 0;
+    g_mutex_unlock (&helper_pool_lock);
+}
+
+static gboolean helper_pool_active (void) {
+    gboolean ret;
+
+    g_mutex_lock (&helper_pool_lock);
+    ret = helper_pool_queue != NULL;
+    g_mutex_unlock (&helper_pool_lock);
+
+    return ret;
+}
+
+/* run @argv via a pooled broker process, blocking until a broker is free;
+   sets @used_pool to %FALSE (with no error set) when the pool was shut down
+   since the routing check -- the caller should fall back to spawning */
+static gboolean helper_pool_exec (const gchar **argv, gint *status, gchar **stdout_data, gchar **stderr_data, gboolean *used_pool, GError **error) {
+    GAsyncQueue *queue = NULL;
+    BrokerProc *proc = NULL;
+    const gchar **arg_p = NULL;
+    guint32 argc = 0;
+    guint32 len = 0;
+    gint32 exit_code = 0;
+    guint32 out_len = 0;
+    guint32 err_len = 0;
+    gboolean success = TRUE;
+
+    *used_pool = FALSE;
+    g_mutex_lock (&helper_pool_lock);
+    if (!helper_pool_queue) {
+        g_mutex_unlock (&helper_pool_lock);
+        return FALSE;
+    }
+    /* hold a reference on the queue so a concurrent shutdown cannot free it
+       under us; the broker we pop is pushed back before the shutdown's drain
+       loop can collect all of them, so the brokers stay alive for the whole
+       invocation too */
+    queue = g_async_queue_ref (helper_pool_queue);
+    g_mutex_unlock (&helper_pool_lock);
+    *used_pool = TRUE;
+
+    proc = g_async_queue_pop (queue);
+
+    for (arg_p=argv; *arg_p; arg_p++)
+        argc++;
+    success = full_write (proc->fd, &argc, sizeof argc);
+    for (arg_p=argv; success && *arg_p; arg_p++) {
+        len = strlen (*arg_p);
+        success = full_write (proc->fd, &len, sizeof len) &&
+                  full_write (proc->fd, *arg_p, len);
+    }
+
+    if (success)
+        success = full_read (proc->fd, &exit_code, sizeof exit_code) &&
+                  full_read (proc->fd, &out_len, sizeof out_len);
+    if (success) {
+        *stdout_data = g_new0 (gchar, out_len + 1);
+        success = full_read (proc->fd, *stdout_data, out_len) &&
+                  full_read (proc->fd, &err_len, sizeof err_len);
+    }
+    if (success) {
+        *stderr_data = g_new0 (gchar, err_len + 1);
+        success = full_read (proc->fd, *stderr_data, err_len);
+    }
+
+    g_async_queue_push (queue, proc);
+    g_async_queue_unref (queue);
+
+    if (!success) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Failed to communicate with the exec helper broker");
+        g_free (*stdout_data);
+        g_free (*stderr_data);
+        *stdout_data = NULL;
+        *stderr_data = NULL;
+        return FALSE;
+    }
+
+    if (exit_code < 0) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Process killed with a signal");
+        g_free (*stdout_data);
+        g_free (*stderr_data);
+        *stdout_data = NULL;
+        *stderr_data = NULL;
+        return FALSE;
+    }
+
+    *status = exit_code;
+    return TRUE;
+}
+
+/* cache of the compiled regexes, pattern -> GRegex */
+static GMutex regex_cache_lock;
+static GHashTable *regex_cache = NULL;
+
+/**
+ * bd_utils_get_regex:
+ * @pattern: pattern to get the compiled regex for
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Compiles @pattern (with default compile and match options) and caches the
+ * result for the lifetime of the process so that repeated users of the same
+ * pattern (output parsers are typically called in sweeps over many devices)
+ * don't pay for the compilation over and over. Matching against the returned
+ * regex is thread-safe.
+ *
+ * Returns: (transfer none): the compiled regex (owned by the cache, must not
+ *          be unreffed or modified) or %NULL in case of error
+ */
+GRegex* bd_utils_get_regex (const gchar *pattern, GError **error) {
+    GRegex *regex = NULL;
+
+    g_mutex_lock (&regex_cache_lock);
+    if (!regex_cache)
+        regex_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_regex_unref);
+    regex = g_hash_table_lookup (regex_cache, pattern);
+    if (!regex) {
+        regex = g_regex_new (pattern, 0, 0, error);
+        if (regex)
+            g_hash_table_insert (regex_cache, g_strdup (pattern), regex);
+    }
+    g_mutex_unlock (&regex_cache_lock);
+
+    return regex;
+}
+
+/**
+ * bd_utils_version_cmp:
+ * @ver_string1: first version string
+ * @ver_string2: second version string
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: -1, 0 or 1 if @ver_string1 is lower, the same or higher version as
+ *          @ver_string2 respectively. If an error occurs, returns -2 and @error
+ *          is set.
+ *
+ * **ONLY SUPPORTS VERSION STRINGS OF FORMAT X[.Y[.Z[.Z2[.Z3...[-R]]]]] where all components
+ *   are natural numbers!**
+ */
+gint bd_utils_version_cmp (const gchar *ver_string1, const gchar *ver_string2, GError **error) {
+    gchar **v1_fields = NULL;
+    gchar **v2_fields = NULL;
+    guint v1_fields_len = 0;
+    guint v2_fields_len = 0;
+    guint64 v1_value = 0;
+    guint64 v2_value = 0;
+    GRegex *regex = NULL;
+    gboolean success = FALSE;
+    gint ret = -2;
+
+    regex = bd_utils_get_regex ("^(\\d+)(\\.\\d+)*(-\\d)?$", error);
+    if (!regex) {
+        /* error is already populated */
+        return -2;
+    }
+
+    success = g_regex_match (regex, ver_string1, 0, NULL);
+    if (!success) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_VER,
+                     "Invalid or unsupported version (1) format: %s", ver_string1);
+        return -2;
+    }
+    success = g_regex_match (regex, ver_string2, 0, NULL);
+    if (!success) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_VER,
+                     "Invalid or unsupported version (2) format: %s", ver_string2);
+        return -2;
+    }
+
+    v1_fields = g_strsplit_set (ver_string1, ".-", 0);
+    v2_fields = g_strsplit_set (ver_string2, ".-", 0);
+    v1_fields_len = g_strv_length (v1_fields);
+    v2_fields_len = g_strv_length (v2_fields);
+
+    for (guint i=0; (i < v1_fields_len) && (i < v2_fields_len) && ret == -2; i++) {
+        v1_value = g_ascii_strtoull (v1_fields[i], NULL, 0);
+        v2_value = g_ascii_strtoull (v2_fields[i], NULL, 0);
+        if (v1_value < v2_value)
+            ret = -1;
+        else if (v1_value > v2_value)
+            ret = 1;
+    }
+
+    if (ret == -2) {
+        if (v1_fields_len < v2_fields_len)
+            ret = -1;
+        else if (v1_fields_len > v2_fields_len)
+            ret = 1;
+        else
+            ret = 0;
+    }
+
+    g_strfreev (v1_fields);
+    g_strfreev (v2_fields);
+
+    return ret;
+}
+
+/* on-disk cache of detected utility versions, keyed by the utility path with
+   mtime+size guarding staleness; saves spawning every tool with --version on
+   every (re)start of the calling process */
+static GKeyFile *util_version_cache = NULL;
+static gchar *util_version_cache_path = NULL;
+
+G_LOCK_DEFINE_STATIC (util_version_cache);
+
+/* must be called with the util_version_cache lock held */
+static void ensure_util_version_cache (void) {
+    if (util_version_cache)
+        return;
+
+    util_version_cache_path = g_build_filename (g_get_user_cache_dir (), "libblockdev", "util-versions", NULL);
+    util_version_cache = g_key_file_new ();
+    /* best effort, an empty cache is fine */
+    g_key_file_load_from_file (util_version_cache, util_version_cache_path, G_KEY_FILE_NONE, NULL);
+}
+
+static gchar* util_version_cache_lookup (const gchar *util_path, guint64 mtime, guint64 size) {
+    gchar *version = NULL;
+
+    G_LOCK (util_version_cache);
+    ensure_util_version_cache ();
+    if ((guint64) g_key_file_get_uint64 (util_version_cache, util_path, "mtime", NULL) == mtime &&
+        (guint64) g_key_file_get_uint64 (util_version_cache, util_path, "size", NULL) == size)
+        version = g_key_file_get_string (util_version_cache, util_path, "version", NULL);
+    G_UNLOCK (util_version_cache);
+
+    return version;
+}
+
+static void util_version_cache_store (const gchar *util_path, guint64 mtime, guint64 size, const gchar *version) {
+    gchar *cache_dir = NULL;
+
+    G_LOCK (util_version_cache);
+    ensure_util_version_cache ();
+    g_key_file_set_uint64 (util_version_cache, util_path, "mtime", mtime);
+    g_key_file_set_uint64 (util_version_cache, util_path, "size", size);
+    g_key_file_set_string (util_version_cache, util_path, "version", version);
+
+    /* persisting the cache is best effort only */
+    cache_dir = g_path_get_dirname (util_version_cache_path);
+    g_mkdir_with_parents (cache_dir, 0700);
+    g_free (cache_dir);
+    g_key_file_save_to_file (util_version_cache, util_version_cache_path, NULL);
+    G_UNLOCK (util_version_cache);
+}
+
+/**
+ * bd_utils_check_util_version:
+ * @util: name of the utility to check
+ * @version: (allow-none): minimum required version of the utility or %NULL
+ *           if no version is required
+ * @version_arg: (allow-none): argument to use with the @util to get version
+ *               info or %NULL to use "--version"
+ * @version_regexp: (allow-none): regexp to extract version from the version
+ *                  info or %NULL if only version is printed by "$ @util @version_arg"
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: whether the @util is available in a version >= @version or not
+ *          (@error is set in such case).
+ */
+gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, const gchar *version_arg, const gchar *version_regexp, GError **error) {
+    gchar *util_path = NULL;
+    const gchar *argv[] = {util, version_arg ? version_arg : "--version", NULL};
+    gchar *output = NULL;
+    gboolean succ = FALSE;
+    GRegex *regex = NULL;
+    GMatchInfo *match_info = NULL;
+    gchar *version_str = NULL;
+    GError *l_error = NULL;
+    GStatBuf statbuf;
+    gboolean have_stat = FALSE;
+
+    util_path = g_find_program_in_path (util);
+    if (!util_path) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_UNAVAILABLE,
+                     "The '%s' utility is not available", util);
+        return FALSE;
+    }
+
+    if (!version) {
+        /* nothing more to do here */
+        g_free (util_path);
+        return TRUE;
+    }
+
+    /* try the on-disk cache first -- the same unchanged binary reports the
+       same version, no need to execute it again */
+    have_stat = g_stat (util_path, &statbuf) == 0;
+    if (have_stat)
+        version_str = util_version_cache_lookup (util_path, (guint64) statbuf.st_mtime, (guint64) statbuf.st_size);
+    if (version_str) {
+        g_free (util_path);
+        if (bd_utils_version_cmp (version_str, version, &l_error) < 0) {
+            /* smaller version or error */
+            if (!l_error)
+                g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_LOW_VER,
+                             "Too low version of %s: %s. At least %s required.",
+                             util, version_str, version);
+            else
+                g_propagate_error (error, l_error);
+            g_free (version_str);
+            return FALSE;
+        }
+        g_free (version_str);
+        return TRUE;
+    }
+
+    succ = bd_utils_exec_and_capture_output (argv, NULL, &output, &l_error);
+    if (!succ) {
+        /* if we got nothing on STDOUT, try using STDERR data from error message */
+        if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
+            output = g_strdup (l_error->message);
+            g_clear_error (&l_error);
+        } else if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED)) {
             /* exit status != 0, try using the output anyway */
             output = g_strdup (l_error->message);
             g_clear_error (&l_error);
@@ -763,9 +2006,10 @@ gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, c
     }
 
     if (version_regexp) {
-        regex = g_regex_new (version_regexp, 0, 0, error);
+        regex = bd_utils_get_regex (version_regexp, error);
         if (!regex) {
             g_free (output);
+            g_free (util_path);
             /* error is already populated */
             return FALSE;
         }
@@ -775,11 +2019,10 @@ gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, c
             g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_UNKNOWN_VER,
                          "Failed to determine %s's version from: %s", util, output);
             g_free (output);
-            g_regex_unref (regex);
+            g_free (util_path);
             g_match_info_free (match_info);
             return FALSE;
         }
-        g_regex_unref (regex);
 
         version_str = g_match_info_fetch (match_info, 1);
         g_match_info_free (match_info);
@@ -792,11 +2035,16 @@ gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, c
                      "Failed to determine %s's version from: %s", util, output);
         g_free (version_str);
         g_free (output);
+        g_free (util_path);
         return FALSE;
     }
 
     g_free (output);
 
+    if (have_stat)
+        util_version_cache_store (util_path, (guint64) statbuf.st_mtime, (guint64) statbuf.st_size, version_str);
+    g_free (util_path);
+
     if (bd_utils_version_cmp (version_str, version, &l_error) < 0) {
         /* smaller version or error */
         if (!l_error)
@@ -848,6 +2096,115 @@ gboolean bd_utils_init_prog_reporting_thread (BDUtilsProgFunc new_prog_func, GEr
     return TRUE;
 }
 
+/**
+ * bd_utils_init_prog_reporting_context:
+ * @new_prog_func: (allow-none) (scope notified): progress reporting function to
+ *                                                use on current thread or %NULL
+ *                                                to reset to default or global
+ * @user_data: user data to pass to @new_prog_func with every report
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Like bd_utils_init_prog_reporting_thread() except that @new_prog_func also
+ * gets @user_data with every report. This makes it possible to give each
+ * worker thread its own progress context (e.g. the operation or request the
+ * thread is processing) so that concurrent operations don't have to
+ * demultiplex the events of a shared global callback by task ID. Both the
+ * function and the data are thread-local, there is no synchronization on the
+ * reporting path. Takes precedence over callbacks set up with
+ * bd_utils_init_prog_reporting_thread() and bd_utils_init_prog_reporting().
+ *
+ * Returns: whether progress reporting was successfully initialized or not
+ */
+gboolean bd_utils_init_prog_reporting_context (BDUtilsProgContextFunc new_prog_func, gpointer user_data, GError **error __attribute__((unused))) {
+    /* XXX: the error attribute will likely be used in the future when this
+       function gets more complicated */
+
+    thread_prog_context_func = new_prog_func;
+    thread_prog_context_data = new_prog_func ? user_data : NULL;
+
+    return TRUE;
+}
+
+/* one queued progress report */
+typedef struct ProgReportMsg {
+    guint64 task_id;
+    BDUtilsProgStatus status;
+    guint8 completion;
+    gchar *msg;
+} ProgReportMsg;
+
+static GAsyncQueue *prog_report_queue = NULL;
+static GThread *prog_report_thread = NULL;
+static BDUtilsProgFunc prog_report_async_func = NULL;
+static ProgReportMsg prog_report_stop_msg;
+
+static gpointer prog_report_thread_func (gpointer data __attribute__((unused))) {
+    ProgReportMsg *report = NULL;
+
+    while ((report = g_async_queue_pop (prog_report_queue)) != &prog_report_stop_msg) {
+        prog_report_async_func (report->task_id, report->status, report->completion, report->msg);
+        g_free (report->msg);
+        g_free (report);
+    }
+
+    return NULL;
+}
+
+/* trampoline installed as the progress reporting function in async mode; the
+   operation threads only pay for the enqueue, the (potentially slow) client
+   callback runs on the dedicated reporting thread */
+static void prog_report_enqueue (guint64 task_id, BDUtilsProgStatus status, guint8 completion, gchar *msg) {
+    ProgReportMsg *report = g_new0 (ProgReportMsg, 1);
+
+    report->task_id = task_id;
+    report->status = status;
+    report->completion = completion;
+    report->msg = g_strdup (msg);
+    g_async_queue_push (prog_report_queue, report);
+}
+
+/**
+ * bd_utils_init_prog_reporting_async:
+ * @new_prog_func: (allow-none) (scope notified): progress reporting function to
+ *                                                run on a dedicated reporting
+ *                                                thread or %NULL to shut the
+ *                                                thread down and reset to
+ *                                                default
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Like bd_utils_init_prog_reporting() except that @new_prog_func is invoked
+ * from a single dedicated reporting thread fed by a queue instead of being
+ * called directly from the operation threads. With many concurrent operations
+ * this keeps the cost of a progress tick on the operation path down to an
+ * enqueue, no matter how slow the client callback is. Reports from one task
+ * are delivered in order; the %BDUtilsProgFunc contract is unchanged.
+ *
+ * Returns: whether asynchronous progress reporting was successfully
+ *          initialized or not
+ */
+gboolean bd_utils_init_prog_reporting_async (BDUtilsProgFunc new_prog_func, GError **error __attribute__((unused))) {
+    if (prog_report_thread) {
+        /* shut the previous reporting thread down first */
+        g_async_queue_push (prog_report_queue, &prog_report_stop_msg);
+        g_thread_join (prog_report_thread);
+        prog_report_thread = NULL;
+        g_async_queue_unref (prog_report_queue);
+        prog_report_queue = NULL;
+        prog_report_async_func = NULL;
+        prog_func = NULL;
+    }
+
+    if (!new_prog_func)
+        return TRUE;
+
+    prog_report_async_func = new_prog_func;
+    prog_report_queue = g_async_queue_new ();
+    prog_report_thread = g_thread_new ("prog-report", prog_report_thread_func, NULL);
+    prog_func = prog_report_enqueue;
+
+    return TRUE;
+}
+
 static void thread_progress_muted (guint64 task_id __attribute__((unused)), BDUtilsProgStatus status __attribute__((unused)), guint8 completion __attribute__((unused)), gchar *msg __attribute__((unused))) {
     /* This function serves as a special value for the progress reporting
      * function to detect that nothing is done here. If clients use their own
@@ -868,6 +2225,27 @@ gboolean bd_utils_mute_prog_reporting_thread (GError **error __attribute__((unus
        function gets more complicated */
 
     thread_prog_func = thread_progress_muted;
+    thread_prog_context_func = NULL;
+    thread_prog_context_data = NULL;
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_unmute_prog_reporting_thread:
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Undoes a previous bd_utils_mute_prog_reporting_thread() call, making the
+ * current thread report progress through the global reporting function (if
+ * any) again.
+ *
+ * Returns: whether progress reporting for the current thread was successfully
+ * unmuted or not
+ */
+gboolean bd_utils_unmute_prog_reporting_thread (GError **error __attribute__((unused))) {
+    thread_prog_func = NULL;
+    thread_prog_context_func = NULL;
+    thread_prog_context_data = NULL;
 
     return TRUE;
 }
@@ -881,6 +2259,8 @@ gboolean bd_utils_mute_prog_reporting_thread (GError **error __attribute__((unus
  * bd_utils_mute_prog_reporting_thread was used to mute the thread.
  */
 gboolean bd_utils_prog_reporting_initialized (void) {
+    if (thread_prog_context_func != NULL)
+        return TRUE;
     return (thread_prog_func != NULL || prog_func != NULL) && thread_prog_func != thread_progress_muted;
 }
 
@@ -896,12 +2276,12 @@ guint64 bd_utils_report_started (const gchar *msg) {
 
     current_prog_func = thread_prog_func != NULL ? thread_prog_func : prog_func;
 
-    g_mutex_lock (&task_id_counter_lock);
-    task_id_counter++;
-    task_id = task_id_counter;
-    g_mutex_unlock (&task_id_counter_lock);
+    task_id = __atomic_add_fetch (&task_id_counter, 1, __ATOMIC_RELAXED);
 
-    if (current_prog_func)
+    BD_TRACE (progress_started, task_id, msg);
+    if (thread_prog_context_func)
+        thread_prog_context_func (task_id, BD_UTILS_PROG_STARTED, 0, (gchar *)msg, thread_prog_context_data);
+    else if (current_prog_func)
         current_prog_func (task_id, BD_UTILS_PROG_STARTED, 0, (gchar *)msg);
     return task_id;
 }
@@ -915,8 +2295,11 @@ guint64 bd_utils_report_started (const gchar *msg) {
 void bd_utils_report_progress (guint64 task_id, guint64 completion, const gchar *msg) {
     BDUtilsProgFunc current_prog_func;
 
+    BD_TRACE (progress, task_id, completion);
     current_prog_func = thread_prog_func != NULL ? thread_prog_func : prog_func;
-    if (current_prog_func)
+    if (thread_prog_context_func)
+        thread_prog_context_func (task_id, BD_UTILS_PROG_PROGRESS, completion, (gchar *)msg, thread_prog_context_data);
+    else if (current_prog_func)
         current_prog_func (task_id, BD_UTILS_PROG_PROGRESS, completion, (gchar *)msg);
 }
 
@@ -928,8 +2311,11 @@ void bd_utils_report_progress (guint64 task_id, guint64 completion, const gchar
 void bd_utils_report_finished (guint64 task_id, const gchar *msg) {
     BDUtilsProgFunc current_prog_func;
 
+    BD_TRACE (progress_finished, task_id, msg);
     current_prog_func = thread_prog_func != NULL ? thread_prog_func : prog_func;
-    if (current_prog_func)
+    if (thread_prog_context_func)
+        thread_prog_context_func (task_id, BD_UTILS_PROG_FINISHED, 100, (gchar *)msg, thread_prog_context_data);
+    else if (current_prog_func)
         current_prog_func (task_id, BD_UTILS_PROG_FINISHED, 100, (gchar *)msg);
 }
 
@@ -1,4 +1,5 @@
 #include <glib.h>
+#include <gio/gio.h>
 #include "extra_arg.h"
 
 #ifndef BD_UTILS_EXEC
@@ -19,6 +20,16 @@ typedef enum {
  */
 typedef void (*BDUtilsProgFunc) (guint64 task_id, BDUtilsProgStatus status, guint8 completion, gchar *msg);
 
+/**
+ * BDUtilsProgContextFunc:
+ * @task_id: ID of the task/action the progress is reported for
+ * @status: progress status
+ * @completion: percentage of completion
+ * @msg: (allow-none): arbitrary progress message (for the user)
+ * @user_data: user data passed to bd_utils_init_prog_reporting_context()
+ */
+typedef void (*BDUtilsProgContextFunc) (guint64 task_id, BDUtilsProgStatus status, guint8 completion, gchar *msg, gpointer user_data);
+
 /**
  * BDUtilsProgExtract:
  * @line: line to extract progress from
@@ -60,6 +71,8 @@ typedef enum {
     BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR,
     BD_UTILS_EXEC_ERROR_UTIL_FEATURE_CHECK_ERROR,
     BD_UTILS_EXEC_ERROR_UTIL_FEATURE_UNAVAILABLE,
+    BD_UTILS_EXEC_ERROR_CANCELLED,
+    BD_UTILS_EXEC_ERROR_TIMED_OUT,
 } BDUtilsExecError;
 
 gboolean bd_utils_exec_and_report_error (const gchar **argv, const BDExtraArg **extra, GError **error);
@@ -67,13 +80,39 @@ gboolean bd_utils_exec_and_report_error_no_progress (const gchar **argv, const B
 gboolean bd_utils_exec_and_report_status_error (const gchar **argv, const BDExtraArg **extra, gint *status, GError **error);
 gboolean bd_utils_exec_and_capture_output (const gchar **argv, const BDExtraArg **extra, gchar **output, GError **error);
 gboolean bd_utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, gint *proc_status, GError **error);
+gboolean bd_utils_exec_and_report_progress_cancellable (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, guint timeout_msec, GCancellable *cancellable, gint *proc_status, GError **error);
+gboolean bd_utils_exec_and_capture_output_cancellable (const gchar **argv, const BDExtraArg **extra, guint timeout_msec, GCancellable *cancellable, gchar **output, GError **error);
 gboolean bd_utils_exec_with_input (const gchar **argv, const gchar *input, const BDExtraArg **extra, GError **error);
+
+/**
+ * BDUtilsExecIter:
+ *
+ * Opaque iterator over a running utility's standard output. See
+ * bd_utils_exec_iterate_start().
+ */
+typedef struct _BDUtilsExecIter BDUtilsExecIter;
+
+BDUtilsExecIter* bd_utils_exec_iterate_start (const gchar **argv, const BDExtraArg **extra, GError **error);
+const gchar* bd_utils_exec_iterate_next (BDUtilsExecIter *iter, GError **error);
+gboolean bd_utils_exec_iterate_finish (BDUtilsExecIter *iter, gint *status, GError **error);
+void bd_utils_exec_and_report_progress_async (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+gboolean bd_utils_exec_and_report_progress_finish (GAsyncResult *result, gint *proc_status, GError **error);
+void bd_utils_exec_and_capture_output_async (const gchar **argv, const BDExtraArg **extra, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+gboolean bd_utils_exec_and_capture_output_finish (GAsyncResult *result, gchar **output, GError **error);
+gboolean bd_utils_exec_batch (const gchar ***argvs, guint count, guint max_parallel, const BDExtraArg **extra, gint *statuses, GError **item_errors, GError **error);
+void bd_utils_exec_set_posix_spawn (gboolean enabled);
+gboolean bd_utils_exec_helper_pool_init (guint size, GError **error);
+void bd_utils_exec_helper_pool_shutdown (void);
+GRegex* bd_utils_get_regex (const gchar *pattern, GError **error);
 gint bd_utils_version_cmp (const gchar *ver_string1, const gchar *ver_string2, GError **error);
 gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, const gchar *version_arg, const gchar *version_regexp, GError **error);
 
 gboolean bd_utils_init_prog_reporting (BDUtilsProgFunc new_prog_func, GError **error);
 gboolean bd_utils_init_prog_reporting_thread (BDUtilsProgFunc new_prog_func, GError **error);
+gboolean bd_utils_init_prog_reporting_context (BDUtilsProgContextFunc new_prog_func, gpointer user_data, GError **error);
+gboolean bd_utils_init_prog_reporting_async (BDUtilsProgFunc new_prog_func, GError **error);
 gboolean bd_utils_mute_prog_reporting_thread (GError **error);
+gboolean bd_utils_unmute_prog_reporting_thread (GError **error);
 gboolean bd_utils_prog_reporting_initialized (void);
 guint64 bd_utils_report_started (const gchar *msg);
 void bd_utils_report_progress (guint64 task_id, guint64 completion, const gchar *msg);
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2026  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "jobs.h"
+#include "logging.h"
+
+/**
+ * SECTION: jobs
+ * @short_description: dependency-aware job scheduler
+ * @title: Jobs
+ * @include: jobs.h
+ *
+ * Building a storage stack (partition -> LUKS format -> PV -> VG -> LV ->
+ * mkfs) across many disks is a DAG of operations, most of which are
+ * independent of each other. The job scheduler lets callers submit such
+ * operations with declared dependencies and then run the whole graph with a
+ * worker pool that executes independent branches concurrently, instead of
+ * serializing everything or hand-rolling threading around the blocking
+ * libblockdev calls.
+ *
+ * Jobs may only depend on previously added jobs, so the graph is acyclic by
+ * construction. When a job fails, everything that (transitively) depends on
+ * it is skipped; independent branches still run to completion. The scheduler
+ * is single-shot: it can be run once and queried for per-job results
+ * afterwards.
+ *
+ * The scheduler itself is not thread-safe: adding jobs, running the graph and
+ * querying results are expected to happen from one (controlling) thread, only
+ * the jobs themselves run concurrently.
+ */
+
+typedef enum {
+    JOB_PENDING,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_FAILED,
+    JOB_SKIPPED,
+} JobState;
+
+typedef struct BDUtilsJob {
+    guint64 id;
+    BDUtilsJobFunc func;
+    gpointer user_data;
+    GPtrArray *dependents;    /* BDUtilsJob* (unowned) */
+    guint n_unmet;            /* not-yet-finished direct dependencies */
+    JobState state;
+    GError *error;
+} BDUtilsJob;
+
+struct BDUtilsJobScheduler {
+    GMutex lock;
+    GCond cond;
+    GHashTable *jobs;         /* id -> BDUtilsJob* (owned) */
+    GPtrArray *order;         /* BDUtilsJob* in submission order (unowned) */
+    guint64 next_id;
+    guint n_workers;
+    guint n_unfinished;
+    gboolean ran;
+    GThreadPool *pool;
+};
+
+/**
+ * bd_utils_jobs_error_quark: (skip)
+ */
+GQuark bd_utils_jobs_error_quark (void) {
+    return g_quark_from_static_string ("g-bd-utils-jobs-error-quark");
+}
+
+static void job_free (gpointer data) {
+    BDUtilsJob *job = data;
+
+    g_ptr_array_free (job->dependents, TRUE);
+    if (job->error)
+        g_error_free (job->error);
+    g_free (job);
+}
+
+/**
+ * bd_utils_job_scheduler_new:
+ * @n_workers: maximum number of jobs to run concurrently or 0 to use the
+ *             number of available processors
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: (transfer full): a new job scheduler to be freed with
+ *          bd_utils_job_scheduler_free() or %NULL in case of error
+ */
+BDUtilsJobScheduler* bd_utils_job_scheduler_new (guint n_workers, GError **error __attribute__((unused))) {
+    BDUtilsJobScheduler *scheduler = NULL;
+
+    scheduler = g_new0 (BDUtilsJobScheduler, 1);
+    g_mutex_init (&scheduler->lock);
+    g_cond_init (&scheduler->cond);
+    scheduler->jobs = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, job_free);
+    scheduler->order = g_ptr_array_new ();
+    scheduler->next_id = 1;
+    scheduler->n_workers = n_workers > 0 ? n_workers : g_get_num_processors ();
+
+    return scheduler;
+}
+
+/**
+ * bd_utils_job_scheduler_add:
+ * @scheduler: scheduler to add the job to
+ * @func: (scope notified): function to run for the job
+ * @user_data: (allow-none): data to pass to @func
+ * @deps: (allow-none) (array length=n_deps): IDs of previously added jobs
+ *        this job depends on
+ * @n_deps: number of IDs in @deps
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Adds a job to the graph. The job only becomes runnable once all the jobs in
+ * @deps finished successfully; if any of them fails (or is skipped), the job
+ * is skipped too. Since dependencies have to be already existing jobs, no
+ * cycles can be constructed.
+ *
+ * Returns: a non-zero ID of the job (to be used as a dependency of later jobs
+ *          and with bd_utils_job_scheduler_get_result()) or 0 in case of
+ *          error
+ */
+guint64 bd_utils_job_scheduler_add (BDUtilsJobScheduler *scheduler, BDUtilsJobFunc func, gpointer user_data, const guint64 *deps, guint n_deps, GError **error) {
+    BDUtilsJob *job = NULL;
+    BDUtilsJob *dep = NULL;
+    guint64 *key = NULL;
+    guint i = 0;
+
+    if (scheduler->ran) {
+        g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_FAILED,
+                     "The scheduler has already been run, no more jobs can be added");
+        return 0;
+    }
+
+    /* validate the dependencies first so that an error leaves the graph untouched */
+    for (i = 0; i < n_deps; i++) {
+        if (!g_hash_table_lookup (scheduler->jobs, &deps[i])) {
+            g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_INVALID_DEPENDENCY,
+                         "No job with the ID %"G_GUINT64_FORMAT" to depend on", deps[i]);
+            return 0;
+        }
+    }
+
+    job = g_new0 (BDUtilsJob, 1);
+    job->id = scheduler->next_id++;
+    job->func = func;
+    job->user_data = user_data;
+    job->dependents = g_ptr_array_new ();
+    job->n_unmet = n_deps;
+    job->state = JOB_PENDING;
+
+    for (i = 0; i < n_deps; i++) {
+        dep = g_hash_table_lookup (scheduler->jobs, &deps[i]);
+        g_ptr_array_add (dep->dependents, job);
+    }
+
+    key = g_new (guint64, 1);
+    *key = job->id;
+    g_hash_table_insert (scheduler->jobs, key, job);
+    g_ptr_array_add (scheduler->order, job);
+
+    return job->id;
+}
+
+/* mark everything that (transitively) depends on @job as skipped; runs with
+   the scheduler's lock held */
+static void skip_dependents (BDUtilsJobScheduler *scheduler, BDUtilsJob *job) {
+    BDUtilsJob *dependent = NULL;
+    guint i = 0;
+
+    for (i = 0; i < job->dependents->len; i++) {
+        dependent = g_ptr_array_index (job->dependents, i);
+        if (dependent->state == JOB_PENDING) {
+            dependent->state = JOB_SKIPPED;
+            scheduler->n_unfinished--;
+            skip_dependents (scheduler, dependent);
+        }
+    }
+}
+
+static void job_worker (gpointer data, gpointer pool_data) {
+    BDUtilsJob *job = data;
+    BDUtilsJobScheduler *scheduler = pool_data;
+    BDUtilsJob *dependent = NULL;
+    gboolean success = FALSE;
+    GError *l_error = NULL;
+    guint i = 0;
+
+    success = job->func (job->user_data, &l_error);
+
+    g_mutex_lock (&scheduler->lock);
+    if (success) {
+        job->state = JOB_DONE;
+        for (i = 0; i < job->dependents->len; i++) {
+            dependent = g_ptr_array_index (job->dependents, i);
+            dependent->n_unmet--;
+            if (dependent->n_unmet == 0 && dependent->state == JOB_PENDING) {
+                dependent->state = JOB_RUNNING;
+                g_thread_pool_push (scheduler->pool, dependent, NULL);
+            }
+        }
+    } else {
+        job->state = JOB_FAILED;
+        job->error = l_error;
+        bd_utils_log_format (BD_UTILS_LOG_WARNING,
+                             "jobs: job %"G_GUINT64_FORMAT" failed, skipping its dependents: %s",
+                             job->id, l_error ? l_error->message : "(unknown error)");
+        skip_dependents (scheduler, job);
+    }
+    scheduler->n_unfinished--;
+    g_cond_signal (&scheduler->cond);
+    g_mutex_unlock (&scheduler->lock);
+}
+
+/**
+ * bd_utils_job_scheduler_run:
+ * @scheduler: scheduler to run
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Runs all the added jobs respecting their dependencies, executing
+ * independent jobs concurrently on up to the scheduler's number of worker
+ * threads. Blocks until every job either finished, failed or was skipped
+ * because of a failed dependency. Per-job results can be queried with
+ * bd_utils_job_scheduler_get_result() afterwards.
+ *
+ * Returns: whether all the jobs finished successfully or not (with @error
+ *          set to the first failure in submission order)
+ */
+gboolean bd_utils_job_scheduler_run (BDUtilsJobScheduler *scheduler, GError **error) {
+    BDUtilsJob *job = NULL;
+    guint i = 0;
+
+    if (scheduler->ran) {
+        g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_FAILED,
+                     "The scheduler has already been run");
+        return FALSE;
+    }
+    scheduler->ran = TRUE;
+
+    if (scheduler->order->len == 0)
+        return TRUE;
+
+    scheduler->pool = g_thread_pool_new (job_worker, scheduler, scheduler->n_workers, FALSE, error);
+    if (!scheduler->pool) {
+        g_prefix_error (error, "Failed to create the worker pool: ");
+        return FALSE;
+    }
+
+    g_mutex_lock (&scheduler->lock);
+    scheduler->n_unfinished = scheduler->order->len;
+    for (i = 0; i < scheduler->order->len; i++) {
+        job = g_ptr_array_index (scheduler->order, i);
+        if (job->n_unmet == 0) {
+            job->state = JOB_RUNNING;
+            g_thread_pool_push (scheduler->pool, job, NULL);
+        }
+    }
+    while (scheduler->n_unfinished > 0)
+        g_cond_wait (&scheduler->cond, &scheduler->lock);
+    g_mutex_unlock (&scheduler->lock);
+
+    g_thread_pool_free (scheduler->pool, FALSE, TRUE);
+    scheduler->pool = NULL;
+
+    for (i = 0; i < scheduler->order->len; i++) {
+        job = g_ptr_array_index (scheduler->order, i);
+        if (job->state != JOB_DONE) {
+            if (job->state == JOB_FAILED && job->error)
+                g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_FAILED,
+                             "Job %"G_GUINT64_FORMAT" failed: %s", job->id, job->error->message);
+            else
+                g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_FAILED,
+                             "Job %"G_GUINT64_FORMAT" didn't finish successfully", job->id);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_job_scheduler_get_result:
+ * @scheduler: scheduler the job was run by
+ * @job_id: ID of the job (as returned by bd_utils_job_scheduler_add())
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Returns: whether the job finished successfully or not (with @error set to
+ *          the job's own error, to %BD_UTILS_JOBS_ERROR_SKIPPED if the job
+ *          was skipped because of a failed dependency or to
+ *          %BD_UTILS_JOBS_ERROR_NOT_RUN if the scheduler wasn't run)
+ */
+gboolean bd_utils_job_scheduler_get_result (BDUtilsJobScheduler *scheduler, guint64 job_id, GError **error) {
+    BDUtilsJob *job = NULL;
+
+    job = g_hash_table_lookup (scheduler->jobs, &job_id);
+    if (!job) {
+        g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_FAILED,
+                     "No job with the ID %"G_GUINT64_FORMAT, job_id);
+        return FALSE;
+    }
+
+    switch (job->state) {
+        case JOB_DONE:
+            return TRUE;
+        case JOB_FAILED:
+            if (job->error)
+                g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_FAILED,
+                             "%s", job->error->message);
+            else
+                g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_FAILED,
+                             "The job failed");
+            return FALSE;
+        case JOB_SKIPPED:
+            g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_SKIPPED,
+                         "The job was skipped because one of its dependencies failed");
+            return FALSE;
+        default:
+            g_set_error (error, BD_UTILS_JOBS_ERROR, BD_UTILS_JOBS_ERROR_NOT_RUN,
+                         "The job hasn't been run");
+            return FALSE;
+    }
+}
+
+/**
+ * bd_utils_job_scheduler_free:
+ * @scheduler: (allow-none): scheduler to free or %NULL
+ *
+ * Frees the scheduler and all its jobs. Must not be called while
+ * bd_utils_job_scheduler_run() is in progress.
+ */
+void bd_utils_job_scheduler_free (BDUtilsJobScheduler *scheduler) {
+    if (!scheduler)
+        return;
+
+    g_ptr_array_free (scheduler->order, TRUE);
+    g_hash_table_destroy (scheduler->jobs);
+    g_cond_clear (&scheduler->cond);
+    g_mutex_clear (&scheduler->lock);
+    g_free (scheduler);
+}
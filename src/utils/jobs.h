@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2026  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_UTILS_JOBS
+#define BD_UTILS_JOBS
+
+GQuark bd_utils_jobs_error_quark (void);
+#define BD_UTILS_JOBS_ERROR bd_utils_jobs_error_quark ()
+
+typedef enum {
+    BD_UTILS_JOBS_ERROR_FAILED,
+    BD_UTILS_JOBS_ERROR_INVALID_DEPENDENCY,
+    BD_UTILS_JOBS_ERROR_SKIPPED,
+    BD_UTILS_JOBS_ERROR_NOT_RUN,
+} BDUtilsJobsError;
+
+/**
+ * BDUtilsJobFunc:
+ * @user_data: data passed to bd_utils_job_scheduler_add() for the job
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Function type for a single job run by a #BDUtilsJobScheduler. Runs on one
+ * of the scheduler's worker threads.
+ *
+ * Returns: whether the job succeeded or not (with @error set)
+ */
+typedef gboolean (*BDUtilsJobFunc) (gpointer user_data, GError **error);
+
+typedef struct BDUtilsJobScheduler BDUtilsJobScheduler;
+
+BDUtilsJobScheduler* bd_utils_job_scheduler_new (guint n_workers, GError **error);
+guint64 bd_utils_job_scheduler_add (BDUtilsJobScheduler *scheduler, BDUtilsJobFunc func, gpointer user_data, const guint64 *deps, guint n_deps, GError **error);
+gboolean bd_utils_job_scheduler_run (BDUtilsJobScheduler *scheduler, GError **error);
+gboolean bd_utils_job_scheduler_get_result (BDUtilsJobScheduler *scheduler, guint64 job_id, GError **error);
+void bd_utils_job_scheduler_free (BDUtilsJobScheduler *scheduler);
+
+#endif  /* BD_UTILS_JOBS */
@@ -26,6 +26,40 @@
 static BDUtilsLogFunc log_func = &bd_utils_log_stdout;
 static int log_level = BD_UTILS_LOG_WARNING;
 
+/* one queued log message */
+typedef struct LogMsg {
+    gint level;
+    gchar *msg;
+} LogMsg;
+
+static GAsyncQueue *log_queue = NULL;
+static GThread *log_thread = NULL;
+static BDUtilsLogFunc log_async_func = NULL;
+static LogMsg log_stop_msg;
+
+static gpointer log_thread_func (gpointer data __attribute__((unused))) {
+    LogMsg *item = NULL;
+
+    while ((item = g_async_queue_pop (log_queue)) != &log_stop_msg) {
+        log_async_func (item->level, item->msg);
+        g_free (item->msg);
+        g_free (item);
+    }
+
+    return NULL;
+}
+
+/* trampoline installed as the logging function in async mode; callers on the
+   operation path only pay for the enqueue, the real logging function runs on
+   the flush thread */
+static void log_enqueue (gint level, const gchar *msg) {
+    LogMsg *item = g_new0 (LogMsg, 1);
+
+    item->level = level;
+    item->msg = g_strdup (msg);
+    g_async_queue_push (log_queue, item);
+}
+
 /**
  * bd_utils_init_logging:
  * @new_log_func: (allow-none) (scope notified): logging function to use or
@@ -45,6 +79,51 @@ gboolean bd_utils_init_logging (BDUtilsLogFunc new_log_func, GError **error __at
     return TRUE;
 }
 
+/**
+ * bd_utils_init_logging_async:
+ * @new_log_func: (allow-none) (scope notified): logging function to run on a
+ *                                               dedicated flush thread or
+ *                                               %NULL to shut the thread down
+ *                                               and reset to the default
+ *                                               (synchronous) behaviour
+ * @error: (out) (allow-none): place to store error (if any)
+ *
+ * Like bd_utils_init_logging() except that @new_log_func is invoked from a
+ * single dedicated flush thread fed by a queue instead of being called inline
+ * on the operation path. Level filtering (see bd_utils_set_log_level()) and
+ * the lazy formatting done by bd_utils_log_format() happen before the
+ * enqueue, so dropped messages cost nothing and kept ones cost one allocation
+ * plus an enqueue.
+ *
+ * Note that messages may still be in flight on the flush thread when this or
+ * any other operation returns; shut the mode down (by passing %NULL) to make
+ * sure everything was flushed.
+ *
+ * Returns: whether asynchronous logging was successfully initialized or not
+ */
+gboolean bd_utils_init_logging_async (BDUtilsLogFunc new_log_func, GError **error __attribute__((unused))) {
+    if (log_thread) {
+        /* shut the previous flush thread down first (flushes the queue) */
+        g_async_queue_push (log_queue, &log_stop_msg);
+        g_thread_join (log_thread);
+        log_thread = NULL;
+        g_async_queue_unref (log_queue);
+        log_queue = NULL;
+        log_async_func = NULL;
+        log_func = &bd_utils_log_stdout;
+    }
+
+    if (!new_log_func)
+        return TRUE;
+
+    log_async_func = new_log_func;
+    log_queue = g_async_queue_new ();
+    log_thread = g_thread_new ("bd-logging", log_thread_func, NULL);
+    log_func = log_enqueue;
+
+    return TRUE;
+}
+
 /**
  * bd_utils_set_log_level:
  * @level: log level
@@ -61,6 +140,19 @@ void bd_utils_set_log_level (gint level) {
     log_level = level;
 }
 
+/**
+ * bd_utils_log_would_log:
+ * @level: log level
+ *
+ * Returns: whether a message logged with @level would currently be emitted
+ * (i.e. a logging function is installed and @level passes the level filter,
+ * see bd_utils_set_log_level()) or not. Useful to skip expensive construction
+ * of log messages that would just be thrown away.
+ */
+gboolean bd_utils_log_would_log (gint level) {
+    return log_func && level <= log_level;
+}
+
 /**
  * bd_utils_log:
  * @level: log level
@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2026  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "metrics.h"
+
+/* Always-on metrics of the library's activity. To keep the hot path cheap the
+ * counters are accumulated in per-thread slots -- a thread only ever writes to
+ * its own slot so no locking is needed for the updates, the global lock below
+ * is only taken when a thread records its first call of a function (a new
+ * slot is inserted into the thread's table), when a thread exits (its slot is
+ * merged into the 'retired' aggregate) and when the metrics are read or
+ * reset. */
+
+/* per-function counters in a thread's slot; @plugin and @func are static
+   strings owned by the callers */
+typedef struct FuncSlot {
+    const gchar *plugin;
+    const gchar *func;
+    guint64 calls;
+    guint64 total_usec;
+    guint64 max_usec;
+} FuncSlot;
+
+typedef struct ThreadMetrics {
+    GHashTable *funcs;          /* function name -> FuncSlot */
+    guint64 spawns;
+    guint64 child_cpu_usec;
+} ThreadMetrics;
+
+static void retire_thread_metrics (gpointer data);
+
+/* protects 'thread_slots', 'retired' and the insertions into the live
+   threads' tables */
+static GMutex metrics_lock;
+static GSList *thread_slots = NULL;
+static ThreadMetrics retired = {NULL, 0, 0};
+static GPrivate thread_metrics_key = G_PRIVATE_INIT (retire_thread_metrics);
+
+static ThreadMetrics* get_thread_metrics (void) {
+    ThreadMetrics *metrics = g_private_get (&thread_metrics_key);
+
+    if (G_LIKELY (metrics))
+        return metrics;
+
+    metrics = g_new0 (ThreadMetrics, 1);
+    metrics->funcs = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+    g_private_set (&thread_metrics_key, metrics);
+
+    g_mutex_lock (&metrics_lock);
+    thread_slots = g_slist_prepend (thread_slots, metrics);
+    g_mutex_unlock (&metrics_lock);
+
+    return metrics;
+}
+
+/* add @slot's counters (read atomically, the owning thread may be updating
+   them) to the matching slot in @table, creating it if needed */
+static void merge_func_slot (GHashTable *table, FuncSlot *slot) {
+    FuncSlot *dest = g_hash_table_lookup (table, slot->func);
+    guint64 max_usec = 0;
+
+    if (!dest) {
+        dest = g_new0 (FuncSlot, 1);
+        dest->plugin = slot->plugin;
+        dest->func = slot->func;
+        g_hash_table_insert (table, (gpointer) dest->func, dest);
+    }
+
+    dest->calls += __atomic_load_n (&slot->calls, __ATOMIC_RELAXED);
+    dest->total_usec += __atomic_load_n (&slot->total_usec, __ATOMIC_RELAXED);
+    max_usec = __atomic_load_n (&slot->max_usec, __ATOMIC_RELAXED);
+    if (max_usec > dest->max_usec)
+        dest->max_usec = max_usec;
+}
+
+/* destructor of the per-thread slots -- merge the thread's counters into the
+   'retired' aggregate so that they survive the thread */
+static void retire_thread_metrics (gpointer data) {
+    ThreadMetrics *metrics = (ThreadMetrics *) data;
+    GHashTableIter iter;
+    gpointer value = NULL;
+
+    g_mutex_lock (&metrics_lock);
+    thread_slots = g_slist_remove (thread_slots, metrics);
+    if (!retired.funcs)
+        retired.funcs = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+    g_hash_table_iter_init (&iter, metrics->funcs);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+        merge_func_slot (retired.funcs, (FuncSlot *) value);
+    retired.spawns += metrics->spawns;
+    retired.child_cpu_usec += metrics->child_cpu_usec;
+    g_mutex_unlock (&metrics_lock);
+
+    g_hash_table_destroy (metrics->funcs);
+    g_free (metrics);
+}
+
+/**
+ * bd_utils_metrics_record_call:
+ * @plugin: (allow-none): name of the plugin @func belongs to or %NULL
+ * @func: name of the called function
+ * @duration_usec: how long the call took (in microseconds)
+ *
+ * Records one call of @func in the calling thread's metrics slot. Both
+ * @plugin and @func have to be static strings (they are not copied). Used by
+ * the generated plugin API wrappers, there should be no need to call this
+ * directly.
+ */
+void bd_utils_metrics_record_call (const gchar *plugin, const gchar *func, gint64 duration_usec) {
+    ThreadMetrics *metrics = get_thread_metrics ();
+    FuncSlot *slot = g_hash_table_lookup (metrics->funcs, func);
+
+    if (G_UNLIKELY (!slot)) {
+        slot = g_new0 (FuncSlot, 1);
+        slot->plugin = plugin;
+        slot->func = func;
+        /* the aggregation may be walking the table right now */
+        g_mutex_lock (&metrics_lock);
+        g_hash_table_insert (metrics->funcs, (gpointer) func, slot);
+        g_mutex_unlock (&metrics_lock);
+    }
+
+    /* only this thread writes the counters, but the aggregation may be
+       reading them -- store atomically to prevent torn reads */
+    __atomic_store_n (&slot->calls, slot->calls + 1, __ATOMIC_RELAXED);
+    __atomic_store_n (&slot->total_usec, slot->total_usec + (guint64) duration_usec, __ATOMIC_RELAXED);
+    if ((guint64) duration_usec > slot->max_usec)
+        __atomic_store_n (&slot->max_usec, (guint64) duration_usec, __ATOMIC_RELAXED);
+}
+
+/**
+ * bd_utils_metrics_record_spawn:
+ *
+ * Records one spawned external process in the calling thread's metrics slot.
+ * Used by the exec utils, there should be no need to call this directly.
+ */
+void bd_utils_metrics_record_spawn (void) {
+    ThreadMetrics *metrics = get_thread_metrics ();
+
+    __atomic_store_n (&metrics->spawns, metrics->spawns + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * bd_utils_metrics_record_child_cpu:
+ * @cpu_usec: CPU time (in microseconds) consumed by a reaped child process
+ *
+ * Records the CPU time consumed by a spawned external process in the calling
+ * thread's metrics slot. Used by the exec utils, there should be no need to
+ * call this directly.
+ */
+void bd_utils_metrics_record_child_cpu (guint64 cpu_usec) {
+    ThreadMetrics *metrics = get_thread_metrics ();
+
+    __atomic_store_n (&metrics->child_cpu_usec, metrics->child_cpu_usec + cpu_usec, __ATOMIC_RELAXED);
+}
+
+/**
+ * bd_utils_func_metrics_copy: (skip)
+ *
+ * Creates a new copy of @metrics.
+ */
+BDUtilsFuncMetrics* bd_utils_func_metrics_copy (BDUtilsFuncMetrics *metrics) {
+    BDUtilsFuncMetrics *ret = g_new0 (BDUtilsFuncMetrics, 1);
+
+    ret->plugin = g_strdup (metrics->plugin);
+    ret->func = g_strdup (metrics->func);
+    ret->calls = metrics->calls;
+    ret->total_usec = metrics->total_usec;
+    ret->max_usec = metrics->max_usec;
+
+    return ret;
+}
+
+/**
+ * bd_utils_func_metrics_free: (skip)
+ *
+ * Frees @metrics.
+ */
+void bd_utils_func_metrics_free (BDUtilsFuncMetrics *metrics) {
+    if (!metrics)
+        return;
+    g_free (metrics->plugin);
+    g_free (metrics->func);
+    g_free (metrics);
+}
+
+GType bd_utils_func_metrics_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsFuncMetrics",
+                                             (GBoxedCopyFunc) bd_utils_func_metrics_copy,
+                                             (GBoxedFreeFunc) bd_utils_func_metrics_free);
+
+    return type;
+}
+
+/**
+ * bd_utils_metrics_copy: (skip)
+ *
+ * Creates a new copy of @metrics.
+ */
+BDUtilsMetrics* bd_utils_metrics_copy (BDUtilsMetrics *metrics) {
+    BDUtilsMetrics *ret = g_new0 (BDUtilsMetrics, 1);
+    guint n_funcs = 0;
+    guint i = 0;
+
+    ret->spawns = metrics->spawns;
+    ret->child_cpu_usec = metrics->child_cpu_usec;
+    for (n_funcs = 0; metrics->funcs[n_funcs]; n_funcs++);
+    ret->funcs = g_new0 (BDUtilsFuncMetrics*, n_funcs + 1);
+    for (i = 0; i < n_funcs; i++)
+        ret->funcs[i] = bd_utils_func_metrics_copy (metrics->funcs[i]);
+
+    return ret;
+}
+
+/**
+ * bd_utils_metrics_free: (skip)
+ *
+ * Frees @metrics.
+ */
+void bd_utils_metrics_free (BDUtilsMetrics *metrics) {
+    BDUtilsFuncMetrics **func_p = NULL;
+
+    if (!metrics)
+        return;
+    for (func_p = metrics->funcs; *func_p; func_p++)
+        bd_utils_func_metrics_free (*func_p);
+    g_free (metrics->funcs);
+    g_free (metrics);
+}
+
+GType bd_utils_metrics_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsMetrics",
+                                             (GBoxedCopyFunc) bd_utils_metrics_copy,
+                                             (GBoxedFreeFunc) bd_utils_metrics_free);
+
+    return type;
+}
+
+/**
+ * bd_utils_get_metrics:
+ *
+ * Returns: (transfer full): metrics of the library's activity since the
+ *          library was loaded (or since the last bd_utils_reset_metrics()
+ *          call) aggregated over all threads -- per-function call counts and
+ *          latencies plus the number of spawned external processes and the
+ *          CPU time they consumed
+ */
+BDUtilsMetrics* bd_utils_get_metrics (void) {
+    BDUtilsMetrics *ret = g_new0 (BDUtilsMetrics, 1);
+    GHashTable *agg = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+    GHashTableIter iter;
+    gpointer value = NULL;
+    GSList *item = NULL;
+    guint i = 0;
+
+    g_mutex_lock (&metrics_lock);
+    if (retired.funcs) {
+        g_hash_table_iter_init (&iter, retired.funcs);
+        while (g_hash_table_iter_next (&iter, NULL, &value))
+            merge_func_slot (agg, (FuncSlot *) value);
+    }
+    ret->spawns = retired.spawns;
+    ret->child_cpu_usec = retired.child_cpu_usec;
+
+    for (item = thread_slots; item; item = item->next) {
+        ThreadMetrics *metrics = (ThreadMetrics *) item->data;
+        g_hash_table_iter_init (&iter, metrics->funcs);
+        while (g_hash_table_iter_next (&iter, NULL, &value))
+            merge_func_slot (agg, (FuncSlot *) value);
+        ret->spawns += __atomic_load_n (&metrics->spawns, __ATOMIC_RELAXED);
+        ret->child_cpu_usec += __atomic_load_n (&metrics->child_cpu_usec, __ATOMIC_RELAXED);
+    }
+    g_mutex_unlock (&metrics_lock);
+
+    ret->funcs = g_new0 (BDUtilsFuncMetrics*, g_hash_table_size (agg) + 1);
+    g_hash_table_iter_init (&iter, agg);
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+        FuncSlot *slot = (FuncSlot *) value;
+        BDUtilsFuncMetrics *func_metrics = g_new0 (BDUtilsFuncMetrics, 1);
+        func_metrics->plugin = g_strdup (slot->plugin);
+        func_metrics->func = g_strdup (slot->func);
+        func_metrics->calls = slot->calls;
+        func_metrics->total_usec = slot->total_usec;
+        func_metrics->max_usec = slot->max_usec;
+        ret->funcs[i++] = func_metrics;
+    }
+    g_hash_table_destroy (agg);
+
+    return ret;
+}
+
+/**
+ * bd_utils_reset_metrics:
+ *
+ * Resets all the metrics to zero. Counter ticks recorded by other threads
+ * concurrently with the reset may be lost, which for the monitoring purposes
+ * of the metrics doesn't matter.
+ */
+void bd_utils_reset_metrics (void) {
+    GHashTableIter iter;
+    gpointer value = NULL;
+    GSList *item = NULL;
+
+    g_mutex_lock (&metrics_lock);
+    if (retired.funcs)
+        g_hash_table_remove_all (retired.funcs);
+    retired.spawns = 0;
+    retired.child_cpu_usec = 0;
+
+    for (item = thread_slots; item; item = item->next) {
+        ThreadMetrics *metrics = (ThreadMetrics *) item->data;
+        g_hash_table_iter_init (&iter, metrics->funcs);
+        while (g_hash_table_iter_next (&iter, NULL, &value)) {
+            FuncSlot *slot = (FuncSlot *) value;
+            __atomic_store_n (&slot->calls, 0, __ATOMIC_RELAXED);
+            __atomic_store_n (&slot->total_usec, 0, __ATOMIC_RELAXED);
+            __atomic_store_n (&slot->max_usec, 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n (&metrics->spawns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n (&metrics->child_cpu_usec, 0, __ATOMIC_RELAXED);
+    }
+    g_mutex_unlock (&metrics_lock);
+}
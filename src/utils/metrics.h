@@ -0,0 +1,56 @@
+#include <glib.h>
+#include <glib-object.h>
+
+#ifndef BD_UTILS_METRICS
+#define BD_UTILS_METRICS
+
+#define BD_UTILS_TYPE_FUNC_METRICS (bd_utils_func_metrics_get_type ())
+GType bd_utils_func_metrics_get_type (void);
+
+/**
+ * BDUtilsFuncMetrics:
+ * @plugin: name of the plugin the function belongs to or %NULL for the
+ *          library-level functions
+ * @func: name of the function
+ * @calls: how many times the function was called
+ * @total_usec: cumulative time (in microseconds) spent in the function
+ * @max_usec: the longest single call (in microseconds)
+ */
+typedef struct BDUtilsFuncMetrics {
+    gchar *plugin;
+    gchar *func;
+    guint64 calls;
+    guint64 total_usec;
+    guint64 max_usec;
+} BDUtilsFuncMetrics;
+
+BDUtilsFuncMetrics* bd_utils_func_metrics_copy (BDUtilsFuncMetrics *metrics);
+void bd_utils_func_metrics_free (BDUtilsFuncMetrics *metrics);
+
+#define BD_UTILS_TYPE_METRICS (bd_utils_metrics_get_type ())
+GType bd_utils_metrics_get_type (void);
+
+/**
+ * BDUtilsMetrics:
+ * @spawns: how many external processes were spawned
+ * @child_cpu_usec: CPU time (in microseconds) consumed by the spawned
+ *                  processes (only those reaped by the library itself)
+ * @funcs: (array zero-terminated=1): per-function metrics
+ */
+typedef struct BDUtilsMetrics {
+    guint64 spawns;
+    guint64 child_cpu_usec;
+    BDUtilsFuncMetrics **funcs;
+} BDUtilsMetrics;
+
+BDUtilsMetrics* bd_utils_metrics_copy (BDUtilsMetrics *metrics);
+void bd_utils_metrics_free (BDUtilsMetrics *metrics);
+
+BDUtilsMetrics* bd_utils_get_metrics (void);
+void bd_utils_reset_metrics (void);
+
+void bd_utils_metrics_record_call (const gchar *plugin, const gchar *func, gint64 duration_usec);
+void bd_utils_metrics_record_spawn (void);
+void bd_utils_metrics_record_child_cpu (guint64 cpu_usec);
+
+#endif  /* BD_UTILS_METRICS */
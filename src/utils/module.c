@@ -23,6 +23,7 @@
 #include <string.h>
 #include <syslog.h>
 #include <locale.h>
+#include <sys/stat.h>
 #include <sys/utsname.h>
 
 #include "module.h"
@@ -74,6 +75,65 @@ static void set_kmod_logging (struct kmod_ctx *ctx) {
     kmod_set_log_fn (ctx, utils_kmod_log_redirect, NULL);
 }
 
+static struct kmod_ctx *cached_kmod_ctx = NULL;
+static time_t cached_kmod_mtime = 0;
+
+G_LOCK_DEFINE_STATIC (kmod_ctx);
+
+/* get a reference to the shared kmod context, (re)creating it if the module
+   index changed since it was created; creating a context means re-reading and
+   re-parsing the /lib/modules indexes, so it pays off to share one between
+   calls. The context is returned with its lock held -- libkmod contexts are
+   not thread-safe (module lookups mutate the context-level module pool), so
+   the lock must be held across the whole use, not just the pointer handout;
+   callers hand the context back with put_kmod_ctx() */
+static struct kmod_ctx* get_kmod_ctx (GError **error) {
+    struct kmod_ctx *ctx = NULL;
+    gchar *null_config = NULL;
+    struct utsname un;
+    struct stat sb;
+    gchar *dep_path = NULL;
+    time_t mtime = 0;
+
+    if (uname (&un) == 0) {
+        dep_path = g_strdup_printf ("/lib/modules/%s/modules.dep.bin", un.release);
+        if (stat (dep_path, &sb) == 0)
+            mtime = sb.st_mtime;
+        g_free (dep_path);
+    }
+
+    G_LOCK (kmod_ctx);
+    if (cached_kmod_ctx && mtime != cached_kmod_mtime) {
+        /* the module index changed, drop the cached context */
+        kmod_unref (cached_kmod_ctx);
+        cached_kmod_ctx = NULL;
+    }
+
+    if (!cached_kmod_ctx) {
+        ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+        if (!ctx) {
+            G_UNLOCK (kmod_ctx);
+            g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
+                         "Failed to initialize kmod context");
+            return NULL;
+        }
+        set_kmod_logging (ctx);
+        cached_kmod_ctx = ctx;
+        cached_kmod_mtime = mtime;
+    }
+
+    ctx = kmod_ref (cached_kmod_ctx);
+
+    /* deliberately still holding the lock, see above */
+    return ctx;
+}
+
+/* hand the shared context back, releasing the lock taken by get_kmod_ctx() */
+static void put_kmod_ctx (struct kmod_ctx *ctx) {
+    kmod_unref (ctx);
+    G_UNLOCK (kmod_ctx);
+}
+
 /**
  * bd_utils_have_kernel_module:
  * @module_name: name of the kernel module to check
@@ -86,26 +146,23 @@ gboolean bd_utils_have_kernel_module (const gchar *module_name, GError **error)
     gint ret = 0;
     struct kmod_ctx *ctx = NULL;
     struct kmod_module *mod = NULL;
-    gchar *null_config = NULL;
     const gchar *path = NULL;
     gboolean have_path = FALSE;
     gboolean builtin = FALSE;
     locale_t c_locale = newlocale (LC_ALL_MASK, "C", (locale_t) 0);
 
-    ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+    ctx = get_kmod_ctx (error);
     if (!ctx) {
-        g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
-                     "Failed to initialize kmod context");
+        /* error is already populated */
         freelocale (c_locale);
         return FALSE;
     }
-    set_kmod_logging (ctx);
 
     ret = kmod_module_new_from_name (ctx, module_name, &mod);
     if (ret < 0) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_FAIL,
                      "Failed to get the module: %s", strerror_l (-ret, c_locale));
-        kmod_unref (ctx);
+        put_kmod_ctx (ctx);
         freelocale (c_locale);
         return FALSE;
     }
@@ -116,7 +173,7 @@ gboolean bd_utils_have_kernel_module (const gchar *module_name, GError **error)
       builtin = kmod_module_get_initstate (mod) == KMOD_MODULE_BUILTIN;
     }
     kmod_module_unref (mod);
-    kmod_unref (ctx);
+    put_kmod_ctx (ctx);
     freelocale (c_locale);
 
     return have_path || builtin;
@@ -134,23 +191,20 @@ gboolean bd_utils_load_kernel_module (const gchar *module_name, const gchar *opt
     gint ret = 0;
     struct kmod_ctx *ctx = NULL;
     struct kmod_module *mod = NULL;
-    gchar *null_config = NULL;
     locale_t c_locale = newlocale (LC_ALL_MASK, "C", (locale_t) 0);
 
-    ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+    ctx = get_kmod_ctx (error);
     if (!ctx) {
-        g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
-                     "Failed to initialize kmod context");
+        /* error is already populated */
         freelocale (c_locale);
         return FALSE;
     }
-    set_kmod_logging (ctx);
 
     ret = kmod_module_new_from_name (ctx, module_name, &mod);
     if (ret < 0) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_FAIL,
                      "Failed to get the module: %s", strerror_l (-ret, c_locale));
-        kmod_unref (ctx);
+        put_kmod_ctx (ctx);
         freelocale (c_locale);
         return FALSE;
     }
@@ -159,7 +213,7 @@ gboolean bd_utils_load_kernel_module (const gchar *module_name, const gchar *opt
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_NOEXIST,
                      "Module '%s' doesn't exist", module_name);
         kmod_module_unref (mod);
-        kmod_unref (ctx);
+        put_kmod_ctx (ctx);
         freelocale (c_locale);
         return FALSE;
     }
@@ -178,13 +232,13 @@ gboolean bd_utils_load_kernel_module (const gchar *module_name, const gchar *opt
                          "Failed to load the module '%s': %s",
                          module_name, strerror_l (-ret, c_locale));
         kmod_module_unref (mod);
-        kmod_unref (ctx);
+        put_kmod_ctx (ctx);
         freelocale (c_locale);
         return FALSE;
     }
 
     kmod_module_unref (mod);
-    kmod_unref (ctx);
+    put_kmod_ctx (ctx);
     freelocale (c_locale);
     return TRUE;
 }
@@ -202,24 +256,21 @@ gboolean bd_utils_unload_kernel_module (const gchar *module_name, GError **error
     struct kmod_module *mod = NULL;
     struct kmod_list *list = NULL;
     struct kmod_list *cur = NULL;
-    gchar *null_config = NULL;
     gboolean found = FALSE;
     locale_t c_locale = newlocale (LC_ALL_MASK, "C", (locale_t) 0);
 
-    ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+    ctx = get_kmod_ctx (error);
     if (!ctx) {
-        g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
-                     "Failed to initialize kmod context");
+        /* error is already populated */
         freelocale (c_locale);
         return FALSE;
     }
-    set_kmod_logging (ctx);
 
     ret = kmod_module_new_from_loaded (ctx, &list);
     if (ret < 0) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_FAIL,
                      "Failed to get the module: %s", strerror_l (-ret, c_locale));
-        kmod_unref (ctx);
+        put_kmod_ctx (ctx);
         freelocale (c_locale);
         return FALSE;
     }
@@ -236,7 +287,7 @@ gboolean bd_utils_unload_kernel_module (const gchar *module_name, GError **error
     if (!found) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_NOEXIST,
                      "Module '%s' is not loaded", module_name);
-        kmod_unref (ctx);
+        put_kmod_ctx (ctx);
         freelocale (c_locale);
         return FALSE;
     }
@@ -248,13 +299,13 @@ gboolean bd_utils_unload_kernel_module (const gchar *module_name, GError **error
                      "Failed to unload the module '%s': %s",
                      module_name, strerror_l (-ret, c_locale));
         kmod_module_unref (mod);
-        kmod_unref (ctx);
+        put_kmod_ctx (ctx);
         freelocale (c_locale);
         return FALSE;
     }
 
     kmod_module_unref (mod);
-    kmod_unref (ctx);
+    put_kmod_ctx (ctx);
     freelocale (c_locale);
     return TRUE;
 }
@@ -0,0 +1,553 @@
+/*
+ * Copyright (C) 2014  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "probe.h"
+#include "dev_events.h"
+
+/**
+ * SECTION: probe
+ * @short_description: shared cache for device signature probe results
+ * @title: Probe
+ * @include: probe.h
+ *
+ * An opt-in library-level cache for device signature (libblkid) probe
+ * results. During a device-classification sweep several plugins typically
+ * probe the very same device within milliseconds (e.g. the fs plugin
+ * determining the filesystem type and the crypto plugin checking for a LUKS
+ * signature); with the cache enabled only the first of them reads the device,
+ * the others answer from memory. Cached entries are invalidated by udev
+ * events on block devices and by the write operations going through the
+ * library.
+ *
+ * On top of the in-process cache there is an optional cross-process layer
+ * (see bd_utils_set_probe_cache_shared()): a small shared memory segment
+ * through which all the libblockdev-linked processes of the same user
+ * (a storage daemon, an installer,...) can reuse each other's fresh probe
+ * results instead of each re-reading the same devices during hotplug storms.
+ */
+
+/**
+ * bd_utils_probe_error_quark: (skip)
+ */
+GQuark bd_utils_probe_error_quark (void)
+{
+    return g_quark_from_static_string ("g-bd-utils-probe-error-quark");
+}
+
+/* usage and type of the first signature probed on a device (both NULL for no
+   signature at all) */
+typedef struct ProbeCacheEntry {
+    gchar *usage;
+    gchar *type;
+} ProbeCacheEntry;
+
+static void probe_cache_entry_free (gpointer data) {
+    ProbeCacheEntry *entry = data;
+
+    g_free (entry->usage);
+    g_free (entry->type);
+    g_free (entry);
+}
+
+static GMutex probe_cache_lock;
+static gboolean probe_cache_enabled = FALSE;
+static guint64 probe_cache_generation = 0;
+/* devno -> #ProbeCacheEntry */
+static GHashTable *probe_cache = NULL;
+static guint probe_events_sub = 0;
+
+static guint64 device_devno (const gchar *device) {
+    struct stat st;
+
+    if (stat (device, &st) != 0 || !S_ISBLK (st.st_mode))
+        return 0;
+
+    return (guint64) st.st_rdev;
+}
+
+static void probe_cache_event_cb (const gchar *device __attribute__((unused)), BDUtilsDeviceAction action __attribute__((unused)), guint64 devno, gpointer user_data __attribute__((unused))) {
+    g_mutex_lock (&probe_cache_lock);
+    if (probe_cache_enabled) {
+        probe_cache_generation++;
+        if (devno != 0)
+            g_hash_table_remove (probe_cache, &devno);
+    }
+    g_mutex_unlock (&probe_cache_lock);
+}
+
+
+/*********************** cross-process shared cache ***********************/
+
+/* one segment per user -- the processes that can share probe results are the
+   ones allowed to probe the same devices */
+#define SHARED_CACHE_NAME_FMT "/libblockdev-probe-cache-%u"
+#define SHARED_CACHE_MAGIC 0x42447363u
+#define SHARED_CACHE_VERSION 1
+#define SHARED_CACHE_SLOTS 256
+#define SHARED_CACHE_STR_LEN 34
+/* slots older than this are ignored; the shared cache only serves the "many
+   processes classify the same device within a moment" case, a short lifetime
+   bounds the staleness a process that missed some uevents (e.g. one that was
+   not running when they arrived) can possibly see */
+#define SHARED_CACHE_TTL_USEC (2 * G_USEC_PER_SEC)
+/* how long to wait for the process that created the segment to finish
+   initializing it */
+#define SHARED_CACHE_INIT_TIMEOUT_USEC G_USEC_PER_SEC
+
+/* direct-mapped slot (index is devno % SHARED_CACHE_SLOTS), an empty or
+   evicted slot has devno 0 */
+typedef struct SharedCacheSlot {
+    guint64 devno;
+    gint64 stamp;                        /* CLOCK_MONOTONIC is system-wide */
+    guint8 has_signature;
+    gchar usage[SHARED_CACHE_STR_LEN];
+    gchar type[SHARED_CACHE_STR_LEN];
+} SharedCacheSlot;
+
+typedef struct SharedCache {
+    guint32 magic;
+    guint32 version;
+    pthread_mutex_t lock;
+    guint64 generation;
+    SharedCacheSlot slots[SHARED_CACHE_SLOTS];
+} SharedCache;
+
+static SharedCache *shared_cache = NULL;
+static gint shared_cache_fd = -1;
+static guint shared_events_sub = 0;
+
+/* locks the shared segment; if the previous owner of the lock died while
+   holding it the data cannot be trusted and is dropped */
+static gint shared_cache_acquire (SharedCache *cache) {
+    gint ret = pthread_mutex_lock (&cache->lock);
+
+    if (ret == EOWNERDEAD) {
+        memset (cache->slots, 0, sizeof (cache->slots));
+        cache->generation++;
+        pthread_mutex_consistent (&cache->lock);
+        ret = 0;
+    }
+
+    return ret;
+}
+
+static void shared_cache_event_cb (const gchar *device __attribute__((unused)), BDUtilsDeviceAction action __attribute__((unused)), guint64 devno, gpointer user_data __attribute__((unused))) {
+    SharedCacheSlot *slot = NULL;
+
+    g_mutex_lock (&probe_cache_lock);
+    if (shared_cache && shared_cache_acquire (shared_cache) == 0) {
+        shared_cache->generation++;
+        if (devno != 0) {
+            slot = &shared_cache->slots[devno % SHARED_CACHE_SLOTS];
+            if (slot->devno == devno)
+                memset (slot, 0, sizeof (SharedCacheSlot));
+        } else
+            memset (shared_cache->slots, 0, sizeof (shared_cache->slots));
+        pthread_mutex_unlock (&shared_cache->lock);
+    }
+    g_mutex_unlock (&probe_cache_lock);
+}
+
+static gboolean shared_cache_attach (SharedCache **cache_ret, gint *fd_ret, GError **error) {
+    g_autofree gchar *name = NULL;
+    SharedCache *cache = NULL;
+    pthread_mutexattr_t attr;
+    gboolean creator = FALSE;
+    gint64 deadline = 0;
+    gint fd = -1;
+
+    name = g_strdup_printf (SHARED_CACHE_NAME_FMT, (guint) getuid ());
+    fd = shm_open (name, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if (fd >= 0)
+        creator = TRUE;
+    else if (errno == EEXIST)
+        fd = shm_open (name, O_RDWR, 0600);
+    if (fd < 0) {
+        g_set_error (error, BD_UTILS_PROBE_ERROR, BD_UTILS_PROBE_ERROR_FAILED,
+                     "Failed to open the shared probe cache segment '%s': %m", name);
+        return FALSE;
+    }
+
+    if (ftruncate (fd, sizeof (SharedCache)) != 0) {
+        g_set_error (error, BD_UTILS_PROBE_ERROR, BD_UTILS_PROBE_ERROR_FAILED,
+                     "Failed to size the shared probe cache segment '%s': %m", name);
+        close (fd);
+        if (creator)
+            shm_unlink (name);
+        return FALSE;
+    }
+
+    cache = mmap (NULL, sizeof (SharedCache), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cache == MAP_FAILED) {
+        g_set_error (error, BD_UTILS_PROBE_ERROR, BD_UTILS_PROBE_ERROR_FAILED,
+                     "Failed to map the shared probe cache segment '%s': %m", name);
+        close (fd);
+        if (creator)
+            shm_unlink (name);
+        return FALSE;
+    }
+
+    if (creator) {
+        pthread_mutexattr_init (&attr);
+        pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init (&cache->lock, &attr);
+        pthread_mutexattr_destroy (&attr);
+        cache->version = SHARED_CACHE_VERSION;
+        /* the magic goes in last, it tells the other processes the segment is
+           fully initialized */
+        __atomic_store_n (&cache->magic, SHARED_CACHE_MAGIC, __ATOMIC_RELEASE);
+    } else {
+        deadline = g_get_monotonic_time () + SHARED_CACHE_INIT_TIMEOUT_USEC;
+        while (__atomic_load_n (&cache->magic, __ATOMIC_ACQUIRE) != SHARED_CACHE_MAGIC
+               && g_get_monotonic_time () < deadline)
+            g_usleep (1000);
+        if (__atomic_load_n (&cache->magic, __ATOMIC_ACQUIRE) != SHARED_CACHE_MAGIC
+            || cache->version != SHARED_CACHE_VERSION) {
+            g_set_error (error, BD_UTILS_PROBE_ERROR, BD_UTILS_PROBE_ERROR_FAILED,
+                         "The shared probe cache segment '%s' is uninitialized or incompatible "
+                         "(remove it from /dev/shm if it was left behind by a crashed process)",
+                         name);
+            munmap (cache, sizeof (SharedCache));
+            close (fd);
+            return FALSE;
+        }
+    }
+
+    *cache_ret = cache;
+    *fd_ret = fd;
+    return TRUE;
+}
+
+/**
+ * bd_utils_set_probe_cache:
+ * @enabled: whether to serve repeated signature probes from an in-memory cache
+ *           or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables the library-level cache for device signature probe
+ * results. With the cache enabled repeated probes of the same device (from
+ * any plugin) are answered from memory; cached entries are invalidated by the
+ * write operations going through the library and by udev events on block
+ * devices so out-of-band changes are picked up on the next probe. The cache
+ * is disabled by default.
+ *
+ * Returns: whether the cache was successfully enabled/disabled or not
+ */
+gboolean bd_utils_set_probe_cache (gboolean enabled, GError **error) {
+    guint sub_id = 0;
+
+    if (enabled) {
+        /* the subscription has to be in place before the cache is enabled,
+           otherwise an event arriving in between would be missed; it also
+           cannot be created with the lock held -- the callback takes the same
+           lock and the event thread dispatches under its own one */
+        sub_id = bd_utils_subscribe_device_events (probe_cache_event_cb, NULL, error);
+        if (sub_id == 0)
+            return FALSE;
+
+        g_mutex_lock (&probe_cache_lock);
+        if (probe_cache_enabled) {
+            /* already enabled by someone else in the meantime */
+            g_mutex_unlock (&probe_cache_lock);
+            bd_utils_unsubscribe_device_events (sub_id, NULL);
+            return TRUE;
+        }
+        probe_events_sub = sub_id;
+        probe_cache = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, probe_cache_entry_free);
+        probe_cache_enabled = TRUE;
+        g_mutex_unlock (&probe_cache_lock);
+    } else {
+        g_mutex_lock (&probe_cache_lock);
+        if (!probe_cache_enabled) {
+            g_mutex_unlock (&probe_cache_lock);
+            return TRUE;
+        }
+        sub_id = probe_events_sub;
+        probe_events_sub = 0;
+        probe_cache_enabled = FALSE;
+        probe_cache_generation++;
+        g_hash_table_destroy (probe_cache);
+        probe_cache = NULL;
+        g_mutex_unlock (&probe_cache_lock);
+
+        /* the callback may be blocked on the lock right now so the
+           subscription can only be cancelled after releasing it */
+        bd_utils_unsubscribe_device_events (sub_id, NULL);
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_set_probe_cache_shared:
+ * @enabled: whether to share probe results with the other libblockdev-linked
+ *           processes of the same user or not
+ * @error: (out): place to store error (if any)
+ *
+ * Enables or disables the cross-process layer of the probe cache. With the
+ * layer enabled probe results are also published in a small per-user shared
+ * memory segment, so when several processes (e.g. a storage daemon and an
+ * installer) classify the same devices during a hotplug storm, only one of
+ * them reads each device and the others reuse its result. Shared entries are
+ * only served for a short time after being stored and are invalidated by
+ * uevents and by the write operations of every participating process, which
+ * bounds the staleness a process that was not running when a device changed
+ * can see. This layer is independent of bd_utils_set_probe_cache() (either
+ * can be enabled without the other) and is disabled by default.
+ *
+ * Returns: whether the shared cache was successfully enabled/disabled or not
+ */
+gboolean bd_utils_set_probe_cache_shared (gboolean enabled, GError **error) {
+    SharedCache *cache = NULL;
+    guint sub_id = 0;
+    gint fd = -1;
+
+    if (enabled) {
+        g_mutex_lock (&probe_cache_lock);
+        if (shared_cache) {
+            g_mutex_unlock (&probe_cache_lock);
+            return TRUE;
+        }
+        g_mutex_unlock (&probe_cache_lock);
+
+        /* the subscription has to be in place before the first result is
+           served so no invalidating event is missed */
+        sub_id = bd_utils_subscribe_device_events (shared_cache_event_cb, NULL, error);
+        if (sub_id == 0)
+            return FALSE;
+
+        /* attaching is done without the lock held, it may involve waiting for
+           another process initializing the segment */
+        if (!shared_cache_attach (&cache, &fd, error)) {
+            bd_utils_unsubscribe_device_events (sub_id, NULL);
+            return FALSE;
+        }
+
+        g_mutex_lock (&probe_cache_lock);
+        if (shared_cache) {
+            /* already enabled by someone else in the meantime */
+            g_mutex_unlock (&probe_cache_lock);
+            bd_utils_unsubscribe_device_events (sub_id, NULL);
+            munmap (cache, sizeof (SharedCache));
+            close (fd);
+            return TRUE;
+        }
+        shared_cache = cache;
+        shared_cache_fd = fd;
+        shared_events_sub = sub_id;
+        g_mutex_unlock (&probe_cache_lock);
+    } else {
+        g_mutex_lock (&probe_cache_lock);
+        if (!shared_cache) {
+            g_mutex_unlock (&probe_cache_lock);
+            return TRUE;
+        }
+        cache = shared_cache;
+        fd = shared_cache_fd;
+        sub_id = shared_events_sub;
+        shared_cache = NULL;
+        shared_cache_fd = -1;
+        shared_events_sub = 0;
+        g_mutex_unlock (&probe_cache_lock);
+
+        /* the callback may be blocked on the lock right now so the
+           subscription can only be cancelled after releasing it */
+        bd_utils_unsubscribe_device_events (sub_id, NULL);
+
+        /* the segment itself is deliberately left in place -- other processes
+           may still be using it and a fresh process will reattach to it */
+        munmap (cache, sizeof (SharedCache));
+        close (fd);
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_probe_cache_lookup:
+ * @device: the device to get the cached probe result for
+ * @usage: (out) (allow-none) (transfer full): usage ("filesystem", "crypto",
+ *         "raid",...) of the cached signature or %NULL if the device has no
+ *         signature (only valid when %TRUE is returned)
+ * @type: (out) (allow-none) (transfer full): type of the cached signature or
+ *        %NULL if the device has no signature (only valid when %TRUE is
+ *        returned)
+ * @devno: (out) (allow-none): device number of @device (or 0 if it cannot be
+ *         resolved) for a later bd_utils_probe_cache_insert()
+ * @generation: (out) (allow-none): current cache generation for a later
+ *              bd_utils_probe_cache_insert()
+ *
+ * Looks @device up in the probe cache. On a miss the caller is expected to
+ * run the actual probe and store its result with bd_utils_probe_cache_insert()
+ * passing the @devno and @generation values obtained here (the generation
+ * snapshot prevents a result that raced with an invalidation from being
+ * cached).
+ *
+ * Returns: whether a cached result for @device was found or not
+ */
+gboolean bd_utils_probe_cache_lookup (const gchar *device, gchar **usage, gchar **type, guint64 *devno, guint64 *generation) {
+    const ProbeCacheEntry *entry = NULL;
+    SharedCacheSlot *slot = NULL;
+    guint64 l_devno = 0;
+    guint64 l_generation = 0;
+    gboolean found = FALSE;
+
+    g_mutex_lock (&probe_cache_lock);
+    if (probe_cache_enabled || shared_cache) {
+        l_devno = device_devno (device);
+        /* the local and the shared cache are invalidated independently so the
+           generation snapshot carries both counters (the insert only ever
+           compares them for equality) */
+        l_generation = probe_cache_generation << 32;
+    }
+    if (probe_cache_enabled && (l_devno != 0)) {
+        entry = g_hash_table_lookup (probe_cache, &l_devno);
+        if (entry) {
+            found = TRUE;
+            if (usage)
+                *usage = g_strdup (entry->usage);
+            if (type)
+                *type = g_strdup (entry->type);
+        }
+    }
+    if (shared_cache && shared_cache_acquire (shared_cache) == 0) {
+        l_generation |= shared_cache->generation & 0xFFFFFFFF;
+        if (!found && (l_devno != 0)) {
+            slot = &shared_cache->slots[l_devno % SHARED_CACHE_SLOTS];
+            if ((slot->devno == l_devno)
+                && ((g_get_monotonic_time () - slot->stamp) <= SHARED_CACHE_TTL_USEC)) {
+                found = TRUE;
+                if (usage)
+                    *usage = (slot->has_signature && slot->usage[0]) ? g_strdup (slot->usage) : NULL;
+                if (type)
+                    *type = (slot->has_signature && slot->type[0]) ? g_strdup (slot->type) : NULL;
+                /* mirror the result into the local cache so the next lookup
+                   doesn't need to touch the shared segment */
+                if (probe_cache_enabled) {
+                    guint64 *key = g_new (guint64, 1);
+                    ProbeCacheEntry *new_entry = g_new0 (ProbeCacheEntry, 1);
+                    *key = l_devno;
+                    if (slot->has_signature) {
+                        new_entry->usage = slot->usage[0] ? g_strdup (slot->usage) : NULL;
+                        new_entry->type = slot->type[0] ? g_strdup (slot->type) : NULL;
+                    }
+                    g_hash_table_replace (probe_cache, key, new_entry);
+                }
+            }
+        }
+        pthread_mutex_unlock (&shared_cache->lock);
+    }
+    g_mutex_unlock (&probe_cache_lock);
+
+    if (devno)
+        *devno = l_devno;
+    if (generation)
+        *generation = l_generation;
+
+    return found;
+}
+
+/**
+ * bd_utils_probe_cache_insert:
+ * @devno: device number the probe was run on (as obtained from
+ *         bd_utils_probe_cache_lookup(), may be 0 in which case nothing is
+ *         cached)
+ * @generation: cache generation snapshot from bd_utils_probe_cache_lookup()
+ * @usage: (allow-none): usage of the first signature probed on the device or
+ *         %NULL if no signature was found
+ * @type: (allow-none): type of the first signature probed on the device or
+ *        %NULL if no signature was found
+ *
+ * Stores a probe result in the cache. The result is silently dropped if the
+ * cache was invalidated while the probe was running (@generation differs from
+ * the current generation) or if the cache is disabled.
+ */
+void bd_utils_probe_cache_insert (guint64 devno, guint64 generation, const gchar *usage, const gchar *type) {
+    SharedCacheSlot *slot = NULL;
+    guint64 *key = NULL;
+    ProbeCacheEntry *entry = NULL;
+
+    g_mutex_lock (&probe_cache_lock);
+    if (probe_cache_enabled && (devno != 0) && ((generation >> 32) == (probe_cache_generation & 0xFFFFFFFF))) {
+        key = g_new (guint64, 1);
+        *key = devno;
+        entry = g_new0 (ProbeCacheEntry, 1);
+        entry->usage = g_strdup (usage);
+        entry->type = g_strdup (type);
+        g_hash_table_replace (probe_cache, key, entry);
+    }
+    if (shared_cache && (devno != 0)
+        && (!usage || strlen (usage) < SHARED_CACHE_STR_LEN)
+        && (!type || strlen (type) < SHARED_CACHE_STR_LEN)
+        && shared_cache_acquire (shared_cache) == 0) {
+        if ((generation & 0xFFFFFFFF) == (shared_cache->generation & 0xFFFFFFFF)) {
+            slot = &shared_cache->slots[devno % SHARED_CACHE_SLOTS];
+            slot->devno = devno;
+            slot->stamp = g_get_monotonic_time ();
+            slot->has_signature = (usage != NULL) || (type != NULL);
+            g_strlcpy (slot->usage, usage ? usage : "", SHARED_CACHE_STR_LEN);
+            g_strlcpy (slot->type, type ? type : "", SHARED_CACHE_STR_LEN);
+        }
+        pthread_mutex_unlock (&shared_cache->lock);
+    }
+    g_mutex_unlock (&probe_cache_lock);
+}
+
+/**
+ * bd_utils_probe_cache_invalidate:
+ * @device: the device to drop the cached probe result for
+ *
+ * Drops the cached probe result for @device (or all the results if @device
+ * cannot be resolved). Write operations going through the library call this
+ * after changing on-disk signatures.
+ */
+void bd_utils_probe_cache_invalidate (const gchar *device) {
+    SharedCacheSlot *slot = NULL;
+    guint64 devno = 0;
+
+    g_mutex_lock (&probe_cache_lock);
+    if (probe_cache_enabled || shared_cache)
+        devno = device_devno (device);
+    if (probe_cache_enabled) {
+        probe_cache_generation++;
+        if (devno != 0)
+            g_hash_table_remove (probe_cache, &devno);
+        else
+            g_hash_table_remove_all (probe_cache);
+    }
+    if (shared_cache && shared_cache_acquire (shared_cache) == 0) {
+        shared_cache->generation++;
+        if (devno != 0) {
+            slot = &shared_cache->slots[devno % SHARED_CACHE_SLOTS];
+            if (slot->devno == devno)
+                memset (slot, 0, sizeof (SharedCacheSlot));
+        } else
+            memset (shared_cache->slots, 0, sizeof (shared_cache->slots));
+        pthread_mutex_unlock (&shared_cache->lock);
+    }
+    g_mutex_unlock (&probe_cache_lock);
+}
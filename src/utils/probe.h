@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2014  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_UTILS_PROBE
+#define BD_UTILS_PROBE
+
+GQuark bd_utils_probe_error_quark (void);
+#define BD_UTILS_PROBE_ERROR bd_utils_probe_error_quark ()
+
+typedef enum {
+    BD_UTILS_PROBE_ERROR_FAILED,
+} BDUtilsProbeError;
+
+gboolean bd_utils_set_probe_cache (gboolean enabled, GError **error);
+gboolean bd_utils_set_probe_cache_shared (gboolean enabled, GError **error);
+gboolean bd_utils_probe_cache_lookup (const gchar *device, gchar **usage, gchar **type, guint64 *devno, guint64 *generation);
+void bd_utils_probe_cache_insert (guint64 devno, guint64 generation, const gchar *usage, const gchar *type);
+void bd_utils_probe_cache_invalidate (const gchar *device);
+
+#endif  /* BD_UTILS_PROBE */
@@ -0,0 +1,31 @@
+#include <glib.h>
+
+#ifndef BD_UTILS_TRACE
+#define BD_UTILS_TRACE
+
+/*
+ * Static (USDT/systemtap) tracepoints for profiling libblockdev in production
+ * with bpftrace, perf or systemtap. Compiled out by default, enabled with the
+ * --with-sdt configure option. All the probes live under the 'libblockdev'
+ * provider:
+ *
+ *   exec_spawn (task_id, argv_str)           -- an external utility is being spawned
+ *   exec_reap (task_id, exit_code)           -- the external utility finished
+ *   progress_started (task_id, msg)          -- a task started being tracked
+ *   progress (task_id, completion)           -- progress (in %) of a tracked task
+ *   progress_finished (task_id, msg)         -- a tracked task finished
+ *   api_entry (plugin, function)             -- a plugin API function was called
+ *   api_exit (plugin, function, duration_us) -- the API function returned
+ *
+ * The duration of an external utility run can be derived by pairing the
+ * exec_spawn/exec_reap probes on the task ID.
+ */
+
+#ifdef WITH_BD_SDT
+#include <sys/sdt.h>
+#define BD_TRACE(name, ...) STAP_PROBEV (libblockdev, name, ##__VA_ARGS__)
+#else
+#define BD_TRACE(name, ...)
+#endif
+
+#endif  /* BD_UTILS_TRACE */
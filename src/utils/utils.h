@@ -5,9 +5,14 @@
 #include "exec.h"
 #include "extra_arg.h"
 #include "dev_utils.h"
+#include "dev_events.h"
+#include "probe.h"
 #include "module.h"
 #include "dbus.h"
 #include "logging.h"
+#include "metrics.h"
+#include "jobs.h"
+#include "trace.h"
 
 /**
  * SECTION: utils
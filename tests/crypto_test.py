@@ -454,6 +454,55 @@ class CryptoTestRemoveKey(CryptoTestCase):
     def test_luks2_remove_key(self):
         self._remove_key(self._luks2_format)
 
+class CryptoTestDeviceHandle(CryptoTestCase):
+    def _device_handle(self, create_fn):
+        """Verify that a series of operations through a device handle works"""
+
+        succ = create_fn(self.loop_dev, PASSWD, None)
+        self.assertTrue(succ)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.crypto_device_open("/non/existing/device")
+
+        handle = BlockDev.crypto_device_open(self.loop_dev)
+        self.assertIsNotNone(handle)
+
+        # multiple keyslot operations through the same handle
+        succ = BlockDev.crypto_luks_device_add_key(handle, [ord(c) for c in PASSWD], [ord(c) for c in PASSWD2])
+        self.assertTrue(succ)
+
+        succ = BlockDev.crypto_luks_device_add_key(handle, [ord(c) for c in PASSWD2], [ord(c) for c in PASSWD3])
+        self.assertTrue(succ)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.crypto_luks_device_remove_key(handle, [ord(c) for c in "wrong-passphrase"])
+
+        succ = BlockDev.crypto_luks_device_remove_key(handle, [ord(c) for c in PASSWD3])
+        self.assertTrue(succ)
+
+        info = BlockDev.crypto_luks_device_info(handle)
+        self.assertIsNotNone(info)
+        self.assertEqual(info.uuid, BlockDev.crypto_luks_uuid(self.loop_dev))
+
+        # changes made through the handle have to be visible to the path-based
+        # functions and those have to keep working once the handle is gone
+        del handle
+
+        succ = BlockDev.crypto_luks_remove_key(self.loop_dev, PASSWD2, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.crypto_luks_add_key(self.loop_dev, PASSWD, None, PASSWD2, None)
+        self.assertTrue(succ)
+
+    @tag_test(TestTags.SLOW)
+    def test_luks_device_handle(self):
+        self._device_handle(self._luks_format)
+
+    @tag_test(TestTags.SLOW)
+    @unittest.skipUnless(HAVE_LUKS2, "LUKS 2 not supported")
+    def test_luks2_device_handle(self):
+        self._device_handle(self._luks2_format)
+
 class CryptoTestErrorLocale(CryptoTestCase):
     def setUp(self):
         self._orig_loc = None
@@ -952,6 +952,75 @@ class GenericResize(GenericTestCase):
             BlockDev.fs_resize(self.loop_dev, 80 * 1024**2)
 
 
+class GenericGetSize(GenericTestCase):
+    def _test_get_size(self, mkfs_function):
+        # clean the device
+        succ = BlockDev.fs_clean(self.loop_dev)
+
+        succ = mkfs_function(self.loop_dev, None)
+        self.assertTrue(succ)
+        size = BlockDev.fs_get_size(self.loop_dev)
+        # a fresh filesystem spans (almost) the whole device; a value far
+        # below that means some other superblock field (e.g. the used bytes)
+        # was reported as the size
+        self.assertLessEqual(size, self.loop_size)
+        self.assertGreater(size, 0.8 * self.loop_size)
+
+    def test_ext4_get_size(self):
+        """Test generic get_size function with an ext4 file system"""
+        self._test_get_size(mkfs_function=BlockDev.fs_ext4_mkfs)
+
+    def test_xfs_get_size(self):
+        """Test generic get_size function with an xfs file system"""
+        self._test_get_size(mkfs_function=BlockDev.fs_xfs_mkfs)
+
+    def test_vfat_get_size(self):
+        """Test generic get_size function with a vfat file system"""
+        self._test_get_size(mkfs_function=BlockDev.fs_vfat_mkfs)
+
+    def test_btrfs_get_size(self):
+        """Test generic get_size function with a btrfs file system"""
+        if not self.btrfs_avail:
+            self.skipTest("skipping Btrfs: not available")
+        self._test_get_size(mkfs_function=BlockDev.fs_btrfs_mkfs)
+
+
+class GenericMany(GenericTestCase):
+    @tag_test(TestTags.CORE)
+    def test_mkfs_check_repair_many(self):
+        """Verify that the batched mkfs/check/repair functions work"""
+
+        items = [BlockDev.FSMkfsItem(self.loop_dev, "ext4", None),
+                 BlockDev.FSMkfsItem(self.loop_dev2, "ext4", None)]
+        succ, errors = BlockDev.fs_mkfs_many(items, 0)
+        self.assertTrue(succ)
+        self.assertEqual(errors, [None, None])
+
+        for dev in (self.loop_dev, self.loop_dev2):
+            fstype = BlockDev.fs_get_fstype(dev)
+            self.assertEqual(fstype, "ext4")
+
+        succ, errors = BlockDev.fs_check_many([self.loop_dev, self.loop_dev2], 0)
+        self.assertTrue(succ)
+        self.assertEqual(errors, [None, None])
+
+        succ, errors = BlockDev.fs_repair_many([self.loop_dev, self.loop_dev2], 0)
+        self.assertTrue(succ)
+        self.assertEqual(errors, [None, None])
+
+    def test_mkfs_many_error(self):
+        """Verify that an error on one device doesn't stop a batched mkfs"""
+
+        items = [BlockDev.FSMkfsItem(self.loop_dev, "ext4", None),
+                 BlockDev.FSMkfsItem("/non/existing/device", "ext4", None)]
+        with self.assertRaisesRegex(GLib.GError, r"Failed to create 1 of the 2 filesystems"):
+            BlockDev.fs_mkfs_many(items, 0)
+
+        # the good device must still have been formatted
+        fstype = BlockDev.fs_get_fstype(self.loop_dev)
+        self.assertEqual(fstype, "ext4")
+
+
 class GenericGetFreeSpace(GenericTestCase):
     def _test_get_free_space(self, mkfs_function, size_delta=0):
         # clean the device
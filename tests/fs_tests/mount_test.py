@@ -99,6 +99,50 @@ class MountTestCase(FSTestCase):
         self.assertTrue(succ)
         self.assertFalse(os.path.ismount(tmp))
 
+    def test_mount_many(self):
+        """Verify that batched mounting and unmounting works"""
+
+        succ = BlockDev.fs_vfat_mkfs(self.loop_dev, None)
+        self.assertTrue(succ)
+        succ = BlockDev.fs_ext4_mkfs(self.loop_dev2, None)
+        self.assertTrue(succ)
+
+        tmp1 = tempfile.mkdtemp(prefix="libblockdev.", suffix="mount_many_test")
+        self.addCleanup(os.rmdir, tmp1)
+        tmp2 = tempfile.mkdtemp(prefix="libblockdev.", suffix="mount_many_test")
+        self.addCleanup(os.rmdir, tmp2)
+
+        self.addCleanup(utils.umount, self.loop_dev)
+        self.addCleanup(utils.umount, self.loop_dev2)
+
+        specs = [BlockDev.FSMountSpec(self.loop_dev, tmp1, "vfat", None),
+                 BlockDev.FSMountSpec(self.loop_dev2, tmp2, None, None)]
+        succ, errors = BlockDev.fs_mount_many(specs, 0)
+        self.assertTrue(succ)
+        self.assertEqual(errors, [None, None])
+        self.assertTrue(os.path.ismount(tmp1))
+        self.assertTrue(os.path.ismount(tmp2))
+
+        # unmount one by the device and one by the mountpoint
+        specs = [BlockDev.FSUnmountSpec(self.loop_dev, False, False),
+                 BlockDev.FSUnmountSpec(tmp2, False, False)]
+        succ, errors = BlockDev.fs_unmount_many(specs, 0)
+        self.assertTrue(succ)
+        self.assertEqual(errors, [None, None])
+        self.assertFalse(os.path.ismount(tmp1))
+        self.assertFalse(os.path.ismount(tmp2))
+
+        # one bad spec fails the batch, the other mounts still happen
+        specs = [BlockDev.FSMountSpec(self.loop_dev, tmp1, "vfat", None),
+                 BlockDev.FSMountSpec("/non/existing/device", tmp2, None, None)]
+        with self.assertRaisesRegex(GLib.GError, r"Failed to mount 1 of the 2 filesystems"):
+            BlockDev.fs_mount_many(specs, 0)
+        self.assertTrue(os.path.ismount(tmp1))
+
+        succ = BlockDev.fs_unmount(self.loop_dev, False, False, None)
+        self.assertTrue(succ)
+        self.assertFalse(os.path.ismount(tmp1))
+
     def test_mount_ro_device(self):
         """ Test mounting an FS on a RO device """
 
@@ -2,7 +2,7 @@ import os
 import unittest
 import re
 import overrides_hack
-from utils import fake_path, TestTags, tag_test
+from utils import fake_path, run_command, TestTags, tag_test
 
 from gi.repository import GLib, BlockDev
 
@@ -368,6 +368,40 @@ class LibraryOpsTestCase(unittest.TestCase):
             self.assertTrue(succ)
             self.assertEqual(set(loaded), set(["swap", "lvm", "crypto"]))
 
+    @tag_test(TestTags.NOSTORAGE)
+    def test_init_lazy(self):
+        """Verify that lazy initialization loads plugins on first use"""
+
+        # bd_init_lazy() can only be called in a process that hasn't
+        # initialized the library yet -> run the checks in a fresh one
+        script = """
+import sys
+sys.path.insert(0, "%s")
+import overrides_hack
+from gi.repository import BlockDev
+
+ps = BlockDev.plugin_specs_from_names(("loop",))
+assert BlockDev.init_lazy(ps, None)
+assert BlockDev.is_initialized()
+
+# the plugin is available, but not loaded yet
+assert BlockDev.is_plugin_available(BlockDev.Plugin.LOOP)
+assert "loop" not in BlockDev.get_available_plugin_names()
+assert BlockDev.get_plugin_soname(BlockDev.Plugin.LOOP) is None
+
+# plugins that were not requested are not available
+assert not BlockDev.is_plugin_available(BlockDev.Plugin.SWAP)
+
+# the first call into the plugin's API loads it on demand
+assert BlockDev.loop_get_backing_file("/non/existing") is None
+assert "loop" in BlockDev.get_available_plugin_names()
+assert BlockDev.get_plugin_soname(BlockDev.Plugin.LOOP) is not None
+assert BlockDev.is_plugin_available(BlockDev.Plugin.LOOP)
+""" % os.path.dirname(os.path.abspath(__file__))
+
+        ret, out, err = run_command("python3 -", script.encode())
+        self.assertEqual(ret, 0, "lazy initialization checks failed in the child process: %s %s" % (out, err))
+
     def test_non_en_init(self):
         """Verify that the library initializes with lang different from en_US"""
 
@@ -151,3 +151,77 @@ class LoopTestGetSetAutoclear(LoopTestCase):
 
         self.assertTrue(BlockDev.loop_set_autoclear(loop, False))
         self.assertFalse(BlockDev.loop_get_autoclear(loop))
+
+class LoopTestSetupMany(LoopTestCase):
+    def setUp(self):
+        LoopTestCase.setUp(self)
+        self.dev_file2 = create_sparse_tempfile("loop_test", 1024**3)
+        self.dev_file3 = create_sparse_tempfile("loop_test", 1024**3)
+        self.loops = []
+
+    def _clean_up(self):
+        for loop in self.loops:
+            try:
+                BlockDev.loop_teardown(loop)
+            except:
+                pass
+        os.unlink(self.dev_file2)
+        os.unlink(self.dev_file3)
+        LoopTestCase._clean_up(self)
+
+    def testLoop_setup_many(self):
+        """Verify that loop_setup_many works as expected"""
+
+        files = [self.dev_file, self.dev_file2, self.dev_file3]
+        self.loops = BlockDev.loop_setup_many(files, False, False, False)
+        self.assertEqual(len(self.loops), 3)
+
+        # the returned names should be in the same order as the files
+        for loop, f_name in zip(self.loops, files):
+            self.assertTrue(loop)
+            self.assertEqual(BlockDev.loop_get_loop_name(f_name), loop)
+            self.assertEqual(BlockDev.loop_get_backing_file(loop), f_name)
+
+        for loop in self.loops:
+            self.assertTrue(BlockDev.loop_teardown(loop))
+        self.loops = []
+
+    def testLoop_setup_many_failure(self):
+        """Verify that a failed loop_setup_many leaves no devices behind"""
+
+        files = [self.dev_file, "/non/existing", self.dev_file2]
+        with self.assertRaises(GLib.Error):
+            BlockDev.loop_setup_many(files, False, False, False)
+
+        # the call is all-or-nothing -- the devices set up for the good files
+        # should have been torn down again
+        time.sleep(1)
+        self.assertIs(BlockDev.loop_get_loop_name(self.dev_file), None)
+        self.assertIs(BlockDev.loop_get_loop_name(self.dev_file2), None)
+
+class LoopTestDirectIO(LoopTestCase):
+    def _get_dio(self, loop):
+        with open("/sys/block/%s/loop/dio" % loop, "r") as f:
+            return f.read().strip()
+
+    def testLoop_set_direct_io(self):
+        """Verify that setting direct I/O on a loop device works as expected"""
+
+        with self.assertRaises(GLib.Error):
+            BlockDev.loop_set_direct_io("/non/existing", True)
+
+        succ, self.loop = BlockDev.loop_setup(self.dev_file)
+        self.assertTrue(succ)
+        self.assertEqual(self._get_dio(self.loop), "0")
+
+        try:
+            succ = BlockDev.loop_set_direct_io(self.loop, True)
+        except GLib.Error:
+            # direct I/O is not supported on all file systems (e.g. tmpfs)
+            self.skipTest("direct I/O not supported on the backing file")
+        self.assertTrue(succ)
+        self.assertEqual(self._get_dio(self.loop), "1")
+
+        succ = BlockDev.loop_set_direct_io(self.loop, False)
+        self.assertTrue(succ)
+        self.assertEqual(self._get_dio(self.loop), "0")
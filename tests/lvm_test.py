@@ -707,6 +707,79 @@ class LvmTestLVcreateRemove(LvmPVVGLVTestCase):
         with self.assertRaises(GLib.GError):
             BlockDev.lvm_lvremove("testVG", "testLV", True, None)
 
+class LvmTestShellMode(LvmPVVGLVTestCase):
+    def _clean_up(self):
+        # make sure the shell mode is off and the config is clean no matter
+        # where the test failed
+        try:
+            BlockDev.lvm_set_global_config(None)
+        except:
+            pass
+        try:
+            BlockDev.lvm_set_shell_mode(False)
+        except:
+            pass
+
+        LvmPVVGLVTestCase._clean_up(self)
+
+    def test_shell_mode(self):
+        """Verify that commands work the same way through the lvm shell"""
+
+        succ = BlockDev.lvm_set_shell_mode(True)
+        self.assertTrue(succ)
+
+        # a failing command must report an error...
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_pvcreate("/non/existing/device", 0, 0, None)
+
+        # ...and not break the session for the following commands
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 512 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        # queries are not routed through the shell but must see the results
+        info = BlockDev.lvm_lvinfo("testVG", "testLV")
+        self.assertEqual(info.lv_name, "testLV")
+
+        succ = BlockDev.lvm_lvremove("testVG", "testLV", True, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgremove("testVG", None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvremove(self.loop_dev2, None)
+        self.assertTrue(succ)
+
+        # a global config with a newline cannot be passed to the line-based
+        # shell, such commands must fall back to direct spawning and still
+        # run as a single command
+        succ = BlockDev.lvm_set_global_config("backup {backup=0\narchive=0}")
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvremove(self.loop_dev, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_set_global_config(None)
+        self.assertTrue(succ)
+
+        # back to normal spawning
+        succ = BlockDev.lvm_set_shell_mode(False)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvremove(self.loop_dev, None)
+        self.assertTrue(succ)
+
 class LvmTestLVcreateWithExtra(LvmPVVGLVTestCase):
     def __init__(self, *args, **kwargs):
         LvmPVVGLVTestCase.__init__(self, *args, **kwargs)
@@ -377,6 +377,98 @@ class UtilsExecLoggingTest(UtilsTestCase):
         self.assertTrue(status)
 
 
+class UtilsExecBatchTest(UtilsTestCase):
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_batch(self):
+        """Verify that batched execution works as expected"""
+
+        succ, statuses, errors = BlockDev.utils_exec_batch([["true"], ["true"], ["true"]], 2, None)
+        self.assertTrue(succ)
+        self.assertEqual(statuses, [0, 0, 0])
+        self.assertEqual(errors, [None, None, None])
+
+        # a failing item fails the whole batch, the other items still run
+        with self.assertRaisesRegex(GLib.GError, r"1 of 3 batched utility calls failed"):
+            BlockDev.utils_exec_batch([["true"], ["false"], ["true"]], 0, None)
+
+
+class UtilsJobSchedulerTest(UtilsTestCase):
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_job_scheduler(self):
+        """Verify that the job scheduler runs jobs respecting their dependencies"""
+
+        done = []
+
+        def job(data):
+            done.append(data)
+            return True
+
+        sched = BlockDev.utils_job_scheduler_new(2)
+        first = BlockDev.utils_job_scheduler_add(sched, job, "first", None)
+        second = BlockDev.utils_job_scheduler_add(sched, job, "second", None)
+        third = BlockDev.utils_job_scheduler_add(sched, job, "third", [first, second])
+
+        # jobs may only depend on already added jobs
+        with self.assertRaisesRegex(GLib.GError, r"No job with the ID"):
+            BlockDev.utils_job_scheduler_add(sched, job, "bogus", [42])
+
+        # nothing has been run yet
+        with self.assertRaisesRegex(GLib.GError, r"hasn't been run"):
+            BlockDev.utils_job_scheduler_get_result(sched, first)
+
+        self.assertTrue(BlockDev.utils_job_scheduler_run(sched))
+
+        # the dependent job must have run after both its dependencies
+        self.assertCountEqual(done[0:2], ["first", "second"])
+        self.assertEqual(done[2], "third")
+
+        for job_id in (first, second, third):
+            self.assertTrue(BlockDev.utils_job_scheduler_get_result(sched, job_id))
+
+        # the scheduler is single-shot
+        with self.assertRaisesRegex(GLib.GError, r"already been run"):
+            BlockDev.utils_job_scheduler_run(sched)
+        with self.assertRaisesRegex(GLib.GError, r"no more jobs can be added"):
+            BlockDev.utils_job_scheduler_add(sched, job, "late", None)
+
+        BlockDev.utils_job_scheduler_free(sched)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_job_scheduler_failure(self):
+        """Verify that a failed job skips its dependents (transitively)"""
+
+        done = []
+
+        def job(data):
+            done.append(data)
+            return True
+
+        def failing_job(data):
+            return False
+
+        sched = BlockDev.utils_job_scheduler_new(0)
+        failing = BlockDev.utils_job_scheduler_add(sched, failing_job, None, None)
+        dependent = BlockDev.utils_job_scheduler_add(sched, job, "dependent", [failing])
+        transitive = BlockDev.utils_job_scheduler_add(sched, job, "transitive", [dependent])
+        independent = BlockDev.utils_job_scheduler_add(sched, job, "independent", None)
+
+        # the summary error belongs to the first failure in submission order
+        with self.assertRaisesRegex(GLib.GError, r"Job %d" % failing):
+            BlockDev.utils_job_scheduler_run(sched)
+
+        # jobs not depending on the failed one still ran
+        self.assertEqual(done, ["independent"])
+
+        with self.assertRaisesRegex(GLib.GError, r"failed"):
+            BlockDev.utils_job_scheduler_get_result(sched, failing)
+        for job_id in (dependent, transitive):
+            with self.assertRaisesRegex(GLib.GError, r"skipped because one of its dependencies failed"):
+                BlockDev.utils_job_scheduler_get_result(sched, job_id)
+        self.assertTrue(BlockDev.utils_job_scheduler_get_result(sched, independent))
+
+        BlockDev.utils_job_scheduler_free(sched)
+
+
 class UtilsDevUtilsTestCase(UtilsTestCase):
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
     def test_resolve_device(self):
@@ -410,6 +502,28 @@ class UtilsDevUtilsTestCase(UtilsTestCase):
         # should resolve the symlink even without the "/dev" prefix
         self.assertEqual(BlockDev.utils_resolve_device(dev_link[5:]), dev)
 
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_resolve_devices(self):
+        """Verify that resolving multiple device specs works as expected"""
+
+        dev = "/dev/libblockdev-test-dev"
+        with open(dev, "w"):
+            pass
+        self.addCleanup(os.unlink, dev)
+
+        dev2 = "/dev/libblockdev-test-dev2"
+        with open(dev2, "w"):
+            pass
+        self.addCleanup(os.unlink, dev2)
+
+        # full paths and bare names, resolved in the given order
+        self.assertEqual(BlockDev.utils_resolve_devices([dev, dev2]), [dev, dev2])
+        self.assertEqual(BlockDev.utils_resolve_devices([dev2[5:], dev[5:]]), [dev2, dev])
+
+        # one bad spec fails the whole sweep
+        with self.assertRaisesRegex(GLib.GError, "no_such_device"):
+            BlockDev.utils_resolve_devices([dev, "no_such_device"])
+
 
 class UtilsDevUtilsSymlinksTestCase(UtilsTestCase):
     def setUp(self):
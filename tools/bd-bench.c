@@ -0,0 +1,338 @@
+/*
+ * A micro-benchmark harness for the hot libblockdev APIs. Sets up loop-device
+ * backed fixtures (plain loop device, LVM VG, LUKS), runs each API in a tight
+ * loop and reports wall-clock time, CPU time (both our own and the spawned
+ * children's) and the number of spawned processes per benchmark. On top of the
+ * human-readable report a single JSON line per run is appended to a history
+ * file so that CI can compare runs over time.
+ *
+ * This needs to run as root (just like the test suite) and is destructive to
+ * the loop devices it creates (and only to them).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <glib.h>
+#include <blockdev/blockdev.h>
+#include <blockdev/crypto.h>
+#include <blockdev/fs.h>
+#include <blockdev/loop.h>
+#include <blockdev/lvm.h>
+#include <blockdev/part.h>
+#include <blockdev/utils.h>
+
+#define BENCH_FILE_SIZE (256ULL * 1024 * 1024)
+#define BENCH_VG_NAME "bdbenchvg"
+#define BENCH_LV_NAME "bdbenchlv"
+#define BENCH_LUKS_NAME "bdbench-luks"
+#define BENCH_LUKS_PASS "bdbenchpass"
+#define DEFAULT_HISTORY_FILE "bd-bench-history.json"
+
+/* incremented from the logging callback for every "Running [N] ..." message,
+   i.e. for every process spawned by the library */
+static guint64 spawn_count = 0;
+
+static void count_spawns_log_func (gint level, const gchar *msg) {
+    if ((level == BD_UTILS_LOG_INFO) && g_str_has_prefix (msg, "Running ["))
+        spawn_count++;
+}
+
+typedef gboolean (*BenchIterFunc) (gpointer data, GError **error);
+
+typedef struct {
+    const gchar *name;
+    guint iterations;
+    gint64 wall_us;
+    gint64 wall_max_us;
+    gint64 cpu_self_us;
+    gint64 cpu_children_us;
+    guint64 spawns;
+    gboolean ok;
+} BenchResult;
+
+static gint64 rusage_cpu_us (const struct rusage *ru) {
+    return (gint64) ru->ru_utime.tv_sec * G_USEC_PER_SEC + ru->ru_utime.tv_usec +
+           (gint64) ru->ru_stime.tv_sec * G_USEC_PER_SEC + ru->ru_stime.tv_usec;
+}
+
+static void run_bench (const gchar *name, guint iterations, BenchIterFunc func, gpointer data, GArray *results) {
+    BenchResult res = {name, iterations, 0, 0, 0, 0, 0, TRUE};
+    struct rusage self_before, self_after;
+    struct rusage children_before, children_after;
+    guint64 spawns_before = spawn_count;
+    GError *error = NULL;
+    guint i = 0;
+
+    getrusage (RUSAGE_SELF, &self_before);
+    getrusage (RUSAGE_CHILDREN, &children_before);
+
+    for (i = 0; i < iterations; i++) {
+        gint64 start = g_get_monotonic_time ();
+        gint64 duration = 0;
+        if (!func (data, &error)) {
+            fprintf (stderr, "%s: iteration %u failed: %s\n", name, i + 1,
+                     error ? error->message : "unknown error");
+            g_clear_error (&error);
+            res.ok = FALSE;
+            break;
+        }
+        duration = g_get_monotonic_time () - start;
+        res.wall_us += duration;
+        if (duration > res.wall_max_us)
+            res.wall_max_us = duration;
+    }
+
+    getrusage (RUSAGE_SELF, &self_after);
+    getrusage (RUSAGE_CHILDREN, &children_after);
+    res.cpu_self_us = rusage_cpu_us (&self_after) - rusage_cpu_us (&self_before);
+    res.cpu_children_us = rusage_cpu_us (&children_after) - rusage_cpu_us (&children_before);
+    res.spawns = spawn_count - spawns_before;
+
+    if (res.ok) {
+        printf ("%-24s %5u iters  avg %8.3f ms  max %8.3f ms  cpu(self) %8.3f ms  cpu(children) %8.3f ms  spawns %3"G_GUINT64_FORMAT"\n",
+                name, iterations,
+                (double) res.wall_us / iterations / 1000.0,
+                (double) res.wall_max_us / 1000.0,
+                (double) res.cpu_self_us / 1000.0,
+                (double) res.cpu_children_us / 1000.0,
+                res.spawns);
+        g_array_append_val (results, res);
+    } else
+        printf ("%-24s FAILED (skipped in the report)\n", name);
+}
+
+/* fixture: a sparse temporary file with a loop device on top of it */
+typedef struct {
+    gchar *file;
+    gchar *device;
+} LoopFixture;
+
+static gboolean loop_fixture_setup (LoopFixture *fixture, GError **error) {
+    const gchar *loop_name = NULL;
+    gint fd = -1;
+
+    fd = g_file_open_tmp ("bd-bench-XXXXXX", &fixture->file, error);
+    if (fd < 0)
+        return FALSE;
+    if (ftruncate (fd, BENCH_FILE_SIZE) != 0) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Failed to resize the backing file '%s': %m", fixture->file);
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+
+    if (!bd_loop_setup (fixture->file, 0, 0, FALSE, FALSE, &loop_name, error))
+        return FALSE;
+    fixture->device = g_strdup_printf ("/dev/%s", loop_name);
+    return TRUE;
+}
+
+static void loop_fixture_teardown (LoopFixture *fixture) {
+    GError *error = NULL;
+    if (fixture->device && !bd_loop_teardown (fixture->device, &error)) {
+        fprintf (stderr, "Failed to tear down the loop device '%s': %s\n",
+                 fixture->device, error->message);
+        g_clear_error (&error);
+    }
+    if (fixture->file)
+        unlink (fixture->file);
+    g_free (fixture->device);
+    g_free (fixture->file);
+    fixture->device = NULL;
+    fixture->file = NULL;
+}
+
+/* the benchmarked operations */
+static gboolean bench_utils_exec (gpointer data G_GNUC_UNUSED, GError **error) {
+    const gchar *argv[] = {"true", NULL};
+    return bd_utils_exec_and_report_error (argv, NULL, error);
+}
+
+static gboolean bench_fs_mkfs (gpointer data, GError **error) {
+    return bd_fs_mkfs ((const gchar *) data, "ext4", NULL, NULL, error);
+}
+
+static gboolean bench_part_create (gpointer data, GError **error) {
+    const gchar *device = (const gchar *) data;
+    BDPartSpec *spec = NULL;
+
+    if (!bd_part_create_table (device, BD_PART_TABLE_GPT, TRUE, error))
+        return FALSE;
+    spec = bd_part_create_part (device, BD_PART_TYPE_REQ_NEXT, 1024 * 1024, 10 * 1024 * 1024,
+                                BD_PART_ALIGN_OPTIMAL, error);
+    if (!spec)
+        return FALSE;
+    bd_part_spec_free (spec);
+    return TRUE;
+}
+
+static gboolean bench_lvm_pvs (gpointer data G_GNUC_UNUSED, GError **error) {
+    BDLVMPVdata **pvs = bd_lvm_pvs (error);
+    BDLVMPVdata **pv_p = NULL;
+
+    if (!pvs)
+        return FALSE;
+    for (pv_p = pvs; *pv_p; pv_p++)
+        bd_lvm_pvdata_free (*pv_p);
+    g_free (pvs);
+    return TRUE;
+}
+
+static gboolean bench_lvm_lvs (gpointer data G_GNUC_UNUSED, GError **error) {
+    BDLVMLVdata **lvs = bd_lvm_lvs (BENCH_VG_NAME, error);
+    BDLVMLVdata **lv_p = NULL;
+
+    if (!lvs)
+        return FALSE;
+    for (lv_p = lvs; *lv_p; lv_p++)
+        bd_lvm_lvdata_free (*lv_p);
+    g_free (lvs);
+    return TRUE;
+}
+
+static gboolean bench_luks_open_close (gpointer data, GError **error) {
+    if (!bd_crypto_luks_open ((const gchar *) data, BENCH_LUKS_NAME, BENCH_LUKS_PASS, NULL, FALSE, error))
+        return FALSE;
+    return bd_crypto_luks_close (BENCH_LUKS_NAME, error);
+}
+
+static void write_history_line (const gchar *path, GArray *results) {
+    FILE *f = fopen (path, "a");
+    guint i = 0;
+
+    if (!f) {
+        fprintf (stderr, "Failed to open the history file '%s' for appending\n", path);
+        return;
+    }
+
+    fprintf (f, "{\"time\": %"G_GINT64_FORMAT", \"benchmarks\": [",
+             g_get_real_time () / G_USEC_PER_SEC);
+    for (i = 0; i < results->len; i++) {
+        BenchResult *res = &g_array_index (results, BenchResult, i);
+        fprintf (f, "%s{\"name\": \"%s\", \"iterations\": %u, "
+                 "\"wall-avg-us\": %"G_GINT64_FORMAT", \"wall-max-us\": %"G_GINT64_FORMAT", "
+                 "\"cpu-self-us\": %"G_GINT64_FORMAT", \"cpu-children-us\": %"G_GINT64_FORMAT", "
+                 "\"spawns\": %"G_GUINT64_FORMAT"}",
+                 (i > 0) ? ", " : "",
+                 res->name, res->iterations,
+                 res->wall_us / res->iterations, res->wall_max_us,
+                 res->cpu_self_us, res->cpu_children_us, res->spawns);
+    }
+    fprintf (f, "]}\n");
+    fclose (f);
+}
+
+void print_usage (const char *cmd) {
+    fprintf (stderr,
+             "Usage: %s [-o FILE]\n"
+             "-h       --help         Print this usage info\n"
+             "-o FILE  --output FILE  Append the JSON results to FILE (default: '%s')\n",
+             cmd, DEFAULT_HISTORY_FILE);
+}
+
+int main (int argc, char *argv[]) {
+    GError *error = NULL;
+    const gchar *history_file = DEFAULT_HISTORY_FILE;
+    LoopFixture loop1 = {NULL, NULL};
+    LoopFixture loop2 = {NULL, NULL};
+    gboolean lvm_fixture = FALSE;
+    GArray *results = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if ((g_strcmp0 (argv[i], "-h") == 0) || (g_strcmp0 (argv[i], "--help") == 0)) {
+            print_usage (argv[0]);
+            return 0;
+        } else if ((g_strcmp0 (argv[i], "-o") == 0) || (g_strcmp0 (argv[i], "--output") == 0)) {
+            if (i + 1 >= argc) {
+                fprintf (stderr, "The -o/--output option requires a file name.\n");
+                print_usage (argv[0]);
+                return 1;
+            }
+            history_file = argv[++i];
+        } else {
+            fprintf (stderr, "Unknown option: '%s'\n", argv[i]);
+            print_usage (argv[0]);
+            return 1;
+        }
+    }
+
+    /* check that we are runnig as root */
+    if ((getuid () != 0) || (geteuid () != 0)) {
+        fprintf (stderr, "This utility must be run as root.\n");
+        return 1;
+    }
+
+    /* initialize the library with the plugins the benchmarks exercise and with
+       a logging function counting the spawned processes */
+    BDPluginSpec loop_plugin = {BD_PLUGIN_LOOP, NULL};
+    BDPluginSpec fs_plugin = {BD_PLUGIN_FS, NULL};
+    BDPluginSpec part_plugin = {BD_PLUGIN_PART, NULL};
+    BDPluginSpec lvm_plugin = {BD_PLUGIN_LVM, NULL};
+    BDPluginSpec crypto_plugin = {BD_PLUGIN_CRYPTO, NULL};
+    BDPluginSpec *plugins[] = {&loop_plugin, &fs_plugin, &part_plugin, &lvm_plugin, &crypto_plugin, NULL};
+    if (!bd_init (plugins, count_spawns_log_func, &error)) {
+        fprintf (stderr, "Failed to initialize the libblockdev library: %s\n",
+                 error->message);
+        return 2;
+    }
+
+    results = g_array_new (FALSE, FALSE, sizeof (BenchResult));
+
+    run_bench ("utils-exec", 100, bench_utils_exec, NULL, results);
+
+    if (!loop_fixture_setup (&loop1, &error)) {
+        fprintf (stderr, "Failed to set up the loop fixture, skipping the device benchmarks: %s\n",
+                 error->message);
+        g_clear_error (&error);
+    } else {
+        run_bench ("fs-mkfs-ext4", 5, bench_fs_mkfs, loop1.device, results);
+        run_bench ("part-create-part", 10, bench_part_create, loop1.device, results);
+
+        /* the LUKS benchmark reformats the device the previous benchmarks used */
+        if (!bd_crypto_luks_format (loop1.device, NULL, 0, BENCH_LUKS_PASS, NULL, 0, &error)) {
+            fprintf (stderr, "Failed to set up the LUKS fixture, skipping the crypto benchmark: %s\n",
+                     error->message);
+            g_clear_error (&error);
+        } else
+            run_bench ("crypto-luks-open-close", 5, bench_luks_open_close, loop1.device, results);
+    }
+
+    /* a separate loop device for the LVM fixture (a dm-backed LV on top of it) */
+    if (!loop_fixture_setup (&loop2, &error) ||
+        !bd_lvm_pvcreate (loop2.device, 0, 0, NULL, &error) ||
+        !bd_lvm_vgcreate (BENCH_VG_NAME, (const gchar *[]){loop2.device, NULL}, 0, NULL, &error) ||
+        !bd_lvm_lvcreate (BENCH_VG_NAME, BENCH_LV_NAME, 50 * 1024 * 1024, NULL, NULL, NULL, &error)) {
+        fprintf (stderr, "Failed to set up the LVM fixture, skipping the LVM benchmarks: %s\n",
+                 error->message);
+        g_clear_error (&error);
+    } else {
+        lvm_fixture = TRUE;
+        run_bench ("lvm-pvs", 10, bench_lvm_pvs, NULL, results);
+        run_bench ("lvm-lvs", 10, bench_lvm_lvs, NULL, results);
+    }
+
+    if (lvm_fixture) {
+        if (!bd_lvm_lvremove (BENCH_VG_NAME, BENCH_LV_NAME, TRUE, NULL, &error) ||
+            !bd_lvm_vgremove (BENCH_VG_NAME, NULL, &error) ||
+            !bd_lvm_pvremove (loop2.device, NULL, &error)) {
+            fprintf (stderr, "Failed to tear down the LVM fixture: %s\n", error->message);
+            g_clear_error (&error);
+        }
+    }
+    loop_fixture_teardown (&loop2);
+    loop_fixture_teardown (&loop1);
+
+    if (results->len > 0)
+        write_history_line (history_file, results);
+    else
+        fprintf (stderr, "No benchmark succeeded, not writing the history file.\n");
+
+    g_array_free (results, TRUE);
+
+    return 0;
+}
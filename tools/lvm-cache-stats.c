@@ -7,11 +7,22 @@
 #include <blockdev/lvm.h>
 #include <bytesize/bs_size.h>
 
+/* counters from the previous sample in the watch mode (for the delta
+   computation) */
+typedef struct {
+    gboolean valid;
+    guint64 read_hits;
+    guint64 read_misses;
+    guint64 write_hits;
+    guint64 write_misses;
+} PrevCounters;
+
 void print_usage (const char *cmd) {
     fprintf (stderr,
              "Usage: %s CACHED_LV [CACHED_LV2...]\n"
-             "-h    --help   Print this usage info\n"
-             "-j    --json   Print stats as JSON\n"
+             "-h    --help     Print this usage info\n"
+             "-j    --json     Print stats as JSON\n"
+             "-w N  --watch N  Keep running and print the stats (and deltas) every N seconds\n"
              "Options need to be specified before LVs.\n",
              cmd);
 }
@@ -29,7 +40,20 @@ void print_ratio (guint64 part, guint64 total, gboolean space, gboolean newline)
     printf ("%s[%6.2f%%]%s", space ? " " : "", percent, newline ? "\n" : "");
 }
 
-gboolean print_lv_stats (const char *vg_name, const char *lv_name, GError **error) {
+guint64 counter_delta (guint64 cur, guint64 prev) {
+    /* guard against counter resets (e.g. the cache being re-attached) */
+    return (cur >= prev) ? cur - prev : cur;
+}
+
+void update_prev (PrevCounters *prev, const BDLVMCacheStats *stats) {
+    prev->read_hits = stats->read_hits;
+    prev->read_misses = stats->read_misses;
+    prev->write_hits = stats->write_hits;
+    prev->write_misses = stats->write_misses;
+    prev->valid = TRUE;
+}
+
+gboolean print_lv_stats (const char *vg_name, const char *lv_name, PrevCounters *prev, GError **error) {
     BDLVMLVdata *lv_data = bd_lvm_lvinfo (vg_name, lv_name, error);
     if (!lv_data)
         return FALSE;
@@ -47,6 +71,16 @@ gboolean print_lv_stats (const char *vg_name, const char *lv_name, GError **erro
     printf ("  write misses: %10"G_GUINT64_FORMAT"\n", stats->write_misses);
     printf ("  write hits:   %10"G_GUINT64_FORMAT, stats->write_hits); print_ratio (stats->write_hits, stats->write_hits + stats->write_misses, TRUE, TRUE);
 
+    if (prev && prev->valid) {
+        printf ("  since last sample:\n");
+        printf ("    read misses:  %10"G_GUINT64_FORMAT"\n", counter_delta (stats->read_misses, prev->read_misses));
+        printf ("    read hits:    %10"G_GUINT64_FORMAT"\n", counter_delta (stats->read_hits, prev->read_hits));
+        printf ("    write misses: %10"G_GUINT64_FORMAT"\n", counter_delta (stats->write_misses, prev->write_misses));
+        printf ("    write hits:   %10"G_GUINT64_FORMAT"\n", counter_delta (stats->write_hits, prev->write_hits));
+    }
+    if (prev)
+        update_prev (prev, stats);
+
     bd_lvm_lvdata_free (lv_data);
     bd_lvm_cache_stats_free (stats);
 
@@ -82,6 +116,42 @@ gboolean print_lv_stats_json(const char *vg_name, const char *lv_name, GError **
     return TRUE;
 }
 
+/* one machine-readable line per LV and sample for the watch mode */
+gboolean print_lv_stats_json_line (const char *vg_name, const char *lv_name, PrevCounters *prev, GError **error) {
+    BDLVMLVdata *lv_data = bd_lvm_lvinfo (vg_name, lv_name, error);
+    if (!lv_data)
+        return FALSE;
+    BDLVMCacheStats *stats = bd_lvm_cache_stats (vg_name, lv_name, error);
+    if (!stats)
+        return FALSE;
+
+    printf ("{\"time\": %"G_GINT64_FORMAT", \"lv\": \"%s/%s\", \"mode\": \"%s\", "
+            "\"lv-size\": %"G_GUINT64_FORMAT", \"cache-size\": %"G_GUINT64_FORMAT", "
+            "\"cache-used\": %"G_GUINT64_FORMAT", "
+            "\"read-misses\": %"G_GUINT64_FORMAT", \"read-hits\": %"G_GUINT64_FORMAT", "
+            "\"write-misses\": %"G_GUINT64_FORMAT", \"write-hits\": %"G_GUINT64_FORMAT,
+            g_get_real_time () / G_USEC_PER_SEC, vg_name, lv_name,
+            bd_lvm_cache_get_mode_str (stats->mode, error), /* ignoring 'error', must be a valid mode */
+            lv_data->size, stats->cache_size, stats->cache_used,
+            stats->read_misses, stats->read_hits,
+            stats->write_misses, stats->write_hits);
+    if (prev->valid)
+        printf (", \"read-misses-delta\": %"G_GUINT64_FORMAT", \"read-hits-delta\": %"G_GUINT64_FORMAT
+                ", \"write-misses-delta\": %"G_GUINT64_FORMAT", \"write-hits-delta\": %"G_GUINT64_FORMAT,
+                counter_delta (stats->read_misses, prev->read_misses),
+                counter_delta (stats->read_hits, prev->read_hits),
+                counter_delta (stats->write_misses, prev->write_misses),
+                counter_delta (stats->write_hits, prev->write_hits));
+    printf ("}\n");
+
+    update_prev (prev, stats);
+
+    bd_lvm_lvdata_free (lv_data);
+    bd_lvm_cache_stats_free (stats);
+
+    return TRUE;
+}
+
 int main (int argc, char *argv[]) {
     gboolean ret = FALSE;
     GError *error = NULL;
@@ -92,11 +162,20 @@ int main (int argc, char *argv[]) {
     }
 
     gboolean json = FALSE;
+    long watch_interval = 0;
     int first_lv_arg = 1;
     for (int i=0; i < argc; i++) {
         if ((g_strcmp0 (argv[i], "-j") == 0) || g_strcmp0 (argv[i], "--json") == 0) {
             json = TRUE;
             first_lv_arg++;
+        } else if ((g_strcmp0 (argv[i], "-w") == 0) || g_strcmp0 (argv[i], "--watch") == 0) {
+            if ((i + 1 >= argc) || ((watch_interval = strtol (argv[i+1], NULL, 10)) <= 0)) {
+                fprintf (stderr, "The -w/--watch option requires a positive number of seconds.\n");
+                print_usage (argv[0]);
+                return 1;
+            }
+            i++;
+            first_lv_arg += 2;
         }
     }
 
@@ -112,6 +191,23 @@ int main (int argc, char *argv[]) {
         return 1;
     }
 
+    /* split the 'VG/LV' arguments up front (also because the watch mode goes
+       over them repeatedly) */
+    int n_lvs = argc - first_lv_arg;
+    const char **vg_names = g_new0 (const char*, n_lvs);
+    const char **lv_names = g_new0 (const char*, n_lvs);
+    PrevCounters *prev = g_new0 (PrevCounters, n_lvs);
+    for (int i = 0; i < n_lvs; i++) {
+        char *slash = strchr (argv[first_lv_arg + i], '/');
+        if (!slash) {
+            fprintf (stderr, "Invalid LV specified: '%s'. Has to be in the VG/LV format.\n", argv[first_lv_arg + i]);
+            return 1;
+        }
+        *slash = '\0';
+        vg_names[i] = argv[first_lv_arg + i];
+        lv_names[i] = slash + 1;
+    }
+
     /* initialize the library -- we only need the LVM plugin */
     BDPluginSpec lvm_plugin = {BD_PLUGIN_LVM, NULL};
     BDPluginSpec *plugins[] = {&lvm_plugin, NULL};
@@ -123,33 +219,46 @@ int main (int argc, char *argv[]) {
         return 2;
     }
 
+    if (watch_interval)
+        /* one long-lived process -- serve the repeated LV queries from the
+           in-memory cache instead of spawning 'lvm' for each of them (not
+           fatal if this fails, the queries are just slower) */
+        if (!bd_lvm_set_query_cache (TRUE, &error))
+            g_clear_error (&error);
+
     gboolean ok = TRUE;
-    for (int i = first_lv_arg; i < argc; i++) {
-        /* Add one blank line between stats for the individual LVs */
-        if (i > first_lv_arg)
-            printf("\n");
+    do {
+        ok = TRUE;
+        for (int i = 0; i < n_lvs; i++) {
+            /* Add one blank line between stats for the individual LVs (but
+               keep the watch-mode JSON output one line per LV and sample) */
+            if ((i > 0) && !(watch_interval && json))
+                printf("\n");
 
-        char *slash = strchr (argv[i], '/');
-        if (!slash) {
-            fprintf (stderr, "Invalid LV specified: '%s'. Has to be in the VG/LV format.\n", argv[i]);
-            ok = FALSE;
-            continue;
+            if (json)
+                ret = watch_interval ? print_lv_stats_json_line (vg_names[i], lv_names[i], prev + i, &error)
+                                     : print_lv_stats_json (vg_names[i], lv_names[i], &error);
+            else
+                ret = print_lv_stats (vg_names[i], lv_names[i], watch_interval ? prev + i : NULL, &error);
+
+            if (!ret) {
+                fprintf (stderr, "Failed to get stats for '%s/%s': %s\n",
+                         vg_names[i], lv_names[i], error->message);
+                g_clear_error (&error);
+                ok = FALSE;
+            }
         }
-        *slash = '\0';
-        const char *vg_name = argv[i];
-        const char *lv_name = slash + 1;
-
-        if (json)
-            ret = print_lv_stats_json (vg_name, lv_name, &error);
-        else
-            ret = print_lv_stats (vg_name, lv_name, &error);
-
-        if (!ret) {
-            fprintf (stderr, "Failed to get stats for '%s/%s': %s\n",
-                     vg_name, lv_name, error->message);
-            ok = FALSE;
+        if (watch_interval) {
+            fflush (stdout);
+            sleep (watch_interval);
+            if (!json)
+                printf ("\n");
         }
-    }
+    } while (watch_interval);
+
+    g_free (vg_names);
+    g_free (lv_names);
+    g_free (prev);
 
     return ok ? 0 : 3;
 }
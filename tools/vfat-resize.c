@@ -113,6 +113,15 @@ int main (int argc, char *argv[]) {
     else
         length = (PedSector) ((PedSector) new_size / ped_dev->sector_size);
 
+    /* the filesystem already spans the requested geometry -- the resize would
+       just move data around for nothing, so skip it (this makes repeated
+       "adapt to the device" invocations cheap) */
+    if (fs->geom->start == start && fs->geom->length == length) {
+        ped_file_system_close (fs);
+        ped_device_close (ped_dev);
+        return 0;
+    }
+
     status = ped_geometry_init (&new_geom, ped_dev, start, length);
     if (status == 0) {
         g_printerr ("Failed to initialize new geometry for the filesystem on '%s'\n", device);